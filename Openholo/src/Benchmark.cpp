@@ -0,0 +1,245 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "Benchmark.h"
+#include "sys.h"
+#include <random>
+#include <thread>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace oph;
+
+Benchmark::Benchmark(const BenchmarkConfig& config)
+	: config(config)
+{
+}
+
+void Benchmark::add(const char* name, const char* unit, Prepare prepare, Run run, Cleanup cleanup)
+{
+	cases.push_back({ name, unit, prepare, run, cleanup });
+}
+
+bool Benchmark::run(void)
+{
+	results.clear();
+	if (!makeDirectory(config.workDir.c_str())) {
+		LOG("<FAILED> Benchmark directory : %s\n", config.workDir.c_str());
+		return false;
+	}
+#ifdef _OPENMP
+	if (config.nThreads > 0) omp_set_num_threads(config.nThreads);
+#endif
+
+	Profiler* profiler = Profiler::getInstance();
+	const bool bProfile = Profiler::isEnable();
+	const int nRepeat = config.repeat < 1 ? 1 : config.repeat;
+	bool bAllOK = true;
+
+	for (auto& c : cases) {
+		if (!config.filter.empty() && c.name.find(config.filter) == std::string::npos) continue;
+		LOG("[Benchmark] %s\n", c.name.c_str());
+
+		BenchmarkResult result;
+		result.name = c.name;
+		result.unit = c.unit;
+		result.bOK = true;
+		result.work = 0;
+		result.repeat = nRepeat;
+		result.mean = result.min = result.max = result.throughput = 0.0;
+
+		std::vector<Real> times;
+		profiler->setEnable(false);
+		for (int i = -config.warmup; i < nRepeat && result.bOK; i++) {
+			if (c.prepare && !c.prepare()) {
+				result.bOK = false;
+				break;
+			}
+			// stages of the timed runs only, prepare and cleanup are not recorded.
+			if (i == 0) profiler->reset();
+			profiler->setEnable(i >= 0);
+			auto begin = CUR_TIME;
+			ulonglong work = c.run();
+			auto end = CUR_TIME;
+			profiler->setEnable(false);
+			if (c.cleanup) c.cleanup();
+
+			if (work == 0) result.bOK = false;
+			if (i < 0) continue;
+			result.work = work;
+			times.push_back(ELAPSED_TIME(begin, end));
+		}
+		profiler->setEnable(bProfile);
+
+		if (result.bOK && !times.empty()) {
+			result.min = result.max = times[0];
+			for (Real t : times) {
+				result.mean += t;
+				if (t < result.min) result.min = t;
+				if (t > result.max) result.max = t;
+			}
+			result.mean /= times.size();
+			result.throughput = result.mean > 0.0 ? result.work / result.mean : 0.0;
+
+			result.stages = profiler->getStages();
+			for (auto& stage : result.stages) {
+				stage.total /= nRepeat;
+				stage.calls /= nRepeat;
+			}
+			LOG("[Benchmark] %s : %lf (s) min %lf max %lf, %.3e %s/s\n",
+				c.name.c_str(), result.mean, result.min, result.max, result.throughput, c.unit.c_str());
+		}
+		else {
+			LOG("<FAILED> Benchmark : %s\n", c.name.c_str());
+			bAllOK = false;
+		}
+		results.push_back(result);
+	}
+	profiler->reset();
+	return bAllOK;
+}
+
+bool Benchmark::exportJSON(const char* fname)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) {
+		LOG("<FAILED> Export benchmark : %s\n", fname);
+		return false;
+	}
+
+	int nThreads = (int)std::thread::hardware_concurrency();
+#ifdef _OPENMP
+	nThreads = omp_get_max_threads();
+#endif
+	fprintf(fp, "{\n\t\"config\": { \"seed\": %u, \"points\": %llu, \"resolution\": [%d, %d], \"layers\": %d, \"channels\": %d, \"threads\": %d, \"repeat\": %d, \"warmup\": %d },\n",
+		config.seed, config.nPoints, config.resolution[_X], config.resolution[_Y], config.nLayers, config.nChannels,
+		nThreads, config.repeat, config.warmup);
+	fprintf(fp, "\t\"host\": { \"cores\": %u, \"openmp\": %s, \"real\": \"%s\" },\n",
+		std::thread::hardware_concurrency(),
+#ifdef _OPENMP
+		"true",
+#else
+		"false",
+#endif
+		sizeof(Real) == sizeof(double) ? "double" : "float");
+
+	fprintf(fp, "\t\"results\": [");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& r = results[i];
+		fprintf(fp, "%s\n\t\t{ \"name\": \"%s\", \"ok\": %s, \"unit\": \"%s\", \"work\": %llu, \"repeat\": %d, \"mean\": %.9f, \"min\": %.9f, \"max\": %.9f, \"throughput\": %.6e,\n\t\t  \"stages\": {",
+			i ? "," : "", r.name.c_str(), r.bOK ? "true" : "false", r.unit.c_str(), r.work, r.repeat, r.mean, r.min, r.max, r.throughput);
+		for (size_t s = 0; s < r.stages.size(); s++)
+			fprintf(fp, "%s \"%s\": %.9f", s ? "," : "", r.stages[s].name.c_str(), r.stages[s].total);
+		fprintf(fp, " } }");
+	}
+	fprintf(fp, "\n\t]\n}\n");
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool Benchmark::exportCSV(const char* fname)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) {
+		LOG("<FAILED> Export benchmark : %s\n", fname);
+		return false;
+	}
+
+	fprintf(fp, "name,ok,unit,work,repeat,mean,min,max,throughput\n");
+	for (auto& r : results)
+		fprintf(fp, "%s,%d,%s,%llu,%d,%.9f,%.9f,%.9f,%.6e\n",
+			r.name.c_str(), r.bOK ? 1 : 0, r.unit.c_str(), r.work, r.repeat, r.mean, r.min, r.max, r.throughput);
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+void Benchmark::randomPoints(uint seed, ulonglong n, int nChannels, std::vector<Real>& vertex, std::vector<Real>& color)
+{
+	// integer draws scaled by hand : the sequence of std::mt19937_64 is fixed by the standard, distributions are not.
+	std::mt19937_64 rand(seed);
+	const Real scale = 1.0 / (Real)rand.max();
+	vertex.resize(n * 3);
+	color.resize(n * nChannels);
+	for (ulonglong i = 0; i < n * 3; i++)
+		vertex[i] = 2.0 * (rand() * scale) - 1.0;
+	for (ulonglong i = 0; i < n * nChannels; i++)
+		color[i] = rand() * scale;
+}
+
+void Benchmark::syntheticImage(uint seed, int width, int height, int nNoise, std::vector<uchar>& image)
+{
+	std::mt19937_64 rand(seed);
+	const Real phaseX = (rand() % 1000) * 1e-3 * M_PI;
+	const Real phaseY = (rand() % 1000) * 1e-3 * M_PI;
+	image.resize((size_t)width * height);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			Real v = 0.5 + 0.25 * sin(2 * M_PI * 3 * x / width + phaseX) + 0.25 * cos(2 * M_PI * 2 * y / height + phaseY);
+			int value = (int)(v * (255 - nNoise)) + (nNoise ? (int)(rand() % (nNoise + 1)) : 0);
+			image[(size_t)y * width + x] = (uchar)(value < 0 ? 0 : value > 255 ? 255 : value);
+		}
+	}
+}
+
+bool Benchmark::makeDirectory(const char* dir)
+{
+	struct stat info;
+	if (stat(dir, &info) == 0) return (info.st_mode & S_IFDIR) != 0;
+#ifdef _WIN32
+	return _mkdir(dir) == 0;
+#else
+	return mkdir(dir, 0755) == 0;
+#endif
+}
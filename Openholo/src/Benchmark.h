@@ -0,0 +1,165 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __Benchmark_h
+#define __Benchmark_h
+
+#include "include.h"
+#include "ivec.h"
+#include "Profiler.h"
+#include <functional>
+
+#ifdef OPH_EXPORT
+#define OPH_DLL __declspec(dllexport)
+#else
+#define OPH_DLL __declspec(dllimport)
+#endif
+
+namespace oph
+{
+	/**
+	* @brief Parameters of a benchmark run, every synthetic input is derived from them.
+	*/
+	struct OPH_DLL BenchmarkConfig {
+		uint seed;					///< seed of the synthetic inputs
+		ulonglong nPoints;			///< object points of the point-cloud generators
+		ivec2 resolution;			///< hologram resolution
+		int nLayers;				///< depth layers of the depth-map / IFTA generators
+		int nChannels;				///< wavelengths, 1 or 3
+		int nThreads;				///< OpenMP threads, 0 : default
+		int repeat;					///< timed runs per case
+		int warmup;					///< untimed runs per case before the timed ones
+		std::string workDir;		///< directory of the synthetic input files
+		std::string filter;			///< run only the cases whose name contains it
+
+		BenchmarkConfig()
+			: seed(1234), nPoints(10000), resolution(1024, 1024), nLayers(64), nChannels(1)
+			, nThreads(0), repeat(3), warmup(1), workDir("benchmark") {}
+	};
+
+	/**
+	* @brief Result of a benchmark case, times are seconds per run.
+	*/
+	struct OPH_DLL BenchmarkResult {
+		std::string name;
+		std::string unit;
+		bool bOK;
+		ulonglong work;					///< units processed by one run
+		int repeat;
+		Real mean;
+		Real min;
+		Real max;
+		Real throughput;				///< units per second of the mean run
+		std::vector<ProfileStage> stages;	///< per-run stage times of the profiler
+	};
+
+	/**
+	* @brief Runner of reproducible benchmark cases.
+	* @details A case is a prepare step (untimed, loads the synthetic input), a timed run returning the work
+	*			units it processed and an optional cleanup. Every run is also recorded by the Profiler, so
+	*			a result carries the time per stage (load, fft, propagate, encode...) next to the total.@n
+	*			Modules add their cases to the runner, e.g. ophGenBenchmark::addCases. The benchmark project of the
+	*			solution runs every case from the command line.
+	*/
+	class OPH_DLL Benchmark
+	{
+	public:
+		typedef std::function<bool(void)> Prepare;
+		typedef std::function<ulonglong(void)> Run;
+		typedef std::function<void(void)> Cleanup;
+
+		explicit Benchmark(const BenchmarkConfig& config);
+
+		const BenchmarkConfig& getConfig(void) const { return config; }
+
+		/**
+		* @param[in] unit of the work returned by run, e.g. "points", "pixels"
+		*/
+		void add(const char* name, const char* unit, Prepare prepare, Run run, Cleanup cleanup = nullptr);
+
+		/**
+		* @brief Run every case matching the filter, in the order they were added.
+		* @return Type: <B>bool</B>\n
+		*				If every case succeeded, the return value is <B>true</B>.
+		*/
+		bool run(void);
+
+		const std::vector<BenchmarkResult>& getResults(void) const { return results; }
+
+		/**
+		* @brief Write the configuration, the host and the results as JSON for regression tracking.
+		*/
+		bool exportJSON(const char* fname);
+		/**
+		* @brief Write one line per case : name, unit, work, repeat, mean, min, max, throughput.
+		*/
+		bool exportCSV(const char* fname);
+
+		/**
+		* @brief Seeded points in [-1, 1]^3 with nChannels amplitudes in [0, 1].
+		*/
+		static void randomPoints(uint seed, ulonglong n, int nChannels, std::vector<Real>& vertex, std::vector<Real>& color);
+		/**
+		* @brief Seeded 8-bit image : smooth pattern plus noise, depth maps use nNoise = 0.
+		*/
+		static void syntheticImage(uint seed, int width, int height, int nNoise, std::vector<uchar>& image);
+		static bool makeDirectory(const char* dir);
+
+	private:
+		struct Case {
+			std::string name;
+			std::string unit;
+			Prepare prepare;
+			Run run;
+			Cleanup cleanup;
+		};
+
+		BenchmarkConfig config;
+		std::vector<Case> cases;
+		std::vector<BenchmarkResult> results;
+	};
+}
+
+#endif // !__Benchmark_h
@@ -0,0 +1,162 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __FileView_h
+#define __FileView_h
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "typedef.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace oph
+{
+	/**
+	* @brief Read-only view of a whole file, memory-mapped when possible and read at once otherwise.
+	*/
+	class FileView {
+	public:
+		FileView() : base(nullptr), size(0), hFile(nullptr), hMapping(nullptr), fd(-1) {}
+		~FileView() { release(); }
+
+		bool open(const std::string& fileName)
+		{
+			release();
+#ifdef _WIN32
+			HANDLE hF = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (hF != INVALID_HANDLE_VALUE) {
+				LARGE_INTEGER li;
+				if (GetFileSizeEx(hF, &li) && li.QuadPart > 0) {
+					HANDLE hM = CreateFileMappingA(hF, nullptr, PAGE_READONLY, 0, 0, nullptr);
+					if (hM != nullptr) {
+						void* view = MapViewOfFile(hM, FILE_MAP_READ, 0, 0, 0);
+						if (view != nullptr) {
+							base = (const uchar*)view;
+							size = (size_t)li.QuadPart;
+							hFile = hF;
+							hMapping = hM;
+							return true;
+						}
+						CloseHandle(hM);
+					}
+				}
+				CloseHandle(hF);
+			}
+#else
+			int f = ::open(fileName.c_str(), O_RDONLY);
+			if (f >= 0) {
+				struct stat st;
+				if (fstat(f, &st) == 0 && st.st_size > 0) {
+					void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+					if (view != MAP_FAILED) {
+						madvise(view, st.st_size, MADV_SEQUENTIAL);
+						base = (const uchar*)view;
+						size = (size_t)st.st_size;
+						fd = f;
+						return true;
+					}
+				}
+				::close(f);
+			}
+#endif
+			// fallback : a single bulk read.
+			std::ifstream File(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+			if (!File.is_open()) return false;
+			size = (size_t)File.tellg();
+			buffer.resize(size);
+			File.seekg(0, std::ios::beg);
+			File.read((char*)buffer.data(), size);
+			if ((size_t)File.gcount() != size) {
+				buffer.clear();
+				size = 0;
+				return false;
+			}
+			base = buffer.data();
+			return true;
+		}
+
+		void release()
+		{
+			if (base != nullptr && buffer.empty()) {
+#ifdef _WIN32
+				UnmapViewOfFile(base);
+				if (hMapping) CloseHandle((HANDLE)hMapping);
+				if (hFile) CloseHandle((HANDLE)hFile);
+#else
+				munmap((void*)base, size);
+				if (fd >= 0) ::close(fd);
+#endif
+			}
+			buffer.clear();
+			base = nullptr;
+			size = 0;
+			hFile = nullptr;
+			hMapping = nullptr;
+			fd = -1;
+		}
+
+		const uchar* data() const { return base; }
+		size_t length() const { return size; }
+
+	private:
+		const uchar* base;
+		size_t size;
+		std::vector<uchar> buffer;
+		void* hFile;
+		void* hMapping;
+		int fd;
+	};
+}
+
+#endif // !__FileView_h
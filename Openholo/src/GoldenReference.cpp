@@ -0,0 +1,282 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "GoldenReference.h"
+#include "sys.h"
+#include "fftw3.h"
+#include "ophFFT.h"
+#include <cstring>
+
+using namespace oph;
+
+namespace {
+	const char GOLDEN_MAGIC[4] = { 'O', 'P', 'H', 'G' };
+	const int GOLDEN_VERSION = 1;
+
+	struct GoldenHeader {
+		char magic[4];
+		int version;
+		int realSize;
+		int bComplex;
+		int nChannels;
+		int width;
+		int height;
+	};
+}
+
+const Real GoldenReference::PSNR_MAX = 300.0;
+
+bool GoldenReference::save(const char* fname, Complex<Real>** field, int nChannels, ivec2 size)
+{
+	return write(fname, (const void* const*)field, sizeof(Complex<Real>), true, nChannels, size);
+}
+
+bool GoldenReference::save(const char* fname, Real** data, int nChannels, ivec2 size)
+{
+	return write(fname, (const void* const*)data, sizeof(Real), false, nChannels, size);
+}
+
+bool GoldenReference::load(const char* fname, std::vector<Complex<Real>>& field, int& nChannels, ivec2& size)
+{
+	std::vector<char> data;
+	if (!read(fname, data, sizeof(Complex<Real>), true, nChannels, size)) return false;
+	field.resize(data.size() / sizeof(Complex<Real>));
+	memcpy(field.data(), data.data(), data.size());
+	return true;
+}
+
+bool GoldenReference::load(const char* fname, std::vector<Real>& data, int& nChannels, ivec2& size)
+{
+	std::vector<char> raw;
+	if (!read(fname, raw, sizeof(Real), false, nChannels, size)) return false;
+	data.resize(raw.size() / sizeof(Real));
+	memcpy(data.data(), raw.data(), raw.size());
+	return true;
+}
+
+bool GoldenReference::write(const char* fname, const void* const* data, size_t elemSize, bool bComplex, int nChannels, ivec2 size)
+{
+	if (data == nullptr) {
+		LOG("<FAILED> Golden reference without data : %s\n", fname);
+		return false;
+	}
+	FILE* fp = fopen(fname, "wb");
+	if (fp == nullptr) {
+		LOG("<FAILED> Save golden reference : %s\n", fname);
+		return false;
+	}
+
+	GoldenHeader header;
+	memcpy(header.magic, GOLDEN_MAGIC, sizeof(GOLDEN_MAGIC));
+	header.version = GOLDEN_VERSION;
+	header.realSize = (int)sizeof(Real);
+	header.bComplex = bComplex ? 1 : 0;
+	header.nChannels = nChannels;
+	header.width = size[_X];
+	header.height = size[_Y];
+	fwrite(&header, sizeof(GoldenHeader), 1, fp);
+
+	const size_t n = (size_t)size[_X] * size[_Y];
+	for (int ch = 0; ch < nChannels; ch++)
+		fwrite(data[ch], elemSize, n, fp);
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool GoldenReference::read(const char* fname, std::vector<char>& data, size_t elemSize, bool bComplex, int& nChannels, ivec2& size)
+{
+	FILE* fp = fopen(fname, "rb");
+	if (fp == nullptr) {
+		LOG("<FAILED> Load golden reference : %s\n", fname);
+		return false;
+	}
+
+	GoldenHeader header;
+	if (fread(&header, sizeof(GoldenHeader), 1, fp) != 1 || memcmp(header.magic, GOLDEN_MAGIC, sizeof(GOLDEN_MAGIC)) ||
+		header.version != GOLDEN_VERSION || header.realSize != (int)sizeof(Real) || header.bComplex != (bComplex ? 1 : 0) ||
+		header.nChannels < 1 || header.width < 1 || header.height < 1) {
+		LOG("<FAILED> Not a golden reference of this build : %s\n", fname);
+		fclose(fp);
+		return false;
+	}
+
+	nChannels = header.nChannels;
+	size[_X] = header.width;
+	size[_Y] = header.height;
+	const size_t n = (size_t)header.width * header.height * header.nChannels;
+	data.resize(n * elemSize);
+	bool bOK = fread(data.data(), elemSize, n, fp) == n;
+	fclose(fp);
+	if (!bOK) LOG("<FAILED> Truncated golden reference : %s\n", fname);
+	return bOK;
+}
+
+Real GoldenReference::relativeL2(const Complex<Real>* ref, const Complex<Real>* test, ulonglong n)
+{
+	Real diff = 0, norm = 0;
+	for (ulonglong i = 0; i < n; i++) {
+		Real re = test[i]._Val[_RE] - ref[i]._Val[_RE];
+		Real im = test[i]._Val[_IM] - ref[i]._Val[_IM];
+		diff += re * re + im * im;
+		norm += ref[i].mag2();
+	}
+	if (norm == 0) return diff == 0 ? 0 : sqrt(diff);
+	return sqrt(diff / norm);
+}
+
+Real GoldenReference::relativeL2(const Real* ref, const Real* test, ulonglong n)
+{
+	Real diff = 0, norm = 0;
+	for (ulonglong i = 0; i < n; i++) {
+		diff += (test[i] - ref[i]) * (test[i] - ref[i]);
+		norm += ref[i] * ref[i];
+	}
+	if (norm == 0) return diff == 0 ? 0 : sqrt(diff);
+	return sqrt(diff / norm);
+}
+
+Real GoldenReference::psnr(const Real* ref, const Real* test, ulonglong n)
+{
+	if (n == 0) return PSNR_MAX;
+
+	Real peak = 0, mse = 0;
+	for (ulonglong i = 0; i < n; i++) {
+		if (fabs(ref[i]) > peak) peak = fabs(ref[i]);
+		mse += (test[i] - ref[i]) * (test[i] - ref[i]);
+	}
+	mse /= n;
+	if (mse == 0) return PSNR_MAX;
+	if (peak == 0) return 0;
+
+	Real ret = 10 * log10(peak * peak / mse);
+	return ret < PSNR_MAX ? ret : PSNR_MAX;
+}
+
+Real GoldenReference::maxPhaseError(const Complex<Real>* ref, const Complex<Real>* test, ulonglong n, Real threshold)
+{
+	Real peak = 0;
+	for (ulonglong i = 0; i < n; i++)
+		if (ref[i].mag2() > peak) peak = ref[i].mag2();
+
+	// compared on the squared amplitudes.
+	const Real limit = peak * threshold * threshold;
+	Real maxError = 0;
+	for (ulonglong i = 0; i < n; i++) {
+		if (ref[i].mag2() <= limit) continue;
+		// arg(test * conj(ref)) is the phase difference wrapped to [-pi, pi].
+		Real re = test[i]._Val[_RE] * ref[i]._Val[_RE] + test[i]._Val[_IM] * ref[i]._Val[_IM];
+		Real im = test[i]._Val[_IM] * ref[i]._Val[_RE] - test[i]._Val[_RE] * ref[i]._Val[_IM];
+		Real error = fabs(atan2(im, re));
+		if (error > maxError) maxError = error;
+	}
+	return maxError;
+}
+
+void GoldenReference::reconstruct(const Complex<Real>* field, ivec2 size, std::vector<Real>& intensity)
+{
+	const int n = size[_X] * size[_Y];
+	fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * n);
+	fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * n);
+	fftw_plan plan;
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		plan = fftw_plan_dft_2d(size[_Y], size[_X], in, out, OPH_FORWARD, OPH_ESTIMATE);
+	}
+
+	for (int i = 0; i < n; i++) {
+		in[i][_RE] = field[i]._Val[_RE];
+		in[i][_IM] = field[i]._Val[_IM];
+	}
+	fftw_execute(plan);
+
+	intensity.resize(n);
+	for (int i = 0; i < n; i++)
+		intensity[i] = (Real)((out[i][_RE] * out[i][_RE] + out[i][_IM] * out[i][_IM]) / n);
+
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(plan);
+	}
+	fftw_free(in);
+	fftw_free(out);
+}
+
+bool GoldenReference::check(GoldenError& error)
+{
+	const GoldenTolerance& tol = error.tolerance;
+	error.bPass =
+		(tol.relL2 < 0 || error.relL2 <= tol.relL2) &&
+		(tol.psnr < 0 || error.psnr >= tol.psnr) &&
+		(tol.phase < 0 || error.phase <= tol.phase);
+	return error.bPass;
+}
+
+bool GoldenReference::exportJSON(const char* fname, const std::vector<GoldenError>& errors)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) {
+		LOG("<FAILED> Export golden comparison : %s\n", fname);
+		return false;
+	}
+
+	bool bPass = true;
+	for (auto& e : errors) bPass = bPass && e.bPass;
+
+	fprintf(fp, "{\n\t\"pass\": %s,\n\t\"real\": \"%s\",\n\t\"results\": [", bPass ? "true" : "false",
+		sizeof(Real) == sizeof(double) ? "double" : "float");
+	for (size_t i = 0; i < errors.size(); i++) {
+		const GoldenError& e = errors[i];
+		fprintf(fp, "%s\n\t\t{ \"name\": \"%s\", \"pass\": %s, \"relL2\": %.6e, \"psnr\": %.3f, \"phase\": %.6e,\n\t\t  \"tolerance\": { \"relL2\": %.6e, \"psnr\": %.3f, \"phase\": %.6e } }",
+			i ? "," : "", e.name.c_str(), e.bPass ? "true" : "false", e.relL2, e.psnr, e.phase,
+			e.tolerance.relL2, e.tolerance.psnr, e.tolerance.phase);
+	}
+	fprintf(fp, "\n\t]\n}\n");
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
@@ -0,0 +1,135 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __GoldenReference_h
+#define __GoldenReference_h
+
+#include "include.h"
+#include "ivec.h"
+
+#ifdef OPH_EXPORT
+#define OPH_DLL __declspec(dllexport)
+#else
+#define OPH_DLL __declspec(dllimport)
+#endif
+
+namespace oph
+{
+	/**
+	* @brief Limits of a comparison against a golden reference, a negative limit is not checked.
+	*/
+	struct OPH_DLL GoldenTolerance {
+		Real relL2;		///< max relative L2 error
+		Real psnr;		///< min PSNR of the reconstructed intensity [dB]
+		Real phase;		///< max phase error [rad]
+
+		GoldenTolerance(Real relL2 = 1e-6, Real psnr = 80.0, Real phase = 1e-4)
+			: relL2(relL2), psnr(psnr), phase(phase) {}
+	};
+
+	/**
+	* @brief Errors of a buffer against its golden reference, the worst channel is kept.
+	*/
+	struct OPH_DLL GoldenError {
+		std::string name;
+		bool bPass;
+		Real relL2;
+		Real psnr;
+		Real phase;					///< 0 for real buffers
+		GoldenTolerance tolerance;
+	};
+
+	/**
+	* @brief Golden references of the hologram buffers (complex field or encoded real data).
+	* @details A reference is captured once from the reference CPU implementation, an optimized kernel is
+	*			then compared with it by the relative L2 error, the PSNR of the reconstructed intensity and the
+	*			max phase error.@n
+	*			File : "OPHG", version, sizeof(Real), complex flag, channels, width, height, then the channels.
+	*/
+	class OPH_DLL GoldenReference
+	{
+	public:
+		static const Real PSNR_MAX;		///< PSNR of identical buffers
+
+		static bool save(const char* fname, Complex<Real>** field, int nChannels, ivec2 size);
+		static bool save(const char* fname, Real** data, int nChannels, ivec2 size);
+		/**
+		* @param[out] field channels one after another
+		*/
+		static bool load(const char* fname, std::vector<Complex<Real>>& field, int& nChannels, ivec2& size);
+		static bool load(const char* fname, std::vector<Real>& data, int& nChannels, ivec2& size);
+
+		/**
+		* @brief ||test - ref|| / ||ref||, 0 when both are zero.
+		*/
+		static Real relativeL2(const Complex<Real>* ref, const Complex<Real>* test, ulonglong n);
+		static Real relativeL2(const Real* ref, const Real* test, ulonglong n);
+		/**
+		* @brief PSNR of test with the peak of ref, e.g. on the intensities of both reconstructions.
+		*/
+		static Real psnr(const Real* ref, const Real* test, ulonglong n);
+		/**
+		* @brief Max |arg(test / ref)| over the samples whose reference amplitude is above threshold x the peak,
+		*		where the phase is meaningful.
+		*/
+		static Real maxPhaseError(const Complex<Real>* ref, const Complex<Real>* test, ulonglong n, Real threshold = 1e-3);
+		/**
+		* @brief Intensity of the Fourier-plane reconstruction of a field, in the FFT order.
+		*/
+		static void reconstruct(const Complex<Real>* field, ivec2 size, std::vector<Real>& intensity);
+
+		/**
+		* @brief Set error.bPass from its tolerance.
+		*/
+		static bool check(GoldenError& error);
+		static bool exportJSON(const char* fname, const std::vector<GoldenError>& errors);
+
+	private:
+		static bool write(const char* fname, const void* const* data, size_t elemSize, bool bComplex, int nChannels, ivec2 size);
+		static bool read(const char* fname, std::vector<char>& data, size_t elemSize, bool bComplex, int& nChannels, ivec2& size);
+	};
+}
+
+#endif // !__GoldenReference_h
@@ -94,6 +94,7 @@ namespace oph
 		Float32 = 9,	/* Single precision floating */
 		Float64 = 10,	/* Double precision floating */
 		CmprFmt = 11,	/* Compressed Image File */
+		Float16 = 12,	/* Half precision floating : stored only, decoded to Float32 */
 	};
 
 	/* Field Store Type */
@@ -101,6 +102,7 @@ namespace oph
 		Null = 0,	/* Null Data */
 		Directly = 1,	/* Field data is directly stored at the 'Field Data' region. */
 		LinkFile = 2,	/* Field data is stored at separate files and they are referred by path. 'Field Data' region stores those file paths. */
+		Tiled = 3,	/* Field data is stored as tiles. 'Field Data' region starts with ohcTileHeader and the tile index table. */
 	};
 
 	/* Encoding Type of Field Data Domain */
@@ -128,6 +130,7 @@ namespace oph
 		PNG = 4,	/* PNG (png, pns) */
 		GIF = 5,	/* GIF (gif) */
 		TIF = 6,	/* TIFF (tif, tiff) */
+		Deflate = 7,	/* Lossless deflate chunks of raw field data. Requires build with _USE_ZLIB */
 	};
 
 
@@ -198,12 +201,64 @@ namespace oph
 			this->comprsType = CompresType::Null;
 		}
 	};
+
+	/* Chunk table entry : 'Field Data' region starts with this table when field data is stored as compressed chunks.
+	   Chunk index is (component * wavlenNum + wavelength), each chunk holds one component plane of one wavelength. */
+	struct ohcChunkEntry {
+		uint64_t	offset;			/* Address of chunk from the start of 'Field Data' region */
+		uint64_t	size;			/* Stored(compressed) size of chunk(in byte) */
+		uint64_t	rawSize;		/* Decompressed size of chunk(in byte) */
+
+		ohcChunkEntry() {
+			this->offset = 0;
+			this->size = 0;
+			this->rawSize = 0;
+		}
+	};
+
+	/* Header of tiled field data : followed by the tile index table of (tileNumX * tileNumY * wavlenNum * components) ohcChunkEntry.
+	   Tile index is ((component * wavlenNum + wavelength) * tileNumY + tileY) * tileNumX + tileX.
+	   Field is pxNumY rows of pxNumX pixels, and pixels in a tile are stored row by row. Edge tiles are cut to the field. */
+	struct ohcTileHeader {
+		uint32_t	tileSizeX;		/* Number of pixels of a tile in x-direction */
+		uint32_t	tileSizeY;		/* Number of pixels of a tile in y-direction */
+		uint32_t	tileNumX;		/* Number of tiles in x-direction */
+		uint32_t	tileNumY;		/* Number of tiles in y-direction */
+
+		ohcTileHeader() {
+			this->tileSizeX = 0;
+			this->tileSizeY = 0;
+			this->tileNumX = 0;
+			this->tileNumY = 0;
+		}
+	};
 #pragma pack(pop)
 	struct ohcHeader {
 		ohcFileHeader			fileHeader;
 		ohcFieldInfoHeader		fieldInfo;
 		std::vector<double_t>	wavlenTable; /* Wavelength : Scalable Data Size(8/24/8n). When 'clrType' is RGB, wavelengths of red, green, and blue are stored sequentially; When 'clrType' is MLT, size of this field is 8*n bytes, where 'n' is the 'wavlenNum'. */
 	};
+
+	/* Read-only view of one wavelength channel inside the field data region of an opened OHC file. */
+	struct ohcFieldView {
+		DataType	dataType;		/* Float32 or Float64 */
+		FldCodeType	fldCodeType;	/* Meaning of comp0/comp1 : RI, AP, AE or PE */
+		const void*	comp0;			/* First component(Real, Amplitude or Phase) of the first pixel */
+		const void*	comp1;			/* Second component(Imaginary or Phase) of the first pixel. nullptr for AE, PE */
+		uint64_t	stride;			/* Distance between adjacent pixels in elements : 1 for EachChanl, wavlenNum for SeqtChanl */
+		uint32_t	pxNumX;			/* Number of pixels in x-direction */
+		uint32_t	pxNumY;			/* Number of pixels in y-direction */
+
+		ohcFieldView() {
+			this->dataType = DataType::Null;
+			this->fldCodeType = FldCodeType::Null;
+			this->comp0 = nullptr;
+			this->comp1 = nullptr;
+			this->stride = 0;
+			this->pxNumX = 0;
+			this->pxNumY = 0;
+		}
+	};
 }
 
 #endif
\ No newline at end of file
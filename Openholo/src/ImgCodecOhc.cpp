@@ -49,6 +49,19 @@
 
 #include "sys.h"
 #include <limits> // limit value of each data types
+#include <omp.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _USE_ZLIB
+#include <zlib.h>
+#endif
 
 
 //hot key for call by this pointer
@@ -57,6 +70,64 @@
 #define WavLeng this->Header->wavlenTable
 
 
+/************************ Half precision *****************************/
+
+static inline uint16_t floatToHalf(float f)
+{
+	uint32_t x;
+	std::memcpy(&x, &f, sizeof(x));
+
+	uint32_t sign = (x >> 16) & 0x8000;
+	uint32_t expo = (x >> 23) & 0xff;
+	uint32_t mant = x & 0x7fffff;
+
+	if (expo == 0xff) // Inf, NaN
+		return (uint16_t)(sign | 0x7c00 | (mant ? 0x200 : 0));
+
+	int e = (int)expo - 127 + 15;
+	if (e >= 31) // overflow
+		return (uint16_t)(sign | 0x7c00);
+
+	if (e <= 0) { // subnormal or zero
+		if (e < -10) return (uint16_t)sign;
+		mant |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - e);
+		uint32_t h = mant >> shift;
+		uint32_t rem = mant & ((1u << shift) - 1);
+		uint32_t half = 1u << (shift - 1);
+		if (rem > half || (rem == half && (h & 1))) h++;
+		return (uint16_t)(sign | h);
+	}
+
+	// round to nearest even. a carry into the exponent is still a valid half.
+	uint32_t h = sign | ((uint32_t)e << 10) | (mant >> 13);
+	uint32_t rem = mant & 0x1fff;
+	if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) h++;
+	return (uint16_t)h;
+}
+
+static inline float halfToFloat(uint16_t h)
+{
+	uint32_t sign = ((uint32_t)h & 0x8000) << 16;
+	uint32_t expo = (h >> 10) & 0x1f;
+	uint32_t mant = h & 0x3ff;
+	uint32_t x;
+
+	if (expo == 0) {
+		float v = std::ldexp((float)mant, -24);
+		return sign ? -v : v;
+	}
+	else if (expo == 31)
+		x = sign | 0x7f800000 | (mant << 13);
+	else
+		x = sign | ((expo + 112) << 23) | (mant << 13);
+
+	float f;
+	std::memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+
 /************************ OHC CODEC *****************************/
 
 oph::ImgCodecOhc::ImgCodecOhc() {
@@ -193,6 +264,7 @@ oph::ImgDecoderOhc::ImgDecoderOhc(const std::string &_fname, const ohcHeader &_H
 
 oph::ImgDecoderOhc::~ImgDecoderOhc()
 {
+	this->close();
 	this->releaseOHCheader();
 	this->releaseFldData();
 	this->releaseCodeBuffer();
@@ -304,48 +376,54 @@ void oph::ImgDecoderOhc::getLinkFilePath(std::vector<std::string> &linkFilePath_
 		linkFilePath_array = this->linkFilePath;
 }
 
+bool oph::ImgDecoderOhc::readHeader(void) {
+	if (this->Header == nullptr)
+		this->Header = new ohcHeader();
+
+	// Read OHC File Header
+	File.read((char *)&FHeader.fileSignature, sizeof(FHeader.fileSignature));
+	if ((FHeader.fileSignature[0] != FMT_SIGN_OHC[0]) || (FHeader.fileSignature[1] != FMT_SIGN_OHC[1])) {
+		LOG("Not OHC File");
+		return false;
+	}
+	else {
+		File.seekg(ios::beg); // Move file pointer
+		File.read((char *)&FHeader, sizeof(FHeader));
+		printf("Reading Openholo Complex Field File...\n%s\n", fname.c_str());
+		printf("OHC File was made on OpenHolo version v%x.%x...\n", FHeader.fileVersionMajor, FHeader.fileVersionMinor);
+	}
+
+	// Read Field Info Header
+	File.read((char *)&FldInfo, sizeof(FldInfo));
+	if (FldInfo.fldSize == 0) {
+		LOG("Error : No Field Data");
+		return false;
+	}
+
+	// Read Wavelength Table
+	WavLeng.clear();
+	WavLeng.resize(FldInfo.wavlenNum);
+	File.read((char *)WavLeng.data(), sizeof(double_t) * FldInfo.wavlenNum);
+
+	return true;
+}
+
 bool oph::ImgDecoderOhc::load() {
 	this->File.open(this->fname, std::ios::in | std::ios::binary);
 
 	bool isOpen = File.is_open();
 	if (this->File.is_open()) {
-		if (this->Header == nullptr)
-			this->Header = new ohcHeader();
-
-
-		// Read OHC File Header
-		File.read((char *)&FHeader.fileSignature, sizeof(FHeader.fileSignature));
-		if ((FHeader.fileSignature[0] != FMT_SIGN_OHC[0]) || (FHeader.fileSignature[1] != FMT_SIGN_OHC[1])) {
-			LOG("Not OHC File");
-			return false;
-		}
-		else {
-			File.seekg(ios::beg); // Move file pointer
-			File.read((char *)&FHeader, sizeof(FHeader));
-			printf("Reading Openholo Complex Field File...\n%s\n", fname.c_str());
-			printf("OHC File was made on OpenHolo version v%x.%x...\n", FHeader.fileVersionMajor, FHeader.fileVersionMinor);
-		}
-
-		// Read Field Info Header
-		File.read((char *)&FldInfo, sizeof(FldInfo));
-		if (FldInfo.fldSize == 0) {
-			LOG("Error : No Field Data");
+		if (!readHeader()) {
 			this->File.close();
 			return false;
 		}
 
-		// Read Wavelength Table
-		for (uint n = 0; n < FldInfo.wavlenNum; ++n) {
-			double_t waveLength = 0.0;
-			File.read((char *)&waveLength, sizeof(waveLength));
-			WavLeng.push_back(waveLength);
-		}
-
 		// Decoding Field Data
 		bool ok = false;
 		switch (FldInfo.cmplxFldType) {
 		case DataType::Float64:
 		case DataType::Float32:
+		case DataType::Float16:
 			ok = decodeFieldData();
 			break;
 		case DataType::CmprFmt:
@@ -359,48 +437,10 @@ bool oph::ImgDecoderOhc::load() {
 			return false;
 			break;
 		}
-		//switch (FldInfo.cmplxFldType) {
-		//case DataType::Float64:
-		//	ok = decodeFieldData<double_t>();
-		//	break;
-		//case DataType::Float32:
-		//	ok = decodeFieldData<float_t>();
-		//	break;
-		//case DataType::Int8:
-		//	ok = decodeFieldData<int8_t>();
-		//	break;
-		//case DataType::Int16:
-		//	ok = decodeFieldData<int16_t>();
-		//	break;
-		//case DataType::Int32:
-		//	ok = decodeFieldData<int32_t>();
-		//	break;
-		//case DataType::Int64:
-		//	ok = decodeFieldData<int64_t>();
-		//	break;
-		//case DataType::Uint8:
-		//	ok = decodeFieldData<uint8_t>();
-		//	break;
-		//case DataType::Uint16:
-		//	ok = decodeFieldData<uint16_t>();
-		//	break;
-		//case DataType::Uint32:
-		//	ok = decodeFieldData<uint32_t>();
-		//	break;
-		//case DataType::Uint64:
-		//	ok = decodeFieldData<uint64_t>();
-		//	break;
-		//case DataType::CmprFmt:
-		//	LOG("Error : Compressed Image Format Decoding is Not Yet supported...");
-		//	this->File.close();
-		//	return false;
-		//	break;
-		//default:
-		//	LOG("Error : Invalid Decoding Complex Field Data Type...");
-		//	this->File.close();
-		//	return false;
-		//	break;
-		//}
+		if (!ok) {
+			this->File.close();
+			return false;
+		}
 
 		this->bLoadFile = true;
 		this->File.close();
@@ -412,6 +452,529 @@ bool oph::ImgDecoderOhc::load() {
 	}
 }
 
+bool oph::ImgDecoderOhc::open() {
+	this->close();
+
+	this->File.open(this->fname, std::ios::in | std::ios::binary);
+	if (!this->File.is_open()) {
+		LOG("Error : Failed loading OHC file...");
+		return false;
+	}
+	if (!readHeader()) {
+		this->File.close();
+		return false;
+	}
+	if (FldInfo.fldStore == FldStore::LinkFile) {
+		LOG("Error : Link Image File Decoding is Not Yet supported...\n");
+		this->File.close();
+		return false;
+	}
+	if (FldInfo.cmplxFldType != DataType::Float32 && FldInfo.cmplxFldType != DataType::Float64 && FldInfo.cmplxFldType != DataType::Float16) {
+		LOG("Error : Invalid Decoding Complex Field Data Type...");
+		this->File.close();
+		return false;
+	}
+
+	uint64_t offset = FHeader.fileOffBytes;
+	if (offset == (uint32_t)-1 || offset == 0)
+		offset = sizeof(ohcFileHeader) + FldInfo.headerSize;
+
+	File.seekg(0, ios::end);
+	uint64_t fileSize = (uint64_t)File.tellg();
+	if (offset + FldInfo.fldSize > fileSize) {
+		LOG("Error : Truncated OHC file...");
+		this->File.close();
+		return false;
+	}
+
+	// Directly stored planes are read through views, so fldSize must hold every plane the header implies.
+	if (FldInfo.fldStore != FldStore::Tiled && FldInfo.comprsType != CompresType::Deflate) {
+		uint64_t n_cmplxChnl = 0;
+		if ((FldInfo.fldCodeType == FldCodeType::AP) || (FldInfo.fldCodeType == FldCodeType::RI))
+			n_cmplxChnl = 2;
+		else if ((FldInfo.fldCodeType == FldCodeType::AE) || (FldInfo.fldCodeType == FldCodeType::PE))
+			n_cmplxChnl = 1;
+		const uint64_t elemSize = (FldInfo.cmplxFldType == DataType::Float16) ? sizeof(uint16_t) :
+			(FldInfo.cmplxFldType == DataType::Float32) ? sizeof(float) : sizeof(double);
+		const uint64_t n_elems = (uint64_t)FldInfo.pxNumX * FldInfo.pxNumY * FldInfo.wavlenNum * n_cmplxChnl;
+		if (n_elems == 0 || FldInfo.fldSize < n_elems * elemSize) {
+			LOG("Error : Field size of OHC file is smaller than its header implies...");
+			this->File.close();
+			return false;
+		}
+	}
+
+	// Tiled : only the tile table is read now, tiles are read on demand by decodeRegion().
+	if (FldInfo.fldStore == FldStore::Tiled) {
+		File.seekg(offset, ios::beg);
+		if (!readChunkTable()) {
+			this->File.close();
+			return false;
+		}
+		this->bLoadFile = true;
+		return true;
+	}
+
+	// Map the whole file and point at the field region. Packed data(Float16, compressed) is expanded instead.
+	const bool bPacked = (FldInfo.cmplxFldType == DataType::Float16) || (FldInfo.comprsType == CompresType::Deflate);
+	if (!bPacked) {
+#ifdef _WIN32
+		HANDLE hFile = CreateFileA(this->fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (hFile != INVALID_HANDLE_VALUE) {
+			HANDLE hMap = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (hMap != nullptr) {
+				void* base = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+				if (base != nullptr) {
+					this->mapBase = (const uchar*)base;
+					this->hMapping = hMap;
+				}
+				else
+					CloseHandle(hMap);
+			}
+			if (this->mapBase != nullptr)
+				this->hMapFile = hFile;
+			else
+				CloseHandle(hFile);
+		}
+#else
+		int fd = ::open(this->fname.c_str(), O_RDONLY);
+		if (fd >= 0) {
+			void* base = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (base != MAP_FAILED) {
+				madvise(base, fileSize, MADV_SEQUENTIAL);
+				this->mapBase = (const uchar*)base;
+				this->mapFd = fd;
+			}
+			else
+				::close(fd);
+		}
+#endif
+	}
+
+	if (this->mapBase != nullptr) {
+		this->mapSize = fileSize;
+		this->fieldBase = this->mapBase + offset;
+		this->fieldType = FldInfo.cmplxFldType;
+	}
+	else {
+		// Fall back to one bulk read of the field region.
+		File.seekg(offset, ios::beg);
+		if (!readFieldData()) {
+			this->File.close();
+			return false;
+		}
+		this->fieldBase = (this->fieldType == DataType::Float32) ? (const uchar*)this->buf_f32 : (const uchar*)this->buf_f64;
+	}
+	this->File.close();
+
+	this->bLoadFile = true;
+	return true;
+}
+
+void oph::ImgDecoderOhc::close() {
+	if (this->mapBase != nullptr) {
+#ifdef _WIN32
+		UnmapViewOfFile(this->mapBase);
+		if (this->hMapping) CloseHandle((HANDLE)this->hMapping);
+		if (this->hMapFile) CloseHandle((HANDLE)this->hMapFile);
+#else
+		munmap((void*)this->mapBase, this->mapSize);
+		if (this->mapFd >= 0) ::close(this->mapFd);
+#endif
+	}
+	else if (this->fieldBase != nullptr)
+		this->releaseCodeBuffer();
+
+	if (this->File.is_open())
+		this->File.close();
+	this->chunkTable.clear();
+	this->tileHeader = ohcTileHeader();
+
+	this->mapBase = nullptr;
+	this->fieldBase = nullptr;
+	this->fieldType = DataType::Null;
+	this->mapSize = 0;
+	this->hMapping = nullptr;
+	this->hMapFile = nullptr;
+	this->mapFd = -1;
+}
+
+bool oph::ImgDecoderOhc::getFieldView(ohcFieldView &view, uint wavelen_idx) {
+	if (this->isTiled()) {
+		LOG("OHC CODEC Error : Tiled field data has no contiguous view.");
+		return false;
+	}
+	if (this->Header == nullptr || this->fieldBase == nullptr) {
+		LOG("OHC CODEC Error : No opened data.");
+		return false;
+	}
+	if (wavelen_idx >= FldInfo.wavlenNum) {
+		LOG("OHC CODEC Error : Invalid wavelength index.");
+		return false;
+	}
+
+	const uint64_t n_wavlens = FldInfo.wavlenNum;
+	const uint64_t n_pixels = (uint64_t)FldInfo.pxNumX * FldInfo.pxNumY;
+	const uint64_t n_fields = n_pixels * n_wavlens;
+	const uint64_t elemSize = (this->fieldType == DataType::Float32) ? sizeof(float) : sizeof(double);
+
+	uint64_t first = 0;
+	if (FldInfo.clrArrange == ColorArran::SeqtChanl && FldInfo.comprsType != CompresType::Deflate) {
+		first = wavelen_idx;
+		view.stride = n_wavlens;
+	}
+	else {
+		first = wavelen_idx * n_pixels;
+		view.stride = 1;
+	}
+
+	view.dataType = this->fieldType;
+	view.fldCodeType = FldInfo.fldCodeType;
+	view.pxNumX = FldInfo.pxNumX;
+	view.pxNumY = FldInfo.pxNumY;
+	view.comp0 = this->fieldBase + first * elemSize;
+	if ((FldInfo.fldCodeType == FldCodeType::RI) || (FldInfo.fldCodeType == FldCodeType::AP))
+		view.comp1 = this->fieldBase + (first + n_fields) * elemSize;
+	else
+		view.comp1 = nullptr;
+
+	return true;
+}
+
+template<typename T>
+static void decodeView(const oph::ohcFieldView &view, oph::Complex<Real>* dst)
+{
+	const T* c0 = (const T*)view.comp0;
+	const T* c1 = (const T*)view.comp1;
+	const long long stride = (long long)view.stride;
+	const long long n_pixels = (long long)view.pxNumX * view.pxNumY;
+	long long i;
+
+	switch (view.fldCodeType) {
+	case oph::FldCodeType::RI:
+#pragma omp parallel for private(i)
+		for (i = 0; i < n_pixels; i++) {
+			dst[i][_RE] = (Real)c0[i * stride];
+			dst[i][_IM] = (Real)c1[i * stride];
+		}
+		break;
+	case oph::FldCodeType::AP:
+#pragma omp parallel for private(i)
+		for (i = 0; i < n_pixels; i++) {
+			Real amp = (Real)c0[i * stride];
+			Real phase = (Real)c1[i * stride];
+			dst[i][_RE] = amp * cos(phase);
+			dst[i][_IM] = amp * sin(phase);
+		}
+		break;
+	case oph::FldCodeType::AE:
+#pragma omp parallel for private(i)
+		for (i = 0; i < n_pixels; i++) {
+			dst[i][_RE] = (Real)c0[i * stride];
+			dst[i][_IM] = 0.0;
+		}
+		break;
+	case oph::FldCodeType::PE:
+#pragma omp parallel for private(i)
+		for (i = 0; i < n_pixels; i++) {
+			Real phase = (Real)c0[i * stride];
+			dst[i][_RE] = cos(phase);
+			dst[i][_IM] = sin(phase);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool oph::ImgDecoderOhc::decodeComplexField(Complex<Real>* dst, uint wavelen_idx) {
+	if (dst == nullptr) {
+		LOG("OHC CODEC Error : No destination buffer.");
+		return false;
+	}
+	if (this->isTiled())
+		return decodeRegion(dst, wavelen_idx, 0, 0, FldInfo.pxNumX, FldInfo.pxNumY);
+
+	ohcFieldView view;
+	if (!getFieldView(view, wavelen_idx))
+		return false;
+
+	if (view.dataType == DataType::Float32)
+		decodeView<float>(view, dst);
+	else
+		decodeView<double>(view, dst);
+
+	return true;
+}
+
+static inline Real loadElem(const uchar* base, oph::DataType type, uint64_t i)
+{
+	if (type == oph::DataType::Float64)
+		return (Real)((const double*)base)[i];
+	else if (type == oph::DataType::Float32)
+		return (Real)((const float*)base)[i];
+	else
+		return (Real)halfToFloat(((const uint16_t*)base)[i]);
+}
+
+static inline void composeElem(oph::Complex<Real>& dst, oph::FldCodeType code, Real a, Real b)
+{
+	switch (code) {
+	case oph::FldCodeType::RI: dst[_RE] = a; dst[_IM] = b; break;
+	case oph::FldCodeType::AP: dst[_RE] = a * cos(b); dst[_IM] = a * sin(b); break;
+	case oph::FldCodeType::AE: dst[_RE] = a; dst[_IM] = 0.0; break;
+	case oph::FldCodeType::PE: dst[_RE] = cos(a); dst[_IM] = sin(a); break;
+	default: break;
+	}
+}
+
+bool oph::ImgDecoderOhc::decodeRegion(Complex<Real>* dst, uint wavelen_idx, int x0, int y0, int width, int height) {
+	if (dst == nullptr) {
+		LOG("OHC CODEC Error : No destination buffer.");
+		return false;
+	}
+	if (this->Header == nullptr || !this->bLoadFile) {
+		LOG("OHC CODEC Error : No opened data.");
+		return false;
+	}
+	if (wavelen_idx >= FldInfo.wavlenNum || x0 < 0 || y0 < 0 || width <= 0 || height <= 0 ||
+		(uint64_t)x0 + width > FldInfo.pxNumX || (uint64_t)y0 + height > FldInfo.pxNumY) {
+		LOG("OHC CODEC Error : Invalid region.");
+		return false;
+	}
+	const bool bDual = (FldInfo.fldCodeType == FldCodeType::RI) || (FldInfo.fldCodeType == FldCodeType::AP);
+
+	if (!this->isTiled()) {
+		ohcFieldView view;
+		if (!getFieldView(view, wavelen_idx))
+			return false;
+
+		int y;
+#pragma omp parallel for private(y)
+		for (y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				const uint64_t e = ((uint64_t)(y0 + y) * view.pxNumX + (x0 + x)) * view.stride;
+				const Real a = loadElem((const uchar*)view.comp0, view.dataType, e);
+				const Real b = bDual ? loadElem((const uchar*)view.comp1, view.dataType, e) : 0.0;
+				composeElem(dst[(uint64_t)y * width + x], view.fldCodeType, a, b);
+			}
+		}
+		return true;
+	}
+
+	// Tiled : read and decode only the overlapping tiles.
+	const uint tsx = this->tileHeader.tileSizeX;
+	const uint tsy = this->tileHeader.tileSizeY;
+	std::vector<uchar> raw0, raw1;
+	for (uint ty = y0 / tsy; ty <= (uint)(y0 + height - 1) / tsy; ty++) {
+		for (uint tx = x0 / tsx; tx <= (uint)(x0 + width - 1) / tsx; tx++) {
+			const uint64_t chunk0 = ((uint64_t)wavelen_idx * this->tileHeader.tileNumY + ty) * this->tileHeader.tileNumX + tx;
+			const uint64_t chunk1 = chunk0 + (uint64_t)FldInfo.wavlenNum * this->tileHeader.tileNumY * this->tileHeader.tileNumX;
+			if (!readChunk(chunk0, raw0)) return false;
+			if (bDual && !readChunk(chunk1, raw1)) return false;
+
+			const int tileX0 = tx * tsx;
+			const int tileY0 = ty * tsy;
+			const int tileW = (int)std::min<uint64_t>(tsx, FldInfo.pxNumX - tileX0);
+			const int bx = std::max(x0, tileX0);
+			const int ex = std::min(x0 + width, tileX0 + tileW);
+			const int by = std::max(y0, tileY0);
+			const int ey = std::min(y0 + height, tileY0 + (int)tsy);
+
+			int y;
+#pragma omp parallel for private(y)
+			for (y = by; y < ey; y++) {
+				for (int x = bx; x < ex; x++) {
+					const uint64_t e = (uint64_t)(y - tileY0) * tileW + (x - tileX0);
+					const Real a = loadElem(raw0.data(), FldInfo.cmplxFldType, e);
+					const Real b = bDual ? loadElem(raw1.data(), FldInfo.cmplxFldType, e) : 0.0;
+					composeElem(dst[(uint64_t)(y - y0) * width + (x - x0)], FldInfo.fldCodeType, a, b);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool oph::ImgDecoderOhc::readChunkTable(void) {
+	const uint64_t n_cmplxChnl = ((FldInfo.fldCodeType == FldCodeType::AP) || (FldInfo.fldCodeType == FldCodeType::RI)) ? 2 : 1;
+	uint64_t n_tiles = 1;
+
+	this->fieldOffset = File.tellg();
+	if (FldInfo.fldStore == FldStore::Tiled) {
+		File.read((char*)&this->tileHeader, sizeof(ohcTileHeader));
+		const ohcTileHeader &th = this->tileHeader;
+		if (th.tileSizeX == 0 || th.tileSizeY == 0 ||
+			th.tileNumX != (FldInfo.pxNumX + th.tileSizeX - 1) / th.tileSizeX ||
+			th.tileNumY != (FldInfo.pxNumY + th.tileSizeY - 1) / th.tileSizeY) {
+			LOG("Error : Invalid tile header of OHC file...");
+			return false;
+		}
+		n_tiles = (uint64_t)th.tileNumX * th.tileNumY;
+	}
+
+	this->chunkTable.resize(n_cmplxChnl * FldInfo.wavlenNum * n_tiles);
+	File.read((char*)this->chunkTable.data(), sizeof(ohcChunkEntry) * this->chunkTable.size());
+	if ((uint64_t)File.gcount() != sizeof(ohcChunkEntry) * this->chunkTable.size()) {
+		LOG("Error : Truncated OHC file...");
+		return false;
+	}
+
+	// entries come from the file, so every chunk must lie in the field data and hold exactly one plane or tile.
+	const uint64_t elemSize = (FldInfo.cmplxFldType == DataType::Float16) ? sizeof(uint16_t) :
+		(FldInfo.cmplxFldType == DataType::Float32) ? sizeof(float) : sizeof(double);
+	const uint64_t tableEnd = (uint64_t)File.tellg() - this->fieldOffset;
+	for (uint64_t k = 0; k < this->chunkTable.size(); k++) {
+		const ohcChunkEntry &entry = this->chunkTable[k];
+		uint64_t w = FldInfo.pxNumX, h = FldInfo.pxNumY;
+		if (FldInfo.fldStore == FldStore::Tiled) {
+			const ohcTileHeader &th = this->tileHeader;
+			const uint64_t tile = k % n_tiles;
+			const uint64_t tx = tile % th.tileNumX, ty = tile / th.tileNumX;
+			w = std::min<uint64_t>(th.tileSizeX, FldInfo.pxNumX - tx * th.tileSizeX);
+			h = std::min<uint64_t>(th.tileSizeY, FldInfo.pxNumY - ty * th.tileSizeY);
+		}
+		if (entry.rawSize != w * h * elemSize || entry.offset < tableEnd ||
+			entry.offset > FldInfo.fldSize || entry.size > FldInfo.fldSize - entry.offset) {
+			LOG("Error : Invalid chunk table of OHC file...");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool oph::ImgDecoderOhc::readChunk(uint64_t chunk_idx, std::vector<uchar> &raw) {
+	if (chunk_idx >= this->chunkTable.size()) {
+		LOG("Error : Invalid chunk index...");
+		return false;
+	}
+	const ohcChunkEntry &entry = this->chunkTable[chunk_idx];
+	File.clear();
+	File.seekg(this->fieldOffset + (std::streamoff)entry.offset, ios::beg);
+
+	if (FldInfo.comprsType != CompresType::Deflate) {
+		if (entry.size != entry.rawSize) {
+			LOG("Error : Invalid chunk size of OHC file...");
+			return false;
+		}
+		raw.resize(entry.rawSize);
+		File.read((char*)raw.data(), entry.size);
+		return (uint64_t)File.gcount() == entry.size;
+	}
+
+#ifdef _USE_ZLIB
+	std::vector<uchar> packed(entry.size);
+	File.read((char*)packed.data(), entry.size);
+	if ((uint64_t)File.gcount() != entry.size)
+		return false;
+
+	raw.resize(entry.rawSize);
+	uLongf outSize = (uLongf)entry.rawSize;
+	if (uncompress(raw.data(), &outSize, packed.data(), (uLong)entry.size) != Z_OK || outSize != entry.rawSize) {
+		LOG("Error : Failed decompressing OHC field data...");
+		return false;
+	}
+	return true;
+#else
+	LOG("Error : Compressed OHC field data needs build with _USE_ZLIB...");
+	return false;
+#endif
+}
+
+bool oph::ImgDecoderOhc::readFieldData(void)
+{
+	const uint64_t n_pixels = (uint64_t)FldInfo.pxNumX * FldInfo.pxNumY;
+	const uint64_t n_fields = n_pixels * FldInfo.wavlenNum;
+	int n_cmplxChnl = 0;
+	if ((FldInfo.fldCodeType == FldCodeType::AP) || (FldInfo.fldCodeType == FldCodeType::RI))
+		n_cmplxChnl = 2;
+	else if ((FldInfo.fldCodeType == FldCodeType::AE) || (FldInfo.fldCodeType == FldCodeType::PE))
+		n_cmplxChnl = 1;
+	const uint64_t n_elems = n_fields * n_cmplxChnl;
+
+	uint64_t elemSize = 0;
+	switch (FldInfo.cmplxFldType) {
+	case DataType::Float16: elemSize = sizeof(uint16_t); break;
+	case DataType::Float32: elemSize = sizeof(float); break;
+	case DataType::Float64: elemSize = sizeof(double); break;
+	default:
+		LOG("Error : Invalid Decoding Complex Field Data Type...");
+		return false;
+	}
+
+	this->releaseCodeBuffer();
+	if (FldInfo.cmplxFldType == DataType::Float64) {
+		this->buf_f64 = new double[n_elems];
+		this->fieldType = DataType::Float64;
+	}
+	else {
+		this->buf_f32 = new float[n_elems];
+		this->fieldType = DataType::Float32;
+	}
+	uchar* dst = (this->fieldType == DataType::Float32) ? (uchar*)this->buf_f32 : (uchar*)this->buf_f64;
+
+	// Directly stored : one bulk read, Float16 widened to float after reading.
+	if (FldInfo.comprsType != CompresType::Deflate && FldInfo.fldStore != FldStore::Tiled) {
+		if (FldInfo.cmplxFldType != DataType::Float16) {
+			File.read((char*)dst, elemSize * n_elems);
+			return (uint64_t)File.gcount() == elemSize * n_elems;
+		}
+
+		std::vector<uint16_t> half(n_elems);
+		File.read((char*)half.data(), elemSize * n_elems);
+		if ((uint64_t)File.gcount() != elemSize * n_elems) return false;
+
+		long long i;
+#pragma omp parallel for private(i)
+		for (i = 0; i < (long long)n_elems; i++)
+			this->buf_f32[i] = halfToFloat(half[i]);
+		return true;
+	}
+
+	// Chunked : compressed planes or tiles, expanded to each channel planes.
+	if (!readChunkTable())
+		return false;
+
+	const bool bTiled = (FldInfo.fldStore == FldStore::Tiled);
+	const uint64_t tilesPerPlane = bTiled ? (uint64_t)this->tileHeader.tileNumX * this->tileHeader.tileNumY : 1;
+	const uint tsx = bTiled ? this->tileHeader.tileSizeX : FldInfo.pxNumX;
+	const uint tsy = bTiled ? this->tileHeader.tileSizeY : FldInfo.pxNumY;
+	const uint tnx = bTiled ? this->tileHeader.tileNumX : 1;
+	const uint64_t dstElemSize = (this->fieldType == DataType::Float32) ? sizeof(float) : sizeof(double);
+
+	std::vector<uchar> raw;
+	for (uint64_t k = 0; k < this->chunkTable.size(); k++) {
+		if (!readChunk(k, raw))
+			return false;
+
+		const uint64_t plane = k / tilesPerPlane;
+		const uint64_t tile = k % tilesPerPlane;
+		const uint tileX0 = (uint)(tile % tnx) * tsx;
+		const uint tileY0 = (uint)(tile / tnx) * tsy;
+		const int tileW = (int)std::min<uint64_t>(tsx, FldInfo.pxNumX - tileX0);
+		const int tileH = (int)std::min<uint64_t>(tsy, FldInfo.pxNumY - tileY0);
+		if (raw.size() != (uint64_t)tileW * tileH * elemSize) {
+			LOG("Error : Invalid chunk size of OHC file...");
+			return false;
+		}
+
+		uchar* out = dst + (plane * n_pixels + (uint64_t)tileY0 * FldInfo.pxNumX + tileX0) * dstElemSize;
+		int y;
+#pragma omp parallel for private(y)
+		for (y = 0; y < tileH; y++) {
+			uchar* row = out + (uint64_t)y * FldInfo.pxNumX * dstElemSize;
+			if (FldInfo.cmplxFldType == DataType::Float16) {
+				for (int x = 0; x < tileW; x++)
+					((float*)row)[x] = halfToFloat(((const uint16_t*)raw.data())[(uint64_t)y * tileW + x]);
+			}
+			else
+				std::memcpy(row, raw.data() + (uint64_t)y * tileW * elemSize, tileW * elemSize);
+		}
+	}
+	return true;
+}
+
 void oph::ImgDecoderOhc::fieldToComplex(void)
 {
 	if (field_cmplx.empty() != true) return;
@@ -489,17 +1052,14 @@ bool oph::ImgDecoderOhc::decodeFieldData()
 	}
 	}
 
-	if (FldInfo.fldStore == FldStore::Directly) {
-		if (FldInfo.cmplxFldType == DataType::Float32) {
-			this->buf_f32 = new float[n_fields * n_cmplxChnl];
-			for (ulonglong i = 0; i < n_fields * n_cmplxChnl; i++)
-				this->File.read((char*)&this->buf_f32[i], sizeof(float));
-		}
-		else if (FldInfo.cmplxFldType == DataType::Float64) {
-			this->buf_f64 = new double[n_fields * n_cmplxChnl];
-			for (ulonglong i = 0; i < n_fields * n_cmplxChnl; i++)
-				this->File.read((char*)&this->buf_f64[i], sizeof(double));
+	if (FldInfo.fldStore == FldStore::Directly || FldInfo.fldStore == FldStore::Tiled) {
+		if (!readFieldData()) {
+			LOG("Error : Failed reading field data...\n");
+			return false;
 		}
+		// chunked data is always expanded each channel
+		const bool bChunked = (FldInfo.comprsType == CompresType::Deflate) || (FldInfo.fldStore == FldStore::Tiled);
+		const ColorArran clrArrange = bChunked ? ColorArran::EachChanl : FldInfo.clrArrange;
 
 		for (int x = 0; x < cols; ++x) {
 			for (int y = 0; y < rows; ++y) {
@@ -508,83 +1068,83 @@ bool oph::ImgDecoderOhc::decodeFieldData()
 				for (int clrChnl = 0; clrChnl < n_wavlens; ++clrChnl) { // RGB is wavlenNum == 3
 					ulonglong idx_sqtlChnl = n_wavlens * idx + clrChnl;
 
-					if (FldInfo.clrArrange == ColorArran::SeqtChanl) {
+					if (clrArrange == ColorArran::SeqtChanl) {
 						switch (FldInfo.fldCodeType) {
 						case FldCodeType::RI: {
-							if (FldInfo.cmplxFldType == DataType::Float32) {
+							if (this->fieldType == DataType::Float32) {
 								this->field_cmplx[clrChnl][x][y][_RE] = *(this->buf_f32 + idx_sqtlChnl + 0 * n_fields);
 								this->field_cmplx[clrChnl][x][y][_IM] = *(this->buf_f32 + idx_sqtlChnl + 1 * n_fields);
 							}
-							else if (FldInfo.cmplxFldType == DataType::Float64) {
+							else if (this->fieldType == DataType::Float64) {
 								this->field_cmplx[clrChnl][x][y][_RE] = *(this->buf_f64 + idx_sqtlChnl + 0 * n_fields);
 								this->field_cmplx[clrChnl][x][y][_IM] = *(this->buf_f64 + idx_sqtlChnl + 1 * n_fields);
 							}
 							break;
 						}
 						case FldCodeType::AP: {
-							if (FldInfo.cmplxFldType == DataType::Float32) {
+							if (this->fieldType == DataType::Float32) {
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f32 + idx_sqtlChnl + 0 * n_fields);
 								this->field_phase[clrChnl][x][y] = *(this->buf_f32 + idx_sqtlChnl + 1 * n_fields);
 							}
-							else if (FldInfo.cmplxFldType == DataType::Float64) {
+							else if (this->fieldType == DataType::Float64) {
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f64 + idx_sqtlChnl + 0 * n_fields);
 								this->field_phase[clrChnl][x][y] = *(this->buf_f64 + idx_sqtlChnl + 1 * n_fields);
 							}
 							break;
 						}
 						case FldCodeType::AE: {
-							if (FldInfo.cmplxFldType == DataType::Float32)
+							if (this->fieldType == DataType::Float32)
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f32 + idx_sqtlChnl + 0 * n_fields);
-							else if (FldInfo.cmplxFldType == DataType::Float64)
+							else if (this->fieldType == DataType::Float64)
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f64 + idx_sqtlChnl + 0 * n_fields);
 							break;
 						}
 						case FldCodeType::PE: {
-							if (FldInfo.cmplxFldType == DataType::Float32)
+							if (this->fieldType == DataType::Float32)
 								this->field_phase[clrChnl][x][y] = *(this->buf_f32 + idx_sqtlChnl + 0 * n_fields);
-							else if (FldInfo.cmplxFldType == DataType::Float64)
+							else if (this->fieldType == DataType::Float64)
 								this->field_phase[clrChnl][x][y] = *(this->buf_f64 + idx_sqtlChnl + 0 * n_fields);
 							break;
 						}
 						}
 					}
-					else if (FldInfo.clrArrange == ColorArran::EachChanl) {
+					else if (clrArrange == ColorArran::EachChanl) {
 						ulonglong idx_eachChnl = idx + clrChnl * n_pixels;
 
 						switch (FldInfo.fldCodeType) {
 						case FldCodeType::RI: {
-							if (FldInfo.cmplxFldType == DataType::Float32) {
+							if (this->fieldType == DataType::Float32) {
 								this->field_cmplx[clrChnl][x][y][_RE] = *(this->buf_f32 + idx_eachChnl + 0 * n_fields);
 								this->field_cmplx[clrChnl][x][y][_IM] = *(this->buf_f32 + idx_eachChnl + 1 * n_fields);
 							}
-							else if (FldInfo.cmplxFldType == DataType::Float64) {
+							else if (this->fieldType == DataType::Float64) {
 								this->field_cmplx[clrChnl][x][y][_RE] = *(this->buf_f64 + idx_eachChnl + 0 * n_fields);
 								this->field_cmplx[clrChnl][x][y][_IM] = *(this->buf_f64 + idx_eachChnl + 1 * n_fields);
 							}
 							break;
 						}
 						case FldCodeType::AP: {
-							if (FldInfo.cmplxFldType == DataType::Float32) {
+							if (this->fieldType == DataType::Float32) {
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f32 + idx_eachChnl + 0 * n_fields);
 								this->field_phase[clrChnl][x][y] = *(this->buf_f32 + idx_eachChnl + 1 * n_fields);
 							}
-							else if (FldInfo.cmplxFldType == DataType::Float64) {
+							else if (this->fieldType == DataType::Float64) {
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f64 + idx_eachChnl + 0 * n_fields);
 								this->field_phase[clrChnl][x][y] = *(this->buf_f64 + idx_eachChnl + 1 * n_fields);
 							}
 							break;
 						}
 						case FldCodeType::AE: {
-							if (FldInfo.cmplxFldType == DataType::Float32)
+							if (this->fieldType == DataType::Float32)
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f32 + idx_eachChnl + 0 * n_fields);
-							else if (FldInfo.cmplxFldType == DataType::Float64)
+							else if (this->fieldType == DataType::Float64)
 								this->field_ampli[clrChnl][x][y] = *(this->buf_f64 + idx_eachChnl + 0 * n_fields);
 							break;
 						}
 						case FldCodeType::PE: {
-							if (FldInfo.cmplxFldType == DataType::Float32)
+							if (this->fieldType == DataType::Float32)
 								this->field_phase[clrChnl][x][y] = *(this->buf_f32 + idx_eachChnl + 0 * n_fields);
-							else if (FldInfo.cmplxFldType == DataType::Float64)
+							else if (this->fieldType == DataType::Float64)
 								this->field_phase[clrChnl][x][y] = *(this->buf_f64 + idx_eachChnl + 0 * n_fields);
 							break;
 						}
@@ -834,6 +1394,9 @@ oph::ImgEncoderOhc::ImgEncoderOhc(const std::string &_fname)
 
 oph::ImgEncoderOhc::~ImgEncoderOhc()
 {
+	if (this->bStreaming)
+		this->endStream();
+	this->waitStream();
 	this->releaseOHCheader();
 	this->releaseFldData();
 	this->releaseCodeBuffer();
@@ -999,15 +1562,39 @@ void oph::ImgEncoderOhc::setPhaseEncoding(const BPhaseCode _bPhaseCode, const ve
 	}
 }
 
-//void oph::ImgEncoderOhc::setCompressedFormatType(const CompresType _comprsType) {
-//	if (this->Header == nullptr) {
-//		LOG("OHC CODEC Error : No header data.");
-//		return;
-//	}
-//	else {
-//		FldInfo.comprsType = _comprsType;
-//	}	
-//}
+void oph::ImgEncoderOhc::setCompressedFormatType(const CompresType _comprsType) {
+	if (this->Header == nullptr) {
+		LOG("OHC CODEC Error : No header data.");
+		return;
+	}
+	else if (_comprsType != CompresType::Null && _comprsType != CompresType::Deflate) {
+		LOG("OHC CODEC Error : Only Deflate compression is supported.");
+		return;
+	}
+#ifndef _USE_ZLIB
+	else if (_comprsType == CompresType::Deflate) {
+		LOG("OHC CODEC Error : Deflate compression needs build with _USE_ZLIB.");
+		return;
+	}
+#endif
+	else {
+		FldInfo.comprsType = _comprsType;
+	}	
+}
+
+void oph::ImgEncoderOhc::setDataType(const DataType _cmplxFldType) {
+	if (this->Header == nullptr) {
+		LOG("OHC CODEC Error : No header data.");
+		return;
+	}
+	else if (_cmplxFldType != DataType::Float64 && _cmplxFldType != DataType::Float32 && _cmplxFldType != DataType::Float16) {
+		LOG("OHC CODEC Error : Invalid Complex Field Data Type.");
+		return;
+	}
+	else {
+		FldInfo.cmplxFldType = _cmplxFldType;
+	}
+}
 
 void oph::ImgEncoderOhc::setWavelength(const Real _wavlen, const LenUnit _unit) {
 	this->addWavelength(_wavlen);
@@ -1170,19 +1757,9 @@ bool oph::ImgEncoderOhc::save() {
 		// write Complex Field Data
 		//fwrite(this->buf, 1, sizeof(dataSize), fp);
 		if (FldInfo.cmplxFldType == DataType::Float32)
-		{
-			size_t dataTypeSize = sizeof(float);
-			ulonglong maxIdx = dataSize / dataTypeSize;
-			for (ulonglong i = 0; i < maxIdx; i++)
-				File.write((char *)&buf_f32[i], dataTypeSize);
-		}
+			File.write((char *)buf_f32, dataSize);
 		else if (FldInfo.cmplxFldType == DataType::Float64)
-		{
-			size_t dataTypeSize = sizeof(double);
-			ulonglong maxIdx = dataSize / dataTypeSize;
-			for (ulonglong i = 0; i < maxIdx; i++)
-				File.write((char *)&buf_f64[i], dataTypeSize);
-		}
+			File.write((char *)buf_f64, dataSize);
 		//this->File.write((char*)this->buf, sizeof(dataSize));
 
 		//fclose(fp);
@@ -1201,6 +1778,392 @@ bool oph::ImgEncoderOhc::save() {
 	}
 }
 
+static inline void storeElem(double* dst, Real v) { *dst = (double)v; }
+static inline void storeElem(float* dst, Real v) { *dst = (float)v; }
+static inline void storeElem(uint16_t* dst, Real v) { *dst = floatToHalf((float)v); }
+
+template<typename T>
+static void encodeRect(const oph::Complex<Real>* src, uint64_t srcPitch, int width, int height, oph::FldCodeType code, int comp, T* dst, uint64_t stride)
+{
+	const long long n = (long long)width * height;
+	long long i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < n; i++) {
+		const oph::Complex<Real>& c = src[(i / width) * srcPitch + (i % width)];
+		const Real re = c.real();
+		const Real im = c.imag();
+		Real v = 0;
+		switch (code) {
+		case oph::FldCodeType::RI: v = (comp == 0) ? re : im; break;
+		case oph::FldCodeType::AP: v = (comp == 0) ? sqrt(re * re + im * im) : atan2(im, re); break;
+		case oph::FldCodeType::AE: v = sqrt(re * re + im * im); break;
+		case oph::FldCodeType::PE: v = atan2(im, re); break;
+		default: break;
+		}
+		storeElem(dst + i * stride, v);
+	}
+}
+
+/* Encode one component of a width * height rectangle of src(row pitch srcPitch) to storage type, stride elements apart. */
+static void encodeRect(const oph::Complex<Real>* src, uint64_t srcPitch, int width, int height, oph::FldCodeType code, int comp, oph::DataType type, uchar* dst, uint64_t stride)
+{
+	if (type == oph::DataType::Float64)
+		encodeRect<double>(src, srcPitch, width, height, code, comp, (double*)dst, stride);
+	else if (type == oph::DataType::Float32)
+		encodeRect<float>(src, srcPitch, width, height, code, comp, (float*)dst, stride);
+	else
+		encodeRect<uint16_t>(src, srcPitch, width, height, code, comp, (uint16_t*)dst, stride);
+}
+
+static inline uint64_t storageSize(oph::DataType type)
+{
+	return (type == oph::DataType::Float64) ? sizeof(double) : (type == oph::DataType::Float32) ? sizeof(float) : sizeof(uint16_t);
+}
+
+void oph::ImgEncoderOhc::setTileSize(const uint _tileSizeX, const uint _tileSizeY) {
+	if (this->Header == nullptr) {
+		LOG("OHC CODEC Error : No header data.");
+		return;
+	}
+	if (_tileSizeX == 0 || _tileSizeY == 0) {
+		this->tileHeader = ohcTileHeader();
+		FldInfo.fldStore = FldStore::Directly;
+	}
+	else {
+		this->tileHeader.tileSizeX = _tileSizeX;
+		this->tileHeader.tileSizeY = _tileSizeY;
+		FldInfo.fldStore = FldStore::Tiled;
+	}
+}
+
+bool oph::ImgEncoderOhc::beginStream()
+{
+	this->waitStream();
+
+	if (this->Header == nullptr)
+		this->initOHCheader();
+
+	if (FldInfo.pxNumX == (uint32_t)-1 || FldInfo.pxNumY == (uint32_t)-1 || FldInfo.wavlenNum == 0) {
+		LOG("OHC CODEC Error : Field size or wavelength is not set.");
+		return false;
+	}
+	if (FldInfo.fldStore != FldStore::Directly && FldInfo.fldStore != FldStore::Tiled) {
+		LOG("Error : Link Image File Encoding is Not Yet supported...");
+		return false;
+	}
+	if (FldInfo.fldStore == FldStore::Tiled && (this->tileHeader.tileSizeX == 0 || this->tileHeader.tileSizeY == 0)) {
+		LOG("OHC CODEC Error : Tile size is not set.");
+		return false;
+	}
+	if (FldInfo.cmplxFldType != DataType::Float64 && FldInfo.cmplxFldType != DataType::Float32 && FldInfo.cmplxFldType != DataType::Float16) {
+		LOG("Error : Invalid Encoding Complex Field Data Type...");
+		return false;
+	}
+#ifndef _USE_ZLIB
+	if (FldInfo.comprsType == CompresType::Deflate) {
+		LOG("OHC CODEC Error : Deflate compression needs build with _USE_ZLIB.");
+		return false;
+	}
+#endif
+	const bool bChunked = (FldInfo.comprsType == CompresType::Deflate) || (FldInfo.fldStore == FldStore::Tiled);
+	this->streamClrArrange = FldInfo.clrArrange;
+	if (bChunked && FldInfo.clrArrange == ColorArran::SeqtChanl) {
+		LOG("OHC CODEC : Chunked field data is stored each channel.");
+		FldInfo.clrArrange = ColorArran::EachChanl;
+	}
+
+	this->File.open(this->fname, std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!this->File.is_open()) {
+		LOG("Error : Failed saving OHC file...");
+		return false;
+	}
+	LOG("Saving...%s...", fname.c_str());
+
+	const uint64_t n_pixels = (uint64_t)FldInfo.pxNumX * FldInfo.pxNumY;
+	const uint64_t n_fields = n_pixels * FldInfo.wavlenNum;
+	const uint64_t n_cmplxChnl = ((FldInfo.fldCodeType == FldCodeType::AP) || (FldInfo.fldCodeType == FldCodeType::RI)) ? 2 : 1;
+	const uint64_t elemSize = storageSize(FldInfo.cmplxFldType);
+
+	setPhaseEncoding(BPhaseCode::NotEncoded, -1.0, 1.0);
+	FldInfo.headerSize = (uint32_t)(sizeof(ohcFieldInfoHeader) + FldInfo.wavlenNum * sizeof(double_t));
+	this->fieldOff = sizeof(ohcFileHeader) + FldInfo.headerSize;
+	FHeader.fileOffBytes = (uint32_t)this->fieldOff;
+
+	this->chunkTable.clear();
+	this->seqtStage.clear();
+	uint64_t tableHead = 0;
+	if (bChunked) {
+		uint64_t n_tiles = 1;
+		if (FldInfo.fldStore == FldStore::Tiled) {
+			this->tileHeader.tileNumX = (FldInfo.pxNumX + this->tileHeader.tileSizeX - 1) / this->tileHeader.tileSizeX;
+			this->tileHeader.tileNumY = (FldInfo.pxNumY + this->tileHeader.tileSizeY - 1) / this->tileHeader.tileSizeY;
+			n_tiles = (uint64_t)this->tileHeader.tileNumX * this->tileHeader.tileNumY;
+			tableHead = sizeof(ohcTileHeader);
+		}
+		this->chunkTable.resize(n_cmplxChnl * FldInfo.wavlenNum * n_tiles);
+		this->chunkEnd = tableHead + sizeof(ohcChunkEntry) * this->chunkTable.size();
+		FldInfo.fldSize = 0; // patched by endStream()
+	}
+	else {
+		FldInfo.fldSize = elemSize * n_fields * n_cmplxChnl;
+		if (FldInfo.clrArrange == ColorArran::SeqtChanl)
+			this->seqtStage.resize(FldInfo.fldSize);
+	}
+	FHeader.fileSize = this->fieldOff + FldInfo.fldSize;
+
+	// headers now, sizes of chunked data are rewritten at the end.
+	File.write((char *)&FHeader, sizeof(FHeader));
+	File.write((char *)&FldInfo, sizeof(FldInfo));
+	File.write((char *)WavLeng.data(), sizeof(double_t) * FldInfo.wavlenNum);
+	if (tableHead != 0)
+		File.write((char *)&this->tileHeader, sizeof(ohcTileHeader));
+	if (!this->chunkTable.empty())
+		File.write((char *)this->chunkTable.data(), sizeof(ohcChunkEntry) * this->chunkTable.size());
+
+	this->bStreaming = true;
+	this->bStreamOk = File.good();
+	if (this->bAsync) {
+		// backpressure : a caller faster than the disk waits once two fields are queued.
+		this->ioQueueBytes = 0;
+		this->ioQueueLimit = 2 * n_pixels * n_cmplxChnl * elemSize;
+		this->ioThread = std::thread(&ImgEncoderOhc::ioThreadFunc, this);
+	}
+
+	return this->bStreamOk;
+}
+
+bool oph::ImgEncoderOhc::writeComplexField(const Complex<Real>* data, uint wavelen_idx)
+{
+	if (!this->bStreaming) {
+		LOG("OHC CODEC Error : Stream is not started.");
+		return false;
+	}
+	if (data == nullptr || wavelen_idx >= FldInfo.wavlenNum) {
+		LOG("OHC CODEC Error : Invalid complex field data.");
+		return false;
+	}
+
+	if (FldInfo.fldStore == FldStore::Tiled) {
+		const uint64_t pitch = FldInfo.pxNumX;
+		for (uint ty = 0; ty < this->tileHeader.tileNumY; ty++) {
+			for (uint tx = 0; tx < this->tileHeader.tileNumX; tx++) {
+				const Complex<Real>* tile = data + (uint64_t)ty * this->tileHeader.tileSizeY * pitch + (uint64_t)tx * this->tileHeader.tileSizeX;
+				const int w = (int)std::min<uint64_t>(this->tileHeader.tileSizeX, FldInfo.pxNumX - (uint64_t)tx * this->tileHeader.tileSizeX);
+				const int h = (int)std::min<uint64_t>(this->tileHeader.tileSizeY, FldInfo.pxNumY - (uint64_t)ty * this->tileHeader.tileSizeY);
+				const int n_cmplxChnl = ((FldInfo.fldCodeType == FldCodeType::AP) || (FldInfo.fldCodeType == FldCodeType::RI)) ? 2 : 1;
+
+				for (int comp = 0; comp < n_cmplxChnl; comp++) {
+					ohcWriteJob job;
+					job.bFinish = false;
+					job.data.resize((uint64_t)w * h * storageSize(FldInfo.cmplxFldType));
+					encodeRect(tile, pitch, w, h, FldInfo.fldCodeType, comp, FldInfo.cmplxFldType, job.data.data(), 1);
+					job.pos = (((uint64_t)comp * FldInfo.wavlenNum + wavelen_idx) * this->tileHeader.tileNumY + ty) * this->tileHeader.tileNumX + tx;
+					this->queueJob(job);
+				}
+			}
+		}
+		return this->bStreamOk;
+	}
+
+	const uint64_t n_wavlens = FldInfo.wavlenNum;
+	const uint64_t n_pixels = (uint64_t)FldInfo.pxNumX * FldInfo.pxNumY;
+	const uint64_t n_fields = n_pixels * n_wavlens;
+	const int n_cmplxChnl = ((FldInfo.fldCodeType == FldCodeType::AP) || (FldInfo.fldCodeType == FldCodeType::RI)) ? 2 : 1;
+	const uint64_t elemSize = storageSize(FldInfo.cmplxFldType);
+
+	for (int comp = 0; comp < n_cmplxChnl; comp++) {
+		// Sequential channels interleave all wavelengths, so they are staged and written by endStream().
+		if (!this->seqtStage.empty()) {
+			uchar* dst = this->seqtStage.data() + (comp * n_fields + wavelen_idx) * elemSize;
+			encodeRect(data, FldInfo.pxNumX, FldInfo.pxNumX, FldInfo.pxNumY, FldInfo.fldCodeType, comp, FldInfo.cmplxFldType, dst, n_wavlens);
+			continue;
+		}
+
+		ohcWriteJob job;
+		job.bFinish = false;
+		job.data.resize(n_pixels * elemSize);
+		encodeRect(data, FldInfo.pxNumX, FldInfo.pxNumX, FldInfo.pxNumY, FldInfo.fldCodeType, comp, FldInfo.cmplxFldType, job.data.data(), 1);
+
+		if (FldInfo.comprsType == CompresType::Deflate)
+			job.pos = comp * n_wavlens + wavelen_idx;
+		else
+			job.pos = this->fieldOff + (comp * n_fields + wavelen_idx * n_pixels) * elemSize;
+		this->queueJob(job);
+	}
+
+	return this->bStreamOk;
+}
+
+bool oph::ImgEncoderOhc::writeTile(const Complex<Real>* data, uint wavelen_idx, uint tile_x, uint tile_y)
+{
+	if (!this->bStreaming || FldInfo.fldStore != FldStore::Tiled) {
+		LOG("OHC CODEC Error : Tiled stream is not started.");
+		return false;
+	}
+	if (data == nullptr || wavelen_idx >= FldInfo.wavlenNum || tile_x >= this->tileHeader.tileNumX || tile_y >= this->tileHeader.tileNumY) {
+		LOG("OHC CODEC Error : Invalid tile data.");
+		return false;
+	}
+
+	const int w = (int)std::min<uint64_t>(this->tileHeader.tileSizeX, FldInfo.pxNumX - (uint64_t)tile_x * this->tileHeader.tileSizeX);
+	const int h = (int)std::min<uint64_t>(this->tileHeader.tileSizeY, FldInfo.pxNumY - (uint64_t)tile_y * this->tileHeader.tileSizeY);
+	const int n_cmplxChnl = ((FldInfo.fldCodeType == FldCodeType::AP) || (FldInfo.fldCodeType == FldCodeType::RI)) ? 2 : 1;
+
+	for (int comp = 0; comp < n_cmplxChnl; comp++) {
+		ohcWriteJob job;
+		job.bFinish = false;
+		job.data.resize((uint64_t)w * h * storageSize(FldInfo.cmplxFldType));
+		encodeRect(data, w, w, h, FldInfo.fldCodeType, comp, FldInfo.cmplxFldType, job.data.data(), 1);
+		job.pos = (((uint64_t)comp * FldInfo.wavlenNum + wavelen_idx) * this->tileHeader.tileNumY + tile_y) * this->tileHeader.tileNumX + tile_x;
+		this->queueJob(job);
+	}
+
+	return this->bStreamOk;
+}
+
+bool oph::ImgEncoderOhc::endStream()
+{
+	if (!this->bStreaming) return false;
+	this->bStreaming = false;
+
+	if (this->bAsync) {
+		ohcWriteJob job;
+		job.pos = 0;
+		job.bFinish = true;
+		this->queueJob(job);
+		return true;
+	}
+
+	return this->finishStream();
+}
+
+bool oph::ImgEncoderOhc::waitStream()
+{
+	if (this->ioThread.joinable())
+		this->ioThread.join();
+
+	return this->bStreamOk;
+}
+
+void oph::ImgEncoderOhc::queueJob(ohcWriteJob &job)
+{
+	if (this->bAsync) {
+		std::unique_lock<std::mutex> lock(this->ioMutex);
+		// a job larger than the limit still goes into an empty queue.
+		const uint64_t size = job.data.size();
+		this->ioSpaceCond.wait(lock, [this, size] {
+			return this->ioQueue.empty() || this->ioQueueBytes + size <= this->ioQueueLimit;
+		});
+		this->ioQueueBytes += size;
+		this->ioQueue.push_back(std::move(job));
+		this->ioCond.notify_one();
+	}
+	else
+		this->writeJob(job);
+}
+
+void oph::ImgEncoderOhc::writeJob(ohcWriteJob &job)
+{
+	if (this->chunkTable.empty()) {
+		File.seekp(job.pos, ios::beg);
+		File.write((char *)job.data.data(), job.data.size());
+	}
+	else {
+		const uchar* stored = job.data.data();
+		uint64_t storedSize = job.data.size();
+#ifdef _USE_ZLIB
+		std::vector<uchar> packed;
+		if (FldInfo.comprsType == CompresType::Deflate) {
+			uLongf packedSize = compressBound((uLong)job.data.size());
+			packed.resize(packedSize);
+			if (compress2(packed.data(), &packedSize, job.data.data(), (uLong)job.data.size(), Z_BEST_SPEED) != Z_OK) {
+				LOG("Error : Failed compressing OHC field data...");
+				this->bStreamOk = false;
+				return;
+			}
+			stored = packed.data();
+			storedSize = packedSize;
+		}
+#endif
+
+		ohcChunkEntry &entry = this->chunkTable[job.pos];
+		entry.offset = this->chunkEnd;
+		entry.size = storedSize;
+		entry.rawSize = job.data.size();
+
+		File.seekp(this->fieldOff + this->chunkEnd, ios::beg);
+		File.write((char *)stored, storedSize);
+		this->chunkEnd += storedSize;
+	}
+
+	if (!File.good())
+		this->bStreamOk = false;
+}
+
+void oph::ImgEncoderOhc::ioThreadFunc()
+{
+	while (true) {
+		ohcWriteJob job;
+		{
+			std::unique_lock<std::mutex> lock(this->ioMutex);
+			this->ioCond.wait(lock, [this] { return !this->ioQueue.empty(); });
+			job = std::move(this->ioQueue.front());
+			this->ioQueue.pop_front();
+			this->ioQueueBytes -= job.data.size();
+		}
+		this->ioSpaceCond.notify_one();
+
+		if (job.bFinish) {
+			this->finishStream();
+			return;
+		}
+		this->writeJob(job);
+	}
+}
+
+bool oph::ImgEncoderOhc::finishStream()
+{
+	auto start = CUR_TIME;
+
+	if (!this->seqtStage.empty()) {
+		File.seekp(this->fieldOff, ios::beg);
+		File.write((char *)this->seqtStage.data(), this->seqtStage.size());
+		std::vector<uchar>().swap(this->seqtStage);
+	}
+
+	if (!this->chunkTable.empty()) {
+		// every chunk must have been written once
+		for (size_t k = 0; k < this->chunkTable.size(); k++) {
+			if (this->chunkTable[k].rawSize == 0) {
+				LOG("Error : Missing complex field data...");
+				this->bStreamOk = false;
+				break;
+			}
+		}
+		FldInfo.fldSize = this->chunkEnd;
+		FHeader.fileSize = this->fieldOff + FldInfo.fldSize;
+
+		File.seekp(0, ios::beg);
+		File.write((char *)&FHeader, sizeof(FHeader));
+		File.write((char *)&FldInfo, sizeof(FldInfo));
+		File.seekp(this->fieldOff, ios::beg);
+		if (FldInfo.fldStore == FldStore::Tiled)
+			File.write((char *)&this->tileHeader, sizeof(ohcTileHeader));
+		File.write((char *)this->chunkTable.data(), sizeof(ohcChunkEntry) * this->chunkTable.size());
+	}
+
+	if (!File.good())
+		this->bStreamOk = false;
+	this->File.close();
+	// the file keeps the arrangement it was written with, the next stream uses the caller's one again.
+	FldInfo.clrArrange = this->streamClrArrange;
+
+	auto end = CUR_TIME;
+	LOG("%.5lfsec...done\n", ELAPSED_TIME(start, end));
+
+	return this->bStreamOk;
+}
+
 uint64_t oph::ImgEncoderOhc::encodeFieldData()
 {
 	ulonglong dataSizeBytes = 0;
@@ -47,6 +47,11 @@
 #define __ImgCodecOhc_h
 
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
 #include "include.h"
 #include "mat.h"
 #include "vec.h"
@@ -94,6 +99,10 @@ namespace oph
 		std::vector<std::string> linkFilePath;
 
 		ohcHeader* Header = nullptr;
+
+		//chunked field data : compressed planes or tiles
+		ohcTileHeader tileHeader;
+		std::vector<ohcChunkEntry> chunkTable;
 	};
 
 
@@ -120,8 +129,32 @@ namespace oph
 
 		bool load();
 
+		/* Read the headers only and map the field data region (or read it in one bulk read if mapping fails). */
+		bool open();
+		void close();
+		bool isMapped() { return this->mapBase != nullptr; }
+
+		/* Zero-copy access to the field data of opened file. Valid until close(). */
+		bool getFieldView(ohcFieldView &view, uint wavelen_idx);
+
+		/* Decode one wavelength channel of opened file straight into a caller-provided buffer of pxNumX * pxNumY. */
+		bool decodeComplexField(Complex<Real>* dst, uint wavelen_idx);
+
+		/* Decode a region of one wavelength channel into a buffer of width * height, row by row.
+		   Field is pxNumY rows of pxNumX pixels like complex_H. Tiled files read only the tiles overlapping the region. */
+		bool decodeRegion(Complex<Real>* dst, uint wavelen_idx, int x0, int y0, int width, int height);
+		bool isTiled() { return this->Header != nullptr && this->Header->fieldInfo.fldStore == FldStore::Tiled; }
+		ivec2 getTileSize() { return ivec2(this->tileHeader.tileSizeX, this->tileHeader.tileSizeY); }
+
 	protected:
 		void fieldToComplex(void);
+		bool readHeader(void);
+		/* Read field data region at current file position into buf_f32/buf_f64, expanding Float16 and compressed chunks. */
+		bool readFieldData(void);
+		/* Read the tile header and chunk index table at current file position, the start of field data region. */
+		bool readChunkTable(void);
+		/* Read one chunk of the field data region, decompressed to storage type elements. */
+		bool readChunk(uint64_t chunk_idx, std::vector<uchar> &raw);
 
 		bool bLoadFile = false;
 		//template<typename T> bool decodeFieldData();
@@ -132,6 +165,16 @@ namespace oph
 		std::vector<OphRealField> field_ampli;
 		std::vector<OphRealField> field_phase;
 		std::ifstream File;
+
+		//opened field data region
+		DataType fieldType = DataType::Null;
+		std::streamoff fieldOffset = 0;
+		const uchar* fieldBase = nullptr;
+		const uchar* mapBase = nullptr;
+		uint64_t mapSize = 0;
+		void* hMapFile = nullptr;
+		void* hMapping = nullptr;
+		int mapFd = -1;
 	};
 
 
@@ -157,7 +200,13 @@ namespace oph
 		void setFieldEncoding(const FldStore _fldStore, const FldCodeType _fldCodeType); //const DataType _cmplxFldType = DataType::Float64);
 		void setPhaseEncoding(const BPhaseCode _bPhaseCode, const double _phaseCodeMin, const double _phaseCodeMax);
 		void setPhaseEncoding(const BPhaseCode _bPhaseCode, const vec2 _phaseCodeRange);
-		//void setCompressedFormatType(const CompresType _comprsType);
+		void setCompressedFormatType(const CompresType _comprsType);
+		/* Storage type of field data : Float64, Float32 or Float16 */
+		void setDataType(const DataType _cmplxFldType);
+		/* Write on an I/O thread. At most two fields of one wavelength are queued, the writer blocks beyond that. */
+		void setAsyncWrite(const bool _bAsync) { this->bAsync = _bAsync; }
+		/* Store field data as tiles of _tileSizeX * _tileSizeY (FldStore::Tiled). 0 stores directly. */
+		void setTileSize(const uint _tileSizeX, const uint _tileSizeY);
 
 		void addWavelengthNComplexFieldData(const Real wavlen, const OphComplexField &data);
 		void addComplexFieldData(const OphComplexField &data);
@@ -168,12 +217,47 @@ namespace oph
 
 		bool save();
 
+		/* Streaming write : the headers are written first, then each wavelength channel straight from a complex buffer of pxNumX * pxNumY. */
+		bool beginStream();
+		bool writeComplexField(const Complex<Real>* data, uint wavelen_idx);
+		/* Tiled stream only : write one tile from a buffer of its own size, row by row. */
+		bool writeTile(const Complex<Real>* data, uint wavelen_idx, uint tile_x, uint tile_y);
+		/* Finish the file. With async write, it returns after queueing and waitStream() returns the result. */
+		bool endStream();
+		bool waitStream();
+
 	protected:
 		//template<typename T> uint64_t encodeFieldData();
 		//template<typename T> T encodePhase(const Real phase_angle, const Real min_p, const Real max_p, const double min_T, const double max_T);
 		uint64_t encodeFieldData();
 
+		struct ohcWriteJob {
+			uint64_t pos;		/* file position of raw plane, or chunk index of compressed plane */
+			bool bFinish;
+			std::vector<uchar> data;
+		};
+		void queueJob(ohcWriteJob &job);
+		void writeJob(ohcWriteJob &job);
+		void ioThreadFunc();
+		bool finishStream();
+
 		std::ofstream File;
+
+		//streaming state
+		bool bAsync = false;
+		bool bStreaming = false;
+		std::atomic<bool> bStreamOk{ false };
+		uint64_t fieldOff = 0;
+		uint64_t chunkEnd = 0;
+		ColorArran streamClrArrange = ColorArran::EachChanl;	//< caller's arrangement, restored by finishStream()
+		std::vector<uchar> seqtStage;
+		std::thread ioThread;
+		std::mutex ioMutex;
+		std::condition_variable ioCond;
+		std::condition_variable ioSpaceCond;
+		std::deque<ohcWriteJob> ioQueue;
+		uint64_t ioQueueBytes = 0;
+		uint64_t ioQueueLimit = 0;		//< bytes queued before queueJob() blocks
 	};
 }
 
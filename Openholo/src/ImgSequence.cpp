@@ -0,0 +1,285 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ImgSequence.h"
+#include "FileView.h"
+#include "sys.h"
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#include <strings.h>
+#endif
+
+using namespace oph;
+
+struct ImgSequence::Context {
+	std::vector<std::string> files;
+	bool bGray;
+	bool bUpSideDown;
+	std::vector<ImgFrame> ring;
+	std::vector<longlong> ringIndex;	///< frame held by each slot, -1 if none
+	std::vector<bool> ringValid;
+	size_t nextRead;
+	size_t nextOut;
+	bool bStop;
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::vector<std::thread> readers;
+
+	void reader(void)
+	{
+		const size_t nRing = ring.size();
+		std::unique_lock<std::mutex> lock(mtx);
+		while (true) {
+			cv.wait(lock, [this, nRing] { return bStop || nextRead >= files.size() || nextRead < nextOut + nRing; });
+			if (bStop || nextRead >= files.size()) break;
+			const size_t i = nextRead++;
+			lock.unlock();
+
+			ImgFrame frame;
+			const bool bOK = ImgSequence::decode(files[i].c_str(), frame, bGray, bUpSideDown);
+
+			lock.lock();
+			ring[i % nRing] = std::move(frame);
+			ringValid[i % nRing] = bOK;
+			ringIndex[i % nRing] = (longlong)i;
+			cv.notify_all();
+		}
+	}
+};
+
+ImgSequence::ImgSequence()
+	: ctx(nullptr)
+{
+}
+
+ImgSequence::~ImgSequence()
+{
+	close();
+}
+
+std::vector<std::string> ImgSequence::scan(const char* directory, const char* prefix, const char* ext)
+{
+	std::vector<std::string> files;
+	std::string dir = directory;
+	std::string head = prefix ? prefix : "";
+	std::string tail = ext ? ext : "";
+	if (!tail.empty() && tail[0] != '.') tail.insert(0, ".");
+
+#ifdef _WIN32
+	const std::string sep = "\\";
+	_finddatai64_t fd;
+	intptr_t handle = _findfirst64((dir + sep + head + "*" + tail).c_str(), &fd);
+	if (handle != -1) {
+		do {
+			if (!(fd.attrib & _A_SUBDIR)) files.push_back(dir + sep + fd.name);
+		} while (_findnext64(handle, &fd) == 0);
+		_findclose(handle);
+	}
+#else
+	const std::string sep = "/";
+	DIR* pDir = opendir(dir.c_str());
+	if (pDir) {
+		struct dirent* entry;
+		while ((entry = readdir(pDir)) != nullptr) {
+			std::string name = entry->d_name;
+			if (name.size() < head.size() + tail.size()) continue;
+			if (name.compare(0, head.size(), head) != 0) continue;
+			if (strcasecmp(name.c_str() + name.size() - tail.size(), tail.c_str()) != 0) continue;
+			files.push_back(dir + sep + name);
+		}
+		closedir(pDir);
+	}
+#endif
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+bool ImgSequence::decode(const char* fname, ImgFrame& frame, bool bGray, bool bUpSideDown)
+{
+	FileView view;
+	if (!view.open(fname) || view.length() < sizeof(fileheader) + sizeof(bitmapinfoheader)) {
+		LOG("<FAILED> Load image : %s\n", fname);
+		return false;
+	}
+
+	fileheader hf;
+	bitmapinfoheader hInfo;
+	memcpy(&hf, view.data(), sizeof(fileheader));
+	memcpy(&hInfo, view.data() + sizeof(fileheader), sizeof(bitmapinfoheader));
+	if (hf.signature[0] != 'B' || hf.signature[1] != 'M' || hInfo.bitsperpixel < 8 || hInfo.compression != OPH_COMPRESSION) {
+		LOG("<FAILED> Not supported BMP file : %s\n", fname);
+		return false;
+	}
+
+	// a negative height is a top-down bitmap.
+	const int w = (int)hInfo.width;
+	const int hSigned = (int)hInfo.height;
+	const int h = hSigned < 0 ? -hSigned : hSigned;
+	const int bpp = hInfo.bitsperpixel / 8;
+	const size_t nLine = (((size_t)w * bpp) + 3) & ~(size_t)3;
+	if (w <= 0 || h <= 0 || hf.fileoffset_to_pixelarray + nLine * h > view.length()) {
+		LOG("<FAILED> BMP file is truncated : %s\n", fname);
+		return false;
+	}
+
+	const int nOut = bGray ? 1 : bpp;
+	const bool bFlip = bUpSideDown != (hSigned < 0);
+	frame.path = fname;
+	frame.width = w;
+	frame.height = h;
+	frame.bytesperpixel = bpp;
+	frame.pixels.resize((size_t)w * h * nOut);
+
+	const uchar* pixel = view.data() + hf.fileoffset_to_pixelarray;
+	for (int y = 0; y < h; y++) {
+		const uchar* src = pixel + nLine * y;
+		uchar* dst = frame.pixels.data() + (size_t)(bFlip ? h - 1 - y : y) * w * nOut;
+		if (!bGray || bpp == 1)
+			memcpy(dst, src, (size_t)w * nOut);
+		else if (bpp == 2)
+			for (int x = 0; x < w; x++) dst[x] = src[x * 2];
+		else
+			for (int x = 0; x < w; x++) dst[x] = (uchar)(((uint)src[x * bpp + 0] + src[x * bpp + 1] + src[x * bpp + 2]) / 3);
+	}
+	return true;
+}
+
+bool ImgSequence::loadAll(const std::vector<std::string>& files, std::vector<ImgFrame>& frames, bool bGray, bool bUpSideDown, int nThreads)
+{
+	frames.clear();
+	frames.resize(files.size());
+	if (files.empty()) return true;
+
+	if (nThreads <= 0) nThreads = (int)std::thread::hardware_concurrency();
+	if (nThreads <= 0) nThreads = 1;
+	if ((size_t)nThreads > files.size()) nThreads = (int)files.size();
+
+	// files are taken in order from a shared counter, file reading overlaps with decoding.
+	std::mutex mtx;
+	size_t next = 0;
+	bool bOK = true;
+	auto reader = [&]() {
+		while (true) {
+			size_t i;
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				if (next >= files.size()) return;
+				i = next++;
+			}
+			if (!decode(files[i].c_str(), frames[i], bGray, bUpSideDown)) {
+				std::lock_guard<std::mutex> lock(mtx);
+				bOK = false;
+			}
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int t = 1; t < nThreads; t++)
+		threads.emplace_back(reader);
+	reader();
+	for (auto& t : threads) t.join();
+	return bOK;
+}
+
+bool ImgSequence::open(const std::vector<std::string>& files, bool bGray, bool bUpSideDown, int nThreads, int nRing)
+{
+	close();
+	if (files.empty()) return false;
+	if (nThreads < 1) nThreads = 1;
+	if (nRing < nThreads) nRing = nThreads;
+
+	ctx = new Context;
+	ctx->files = files;
+	ctx->bGray = bGray;
+	ctx->bUpSideDown = bUpSideDown;
+	ctx->ring.resize(nRing);
+	ctx->ringIndex.assign(nRing, -1);
+	ctx->ringValid.assign(nRing, false);
+	ctx->nextRead = 0;
+	ctx->nextOut = 0;
+	ctx->bStop = false;
+	for (int t = 0; t < nThreads; t++)
+		ctx->readers.emplace_back(&Context::reader, ctx);
+	return true;
+}
+
+bool ImgSequence::next(ImgFrame& frame)
+{
+	if (!ctx || ctx->nextOut >= ctx->files.size()) return false;
+
+	std::unique_lock<std::mutex> lock(ctx->mtx);
+	const size_t i = ctx->nextOut;
+	const size_t slot = i % ctx->ring.size();
+	ctx->cv.wait(lock, [this, i, slot] { return ctx->ringIndex[slot] == (longlong)i; });
+	frame = std::move(ctx->ring[slot]);
+	const bool bOK = ctx->ringValid[slot];
+	ctx->ringIndex[slot] = -1;
+	ctx->nextOut++;
+	ctx->cv.notify_all();
+	return bOK;
+}
+
+void ImgSequence::close()
+{
+	if (!ctx) return;
+	{
+		std::lock_guard<std::mutex> lock(ctx->mtx);
+		ctx->bStop = true;
+	}
+	ctx->cv.notify_all();
+	for (auto& t : ctx->readers) t.join();
+	delete ctx;
+	ctx = nullptr;
+}
+
+size_t ImgSequence::size()
+{
+	return ctx ? ctx->files.size() : 0;
+}
@@ -0,0 +1,131 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __ImgSequence_h
+#define __ImgSequence_h
+
+#include "include.h"
+
+#ifdef OPH_EXPORT
+#define OPH_DLL __declspec(dllexport)
+#else
+#define OPH_DLL __declspec(dllimport)
+#endif
+
+namespace oph
+{
+	/**
+	* @brief Decoded image of a sequence.
+	*/
+	struct OPH_DLL ImgFrame {
+		std::string path;
+		int width = 0;
+		int height = 0;
+		int bytesperpixel = 0;			///< of the file, the pixels are 1 byte per pixel when decoded as gray
+		std::vector<uchar> pixels;		///< rows of width * (gray ? 1 : bytesperpixel) bytes without padding
+	};
+
+	/**
+	* @brief Loader of image sequences (BMP) : directory scan, parallel decode and a ring of prefetched frames.
+	* @details Each file is opened once and decoded from a mapped view, the header and the pixels together.@n
+	*			After open(), reader threads decode the files ahead of next() into a ring of frames, so the
+	*			consumer only waits when it is faster than the readers.
+	*/
+	class OPH_DLL ImgSequence {
+	public:
+		ImgSequence();
+		~ImgSequence();
+		ImgSequence(const ImgSequence&) = delete;
+		ImgSequence& operator=(const ImgSequence&) = delete;
+
+		/**
+		* @brief Files of a directory whose name starts with prefix and ends with ext, sorted by name.
+		* @param[in] ext extension with or without the dot, e.g. "bmp"
+		*/
+		static std::vector<std::string> scan(const char* directory, const char* prefix, const char* ext);
+
+		/**
+		* @brief Decode a BMP file.
+		* @param[in] bGray convert to 8-bit gray : (B + G + R) / 3 for color images.
+		* @param[in] bUpSideDown first row of the pixels is the last row of the file (top row of the picture).
+		*/
+		static bool decode(const char* fname, ImgFrame& frame, bool bGray, bool bUpSideDown);
+
+		/**
+		* @brief Decode files concurrently.
+		* @param[in] nThreads number of reader threads, 0 : number of cores.
+		* @return Type: <B>bool</B>\n
+		*				If every file is decoded, the return value is <B>true</B>.
+		*/
+		static bool loadAll(const std::vector<std::string>& files, std::vector<ImgFrame>& frames, bool bGray, bool bUpSideDown, int nThreads = 0);
+
+		/**
+		* @brief Start prefetching a sequence.
+		* @param[in] nThreads number of reader threads.
+		* @param[in] nRing number of frames decoded ahead of next().
+		*/
+		bool open(const std::vector<std::string>& files, bool bGray, bool bUpSideDown, int nThreads = 2, int nRing = 4);
+
+		/**
+		* @brief Take the next frame of the sequence, waiting for it only if it is not decoded yet.
+		* @return Type: <B>bool</B>\n
+		*				<B>false</B> at the end of the sequence or if the frame can not be decoded.
+		*/
+		bool next(ImgFrame& frame);
+
+		/**
+		* @brief Stop the readers and drop the prefetched frames.
+		*/
+		void close();
+
+		size_t size();
+
+	private:
+		struct Context;
+		Context* ctx;
+	};
+}
+
+#endif // !__ImgSequence_h
@@ -51,6 +51,12 @@
 #include "sys.h"
 #include "ImgCodecOhc.h"
 #include "ImgControl.h"
+#include "ophFFT.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
 
 Openholo::Openholo(void)
 	: Base()
@@ -75,6 +81,7 @@ Openholo::Openholo(void)
 
 Openholo::~Openholo(void)
 {
+	waitImgSaving();
 	if (OHC_encoder) {
 		delete OHC_encoder;
 		OHC_encoder = nullptr;
@@ -83,7 +90,6 @@ Openholo::~Openholo(void)
 		delete OHC_decoder;
 		OHC_decoder = nullptr;
 	}
-	fftw_cleanup_threads();
 }
 
 bool Openholo::checkExtension(const char * fname, const char * ext)
@@ -102,9 +108,88 @@ bool Openholo::checkExtension(const char * fname, const char * ext)
 		return false;
 }
 
+namespace {
+	/**
+	* @brief Output file of the bitmap writer, written by gathered blocks.
+	*/
+	class BmpSink {
+	public:
+		BmpSink() : fp(nullptr), fd(-1) {}
+		~BmpSink() { close(); }
+
+		bool open(const char* fname)
+		{
+#ifdef _WIN32
+			fopen_s(&fp, fname, "wb");
+			return fp != nullptr;
+#else
+			fd = ::open(fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			return fd >= 0;
+#endif
+		}
+
+		/// write the buffers in order : one writev call on POSIX, sequential fwrite otherwise.
+		bool write(const void* const* buf, const size_t* len, int n)
+		{
+#ifdef _WIN32
+			for (int i = 0; i < n; i++)
+				if (len[i] && fwrite(buf[i], 1, len[i], fp) != len[i]) return false;
+			return true;
+#else
+			struct iovec iov[8];
+			size_t total = 0;
+			for (int i = 0; i < n; i++) {
+				iov[i].iov_base = const_cast<void*>(buf[i]);
+				iov[i].iov_len = len[i];
+				total += len[i];
+			}
+			struct iovec* cur = iov;
+			while (total > 0) {
+				ssize_t nWritten = writev(fd, cur, n - (int)(cur - iov));
+				if (nWritten <= 0) return false;
+				total -= nWritten;
+				while (nWritten > 0 && (size_t)nWritten >= cur->iov_len) nWritten -= (cur++)->iov_len;
+				if (nWritten > 0) {
+					cur->iov_base = (char*)cur->iov_base + nWritten;
+					cur->iov_len -= nWritten;
+				}
+			}
+			return true;
+#endif
+		}
+
+		bool close()
+		{
+			bool bOK = true;
+			if (fp) bOK = fclose(fp) == 0;
+#ifndef _WIN32
+			if (fd >= 0) bOK = ::close(fd) == 0;
+#endif
+			fp = nullptr;
+			fd = -1;
+			return bOK;
+		}
+
+	private:
+		FILE* fp;
+		int fd;
+	};
+}
+
 bool Openholo::saveAsImg(const char * fname, uint8_t bitsperpixel, uchar* src, int width, int height)
 {
+	return saveAsImg(fname, bitsperpixel, &src, 1, width, height);
+}
+
+bool Openholo::saveAsImg(const char* fname, uint8_t bitsperpixel, uchar** planes, int nPlanes, int width, int height)
+{
+	OPH_PROFILE("save");
 	LOG("Saving...%s...\n", fname);
+	if (!planes || (nPlanes != 1 && nPlanes != 3) || (nPlanes == 3 && bitsperpixel != 24))
+		return false;
+	for (int p = 0; p < nPlanes; p++)
+		if (!planes[p]) return false;
+
 	bool bOK = true;
 	auto start = CUR_TIME;
 	int _width = width, _height = height;
@@ -116,30 +201,22 @@ bool Openholo::saveAsImg(const char * fname, uint8_t bitsperpixel, uchar* src, i
 	int _headersize = sizeof(bitmap);
 	int _iColor = (hasColorTable) ? 256 : 0;
 
-
-	rgbquad *table = nullptr;
-
+	// headers and gray-scale palette.
+	std::vector<uchar> header(sizeof(fileheader) + sizeof(bitmapinfoheader) + _iColor * sizeof(rgbquad), 0);
 	if (hasColorTable) {
 		_headersize += _iColor * sizeof(rgbquad);
-		table = new rgbquad[_iColor];
-		memset(table, 0, sizeof(rgbquad) * _iColor);
+		rgbquad *table = (rgbquad*)&header[sizeof(fileheader) + sizeof(bitmapinfoheader)];
 		for (int i = 0; i < _iColor; i++) { // for gray-scale
 			table[i].rgbBlue = i;
 			table[i].rgbGreen = i;
 			table[i].rgbRed = i;
-		}		
+		}
 	}
 
 	_filesize += _headersize;
 
-	bool bConvert = _stricmp(PathFindExtensionA(fname) + 1, "bmp") ? true : false;
-
-	uchar *pBitmap = new uchar[_filesize];
-	memset(pBitmap, 0x00, _filesize);
-
 	bitmap bitmap;
 	memset(&bitmap, 0, sizeof(bitmap));
-	int iCur = 0;
 
 	bitmap.fileheader.signature[0] = 'B';
 	bitmap.fileheader.signature[1] = 'M';
@@ -156,52 +233,94 @@ bool Openholo::saveAsImg(const char * fname, uint8_t bitsperpixel, uchar* src, i
 	bitmap.bitmapinfoheader.ypixelpermeter = 0;// Y_PIXEL_PER_METER;
 	bitmap.bitmapinfoheader.xpixelpermeter = 0;// X_PIXEL_PER_METER;
 	bitmap.bitmapinfoheader.numcolorspallette = _iColor;
-	
-	memcpy(&pBitmap[iCur], &bitmap.fileheader, sizeof(fileheader));
-	iCur += sizeof(fileheader);
-	memcpy(&pBitmap[iCur], &bitmap.bitmapinfoheader, sizeof(bitmapinfoheader));
-	iCur += sizeof(bitmapinfoheader);
-	
-	if (hasColorTable) {
-		memcpy(&pBitmap[iCur], table, sizeof(rgbquad) * _iColor);
-		iCur += sizeof(rgbquad) * _iColor;
-	}
 
-	if (context_.bRotation) {
-		ImgControl *pControl = ImgControl::getInstance();
-		uchar *pTmp = new uchar[_pixelbytesize];
-		pControl->Rotate(180.0, src, pTmp, _width, _height, _width, _height, bitsperpixel / 8);
-		memcpy(&pBitmap[iCur], pTmp, _pixelbytesize);
-		delete[] pTmp;
-	}
-	else {
-		memcpy(&pBitmap[iCur], src, _pixelbytesize);
-	}
-
-	iCur += _pixelbytesize;
+	memcpy(&header[0], &bitmap.fileheader, sizeof(fileheader));
+	memcpy(&header[sizeof(fileheader)], &bitmap.bitmapinfoheader, sizeof(bitmapinfoheader));
+
+	// rows are written straight from the source unless they have to be rotated or merged.
+	const int ch = bitsperpixel / 8;
+	const bool bRotate = context_.bRotation && ch > 0;
+	const bool bDirect = nPlanes == 1 && !bRotate;
+
+	// one interleaved row of the output : the 180 degree rotation maps pixels as ImgControl::Rotate does,
+	// planes are merged as B, G, R from the last plane to the first as ophGen::mergeColor does.
+	const double radian = 180.0 * M_PI / 180.0;
+	const double cc = cos(radian);
+	const double ss = sin(-radian);
+	const double centerX = (double)_width / 2.0;
+	const double centerY = (double)_height / 2.0;
+	auto makeRow = [&](int y, uchar* dst) {
+		memset(dst, 0, _byteperline);
+		for (int x = 0; x < _width; x++) {
+			int origX = x, origY = y;
+			if (bRotate) {
+				origX = (int)(centerX + ((double)y - centerY)*ss + ((double)x - centerX)*cc);
+				origY = (int)(centerY + ((double)y - centerY)*cc - ((double)x - centerX)*ss);
+				if (origY < 0 || origY >= _height || origX < 0 || origX >= _width) continue;
+			}
+			if (nPlanes == 1)
+				memcpy(&dst[x * ch], &planes[0][origY * _byteperline + origX * ch], ch);
+			else {
+				for (int p = 0; p < nPlanes; p++)
+					dst[x * 3 + 2 - p] = planes[p][origY * _width + origX];
+			}
+		}
+	};
 
+	bool bConvert = _stricmp(PathFindExtensionA(fname) + 1, "bmp") ? true : false;
 
 	if (!bConvert) {
-		if (iCur != _filesize)
+		BmpSink sink;
+		if (!sink.open(fname))
 			bOK = false;
+		else if (bDirect) {
+			const void* buf[2] = { header.data(), planes[0] };
+			const size_t len[2] = { header.size(), (size_t)_pixelbytesize };
+			bOK = sink.write(buf, len, 2);
+		}
 		else {
-			FILE *fp;
-			fopen_s(&fp, fname, "wb");
-			if (fp == nullptr)
-				bOK = false;
-			else {
-				fwrite(pBitmap, 1, _filesize, fp);
-				fclose(fp);
+			// blocks of rows are prepared in parallel and written after the headers.
+			int nBlockRow = (1 << 20) / _byteperline;
+			if (nBlockRow > _height) nBlockRow = _height;
+			if (nBlockRow < 1) nBlockRow = 1;
+			std::vector<uchar> block((size_t)nBlockRow * _byteperline);
+			const void* buf[2] = { header.data(), block.data() };
+			size_t len[2] = { header.size(), 0 };
+			int nBuf = 2;
+			for (int y0 = 0; y0 < _height && bOK; y0 += nBlockRow) {
+				const int nRow = (_height - y0 < nBlockRow) ? _height - y0 : nBlockRow;
+				int y;
+#ifdef _OPENMP
+#pragma omp parallel for private(y)
+#endif
+				for (y = 0; y < nRow; y++)
+					makeRow(y0 + y, &block[(size_t)y * _byteperline]);
+				len[nBuf - 1] = (size_t)nRow * _byteperline;
+				bOK = sink.write(buf + 2 - nBuf, len + 2 - nBuf, nBuf);
+				nBuf = 1;
 			}
 		}
+		if (!sink.close()) bOK = false;
 	}
 	else {
+		// other formats are encoded from a whole bitmap in memory.
+		uchar *pBitmap = new uchar[_filesize];
+		memcpy(pBitmap, header.data(), header.size());
+		if (bDirect)
+			memcpy(&pBitmap[_headersize], planes[0], _pixelbytesize);
+		else {
+			int y;
+#ifdef _OPENMP
+#pragma omp parallel for private(y)
+#endif
+			for (y = 0; y < _height; y++)
+				makeRow(y, &pBitmap[_headersize + y * _byteperline]);
+		}
 		ImgControl *pControl = ImgControl::getInstance();
 		pControl->Save(fname, pBitmap, _filesize);
+		delete[] pBitmap;
 	}
 
-	if(hasColorTable && table) delete[] table;
-	delete[] pBitmap;
 	auto end = CUR_TIME;
 
 	auto during = ((std::chrono::duration<Real>)(end - start)).count();
@@ -211,9 +330,27 @@ bool Openholo::saveAsImg(const char * fname, uint8_t bitsperpixel, uchar* src, i
 	return bOK;
 }
 
+bool Openholo::saveAsImgAsync(const char* fname, uint8_t bitsperpixel, uchar** planes, int nPlanes, int width, int height)
+{
+	bool bPrev = waitImgSaving();
+	std::string path = fname;
+	std::vector<uchar*> src(planes, planes + nPlanes);
+	m_imgSaving = std::async(std::launch::async, [this, path, bitsperpixel, src, width, height]() mutable {
+		return saveAsImg(path.c_str(), bitsperpixel, src.data(), (int)src.size(), width, height);
+	});
+	return bPrev;
+}
+
+bool Openholo::waitImgSaving(void)
+{
+	if (!m_imgSaving.valid()) return true;
+	return m_imgSaving.get();
+}
+
 
 uchar * Openholo::loadAsImg(const char * fname)
 {
+	OPH_PROFILE("load");
 	FILE *infile;
 	fopen_s(&infile, fname, "rb");
 	if (infile == nullptr) { LOG("No such file"); return 0; }
@@ -244,6 +381,7 @@ uchar * Openholo::loadAsImg(const char * fname)
 
 bool Openholo::saveAsOhc(const char * fname)
 {
+	OPH_PROFILE("save");
 	std::string fullname = fname;
 	if (!checkExtension(fname, ".ohc")) fullname.append(".ohc");
 	OHC_encoder->setFileName(fullname.c_str());
@@ -255,20 +393,31 @@ bool Openholo::saveAsOhc(const char * fname)
 	OHC_encoder->getOHCheader(header);
 	auto wavelength_num = header.fieldInfo.wavlenNum;
 
-	for (uint i = 0; i < wavelength_num; i++)
-		OHC_encoder->addComplexFieldData(complex_H[i]);
+	// stream each channel straight from complex_H
+	if (!OHC_encoder->beginStream()) return false;
+	for (uint i = 0; i < wavelength_num; i++) {
+		if (!OHC_encoder->writeComplexField(complex_H[i], i)) {
+			OHC_encoder->endStream();
+			OHC_encoder->waitStream();
+			return false;
+		}
+	}
 
-	if (!OHC_encoder->save()) return false;
+	return OHC_encoder->endStream();
+}
 
-	return true;
+bool Openholo::waitSaveAsOhc(void)
+{
+	return OHC_encoder->waitStream();
 }
 
 bool Openholo::loadAsOhc(const char * fname)
 {
+	OPH_PROFILE("load");
 	std::string fullname = fname;
 	if (!checkExtension(fname, ".ohc")) fullname.append(".ohc");
 	OHC_decoder->setFileName(fullname.c_str());
-	if (!OHC_decoder->load()) return false;
+	if (!OHC_decoder->open()) return false;
 
 	context_.waveNum = OHC_decoder->getNumOfWavlen();
 	context_.pixel_number = OHC_decoder->getNumOfPixel();
@@ -280,7 +429,18 @@ bool Openholo::loadAsOhc(const char * fname)
 	for (int i = 0; i < wavelengthArray.size(); i++)
 		context_.wave_length[i] = wavelengthArray[i];
 	
-	OHC_decoder->getComplexFieldData(&complex_H);
+	const int nWave = context_.waveNum;
+	const long long int pnXY = context_.pixel_number[_X] * context_.pixel_number[_Y];
+	if (complex_H == nullptr)
+		complex_H = new Complex<Real>*[nWave];
+	for (int i = 0; i < nWave; i++) {
+		complex_H[i] = new Complex<Real>[pnXY];
+		if (!OHC_decoder->decodeComplexField(complex_H[i], i)) {
+			OHC_decoder->close();
+			return false;
+		}
+	}
+	OHC_decoder->close();
 
 	context_.k = (2 * M_PI) / context_.wave_length[0];
 	context_.ss[_X] = context_.pixel_number[_X] * context_.pixel_pitch[_X];
@@ -291,6 +451,7 @@ bool Openholo::loadAsOhc(const char * fname)
 
 bool Openholo::loadAsImgUpSideDown(const char * fname, uchar* dst)
 {
+	OPH_PROFILE("load");
 	FILE *infile;
 	fopen_s(&infile, fname, "rb");
 	if (infile == nullptr) { LOG("No such file"); return false; }
@@ -362,48 +523,63 @@ bool Openholo::getImgSize(int & w, int & h, int & bytesperpixel, const char * fn
 
 void Openholo::ImageRotation(double rotate, uchar* src, uchar* dst, int w, int h, int channels)
 {
+	OPH_PROFILE("scale");
 	auto begin = CUR_TIME;
 	int channel = channels;
 	int nBytePerLine = ((w * channel) + 3) & ~3;
 
-	int origX, origY;
 	double radian = rotate * M_PI / 180.0;
 	double cc = cos(radian);
 	double ss = sin(-radian);
 	double centerX = (double)w / 2.0;
 	double centerY = (double)h / 2.0;
 
-	uchar pixel;
-	uchar R, G, B;
+	// per-column terms of the source coordinates, the sums keep the evaluation order of the per-pixel formula.
+	std::vector<double> colX(w), colY(w);
+	for (int x = 0; x < w; x++) {
+		colX[x] = ((double)x - centerX)*cc;
+		colY[x] = ((double)x - centerX)*ss;
+	}
 
 	int num_threads = 1;
-	for (int y = 0; y < h; y++) {
-		for (int x = 0; x < w; x++) {
-			origX = (int)(centerX + ((double)y - centerY)*ss + ((double)x - centerX)*cc);
-			origY = (int)(centerY + ((double)y - centerY)*cc - ((double)x - centerX)*ss);
-
-			pixel = 0;
-			R = G = B = 0;
-			if ((origY >= 0 && origY < h) && (origX >= 0 && origX < w)) {
-				int offsetX = origX * channel;
-				int offsetY = origY * nBytePerLine;
-				B = src[offsetY + offsetX + 0];
-				G = src[offsetY + offsetX + 1];
-				R = src[offsetY + offsetX + 2];
+#ifdef _OPENMP
+	int y;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+#pragma omp for private(y)
+		for (y = 0; y < h; y++)
+#else
+		for (int y = 0; y < h; y++)
+#endif
+		{
+			const double rowX = centerX + ((double)y - centerY)*ss;
+			const double rowY = centerY + ((double)y - centerY)*cc;
+			uchar* dstLine = dst + y * nBytePerLine;
+			for (int x = 0; x < w; x++) {
+				int origX = (int)(rowX + colX[x]);
+				int origY = (int)(rowY - colY[x]);
+				// the source pointer is formed only for samples inside the image.
+				if ((origY < 0 || origY >= h) || (origX < 0 || origX >= w)) {
+					if (channel == 1) dstLine[x] = 0;
+					else if (channel == 3) dstLine[x * 3 + 0] = dstLine[x * 3 + 1] = dstLine[x * 3 + 2] = 0;
+					continue;
+				}
+				const uchar* pixel = src + origY * nBytePerLine + origX * channel;
 
-			}
-			if (channel == 1) {
-				dst[y * nBytePerLine + x] = pixel;
-			}
-			else if (channel == 3) {
-				int tmpX = x * 3;
-				int tmpY = y * nBytePerLine;
-				dst[tmpY + tmpX + 0] = B;
-				dst[tmpY + tmpX + 1] = G;
-				dst[tmpY + tmpX + 2] = R;
+				if (channel == 1) {
+					dstLine[x] = pixel[0];
+				}
+				else if (channel == 3) {
+					dstLine[x * 3 + 0] = pixel[0];
+					dstLine[x * 3 + 1] = pixel[1];
+					dstLine[x * 3 + 2] = pixel[2];
+				}
 			}
 		}
+#ifdef _OPENMP
 	}
+#endif
 	auto end = CUR_TIME;
 	LOG("Image Rotated (%d threads): (%d/%d) (%lf degree) : %lf(s)\n",
 		num_threads,
@@ -411,89 +587,88 @@ void Openholo::ImageRotation(double rotate, uchar* src, uchar* dst, int w, int h
 		((chrono::duration<Real>)(end - begin)).count());
 }
 
-void Openholo::imgScaleBilinear(uchar* src, uchar* dst, int w, int h, int neww, int newh, int channels)
+void Openholo::imgScaleBilinear(const uchar* src, uchar* dst, int w, int h, int neww, int newh, int channels)
 {
+	OPH_PROFILE("scale");
+	if (channels != 1 && channels != 3) return;
+
 	auto begin = CUR_TIME;
 	int channel = channels;
 	int nBytePerLine = ((w * channel) + 3) & ~3;
 	int nNewBytePerLine = ((neww * channel) + 3) & ~3;
+	int nDstLine = (channel == 1) ? neww : nNewBytePerLine;
 	int num_threads = 1;
+
+	// Q11 fixed-point weights : the vertical pass is at most 255 << 11 and the horizontal one 255 << 22,
+	// the rounding of the weights changes the result by less than 1 LSB.
+	const int SHIFT = 11;
+	const uint32_t ONE = 1 << SHIFT;
+
+	// source index and weight of each destination column and row, the positions as in the per-pixel formula.
+	std::vector<int> colIdx(neww * channel);
+	std::vector<uint32_t> colW(neww);
+	for (int x = 0; x < neww; x++) {
+		float gx = (x / (float)neww) * (w - 1);
+		int gxi = (int)gx;
+		colW[x] = (uint32_t)((gx - gxi) * ONE + 0.5f);
+		for (int c = 0; c < channel; c++)
+			colIdx[x * channel + c] = gxi * channel + c;
+	}
+	std::vector<int> rowIdx(newh);
+	std::vector<uint32_t> rowW(newh);
+	for (int y = 0; y < newh; y++) {
+		float gy = (y / (float)newh) * (h - 1);
+		rowIdx[y] = (int)gy;
+		rowW[y] = (uint32_t)((gy - rowIdx[y]) * ONE + 0.5f);
+	}
+
+	// the columns read by the destination : [first, last + 1] pixels of the source row.
+	const int nSpan = (neww > 0) ? (colIdx[(neww - 1) * channel] / channel + 2) * channel : 0;
+	const int nRowLen = (nSpan < w * channel) ? nSpan : w * channel;
+
 #ifdef _OPENMP
 	int y;
 #pragma omp parallel
 	{
 		num_threads = omp_get_num_threads();
+#else
+	{
+#endif
+		std::vector<uint32_t> line(nRowLen + channel);
+		uint32_t* tmp = line.data();
+#ifdef _OPENMP
 #pragma omp for private(y)
 		for (y = 0; y < newh; y++)
 #else
 		for (int y = 0; y < newh; y++)
 #endif
 		{
-			int nbppY = y * nNewBytePerLine;
-			for (int x = 0; x < neww; x++)
-			{
-				float gx = (x / (float)neww) * (w - 1);
-				float gy = (y / (float)newh) * (h - 1);
-
-				int gxi = (int)gx;
-				int gyi = (int)gy;
-
-				if (channel == 1) {
-					uint32_t a00, a01, a10, a11;					
-
-					a00 = src[gxi + 0 + gyi * nBytePerLine];
-					a01 = src[gxi + 1 + gyi * nBytePerLine];
-					a10 = src[gxi + 0 + (gyi + 1) * nBytePerLine];
-					a11 = src[gxi + 1 + (gyi + 1) * nBytePerLine];
-
-					float dx = gx - gxi;
-					float dy = gy - gyi;
-
-					float w1 = (1 - dx) * (1 - dy);
-					float w2 = dx * (1 - dy);
-					float w3 = (1 - dx) * dy;
-					float w4 = dx * dy;
+			// vertical pass over the contiguous source rows.
+			const uchar* top = src + rowIdx[y] * nBytePerLine;
+			const uchar* bottom = top + nBytePerLine;
+			const uint32_t fy = rowW[y];
+			const uint32_t fy1 = ONE - fy;
+			if (fy == 0) {
+				for (int i = 0; i < nRowLen; i++)
+					tmp[i] = (uint32_t)top[i] << SHIFT;
+			}
+			else {
+				for (int i = 0; i < nRowLen; i++)
+					tmp[i] = top[i] * fy1 + bottom[i] * fy;
+			}
 
-					dst[x + y * neww] = int(a00 * w1 + a01 * w2 + a10 * w3 + a11 * w4);
-				}
-				else if (channel == 3) {
-					uint32_t b00[3], b01[3], b10[3], b11[3];
-					int srcX = gxi * channel;
-					int dstX = x * channel;
-
-					b00[0] = src[srcX + 0 + gyi * nBytePerLine];
-					b00[1] = src[srcX + 1 + gyi * nBytePerLine];
-					b00[2] = src[srcX + 2 + gyi * nBytePerLine];
-					
-					b01[0] = src[srcX + 3 + gyi * nBytePerLine];
-					b01[1] = src[srcX + 4 + gyi * nBytePerLine];
-					b01[2] = src[srcX + 5 + gyi * nBytePerLine];
-
-					b10[0] = src[srcX + 0 + (gyi + 1) * nBytePerLine];
-					b10[1] = src[srcX + 1 + (gyi + 1) * nBytePerLine];
-					b10[2] = src[srcX + 2 + (gyi + 1) * nBytePerLine];
-
-					b11[0] = src[srcX + 3 + (gyi + 1) * nBytePerLine];
-					b11[1] = src[srcX + 4 + (gyi + 1) * nBytePerLine];
-					b11[2] = src[srcX + 5 + (gyi + 1) * nBytePerLine];
-					
-					float dx = gx - gxi;
-					float dy = gy - gyi;
-
-					float w1 = (1 - dx) * (1 - dy);
-					float w2 = dx * (1 - dy);
-					float w3 = (1 - dx) * dy;
-					float w4 = dx * dy;
-
-					dst[dstX + 0 + nbppY] = int(b00[0] * w1 + b01[0] * w2 + b10[0] * w3 + b11[0] * w4);
-					dst[dstX + 1 + nbppY] = int(b00[1] * w1 + b01[1] * w2 + b10[1] * w3 + b11[1] * w4);
-					dst[dstX + 2 + nbppY] = int(b00[2] * w1 + b01[2] * w2 + b10[2] * w3 + b11[2] * w4);
+			// horizontal pass with the column table.
+			uchar* out = dst + y * nDstLine;
+			for (int x = 0; x < neww; x++) {
+				const uint32_t fx = colW[x];
+				const uint32_t fx1 = ONE - fx;
+				for (int c = 0; c < channel; c++) {
+					const int i = colIdx[x * channel + c];
+					out[x * channel + c] = (uchar)((tmp[i] * fx1 + tmp[i + channel] * fx) >> (2 * SHIFT));
 				}
 			}
 		}
-#ifdef _OPENMP
 	}
-#endif
 	auto end = CUR_TIME;
 	LOG("Scaled img size (%d threads): (%d/%d) => (%d/%d) : %lf(s)\n",
 		num_threads,
@@ -539,10 +714,14 @@ void Openholo::fft1(int n, Complex<Real>* in, int sign, uint flag)
 
 	if (!bIn) delete[] in;
 
-	if (sign == OPH_FORWARD)
+	if (sign == OPH_FORWARD) {
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
 		plan_fwd = fftw_plan_dft_1d(n, fft_in, fft_out, sign, flag);
-	else if (sign == OPH_BACKWARD)
+	}
+	else if (sign == OPH_BACKWARD) {
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
 		plan_bwd = fftw_plan_dft_1d(n, fft_in, fft_out, sign, flag);
+	}
 	else {
 		LOG("failed fftw : wrong sign");
 		fftFree();
@@ -574,10 +753,14 @@ void Openholo::fft2(oph::ivec2 n, Complex<Real>* in, int sign, uint flag)
 
 	fft_sign = sign;
 
-	if (sign == OPH_FORWARD)
+	if (sign == OPH_FORWARD) {
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
 		plan_fwd = fftw_plan_dft_2d(pny, pnx, fft_in, fft_out, sign, flag);
-	else if (sign == OPH_BACKWARD)
+	}
+	else if (sign == OPH_BACKWARD) {
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
 		plan_bwd = fftw_plan_dft_2d(pny, pnx, fft_in, fft_out, sign, flag);
+	}
 	else {
 		LOG("failed fftw : wrong sign");
 		fftFree();
@@ -608,10 +791,14 @@ void Openholo::fft3(oph::ivec3 n, Complex<Real>* in, int sign, uint flag)
 
 	if (!bIn) delete[] in;
 
-	if (sign == OPH_FORWARD)
+	if (sign == OPH_FORWARD) {
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
 		plan_fwd = fftw_plan_dft_3d(pnz, pny, pnx, fft_in, fft_out, sign, flag);
-	else if (sign == OPH_BACKWARD)
+	}
+	else if (sign == OPH_BACKWARD) {
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
 		plan_bwd = fftw_plan_dft_3d(pnz, pny, pnx, fft_in, fft_out, sign, flag);
+	}
 	else {
 		LOG("failed fftw : wrong sign");
 		fftFree();
@@ -621,6 +808,7 @@ void Openholo::fft3(oph::ivec3 n, Complex<Real>* in, int sign, uint flag)
 
 void Openholo::fftExecute(Complex<Real>* out, bool bReverse)
 {
+	OPH_PROFILE("fft");
 	if (fft_sign == OPH_FORWARD)
 		fftw_execute(plan_fwd);
 	else if (fft_sign == OPH_BACKWARD)
@@ -631,6 +819,7 @@ void Openholo::fftExecute(Complex<Real>* out, bool bReverse)
 		fftFree();
 		return;
 	}
+	OPH_PROFILE_COUNT(PROF_FFT, 1);
 
 	if (!bReverse) {
 		int i;
@@ -660,6 +849,7 @@ void Openholo::fftExecute(Complex<Real>* out, bool bReverse)
 
 void Openholo::fftFree(void)
 {
+	std::unique_lock<std::mutex> lock(ophFFT::plannerLock());
 	if (plan_fwd) {
 		fftw_destroy_plan(plan_fwd);
 		plan_fwd = nullptr;
@@ -668,6 +858,7 @@ void Openholo::fftFree(void)
 		fftw_destroy_plan(plan_bwd);
 		plan_fwd = nullptr;
 	}
+	lock.unlock();
 	fftw_free(fft_in);
 	fftw_free(fft_out);
 
@@ -693,7 +884,10 @@ void Openholo::fftwShift(Complex<Real>* src, Complex<Real>* dst, int nx, int ny,
 
 	fftw_plan plan = nullptr;
 	if (!plan_fwd && !plan_bwd) {
-		plan = fftw_plan_dft_2d(ny, nx, in, out, type, OPH_ESTIMATE);
+		{
+			std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+			plan = fftw_plan_dft_2d(ny, nx, in, out, type, OPH_ESTIMATE);
+		}
 		fftw_execute(plan);
 	}
 	else {
@@ -715,8 +909,10 @@ void Openholo::fftwShift(Complex<Real>* src, Complex<Real>* dst, int nx, int ny,
 	}
 	fftw_free(in);
 	fftw_free(out);
-	if (plan)
+	if (plan) {
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
 		fftw_destroy_plan(plan);
+	}
 
 	memset(dst, 0, sizeof(Complex<Real>)*nx*ny);
 	fftShift(nx, ny, tmp, dst);
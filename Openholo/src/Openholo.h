@@ -54,7 +54,9 @@
 #include "fftw3.h"
 
 #include "ImgCodecOhc.h"
+#include "Profiler.h"
 #include <vector>
+#include <future>
 
 using namespace oph;
 
@@ -121,6 +123,31 @@ public:
 	*/
 	virtual bool saveAsImg(const char* fname, uint8_t bitsperpixel, uchar* src, int width, int height);
 
+	/**
+	* @brief Function for creating image files from color planes
+	* @details A bitmap is written row by row straight from the sources without an image-sized buffer :
+	*			the rows are rotated (context_.bRotation) and the planes are interleaved on the fly.
+	* @param[in] planes 1 image of bitsperpixel with 4-byte aligned rows, or 3 planes of width * height bytes merged as a 24-bit image
+	* @param[in] nPlanes 1 or 3
+	*/
+	bool saveAsImg(const char* fname, uint8_t bitsperpixel, uchar** planes, int nPlanes, int width, int height);
+
+	/**
+	* @brief Function for creating image files on an I/O thread
+	* @details The previous asynchronous write is finished first. The sources must not be changed
+	*			or freed until waitImgSaving() returns.
+	* @return Type: <B>bool</B>\n
+	*				Result of the previous asynchronous write, <B>true</B> if there was none.
+	*/
+	bool saveAsImgAsync(const char* fname, uint8_t bitsperpixel, uchar** planes, int nPlanes, int width, int height);
+
+	/**
+	* @brief Wait for the asynchronous image write.
+	* @return Type: <B>bool</B>\n
+	*				Result of the write, <B>true</B> if there was none.
+	*/
+	bool waitImgSaving(void);
+
 	/**
 	* @brief Function for loading image files
 	* @param[in] fname Input file name
@@ -139,6 +166,36 @@ public:
 	*/
 	virtual bool saveAsOhc(const char *fname);
 
+	/**
+	* @brief Function to wait for OHC file written by background I/O thread
+	* @details With setAsyncWriteOHC(true), saveAsOhc returns after encoding and the file is completed in background.
+	* @return Type: <B>bool</B>\n
+	*				If the succeeds to write OHC file, the return value is <B>true</B>.\n
+	*				If the fails to write OHC file, the return value is <B>false</B>.
+	*/
+	bool waitSaveAsOhc(void);
+
+	/**
+	* @brief Function for setting the data type of the field written to OHC file
+	* @param[in] data_type Float64, Float32 or Float16
+	*/
+	inline void setDataTypeOHC(const DataType data_type)
+		{ OHC_encoder->setDataType(data_type); }
+
+	/**
+	* @brief Function for setting the compression of the field written to OHC file
+	* @param[in] compress_type CompresType::Null or CompresType::Deflate(needs build with _USE_ZLIB)
+	*/
+	inline void setCompressedFormatTypeOHC(const CompresType compress_type)
+		{ OHC_encoder->setCompressedFormatType(compress_type); }
+
+	/**
+	* @brief Function for writing OHC file in background I/O thread
+	* @param[in] bAsync If true, saveAsOhc returns after encoding, see waitSaveAsOhc()
+	*/
+	inline void setAsyncWriteOHC(const bool bAsync)
+		{ OHC_encoder->setAsyncWrite(bAsync); }
+
 
 	/**
 	* @brief Function to read OHC file
@@ -223,7 +280,7 @@ protected:
 	* @param[in] neww Width to replace.
 	* @param[in] newh Height to replace.
 	*/
-	void imgScaleBilinear(uchar* src, uchar* dst, int w, int h, int neww, int newh, int channels = 1);
+	void imgScaleBilinear(const uchar* src, uchar* dst, int w, int h, int neww, int newh, int channels = 1);
 	void ImageRotation(double rotate, uchar* src, uchar* dst, int w, int h, int channels);
 	/**
 	* @brief Function for convert image format to gray8
@@ -301,6 +358,8 @@ private:
 	fftw_complex *fft_in, *fft_out;
 	int pnx, pny, pnz;
 	int fft_sign;
+	/// pending write of saveAsImgAsync().
+	std::future<bool> m_imgSaving;
 
 protected:
 	OphConfig context_;
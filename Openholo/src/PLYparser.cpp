@@ -44,6 +44,12 @@
 //M*/
 
 #include "PLYparser.h"
+#include "FileView.h"
+#include "sys.h"
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 PLYparser::PLYparser()
 {
@@ -135,309 +141,750 @@ bool PLYparser::findIdxOfPropertiesAndElement(const std::vector<PlyElement> &ele
 	else return false;
 }
 
-bool PLYparser::loadPLY(const std::string& fileName, ulonglong &n_points, int &color_channels, Real** vertexArray, Real** colorArray, Real** phaseArray, bool &isPhaseParse) {
-	std::string inputPath = fileName;
-	if ((fileName.find(".ply") == std::string::npos) && (fileName.find(".PLY") == std::string::npos)) inputPath += ".ply";
-	std::ifstream File(inputPath, std::ios::in | std::ios::binary);
+Real PLYparser::readBinaryValue(const uchar* src, Type type, bool bSwap)
+{
+	uchar b[8];
+	int nSize;
+	switch (type) {
+	case Type::INT8: case Type::UINT8: nSize = 1; break;
+	case Type::INT16: case Type::UINT16: nSize = 2; break;
+	case Type::INT32: case Type::UINT32: case Type::FLOAT32: nSize = 4; break;
+	case Type::FLOAT64: nSize = 8; break;
+	default: return 0.0;
+	}
+	if (bSwap) {
+		for (int i = 0; i < nSize; i++) b[i] = src[nSize - 1 - i];
+	}
+	else
+		memcpy(b, src, nSize);
+
+	switch (type) {
+	case Type::INT8: return (Real)*(const int8_t*)b;
+	case Type::UINT8: return (Real)*(const uint8_t*)b;
+	case Type::INT16: { int16_t v; memcpy(&v, b, 2); return (Real)v; }
+	case Type::UINT16: { uint16_t v; memcpy(&v, b, 2); return (Real)v; }
+	case Type::INT32: { int32_t v; memcpy(&v, b, 4); return (Real)v; }
+	case Type::UINT32: { uint32_t v; memcpy(&v, b, 4); return (Real)v; }
+	case Type::FLOAT32: { float v; memcpy(&v, b, 4); return (Real)v; }
+	case Type::FLOAT64: { double v; memcpy(&v, b, 8); return (Real)v; }
+	default: return 0.0;
+	}
+}
 
-	bool isBinary = false;
-	bool isBigEndian = false;
-	std::vector<PlyElement> elements;
-	std::vector<std::string> comments;
-	std::vector<std::string> objInfo;
+const uchar* PLYparser::skipBinaryElement(const PlyElement &element, const uchar* ptr, const uchar* end, bool bSwap)
+{
+	for (longlong e = 0; e < element.size; ++e) {
+		for (size_t j = 0; j < element.properties.size(); ++j) {
+			const PlyProperty &prop = element.properties[j];
+			const int nSize = PropertyTable[prop.propertyType].first;
+			if (prop.isList) {
+				const int nList = PropertyTable[prop.listType].first;
+				if (end - ptr < nList) return nullptr;
+				const longlong nCnt = (longlong)readBinaryValue(ptr, prop.listType, bSwap);
+				ptr += nList;
+				if (nCnt < 0 || (ulonglong)(end - ptr) < (ulonglong)nCnt * nSize) return nullptr;
+				ptr += nCnt * nSize;
+			}
+			else {
+				if (end - ptr < nSize) return nullptr;
+				ptr += nSize;
+			}
+		}
+	}
+	return ptr;
+}
 
-	if (File.is_open()) {
-		//parse header
-		std::string line;
-		std::getline(File, line);
-		std::istringstream lineStr(line);
-		std::string token;
-		lineStr.clear();
-		lineStr >> token;
+bool PLYparser::decodeBinaryPLY(const std::string& fileName, std::streamoff dataOffset, bool isBigEndian,
+	const std::vector<PlyElement> &elements, longlong idxE_vertex, longlong idxE_color, int idxP_channel,
+	const int idxP[7], bool bVertexColor, int &color_channels, Real* vertexArray, Real* colorArray, Real* phaseArray)
+{
+	FileView view;
+	if (!view.open(fileName) || (size_t)dataOffset > view.length()) {
+		std::cerr << "Error : Failed mapping ply file..." << std::endl;
+		return false;
+	}
 
-		if ((token != "ply") && (token != "PLY")) {
-			std::cerr << "Error : Failed loading ply file..." << std::endl;
-			File.close();
-			return false;
-		}
-		else {
-#ifdef _DEBUG
-			std::cout << "Parsing *.PLY file for OpenHolo Point Cloud Generation..." << std::endl;
-#endif
-			//parse PLY header
-			while (std::getline(File, line)) {
-				//std::istringstream lineStr(line);
-				lineStr.clear();
-				lineStr.str(line);
-				std::istream(lineStr.rdbuf()) >> token;
+	const uint16_t one = 1;
+	const bool bHostBigEndian = *(const uchar*)&one == 0;
+	const bool bSwap = isBigEndian != bHostBigEndian;
 
-				if (token == "comment") {
-					comments.push_back((8 > 0) ? line.erase(0, 8) : line);
-				}
-				else if (token == "format") {
-					std::string str;
-					lineStr.clear();
-					lineStr >> str;
-					if (str == "binary_little_endian") isBinary = true;
-					else if (str == "binary_big_endian") isBinary = isBigEndian = true;
-				}
-				else if (token == "element") {
-					elements.emplace_back(lineStr);
-				}
-				else if (token == "property") {
-					if (!elements.size()) std::cerr << "No Elements defined, file is malformed" << std::endl;
-					elements.back().properties.emplace_back(lineStr);
-				}
-				else if (token == "obj_info") objInfo.push_back((9 > 0) ? line.erase(0, 9) : line);
-				else if (token == "end_header") break;
+	const uchar* ptr = view.data() + dataOffset;
+	const uchar* end = view.data() + view.length();
+
+	for (size_t idxE = 0; idxE < elements.size(); ++idxE) {
+		const PlyElement &element = elements[idxE];
+		const size_t nProp = element.properties.size();
+
+		// offset table of the record, valid while no list property is met.
+		std::vector<size_t> offset(nProp, 0);
+		size_t stride = 0;
+		bool bFixed = true;
+		for (size_t j = 0; j < nProp; ++j) {
+			if (element.properties[j].isList) {
+				bFixed = false;
+				break;
 			}
+			offset[j] = stride;
+			stride += PropertyTable[element.properties[j].propertyType].first;
+		}
 
-#ifdef _DEBUG
-			//print comment list
-			for (auto cmt : comments) {
-				std::cout << "Comment : " << cmt << std::endl;
+		if (!bFixed) {
+			if ((longlong)idxE == idxE_vertex) {
+				std::cerr << "Error : list properties of vertices are not supported..." << std::endl;
+				return false;
 			}
+			// variable-size records (e.g. face lists) : skip them.
+			ptr = skipBinaryElement(element, ptr, end, bSwap);
+			if (!ptr) return false;
+			continue;
+		}
 
-			//print element and property list
-			for (auto elmnt : elements) {
-				std::cout << "Element - " << elmnt.name << " : ( " << elmnt.size << " )" << std::endl;
-				for (auto Property : elmnt.properties) {
-					auto tmp = PropertyTable[Property.propertyType].second;
-					std::cout << "\tProperty : " << Property.name << " : ( " << PropertyTable[Property.propertyType].second << " )" << std::endl;
-				}
+		if ((ulonglong)(end - ptr) < (ulonglong)stride * element.size) {
+			std::cerr << "Error : ply file is truncated..." << std::endl;
+			return false;
+		}
+
+		if ((longlong)idxE == idxE_vertex) {
+			Type type[7];
+			size_t off[7];
+			for (int k = 0; k < 7; k++) {
+				type[k] = idxP[k] >= 0 ? element.properties[idxP[k]].propertyType : Type::INVALID;
+				off[k] = idxP[k] >= 0 ? offset[idxP[k]] : 0;
 			}
+			const bool bColorInt[3] = {
+				type[3] != Type::FLOAT32 && type[3] != Type::FLOAT64,
+				type[4] != Type::FLOAT32 && type[4] != Type::FLOAT64,
+				type[5] != Type::FLOAT32 && type[5] != Type::FLOAT64
+			};
+
+			const longlong nRecord = element.size;
+			longlong e;
+#ifdef _OPENMP
+#pragma omp parallel for private(e)
 #endif
-			longlong idxE_color = -1;
-			int idxP_channel = -1;
-			bool ok_channel = findIdxOfPropertiesAndElement(elements, "color", "channel", idxE_color, idxP_channel);
+			for (e = 0; e < nRecord; ++e) {
+				const uchar* rec = ptr + e * stride;
+				vertexArray[3 * e + 0] = readBinaryValue(rec + off[0], type[0], bSwap);
+				vertexArray[3 * e + 1] = readBinaryValue(rec + off[1], type[1], bSwap);
+				vertexArray[3 * e + 2] = readBinaryValue(rec + off[2], type[2], bSwap);
+				if (bVertexColor) {
+					for (int c = 0; c < 3; c++) {
+						Real v = readBinaryValue(rec + off[3 + c], type[3 + c], bSwap);
+						colorArray[3 * e + c] = bColorInt[c] ? (Real)((float)v / 255.f) : v;
+					}
+				}
+				if (phaseArray) phaseArray[e] = readBinaryValue(rec + off[6], type[6], bSwap);
+			}
+		}
+		else if ((longlong)idxE == idxE_color && idxP_channel >= 0 && element.size > 0) {
+			color_channels = (int)readBinaryValue(ptr + offset[idxP_channel], element.properties[idxP_channel].propertyType, bSwap);
+		}
+		ptr += stride * element.size;
+	}
+	return true;
+}
 
-			longlong idxE_vertex = -1;
-			int idxP_x = -1;
-			int idxP_y = -1;
-			int idxP_z = -1;
-			bool ok_vertex = findIdxOfPropertiesAndElement(elements, "vertex", "x", idxE_vertex, idxP_x);
-			ok_vertex = findIdxOfPropertiesAndElement(elements, "vertex", "y", idxE_vertex, idxP_y);
-			ok_vertex = findIdxOfPropertiesAndElement(elements, "vertex", "z", idxE_vertex, idxP_z);
-			if (!ok_vertex) {
-				std::cerr << "Error : file is not having vertices data..." << std::endl;
-				return false;
+namespace {
+	inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+	/// integer prefix of a token, as std::stoi.
+	inline int scanInt(const char* s, const char* e)
+	{
+		bool bNeg = false;
+		if (s < e && (*s == '-' || *s == '+')) bNeg = (*s++ == '-');
+		int v = 0;
+		for (; s < e && *s >= '0' && *s <= '9'; ++s)
+			v = v * 10 + (*s - '0');
+		return bNeg ? -v : v;
+	}
+
+	/// float of a token, as std::stof.
+	inline float scanFloat(const char* s, const char* e)
+	{
+		// exact fast path : mantissa < 2^24 and |exponent| <= 10 are both exact in float,
+		// so one division or multiplication gives the correctly rounded value.
+		static const float pow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+		const char* q = s;
+		bool bNeg = false;
+		if (q < e && (*q == '-' || *q == '+')) bNeg = (*q++ == '-');
+		uint32_t m = 0;
+		int nDigit = 0, nFrac = 0;
+		bool bDot = false, bFast = true;
+		for (; q < e; ++q) {
+			if (*q >= '0' && *q <= '9') {
+				if (m >= (1u << 24) / 10) { bFast = false; break; }
+				m = m * 10 + (*q - '0');
+				nDigit++;
+				if (bDot) nFrac++;
 			}
+			else if (*q == '.' && !bDot) bDot = true;
+			else break;
+		}
+		int exp10 = -nFrac;
+		if (bFast && q < e && (*q == 'e' || *q == 'E')) {
+			++q;
+			bool bExpNeg = false;
+			if (q < e && (*q == '-' || *q == '+')) bExpNeg = (*q++ == '-');
+			int x = 0;
+			const char* d = q;
+			for (; q < e && *q >= '0' && *q <= '9' && x < 1000; ++q)
+				x = x * 10 + (*q - '0');
+			if (q == d) bFast = false;
+			exp10 += bExpNeg ? -x : x;
+		}
+		if (bFast && nDigit > 0 && q == e && m < (1u << 24) && exp10 >= -10 && exp10 <= 10) {
+			float v = exp10 < 0 ? (float)m / pow10[-exp10] : (float)m * pow10[exp10];
+			return bNeg ? -v : v;
+		}
 
-			longlong idxE_face = -1;
-			int idxP_list = -1;
-			int idxP_red = -1;
-			int idxP_green = -1;
-			int idxP_blue = -1;
-			int idxP_alpha = -1;
-			bool ok_face = findIdxOfPropertiesAndElement(elements, "face", "vertex_indices", idxE_face, idxP_list);
+		char buf[64];
+		size_t n = e - s;
+		if (n >= sizeof(buf)) n = sizeof(buf) - 1;
+		memcpy(buf, s, n);
+		buf[n] = '\0';
+		return strtof(buf, nullptr);
+	}
 
-			bool ok_alpha = findIdxOfPropertiesAndElement(elements, "face", "alpha", idxE_face, idxP_alpha);
+	/// values of one vertex line by role : x, y, z, red, green, blue, phase.
+	/// colors are read as integers and scaled by 1/255 whatever their declared type, as the getline parser did.
+	inline void parseVertexLine(const char* s, const char* eol, const std::vector<int> &role, Real value[7])
+	{
+		for (int k = 0; k < 7; k++) value[k] = 0.0;
+		for (size_t j = 0; j < role.size(); ++j) {
+			while (s < eol && isBlank(*s)) ++s;
+			if (s >= eol || *s == '\n') break;
+			const char* t = s;
+			while (t < eol && !isBlank(*t) && *t != '\n') ++t;
+			const int r = role[j];
+			if (r >= 3 && r <= 5)
+				value[r] = (Real)(scanInt(s, t) / 255.f);
+			else if (r >= 0)
+				value[r] = (Real)scanFloat(s, t);
+			s = t;
+		}
+	}
+}
 
-			bool ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "red", idxE_vertex, idxP_red);
-			ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "green", idxE_vertex, idxP_green);
-			ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "blue", idxE_vertex, idxP_blue);
+bool PLYparser::decodeAsciiPLY(const std::string& fileName, std::streamoff dataOffset,
+	const std::vector<PlyElement> &elements, longlong idxE_vertex, longlong idxE_color, int idxP_channel,
+	const int idxP[7], bool bVertexColor, int &color_channels, Real* vertexArray, Real* colorArray, Real* phaseArray)
+{
+	FileView view;
+	if (!view.open(fileName) || (size_t)dataOffset > view.length()) {
+		std::cerr << "Error : Failed mapping ply file..." << std::endl;
+		return false;
+	}
 
-			if (!ok_color) {
-				if (ok_vertex) {
-					ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "diffuse_red", idxE_vertex, idxP_red);
-					ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "diffuse_green", idxE_vertex, idxP_green);
-					ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "diffuse_blue", idxE_vertex, idxP_blue);
-				}
-				if (!ok_color && ok_face) {
-					ok_color = findIdxOfPropertiesAndElement(elements, "face", "red", idxE_face, idxP_red);
-					ok_color = findIdxOfPropertiesAndElement(elements, "face", "green", idxE_face, idxP_green);
-					ok_color = findIdxOfPropertiesAndElement(elements, "face", "blue", idxE_face, idxP_blue);
+	const char* ptr = (const char*)view.data() + dataOffset;
+	const char* end = (const char*)view.data() + view.length();
+
+	auto nextLine = [end](const char* s) {
+		const char* nl = (const char*)memchr(s, '\n', end - s);
+		return nl ? nl + 1 : end;
+	};
+	auto readChannel = [&](const char* s) {
+		const char* e = nextLine(s);
+		for (int j = 0; j <= idxP_channel && s < e; ++j) {
+			while (s < e && isBlank(*s)) ++s;
+			const char* t = s;
+			while (t < e && !isBlank(*t) && *t != '\n') ++t;
+			if (j == idxP_channel) color_channels = scanInt(s, t);
+			s = t;
+		}
+	};
 
-				}
-			}
+	// elements before the vertices are read line by line.
+	for (longlong idxE = 0; idxE < idxE_vertex; ++idxE) {
+		for (longlong e = 0; e < elements[idxE].size && ptr < end; ++e) {
+			if (idxE == idxE_color && idxP_channel >= 0 && e == 0) readChannel(ptr);
+			ptr = nextLine(ptr);
+		}
+	}
 
-			int idxP_phase = -1;
-			isPhaseParse = findIdxOfPropertiesAndElement(elements, "vertex", "phase", idxE_vertex, idxP_phase);
-			if (!isPhaseParse) *phaseArray = nullptr;
+	const longlong nVertex = elements[idxE_vertex].size;
+	const int nProp = (int)elements[idxE_vertex].properties.size();
+	std::vector<int> role(nProp, -1);
+	for (int k = 0; k < 7; k++)
+		if (idxP[k] >= 0 && idxP[k] < nProp) role[idxP[k]] = k;
 
-			
+	// line-aligned chunks of the body.
+	int nChunk = 1;
+#ifdef _OPENMP
+	if (end - ptr > (1 << 20)) nChunk = omp_get_max_threads() * 4;
+#endif
+	std::vector<const char*> bound(nChunk + 1);
+	bound[0] = ptr;
+	bound[nChunk] = end;
+	for (int k = 1; k < nChunk; k++) {
+		const char* s = ptr + (end - ptr) * k / nChunk;
+		bound[k] = s < bound[k - 1] ? bound[k - 1] : nextLine(s - 1);
+	}
 
+	// first record index of each chunk.
+	std::vector<longlong> first(nChunk + 1, 0);
+	int k;
+#ifdef _OPENMP
+#pragma omp parallel for private(k)
+#endif
+	for (k = 0; k < nChunk; k++)
+		first[k + 1] = std::count(bound[k], bound[k + 1], '\n');
+	// a last line without a newline is a record too.
+	if (end > ptr && end[-1] != '\n') first[nChunk]++;
+	for (k = 0; k < nChunk; k++)
+		first[k + 1] += first[k];
+
+#ifdef _OPENMP
+#pragma omp parallel for private(k) schedule(dynamic)
+#endif
+	for (k = 0; k < nChunk; k++) {
+		longlong e = first[k];
+		for (const char* s = bound[k]; s < bound[k + 1] && e < nVertex; ++e) {
+			const char* eol = nextLine(s);
+			Real value[7];
+			parseVertexLine(s, eol, role, value);
+			vertexArray[3 * e + 0] = value[0];
+			vertexArray[3 * e + 1] = value[1];
+			vertexArray[3 * e + 2] = value[2];
+			if (bVertexColor) {
+				colorArray[3 * e + 0] = value[3];
+				colorArray[3 * e + 1] = value[4];
+				colorArray[3 * e + 2] = value[5];
+			}
+			if (phaseArray) phaseArray[e] = value[6];
+			s = eol;
+		}
+	}
+	if (first[nChunk] < nVertex) {
+		std::cerr << "Error : ply file is truncated..." << std::endl;
+		return false;
+	}
 
-			n_points = elements[idxE_vertex].size;
-			*vertexArray = new Real[3 * n_points];
-			*colorArray = new Real[3 * n_points];
-			std::memset(*vertexArray, NULL, sizeof(Real) * 3 * n_points);
-			std::memset(*colorArray, NULL, sizeof(Real) * 3 * n_points);
-			if (isPhaseParse) {
-				*phaseArray = new Real[n_points];
-				std::memset(*phaseArray, NULL, sizeof(Real) * n_points);
+	// a color element after the vertices.
+	if (idxE_color > idxE_vertex && idxP_channel >= 0) {
+		longlong k0 = 0;
+		while (k0 < nChunk && first[k0 + 1] <= nVertex) ++k0;
+		ptr = k0 < nChunk ? bound[k0] : end;
+		for (longlong e = first[k0]; e < nVertex && ptr < end; ++e) ptr = nextLine(ptr);
+		for (longlong idxE = idxE_vertex + 1; idxE < (longlong)elements.size() && ptr < end; ++idxE) {
+			for (longlong e = 0; e < elements[idxE].size && ptr < end; ++e) {
+				if (idxE == idxE_color && e == 0) readChannel(ptr);
+				ptr = nextLine(ptr);
 			}
+		}
+	}
+	return true;
+}
 
+bool PLYparser::readPointCloudHeader(const std::string& inputPath, PlyLayout &layout)
+{
+	std::ifstream File(inputPath, std::ios::in | std::ios::binary);
+	if (!File.is_open()) {
+		std::cerr << "Error : Failed loading ply file..." << std::endl;
+		return false;
+	}
 
+	std::vector<PlyElement> &elements = layout.elements;
+	std::vector<std::string> comments;
+	std::vector<std::string> objInfo;
 
-			//parse Point Cloud Data
-			for (size_t idxE = 0; idxE < elements.size(); ++idxE) {
-				for (longlong e = 0; e < elements[idxE].size; ++e) {
-					auto list = 0;
-					auto x = 0.0f;
-					auto y = 0.0f;
-					auto z = 0.0f;
-					auto red = 0;
-					auto green = 0;
-					auto blue = 0;
-					auto alpha = 0;
-					auto phase = 0.0f;
-					void *tmp = nullptr;
-
-					int nSize;
-					//if()
-
-					
-					// BINARY
-					if (isBinary) {
-						//vertex data parsing
-						if (idxE == idxE_vertex) {
-							//line Processing
-							for (int p = 0; p < elements[idxE].properties.size(); ++p) {
-								nSize = PropertyTable[elements[idxE].properties[p].propertyType].first;
-
-								if (p == idxP_x) tmp = &x;
-								else if (p == idxP_y) tmp = &y;
-								else if (p == idxP_z) tmp = &z;
-								else if (p == idxP_red) tmp = &red;
-								else if (p == idxP_green) tmp = &green;
-								else if (p == idxP_blue) tmp = &blue;
-								else if (p == idxP_phase && isPhaseParse) tmp = &phase;
-								else tmp = nullptr;
-								if (tmp)
-									File.read((char *)tmp, nSize);
-							}
-						}
-						//face data parsing
-						else if (idxE == idxE_face) {
-							//line Processing
-							for (int p = 0; p < elements[idxE].properties.size(); ++p) {
-								nSize = PropertyTable[elements[idxE].properties[p].propertyType].first;
-
-								if (elements[idxE].properties[p].isList) { // list type
-									int nList = PropertyTable[elements[idxE].properties[p].listType].first;
-									auto nCnt = 0;
-									File.read((char *)&nCnt, nList);
-									int *pTest = new int[nCnt];
-									for (int i = 0; i < nCnt; ++i) {
-										File.read((char *)&pTest[i], nSize);
-									}
-									delete[] pTest;
-								}
-
-								if (p == idxP_red) tmp = &red;
-								else if (p == idxP_green) tmp = &green;
-								else if (p == idxP_blue) tmp = &blue;
-								else if (p == idxP_alpha) tmp = &alpha;
-								else tmp = nullptr;
-								if (tmp)
-									File.read((char *)tmp, nSize);
-							}
-						}
-						//color channel parsing
-						else if (ok_channel && (idxE == idxE_color)) {
-							for (int p = 0; p < elements[idxE].properties.size(); ++p) {
-								nSize = PropertyTable[elements[idxE].properties[p].propertyType].first;
-								File.read((char *)&color_channels, nSize);
-							}
-						}
-					}
-					// ASCII
-					else {
-						std::getline(File, line);
-						lineStr.str(line);
-						std::string val;
-
-						//color channel parsing
-						if (ok_channel && (idxE == idxE_color)) {
-							lineStr.clear();
-							lineStr >> val;
-							color_channels = std::stoi(val);
-						}
+	//parse header
+	std::string line;
+	std::getline(File, line);
+	std::istringstream lineStr(line);
+	std::string token;
+	lineStr.clear();
+	lineStr >> token;
 
-						//vertex data parsing
-						if (idxE == idxE_vertex) {
+	if ((token != "ply") && (token != "PLY")) {
+		std::cerr << "Error : Failed loading ply file..." << std::endl;
+		File.close();
+		return false;
+	}
+#ifdef _DEBUG
+	std::cout << "Parsing *.PLY file for OpenHolo Point Cloud Generation..." << std::endl;
+#endif
+	//parse PLY header
+	while (std::getline(File, line)) {
+		//std::istringstream lineStr(line);
+		lineStr.clear();
+		lineStr.str(line);
+		std::istream(lineStr.rdbuf()) >> token;
 
-							//line Processing
-							for (int p = 0; p < elements[idxE].properties.size(); ++p) {
-								lineStr.clear();
+		if (token == "comment") {
+			comments.push_back((8 > 0) ? line.erase(0, 8) : line);
+		}
+		else if (token == "format") {
+			std::string str;
+			lineStr.clear();
+			lineStr >> str;
+			if (str == "binary_little_endian") layout.isBinary = true;
+			else if (str == "binary_big_endian") layout.isBinary = layout.isBigEndian = true;
+		}
+		else if (token == "element") {
+			elements.emplace_back(lineStr);
+		}
+		else if (token == "property") {
+			if (!elements.size()) std::cerr << "No Elements defined, file is malformed" << std::endl;
+			elements.back().properties.emplace_back(lineStr);
+		}
+		else if (token == "obj_info") objInfo.push_back((9 > 0) ? line.erase(0, 9) : line);
+		else if (token == "end_header") break;
+	}
+	layout.dataOffset = File.tellg();
+	File.close();
 
-								lineStr >> val;
+#ifdef _DEBUG
+	//print comment list
+	for (auto cmt : comments) {
+		std::cout << "Comment : " << cmt << std::endl;
+	}
 
-								if (p == idxP_x) x = std::stof(val);
-								else if (p == idxP_y) y = std::stof(val);
-								else if (p == idxP_z) z = std::stof(val);
-								else if (p == idxP_red) red = std::stoi(val);
-								else if (p == idxP_green) green = std::stoi(val);
-								else if (p == idxP_blue) blue = std::stoi(val);
-								else if ((p == idxP_phase) && isPhaseParse) phase = std::stof(val);
-							}
-						}
-					}
-#if 1
-					if (idxE == idxE_vertex) {
-						(*vertexArray)[3 * e + 0] = (Real)x;
-						(*vertexArray)[3 * e + 1] = (Real)y;
-						(*vertexArray)[3 * e + 2] = (Real)z;
-					}
-					if (!ok_face) {
-						(*colorArray)[3 * e + 0] = (Real)(red / 255.f);
-						(*colorArray)[3 * e + 1] = (Real)(green / 255.f);
-						(*colorArray)[3 * e + 2] = (Real)(blue / 255.f);
-					}
-					if (isPhaseParse) (*phaseArray)[e] = phase;
+	//print element and property list
+	for (auto elmnt : elements) {
+		std::cout << "Element - " << elmnt.name << " : ( " << elmnt.size << " )" << std::endl;
+		for (auto Property : elmnt.properties) {
+			auto tmp = PropertyTable[Property.propertyType].second;
+			std::cout << "\tProperty : " << Property.name << " : ( " << PropertyTable[Property.propertyType].second << " )" << std::endl;
+		}
+	}
 #endif
-					
-				}
-			}
-			File.close();
+	longlong idxE_color = -1;
+	int idxP_channel = -1;
+	bool ok_channel = findIdxOfPropertiesAndElement(elements, "color", "channel", idxE_color, idxP_channel);
+
+	longlong idxE_vertex = -1;
+	int idxP_x = -1;
+	int idxP_y = -1;
+	int idxP_z = -1;
+	bool ok_vertex = findIdxOfPropertiesAndElement(elements, "vertex", "x", idxE_vertex, idxP_x);
+	ok_vertex = findIdxOfPropertiesAndElement(elements, "vertex", "y", idxE_vertex, idxP_y);
+	ok_vertex = findIdxOfPropertiesAndElement(elements, "vertex", "z", idxE_vertex, idxP_z);
+	if (!ok_vertex) {
+		std::cerr << "Error : file is not having vertices data..." << std::endl;
+		return false;
+	}
 
-			if (ok_channel && (color_channels == 1)) {
-				Real* grayArray = new Real[n_points];
-				for (ulonglong i = 0; i < n_points; ++i) {
-					grayArray[i] = (*colorArray)[3 * i];
-				}
-				delete[](*colorArray);
-				*colorArray = grayArray;
+	longlong idxE_face = -1;
+	int idxP_list = -1;
+	int idxP_red = -1;
+	int idxP_green = -1;
+	int idxP_blue = -1;
+	int idxP_alpha = -1;
+	bool ok_face = findIdxOfPropertiesAndElement(elements, "face", "vertex_indices", idxE_face, idxP_list);
+
+	bool ok_alpha = findIdxOfPropertiesAndElement(elements, "face", "alpha", idxE_face, idxP_alpha);
+
+	bool ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "red", idxE_vertex, idxP_red);
+	ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "green", idxE_vertex, idxP_green);
+	ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "blue", idxE_vertex, idxP_blue);
+
+	if (!ok_color) {
+		if (ok_vertex) {
+			ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "diffuse_red", idxE_vertex, idxP_red);
+			ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "diffuse_green", idxE_vertex, idxP_green);
+			ok_color = findIdxOfPropertiesAndElement(elements, "vertex", "diffuse_blue", idxE_vertex, idxP_blue);
+		}
+		if (!ok_color && ok_face) {
+			ok_color = findIdxOfPropertiesAndElement(elements, "face", "red", idxE_face, idxP_red);
+			ok_color = findIdxOfPropertiesAndElement(elements, "face", "green", idxE_face, idxP_green);
+			ok_color = findIdxOfPropertiesAndElement(elements, "face", "blue", idxE_face, idxP_blue);
+
+		}
+	}
+
+	int idxP_phase = -1;
+	layout.isPhaseParse = findIdxOfPropertiesAndElement(elements, "vertex", "phase", idxE_vertex, idxP_phase);
+
+	layout.idxE_vertex = idxE_vertex;
+	layout.idxE_color = idxE_color;
+	layout.idxP_channel = ok_channel ? idxP_channel : -1;
+	layout.idxP[0] = idxP_x;
+	layout.idxP[1] = idxP_y;
+	layout.idxP[2] = idxP_z;
+	layout.idxP[3] = idxP_red;
+	layout.idxP[4] = idxP_green;
+	layout.idxP[5] = idxP_blue;
+	layout.idxP[6] = layout.isPhaseParse ? idxP_phase : -1;
+	layout.bVertexColor = !ok_face;
+	return true;
+}
+
+bool PLYparser::loadPLY(const std::string& fileName, ulonglong &n_points, int &color_channels, Real** vertexArray, Real** colorArray, Real** phaseArray, bool &isPhaseParse) {
+	std::string inputPath = fileName;
+	if ((fileName.find(".ply") == std::string::npos) && (fileName.find(".PLY") == std::string::npos)) inputPath += ".ply";
+
+	PlyLayout layout;
+	if (!readPointCloudHeader(inputPath, layout))
+		return false;
+
+	const bool ok_channel = layout.idxP_channel >= 0;
+	isPhaseParse = layout.isPhaseParse;
+	if (!isPhaseParse) *phaseArray = nullptr;
+
+	n_points = layout.elements[layout.idxE_vertex].size;
+	*vertexArray = new Real[3 * n_points];
+	*colorArray = new Real[3 * n_points];
+	std::memset(*vertexArray, NULL, sizeof(Real) * 3 * n_points);
+	std::memset(*colorArray, NULL, sizeof(Real) * 3 * n_points);
+	if (isPhaseParse) {
+		*phaseArray = new Real[n_points];
+		std::memset(*phaseArray, NULL, sizeof(Real) * n_points);
+	}
+
+	// decode the body from a mapped view of the file.
+	bool bDecoded;
+	if (layout.isBinary)
+		bDecoded = decodeBinaryPLY(inputPath, layout.dataOffset, layout.isBigEndian, layout.elements, layout.idxE_vertex, layout.idxE_color, layout.idxP_channel,
+			layout.idxP, layout.bVertexColor, color_channels, *vertexArray, *colorArray, isPhaseParse ? *phaseArray : nullptr);
+	else
+		bDecoded = decodeAsciiPLY(inputPath, layout.dataOffset, layout.elements, layout.idxE_vertex, layout.idxE_color, layout.idxP_channel,
+			layout.idxP, layout.bVertexColor, color_channels, *vertexArray, *colorArray, isPhaseParse ? *phaseArray : nullptr);
+	if (!bDecoded) {
+		std::cerr << "Error : Failed loading ply file..." << std::endl;
+		delete[] *vertexArray;
+		delete[] *colorArray;
+		*vertexArray = nullptr;
+		*colorArray = nullptr;
+		if (isPhaseParse) {
+			delete[] *phaseArray;
+			*phaseArray = nullptr;
+		}
+		return false;
+	}
+
+	if (ok_channel && (color_channels == 1)) {
+		Real* grayArray = new Real[n_points];
+		for (ulonglong i = 0; i < n_points; ++i) {
+			grayArray[i] = (*colorArray)[3 * i];
+		}
+		delete[](*colorArray);
+		*colorArray = grayArray;
+	}
+	else if (!ok_channel) {
+		bool check = false;
+		for (ulonglong i = 0; i < n_points; ++i) {
+			if (((*colorArray)[3 * i + 0] != (*colorArray)[3 * i + 1]) || ((*colorArray)[3 * i + 1] != (*colorArray)[3 * i + 2])) {
+				check = true;
+				break;
 			}
-			else if (!ok_channel) {
-				bool check = false;
-				for (ulonglong i = 0; i < n_points; ++i) {
-					if (((*colorArray)[3 * i + 0] != (*colorArray)[3 * i + 1]) || ((*colorArray)[3 * i + 1] != (*colorArray)[3 * i + 2])) {
-						check = true;
-						break;
-					}
-				}
+		}
 
-				if (check) color_channels = 3;
-				else if (!check) {
-					color_channels = 1;
+		if (check) color_channels = 3;
+		else if (!check) {
+			color_channels = 1;
 #if 0
-					Real* grayArray = new Real[n_points];
-					for (ulonglong i = 0; i < n_points; ++i) {
-						grayArray[i] = (*colorArray)[3 * i];
-					}
-					delete[](*colorArray);
-					*colorArray = grayArray;
+			Real* grayArray = new Real[n_points];
+			for (ulonglong i = 0; i < n_points; ++i) {
+				grayArray[i] = (*colorArray)[3 * i];
+			}
+			delete[](*colorArray);
+			*colorArray = grayArray;
 #else
 
-					for (ulonglong i = 0; i < n_points * 3; ++i) {
-						(*colorArray)[i] = 0.5;
-					}
-#endif
-				}
+			for (ulonglong i = 0; i < n_points * 3; ++i) {
+				(*colorArray)[i] = 0.5;
 			}
+#endif
+		}
+	}
 
 #ifdef _DEBUG
-			std::cout << "Success loading " << n_points << " Point Clouds, Color Channels : " << color_channels << std::endl;
+	std::cout << "Success loading " << n_points << " Point Clouds, Color Channels : " << color_channels << std::endl;
 #endif
-			return true;
+	return true;
+}
+
+struct PLYparser::PlyStream {
+	PlyLayout layout;
+	FileView view;
+	const uchar* ptr;			// next vertex record
+	ulonglong remain;			// vertices left
+	int color_channels;
+	Real noColor;				// color of a cloud without vertex colors
+	// binary records
+	bool bSwap;
+	size_t stride;
+	Type type[7];
+	size_t off[7];
+	bool bColorInt[3];
+	// ascii lines
+	std::vector<int> role;
+};
+
+PLYparser::PlyStream* PLYparser::openStream(const std::string& fileName, ulonglong &n_points, int &color_channels, bool &isPhaseParse)
+{
+	std::string inputPath = fileName;
+	if ((fileName.find(".ply") == std::string::npos) && (fileName.find(".PLY") == std::string::npos)) inputPath += ".ply";
+
+	PlyStream* stream = new PlyStream;
+	PlyLayout &layout = stream->layout;
+	if (!readPointCloudHeader(inputPath, layout) || !stream->view.open(inputPath) || (size_t)layout.dataOffset > stream->view.length()) {
+		std::cerr << "Error : Failed loading ply file..." << std::endl;
+		delete stream;
+		return nullptr;
+	}
+
+	const uint16_t one = 1;
+	const bool bHostBigEndian = *(const uchar*)&one == 0;
+	stream->bSwap = layout.isBigEndian != bHostBigEndian;
+
+	const PlyElement &vertex = layout.elements[layout.idxE_vertex];
+	const int nProp = (int)vertex.properties.size();
+	stream->stride = 0;
+	std::vector<size_t> offset(nProp, 0);
+	for (int j = 0; j < nProp; ++j) {
+		if (vertex.properties[j].isList && layout.isBinary) {
+			std::cerr << "Error : list properties of vertices are not supported..." << std::endl;
+			delete stream;
+			return nullptr;
 		}
+		offset[j] = stream->stride;
+		stream->stride += PropertyTable[vertex.properties[j].propertyType].first;
+	}
+	stream->role.assign(nProp, -1);
+	for (int k = 0; k < 7; k++) {
+		const int idx = layout.idxP[k];
+		stream->type[k] = idx >= 0 ? vertex.properties[idx].propertyType : Type::INVALID;
+		stream->off[k] = idx >= 0 ? offset[idx] : 0;
+		if (idx >= 0 && idx < nProp) stream->role[idx] = k;
+	}
+	for (int c = 0; c < 3; c++) {
+		Type t = layout.idxP[3 + c] >= 0 ? stream->type[3 + c] : Type::UINT8;
+		stream->bColorInt[c] = t != Type::FLOAT32 && t != Type::FLOAT64;
+	}
+
+	// walk the elements to the vertices, and to the color channel wherever it is.
+	const uchar* ptr = stream->view.data() + layout.dataOffset;
+	const uchar* end = stream->view.data() + stream->view.length();
+	auto nextLine = [end](const uchar* s) {
+		const uchar* nl = (const uchar*)memchr(s, '\n', end - s);
+		return nl ? nl + 1 : end;
+	};
+	int channel = 3;
+	stream->ptr = nullptr;
+	for (longlong idxE = 0; idxE < (longlong)layout.elements.size() && ptr; ++idxE) {
+		const PlyElement &element = layout.elements[idxE];
+		if (idxE == layout.idxE_vertex)
+			stream->ptr = ptr;
+		else if (idxE == layout.idxE_color && layout.idxP_channel >= 0 && element.size > 0) {
+			if (layout.isBinary) {
+				size_t off = 0;
+				for (int j = 0; j < layout.idxP_channel; ++j) off += PropertyTable[element.properties[j].propertyType].first;
+				if ((size_t)(end - ptr) >= off + PropertyTable[element.properties[layout.idxP_channel].propertyType].first)
+					channel = (int)readBinaryValue(ptr + off, element.properties[layout.idxP_channel].propertyType, stream->bSwap);
+			}
+			else {
+				std::istringstream lineStr(std::string((const char*)ptr, (const char*)nextLine(ptr)));
+				std::string token;
+				for (int j = 0; j <= layout.idxP_channel; ++j) lineStr >> token;
+				channel = std::atoi(token.c_str());
+			}
+		}
+		if (idxE >= layout.idxE_vertex && (layout.idxP_channel < 0 || idxE >= layout.idxE_color))
+			break;
+		if (layout.isBinary) {
+			if (idxE == layout.idxE_vertex)
+				ptr += stream->stride * element.size;
+			else
+				ptr = skipBinaryElement(element, ptr, end, stream->bSwap);
+		}
+		else {
+			for (longlong e = 0; e < element.size && ptr < end; ++e) ptr = nextLine(ptr);
+		}
+	}
+	if (!ptr || !stream->ptr || ptr > end ||
+		(layout.isBinary && (ulonglong)(end - stream->ptr) < (ulonglong)stream->stride * vertex.size)) {
+		std::cerr << "Error : ply file is truncated..." << std::endl;
+		delete stream;
+		return nullptr;
+	}
+
+	// colors come per point as in loadPLY(), except that a cloud without a channel element keeps
+	// its 3 channels : deciding gray would need a pass over the whole file.
+	const bool bColor = layout.bVertexColor && layout.idxP[3] >= 0 && layout.idxP[4] >= 0 && layout.idxP[5] >= 0;
+	if (layout.idxP_channel >= 0) {
+		stream->color_channels = channel == 1 ? 1 : 3;
+		stream->noColor = 0.0;
 	}
 	else {
-		std::cerr << "Error : Failed loading ply file..." << std::endl;
-		return false;
+		stream->color_channels = bColor ? 3 : 1;
+		stream->noColor = 0.5;
+	}
+	stream->remain = vertex.size;
+
+	n_points = vertex.size;
+	color_channels = stream->color_channels;
+	isPhaseParse = layout.isPhaseParse;
+	return stream;
+}
+
+ulonglong PLYparser::readStream(PlyStream* stream, ulonglong count, Real* vertexArray, Real* colorArray, Real* phaseArray)
+{
+	if (!stream || !stream->remain) return 0;
+	if (count > stream->remain) count = stream->remain;
+
+	const PlyLayout &layout = stream->layout;
+	const int nColors = stream->color_channels;
+	const bool bColor = layout.bVertexColor && layout.idxP[3] >= 0 && layout.idxP[4] >= 0 && layout.idxP[5] >= 0;
+	const bool bPhase = phaseArray && layout.idxP[6] >= 0;
+
+	if (layout.isBinary) {
+		const uchar* base = stream->ptr;
+		const size_t stride = stream->stride;
+		const bool bSwap = stream->bSwap;
+		const Type* type = stream->type;
+		const size_t* off = stream->off;
+		const bool* bColorInt = stream->bColorInt;
+		const Real noColor = stream->noColor;
+		// serial : readStream runs on the loader thread while the caller's OpenMP team diffracts the previous batch.
+		for (longlong e = 0; e < (longlong)count; ++e) {
+			const uchar* rec = base + e * stride;
+			vertexArray[3 * e + 0] = readBinaryValue(rec + off[0], type[0], bSwap);
+			vertexArray[3 * e + 1] = readBinaryValue(rec + off[1], type[1], bSwap);
+			vertexArray[3 * e + 2] = readBinaryValue(rec + off[2], type[2], bSwap);
+			for (int c = 0; c < nColors; c++) {
+				if (!bColor) {
+					colorArray[nColors * e + c] = noColor;
+					continue;
+				}
+				Real v = readBinaryValue(rec + off[3 + c], type[3 + c], bSwap);
+				colorArray[nColors * e + c] = bColorInt[c] ? (Real)((float)v / 255.f) : v;
+			}
+			if (bPhase) phaseArray[e] = readBinaryValue(rec + off[6], type[6], bSwap);
+		}
+		stream->ptr += stride * count;
+	}
+	else {
+		const char* s = (const char*)stream->ptr;
+		const char* end = (const char*)stream->view.data() + stream->view.length();
+		ulonglong e;
+		for (e = 0; e < count && s < end; ++e) {
+			const char* nl = (const char*)memchr(s, '\n', end - s);
+			const char* eol = nl ? nl + 1 : end;
+			Real value[7];
+			parseVertexLine(s, eol, stream->role, value);
+			vertexArray[3 * e + 0] = value[0];
+			vertexArray[3 * e + 1] = value[1];
+			vertexArray[3 * e + 2] = value[2];
+			for (int c = 0; c < nColors; c++)
+				colorArray[nColors * e + c] = bColor ? value[3 + c] : stream->noColor;
+			if (bPhase) phaseArray[e] = value[6];
+			s = eol;
+		}
+		if (e < count) {
+			std::cerr << "Error : ply file is truncated..." << std::endl;
+			stream->remain = 0;
+			return 0;
+		}
+		stream->ptr = (const uchar*)s;
 	}
+	stream->remain -= count;
+	return count;
+}
+
+void PLYparser::closeStream(PlyStream* stream)
+{
+	delete stream;
 }
 
 
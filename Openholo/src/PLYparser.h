@@ -139,8 +139,83 @@ private:
 		const std::string &propertyKeys,
 		longlong &elementIdx,
 		int &propertyIdx);
+
+	/**
+	* @brief Header of a point cloud PLY and the indexes of the properties used by the generators.
+	*/
+	struct PlyLayout {
+		std::vector<PlyElement> elements;
+		bool isBinary = false;
+		bool isBigEndian = false;
+		std::streamoff dataOffset = 0;
+		longlong idxE_vertex = -1;
+		longlong idxE_color = -1;
+		int idxP_channel = -1;	// -1 if there is no color element
+		int idxP[7];			// x, y, z, red, green, blue, phase (-1 if not used)
+		bool bVertexColor = true;
+		bool isPhaseParse = false;
+	};
+
+	bool readPointCloudHeader(const std::string& inputPath, PlyLayout &layout);
+
+	/**
+	* @brief Read one binary property value of any PLY type as Real.
+	*/
+	static Real readBinaryValue(const uchar* src, Type type, bool bSwap);
+
+	/**
+	* @brief Skip the binary records of an element.
+	* @return Type: <B>const uchar*</B>\n
+	*				Position after the element, nullptr if the file is truncated.
+	*/
+	const uchar* skipBinaryElement(const PlyElement &element, const uchar* ptr, const uchar* end, bool bSwap);
+
+	/**
+	* @brief Decode the binary body of a point cloud PLY from a memory-mapped view of the file.
+	* @details Fixed-size vertex records are decoded in parallel through a precomputed offset table,
+	*			list properties (faces) are skipped without allocation.
+	* @param idxP property indexes of the vertex element : x, y, z, red, green, blue, phase (-1 if not used)
+	*/
+	bool decodeBinaryPLY(
+		const std::string& fileName,
+		std::streamoff dataOffset,
+		bool isBigEndian,
+		const std::vector<PlyElement> &elements,
+		longlong idxE_vertex,
+		longlong idxE_color,
+		int idxP_channel,
+		const int idxP[7],
+		bool bVertexColor,
+		int &color_channels,
+		Real* vertexArray,
+		Real* colorArray,
+		Real* phaseArray);
+
+	/**
+	* @brief Parse the ASCII body of a point cloud PLY from a memory-mapped view of the file.
+	* @details The vertex lines are split in line-aligned chunks which are parsed concurrently,
+	*			each chunk writes from its first record index found by counting the line breaks.
+	*/
+	bool decodeAsciiPLY(
+		const std::string& fileName,
+		std::streamoff dataOffset,
+		const std::vector<PlyElement> &elements,
+		longlong idxE_vertex,
+		longlong idxE_color,
+		int idxP_channel,
+		const int idxP[7],
+		bool bVertexColor,
+		int &color_channels,
+		Real* vertexArray,
+		Real* colorArray,
+		Real* phaseArray);
 	
 public:
+	/**
+	* @brief Sequential reader of the vertices of a point cloud PLY, see openStream().
+	*/
+	struct PlyStream;
+
 	bool loadPLY(					// for Point Cloud Data
 		const std::string& fileName,
 		ulonglong &n_points,
@@ -150,6 +225,37 @@ public:
 		Real** phaseArray, //If isPhaseParse is false, PhaseArray is nullptr
 		bool &isPhaseParse);
 
+	/**
+	* @brief Open a point cloud PLY for reading its vertices in batches, without loading the whole cloud.
+	* @details The file is memory-mapped and decoded sequentially by readStream(),
+	*			so only the pages of the current batch need to be resident.
+	* @param[out] color_channels 1 or 3, the number of color values per point given by readStream()
+	* @return Type: <B>PlyStream*</B>\n
+	*				Handle to pass to readStream() and closeStream(), nullptr if the file can not be read.
+	*/
+	PlyStream* openStream(
+		const std::string& fileName,
+		ulonglong &n_points,
+		int &color_channels,
+		bool &isPhaseParse);
+
+	/**
+	* @brief Decode the next vertices of an opened stream.
+	* @param[out] vertexArray 3 * count values
+	* @param[out] colorArray color_channels * count values
+	* @param[out] phaseArray count values, or nullptr
+	* @return Type: <B>ulonglong</B>\n
+	*				Number of decoded vertices, 0 at the end of the stream or on error.
+	*/
+	ulonglong readStream(
+		PlyStream* stream,
+		ulonglong count,
+		Real* vertexArray,
+		Real* colorArray,
+		Real* phaseArray);
+
+	void closeStream(PlyStream* stream);
+
 	bool savePLY(					
 		const std::string& fileName,
 		const ulonglong n_points,
@@ -0,0 +1,335 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "PointCloudCache.h"
+#include "sys.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace oph;
+
+namespace {
+	const char CACHE_MAGIC[4] = { 'O', 'P', 'P', 'C' };
+	const uint32_t CACHE_VERSION = 1;
+	const uint32_t FLAG_PHASE = 1;
+
+	inline uint64_t alignUp(uint64_t v) { return (v + 63) & ~(uint64_t)63; }
+
+	/// group of a value in [lo, hi] split into n groups.
+	inline uint groupOf(float v, float lo, float hi, uint n)
+	{
+		if (!(hi > lo)) return 0;
+		int g = (int)((v - lo) / (hi - lo) * n);
+		if (g < 0) g = 0;
+		if (g >= (int)n) g = n - 1;
+		return (uint)g;
+	}
+
+	/// true if every value is exact in 32-bit float.
+	bool isFloatExact(const Real* src, ulonglong n)
+	{
+		longlong i;
+		int bExact = 1;
+#ifdef _OPENMP
+#pragma omp parallel for private(i) reduction(&&:bExact)
+#endif
+		for (i = 0; i < (longlong)n; i++)
+			bExact = bExact && ((Real)(float)src[i] == src[i]);
+		return bExact != 0;
+	}
+
+	bool writeZero(std::ofstream& File, uint64_t target)
+	{
+		static const char zero[64] = { 0 };
+		uint64_t pos = (uint64_t)File.tellp();
+		if (pos > target) return false;
+		File.write(zero, (std::streamsize)(target - pos));
+		return File.good();
+	}
+}
+
+PointCloudCache::PointCloudCache()
+	: header(nullptr)
+{
+}
+
+PointCloudCache::~PointCloudCache()
+{
+	close();
+}
+
+bool PointCloudCache::getFileStamp(const char* fname, uint64_t& size, int64_t& time)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64(fname, &st) != 0) return false;
+#else
+	struct stat st;
+	if (stat(fname, &st) != 0) return false;
+#endif
+	size = (uint64_t)st.st_size;
+	time = (int64_t)st.st_mtime;
+	return true;
+}
+
+bool PointCloudCache::save(const char* fname, ulonglong n_points, int n_colors, const Real* vertex, const Real* color, const Real* phase,
+	SORT sort, uint nBins, uint nTileX, uint nTileY, const char* source)
+{
+	if (!fname || !vertex || !color || n_points == 0 || n_colors <= 0 || nBins == 0 || nTileX == 0 || nTileY == 0) return false;
+	if (!isFloatExact(vertex, n_points * 3) || !isFloatExact(color, n_points * n_colors) || (phase && !isFloatExact(phase, n_points))) {
+		LOG("<WARNING> %s : values are not exact in 32-bit float, cache is not written.\n", __FUNCTION__);
+		return false;
+	}
+
+	PointCacheHeader hd;
+	memset(&hd, 0, sizeof(hd));
+	memcpy(hd.magic, CACHE_MAGIC, sizeof(hd.magic));
+	hd.version = CACHE_VERSION;
+	hd.nPoints = n_points;
+	hd.nColors = n_colors;
+	hd.flags = phase ? FLAG_PHASE : 0;
+	hd.sort = sort;
+	hd.nBins = nBins;
+	hd.nTileX = nTileX;
+	hd.nTileY = nTileY;
+	if (source) getFileStamp(source, hd.sourceSize, hd.sourceTime);
+
+	// bounding box
+	for (int k = 0; k < 3; k++) {
+		hd.bboxMin[k] = (float)vertex[k];
+		hd.bboxMax[k] = (float)vertex[k];
+	}
+	for (ulonglong i = 1; i < n_points; i++) {
+		for (int k = 0; k < 3; k++) {
+			const float v = (float)vertex[3 * i + k];
+			if (v < hd.bboxMin[k]) hd.bboxMin[k] = v;
+			if (v > hd.bboxMax[k]) hd.bboxMax[k] = v;
+		}
+	}
+
+	// depth histogram, and the group of each point for the sorted layouts.
+	const uint nGroups = sort == SORT_DEPTH ? nBins : (sort == SORT_TILE ? nTileX * nTileY : 0);
+	std::vector<uint> histogram(nBins, 0);
+	std::vector<uint> group(nGroups ? n_points : 0);
+	std::vector<ulonglong> start(nGroups ? nGroups + 1 : 0, 0);
+	for (ulonglong i = 0; i < n_points; i++) {
+		const uint bin = groupOf((float)vertex[3 * i + 2], hd.bboxMin[2], hd.bboxMax[2], nBins);
+		histogram[bin]++;
+		if (sort == SORT_DEPTH)
+			group[i] = bin;
+		else if (sort == SORT_TILE)
+			group[i] = groupOf((float)vertex[3 * i + 1], hd.bboxMin[1], hd.bboxMax[1], nTileY) * nTileX +
+				groupOf((float)vertex[3 * i], hd.bboxMin[0], hd.bboxMax[0], nTileX);
+	}
+
+	// stable counting sort
+	std::vector<ulonglong> order;
+	if (nGroups) {
+		for (ulonglong i = 0; i < n_points; i++) start[group[i] + 1]++;
+		for (uint g = 0; g < nGroups; g++) start[g + 1] += start[g];
+		std::vector<ulonglong> next(start.begin(), start.end() - 1);
+		order.resize(n_points);
+		for (ulonglong i = 0; i < n_points; i++) order[next[group[i]]++] = i;
+	}
+
+	const uint64_t szArray = sizeof(float) * n_points;
+	hd.offVertex = alignUp(sizeof(PointCacheHeader));
+	hd.offColor = alignUp(hd.offVertex + 3 * szArray);
+	uint64_t end = alignUp(hd.offColor + n_colors * szArray);
+	if (phase) {
+		hd.offPhase = end;
+		end = alignUp(hd.offPhase + szArray);
+	}
+	hd.offHistogram = end;
+	end = alignUp(hd.offHistogram + sizeof(uint) * nBins);
+	if (nGroups) hd.offStart = end;
+
+	std::ofstream File(fname, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File.is_open()) return false;
+	File.write((const char*)&hd, sizeof(hd));
+
+	std::vector<float> buf(n_points);
+	auto writeArray = [&](uint64_t offset, const Real* src, int step, int idx) {
+		longlong i;
+#ifdef _OPENMP
+#pragma omp parallel for private(i)
+#endif
+		for (i = 0; i < (longlong)n_points; i++) {
+			const ulonglong s = nGroups ? order[i] : (ulonglong)i;
+			buf[i] = (float)src[s * step + idx];
+		}
+		if (!writeZero(File, offset)) return false;
+		File.write((const char*)buf.data(), (std::streamsize)szArray);
+		return File.good();
+	};
+
+	bool bOk = true;
+	for (int k = 0; k < 3 && bOk; k++)
+		bOk = writeArray(hd.offVertex + k * szArray, vertex, 3, k);
+	for (int c = 0; c < n_colors && bOk; c++)
+		bOk = writeArray(hd.offColor + c * szArray, color, n_colors, c);
+	if (phase && bOk)
+		bOk = writeArray(hd.offPhase, phase, 1, 0);
+	if (bOk && writeZero(File, hd.offHistogram))
+		File.write((const char*)histogram.data(), sizeof(uint) * nBins);
+	if (bOk && nGroups && writeZero(File, hd.offStart))
+		File.write((const char*)start.data(), sizeof(ulonglong) * (nGroups + 1));
+	bOk = bOk && File.good();
+	File.close();
+
+	if (!bOk) {
+		remove(fname);
+		return false;
+	}
+	return true;
+}
+
+bool PointCloudCache::open(const char* fname, const char* source)
+{
+	close();
+	if (!fname || !view.open(fname)) return false;
+
+	const PointCacheHeader* hd = (const PointCacheHeader*)view.data();
+	const uint64_t size = view.length();
+	bool bValid = size >= sizeof(PointCacheHeader) &&
+		memcmp(hd->magic, CACHE_MAGIC, sizeof(hd->magic)) == 0 &&
+		hd->version == CACHE_VERSION && hd->nPoints > 0 && hd->nColors > 0 && hd->nBins > 0;
+	if (bValid) {
+		const uint64_t szArray = sizeof(float) * hd->nPoints;
+		const uint nGroups = hd->sort == SORT_DEPTH ? hd->nBins : (hd->sort == SORT_TILE ? hd->nTileX * hd->nTileY : 0);
+		bValid = hd->offVertex + 3 * szArray <= size &&
+			hd->offColor + hd->nColors * szArray <= size &&
+			(hd->offPhase == 0 || hd->offPhase + szArray <= size) &&
+			hd->offHistogram + sizeof(uint) * hd->nBins <= size &&
+			(nGroups == 0 || (hd->offStart && hd->offStart + sizeof(ulonglong) * (nGroups + 1) <= size));
+	}
+	if (bValid && source) {
+		uint64_t srcSize;
+		int64_t srcTime;
+		bValid = getFileStamp(source, srcSize, srcTime) && srcSize == hd->sourceSize && srcTime == hd->sourceTime;
+	}
+	if (!bValid) {
+		view.release();
+		return false;
+	}
+	header = hd;
+	return true;
+}
+
+void PointCloudCache::close()
+{
+	view.release();
+	header = nullptr;
+}
+
+bool PointCloudCache::toArrays(ulonglong &n_points, int &n_colors, Real** vertex, Real** color, Real** phase)
+{
+	if (!header) return false;
+
+	const ulonglong n = header->nPoints;
+	const int nColors = header->nColors;
+
+	*vertex = new Real[n * 3];
+	*color = new Real[n * nColors];
+	if (phase) *phase = getPhase() ? new Real[n] : nullptr;
+
+	read(0, n, *vertex, *color, phase ? *phase : nullptr);
+
+	n_points = n;
+	n_colors = nColors;
+	return true;
+}
+
+ulonglong PointCloudCache::read(ulonglong first, ulonglong count, Real* vertex, Real* color, Real* phase, bool bParallel)
+{
+	if (!header || first >= header->nPoints) return 0;
+
+	const ulonglong n = header->nPoints;
+	const int nColors = header->nColors;
+	if (count > n - first) count = n - first;
+	const float* xyz[3] = { getX() + first, getY() + first, getZ() + first };
+	const float* col = array<float>(header->offColor) + first;
+	const float* ph = getPhase();
+	if (ph) ph += first;
+
+	longlong i;
+#ifdef _OPENMP
+#pragma omp parallel for private(i) if(bParallel)
+#endif
+	for (i = 0; i < (longlong)count; i++) {
+		vertex[3 * i + 0] = xyz[0][i];
+		vertex[3 * i + 1] = xyz[1][i];
+		vertex[3 * i + 2] = xyz[2][i];
+		for (int c = 0; c < nColors; c++)
+			color[nColors * i + c] = col[c * n + i];
+		if (phase && ph) phase[i] = ph[i];
+	}
+	return count;
+}
+
+void PointCloudCache::getBoundingBox(vec3& min, vec3& max)
+{
+	for (int k = 0; k < 3; k++) {
+		min[k] = header ? header->bboxMin[k] : 0.0;
+		max[k] = header ? header->bboxMax[k] : 0.0;
+	}
+}
+
+const uint* PointCloudCache::getDepthHistogram(uint& nBins)
+{
+	nBins = header ? header->nBins : 0;
+	return array<uint>(header ? header->offHistogram : 0);
+}
+
+const ulonglong* PointCloudCache::getGroupStart(uint& nGroups)
+{
+	nGroups = 0;
+	if (!header || !header->offStart) return nullptr;
+	nGroups = header->sort == SORT_DEPTH ? header->nBins : header->nTileX * header->nTileY;
+	return array<ulonglong>(header->offStart);
+}
@@ -0,0 +1,172 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __PointCloudCache_h
+#define __PointCloudCache_h
+
+#include "include.h"
+#include "vec.h"
+#include "FileView.h"
+
+#ifdef OPH_EXPORT
+#define OPH_DLL __declspec(dllexport)
+#else
+#define OPH_DLL __declspec(dllimport)
+#endif
+
+namespace oph
+{
+	/**
+	* @brief Header of the binary point cloud cache (*.ophpc).
+	* @details The header is followed by 64-byte aligned arrays :@n
+	*			x[n], y[n], z[n], color[n_colors][n], phase[n] (optional) as 32-bit float,@n
+	*			depth histogram[nBins] as uint32, and for a sorted cache the start index of each
+	*			depth bin or tile (nGroups + 1 entries) as uint64.
+	*/
+	struct PointCacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t nPoints;
+		int32_t nColors;
+		uint32_t flags;
+		int32_t sort;
+		uint32_t nBins;
+		uint32_t nTileX;
+		uint32_t nTileY;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		float bboxMin[3];
+		float bboxMax[3];
+		uint64_t offVertex;
+		uint64_t offColor;
+		uint64_t offPhase;
+		uint64_t offHistogram;
+		uint64_t offStart;
+	};
+
+	/**
+	* @brief Native binary cache of a point cloud : written once from parsed data and memory-mapped afterwards.
+	* @details Values are stored as 32-bit float structure of arrays with the bounding box and the depth histogram,
+	*			optionally sorted by depth bin or by x-y tile so that depth or tile-aware engines can read the groups directly.
+	*/
+	class OPH_DLL PointCloudCache {
+	public:
+		enum SORT { SORT_NONE, SORT_DEPTH, SORT_TILE };
+
+		PointCloudCache();
+		~PointCloudCache();
+
+		/**
+		* @brief Write a cache file.
+		* @param[in] vertex x, y, z per point
+		* @param[in] color n_colors values per point
+		* @param[in] phase one value per point, or nullptr
+		* @param[in] source file the cache is made from, its size and modification time are recorded (nullptr : none)
+		* @return Type: <B>bool</B>\n
+		*				If the function succeeds, the return value is <B>true</B>.\n
+		*				If a value is not exact in 32-bit float or the file can not be written, the return value is <B>false</B>.
+		*/
+		static bool save(const char* fname, ulonglong n_points, int n_colors, const Real* vertex, const Real* color, const Real* phase,
+			SORT sort = SORT_NONE, uint nBins = 256, uint nTileX = 16, uint nTileY = 16, const char* source = nullptr);
+
+		/**
+		* @brief Map a cache file.
+		* @param[in] source if not nullptr, the cache is rejected when the size or the modification time of source changed.
+		*/
+		bool open(const char* fname, const char* source = nullptr);
+		void close();
+		bool isOpen() { return header != nullptr; }
+
+		/**
+		* @brief Convert the mapped cache to the interleaved Real arrays used by the generators (allocated with new[]).
+		*/
+		bool toArrays(ulonglong &n_points, int &n_colors, Real** vertex, Real** color, Real** phase);
+
+		/**
+		* @brief Convert the points [first, first + count) to caller's interleaved arrays.
+		* @param[out] vertex 3 * count values
+		* @param[out] color n_colors * count values
+		* @param[out] phase count values, or nullptr
+		* @param[in] bParallel convert with an OpenMP team, false on a loader thread running beside one.
+		* @return Type: <B>ulonglong</B>\n
+		*				Number of converted points, less than count at the end of the cache.
+		*/
+		ulonglong read(ulonglong first, ulonglong count, Real* vertex, Real* color, Real* phase, bool bParallel = true);
+
+		ulonglong getNumberOfPoints() { return header ? header->nPoints : 0; }
+		int getNumberOfColors() { return header ? header->nColors : 0; }
+		bool hasPhase() { return header && header->offPhase != 0; }
+		SORT getSort() { return header ? (SORT)header->sort : SORT_NONE; }
+		void getBoundingBox(vec3& min, vec3& max);
+
+		const float* getX() { return array<float>(header ? header->offVertex : 0); }
+		const float* getY() { return getX() ? getX() + header->nPoints : nullptr; }
+		const float* getZ() { return getX() ? getX() + 2 * header->nPoints : nullptr; }
+		const float* getColor(int ch) { return header && ch < header->nColors ? array<float>(header->offColor) + ch * header->nPoints : nullptr; }
+		const float* getPhase() { return array<float>(header ? header->offPhase : 0); }
+		/**
+		* @brief Number of points per depth bin over [bboxMin.z, bboxMax.z].
+		*/
+		const uint* getDepthHistogram(uint& nBins);
+		/**
+		* @brief First point index of each depth bin (SORT_DEPTH) or tile (SORT_TILE, row-major), nGroups + 1 entries.
+		*/
+		const ulonglong* getGroupStart(uint& nGroups);
+
+		/**
+		* @brief Modification time and size of a file.
+		*/
+		static bool getFileStamp(const char* fname, uint64_t& size, int64_t& time);
+
+	private:
+		template<typename T>
+		const T* array(uint64_t offset) { return (header && offset) ? (const T*)(view.data() + offset) : nullptr; }
+
+		FileView view;
+		const PointCacheHeader* header;
+	};
+}
+
+#endif // !__PointCloudCache_h
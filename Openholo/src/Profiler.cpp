@@ -0,0 +1,280 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "Profiler.h"
+#include "sys.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace oph;
+
+namespace {
+	std::atomic<bool> g_bEnable(false);
+	const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+	const char* const g_counterName[PROF_NUM_COUNTER] = { "points", "fft", "alloc_bytes" };
+
+	struct ProfileEvent {
+		const char* name;
+		longlong begin;
+		longlong end;
+	};
+
+	struct StageStat {
+		ulonglong calls;
+		longlong total;
+		longlong min;
+		longlong max;
+	};
+
+	// stage names are string literals, escaped anyway as callers may pass any text.
+	void writeJSONString(FILE* fp, const char* s)
+	{
+		fputc('"', fp);
+		for (; *s; s++) {
+			if (*s == '"' || *s == '\\') fputc('\\', fp);
+			if ((unsigned char)*s >= 0x20) fputc(*s, fp);
+		}
+		fputc('"', fp);
+	}
+}
+
+struct Profiler::ThreadBuffer {
+	uint tid;
+	std::mutex mtx;
+	std::unordered_map<const char*, StageStat> stats;	///< keyed by the name pointer, merged by text in getStages.
+	std::vector<ProfileEvent> events;
+	std::atomic<ulonglong> counter[PROF_NUM_COUNTER];
+};
+
+Profiler::Profiler()
+	: eventLimit(1 << 20)
+{
+}
+
+Profiler::~Profiler()
+{
+	for (auto* buffer : buffers) delete buffer;
+	buffers.clear();
+}
+
+Profiler* Profiler::getInstance()
+{
+	static Profiler instance;
+	return &instance;
+}
+
+bool Profiler::isEnable(void)
+{
+	return g_bEnable.load(std::memory_order_relaxed);
+}
+
+longlong Profiler::now(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void Profiler::setEnable(bool bEnable)
+{
+	g_bEnable.store(bEnable, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer* Profiler::getThreadBuffer(void)
+{
+	// buffers are owned by the profiler and outlive their threads, so results of pooled threads are kept.
+	static thread_local ThreadBuffer* t_buffer = nullptr;
+	if (t_buffer == nullptr) {
+		ThreadBuffer* buffer = new ThreadBuffer;
+		for (int i = 0; i < PROF_NUM_COUNTER; i++) buffer->counter[i] = 0;
+		std::lock_guard<std::mutex> lock(mtx);
+		buffer->tid = (uint)buffers.size();
+		buffers.push_back(buffer);
+		t_buffer = buffer;
+	}
+	return t_buffer;
+}
+
+void Profiler::record(const char* name, longlong begin, longlong end)
+{
+	ThreadBuffer* buffer = getThreadBuffer();
+	const longlong elapsed = end - begin;
+
+	std::lock_guard<std::mutex> lock(buffer->mtx);
+	auto it = buffer->stats.find(name);
+	if (it == buffer->stats.end())
+		buffer->stats[name] = { 1, elapsed, elapsed, elapsed };
+	else {
+		StageStat& stat = it->second;
+		stat.calls++;
+		stat.total += elapsed;
+		if (elapsed < stat.min) stat.min = elapsed;
+		if (elapsed > stat.max) stat.max = elapsed;
+	}
+	if (buffer->events.size() < eventLimit)
+		buffer->events.push_back({ name, begin, end });
+}
+
+void Profiler::count(PROFILE_COUNTER counter, ulonglong n)
+{
+	getThreadBuffer()->counter[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+std::vector<ProfileStage> Profiler::getStages(void)
+{
+	std::map<std::string, StageStat> merged;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto* buffer : buffers) {
+			std::lock_guard<std::mutex> lockBuffer(buffer->mtx);
+			for (auto& item : buffer->stats) {
+				auto it = merged.find(item.first);
+				if (it == merged.end())
+					merged[item.first] = item.second;
+				else {
+					StageStat& stat = it->second;
+					stat.calls += item.second.calls;
+					stat.total += item.second.total;
+					if (item.second.min < stat.min) stat.min = item.second.min;
+					if (item.second.max > stat.max) stat.max = item.second.max;
+				}
+			}
+		}
+	}
+
+	std::vector<ProfileStage> stages;
+	for (auto& item : merged) {
+		ProfileStage stage;
+		stage.name = item.first;
+		stage.calls = item.second.calls;
+		stage.total = item.second.total * 1e-9;
+		stage.min = item.second.min * 1e-9;
+		stage.max = item.second.max * 1e-9;
+		stages.push_back(stage);
+	}
+	std::sort(stages.begin(), stages.end(), [](const ProfileStage& a, const ProfileStage& b) { return a.total > b.total; });
+	return stages;
+}
+
+ulonglong Profiler::getCounter(PROFILE_COUNTER counter)
+{
+	ulonglong sum = 0;
+	std::lock_guard<std::mutex> lock(mtx);
+	for (auto* buffer : buffers)
+		sum += buffer->counter[counter].load(std::memory_order_relaxed);
+	return sum;
+}
+
+void Profiler::reset(void)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	for (auto* buffer : buffers) {
+		std::lock_guard<std::mutex> lockBuffer(buffer->mtx);
+		buffer->stats.clear();
+		buffer->events.clear();
+		for (int i = 0; i < PROF_NUM_COUNTER; i++) buffer->counter[i] = 0;
+	}
+}
+
+bool Profiler::exportJSON(const char* fname)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) {
+		LOG("<FAILED> Export profile : %s\n", fname);
+		return false;
+	}
+
+	std::vector<ProfileStage> stages = getStages();
+	fprintf(fp, "{\n\t\"stages\": [");
+	for (size_t i = 0; i < stages.size(); i++) {
+		const ProfileStage& stage = stages[i];
+		fprintf(fp, "%s\n\t\t{ \"name\": ", i ? "," : "");
+		writeJSONString(fp, stage.name.c_str());
+		fprintf(fp, ", \"calls\": %llu, \"total\": %.9f, \"mean\": %.9f, \"min\": %.9f, \"max\": %.9f }",
+			stage.calls, stage.total, stage.total / stage.calls, stage.min, stage.max);
+	}
+	fprintf(fp, "\n\t],\n\t\"counters\": {");
+	for (int i = 0; i < PROF_NUM_COUNTER; i++)
+		fprintf(fp, "%s\n\t\t\"%s\": %llu", i ? "," : "", g_counterName[i], getCounter((PROFILE_COUNTER)i));
+	fprintf(fp, "\n\t}\n}\n");
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool Profiler::exportChromeTrace(const char* fname)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) {
+		LOG("<FAILED> Export trace : %s\n", fname);
+		return false;
+	}
+
+	// complete events ("ph":"X") in microseconds, one track per recording thread.
+	bool bFirst = true;
+	longlong last = 0;
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto* buffer : buffers) {
+			std::lock_guard<std::mutex> lockBuffer(buffer->mtx);
+			for (auto& event : buffer->events) {
+				fprintf(fp, "%s\n{\"name\":", bFirst ? "" : ",");
+				writeJSONString(fp, event.name);
+				fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					buffer->tid, event.begin * 1e-3, (event.end - event.begin) * 1e-3);
+				if (event.end > last) last = event.end;
+				bFirst = false;
+			}
+		}
+	}
+	fprintf(fp, "%s\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{", bFirst ? "" : ",", last * 1e-3);
+	for (int i = 0; i < PROF_NUM_COUNTER; i++)
+		fprintf(fp, "%s\"%s\":%llu", i ? "," : "", g_counterName[i], getCounter((PROFILE_COUNTER)i));
+	fprintf(fp, "}}\n]}\n");
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
@@ -0,0 +1,175 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __Profiler_h
+#define __Profiler_h
+
+#include "include.h"
+#include <atomic>
+#include <mutex>
+
+#ifdef OPH_EXPORT
+#define OPH_DLL __declspec(dllexport)
+#else
+#define OPH_DLL __declspec(dllimport)
+#endif
+
+namespace oph
+{
+	/**
+	* @brief Counters of the profiler, summed over all threads.
+	*/
+	enum PROFILE_COUNTER {
+		PROF_POINTS = 0,		///< object points diffracted
+		PROF_FFT,				///< FFTs executed
+		PROF_ALLOC_BYTES,		///< bytes of the hologram buffers allocated
+		PROF_NUM_COUNTER
+	};
+
+	/**
+	* @brief Timing of a named stage.
+	*/
+	struct OPH_DLL ProfileStage {
+		std::string name;
+		ulonglong calls;
+		Real total;			///< seconds
+		Real min;
+		Real max;
+	};
+
+	/**
+	* @brief Collects scoped timings and counters of the hot paths.
+	* @details Disabled by default : a scope then costs one flag test. When enabled, every thread records into
+	*			its own buffer, so the only lock taken on the hot path is the uncontended lock of that buffer.@n
+	*			Stages of the library : load, scale, generate, fft, propagate, encode, normalize, save.
+	*/
+	class OPH_DLL Profiler
+	{
+	private:
+		Profiler();
+		~Profiler();
+	public:
+		/**
+		* @brief Get the shared instance, created once on first use by any thread.
+		*/
+		static Profiler* getInstance();
+
+		static bool isEnable(void);
+		/**
+		* @brief Nanoseconds since the profiler was created.
+		*/
+		static longlong now(void);
+
+		void setEnable(bool bEnable);
+		/**
+		* @brief Number of raw events kept per thread for the trace, the stage statistics are always kept.
+		*/
+		void setEventLimit(size_t limit) { eventLimit = limit; }
+
+		void record(const char* name, longlong begin, longlong end);
+		void count(PROFILE_COUNTER counter, ulonglong n);
+
+		/**
+		* @brief Per-stage breakdown since the last reset, sorted by total time.
+		*/
+		std::vector<ProfileStage> getStages(void);
+		ulonglong getCounter(PROFILE_COUNTER counter);
+		void reset(void);
+
+		/**
+		* @brief Write the stages and the counters as JSON.
+		*/
+		bool exportJSON(const char* fname);
+		/**
+		* @brief Write the raw events in the Chrome trace event format (chrome://tracing, Perfetto).
+		*/
+		bool exportChromeTrace(const char* fname);
+
+	private:
+		struct ThreadBuffer;
+		ThreadBuffer* getThreadBuffer(void);
+
+		std::mutex mtx;
+		std::vector<ThreadBuffer*> buffers;
+		size_t eventLimit;
+	};
+
+	/**
+	* @brief Records the lifetime of the scope as a stage of the profiler.
+	*/
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name)
+			: name(Profiler::isEnable() ? name : nullptr), begin(0)
+		{
+			if (this->name) begin = Profiler::now();
+		}
+		~ProfileScope()
+		{
+			if (name) Profiler::getInstance()->record(name, begin, Profiler::now());
+		}
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* name;
+		longlong begin;
+	};
+}
+
+#define OPH_PROFILE_CONCAT_(a, b) a##b
+#define OPH_PROFILE_CONCAT(a, b) OPH_PROFILE_CONCAT_(a, b)
+
+#ifndef OPH_NO_PROFILE
+/// time the rest of the enclosing scope as the stage name (a string literal).
+#define OPH_PROFILE(name) oph::ProfileScope OPH_PROFILE_CONCAT(_oph_profile_, __LINE__)(name)
+#define OPH_PROFILE_COUNT(counter, n) do { if (oph::Profiler::isEnable()) oph::Profiler::getInstance()->count(counter, n); } while (0)
+#else
+#define OPH_PROFILE(name)
+#define OPH_PROFILE_COUNT(counter, n)
+#endif
+
+#endif // !__Profiler_h
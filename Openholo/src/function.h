@@ -196,31 +196,56 @@ namespace oph
 	}
 
 	/**
-	* @brief Normalize all elements of T* src from 0 to 255.
+	* @brief Minimum and maximum of T* src in one parallel pass.
 	*/
 	template<typename T>
-	inline void normalize(T* src, oph::uchar* dst, const oph::uint nx, const oph::uint ny) {
-		T minVal, maxVal;
-		for (oph::uint ydx = 0; ydx < ny; ydx++){
-			for (oph::uint xdx = 0; xdx < nx; xdx++){
-				T *temp_pos = src + xdx + ydx * nx;
-				if ((xdx == 0) && (ydx == 0)) {	minVal = *(temp_pos); maxVal = *(temp_pos);	}
-				else {
-					if ((*temp_pos) < minVal) minVal = (*temp_pos);
-					if ((*temp_pos) > maxVal) maxVal = (*temp_pos);
-				}
+	inline void minMaxOfArr(const T* src, const int size, T& minVal, T& maxVal) {
+		if (size <= 0) return;
+		minVal = maxVal = src[0];
+#pragma omp parallel
+		{
+			T localMin = src[0], localMax = src[0];
+			int i;
+#pragma omp for
+			for (i = 0; i < size; i++) {
+				if (src[i] < localMin) localMin = src[i];
+				if (src[i] > localMax) localMax = src[i];
 			}
-		}
-		
-		for (oph::uint ydx = 0; ydx < ny; ydx++) {
-			for (oph::uint xdx = 0; xdx < nx; xdx++) {
-				T *src_pos = src + xdx + ydx * nx;
-				oph::uchar *res_pos = dst + xdx + (ny - ydx - 1)*nx;
-				*(res_pos) = oph::force_cast<oph::uchar>(((*(src_pos)-minVal) / (maxVal - minVal)) * 255 + 0.5);
+#pragma omp critical
+			{
+				if (localMin < minVal) minVal = localMin;
+				if (localMax > maxVal) maxVal = localMax;
 			}
 		}
 	}
 
+	/**
+	* @brief Quantize all elements of T* src from 0 to maxLevel with the known range [minVal, maxVal].
+	*		 The rows are written bottom-up (vertical flip for the image files).
+	*/
+	template<typename T, typename Q>
+	inline void quantize(const T* src, Q* dst, const oph::uint nx, const oph::uint ny, const T minVal, const T maxVal, const T maxLevel) {
+		const T range = (maxVal > minVal) ? (maxVal - minVal) : T(1);
+		int ydx;
+#pragma omp parallel for private(ydx)
+		for (ydx = 0; ydx < (int)ny; ydx++) {
+			const T* src_row = src + (size_t)ydx * nx;
+			Q* res_row = dst + (size_t)(ny - ydx - 1) * nx;
+			for (oph::uint xdx = 0; xdx < nx; xdx++)
+				res_row[xdx] = Q(((src_row[xdx] - minVal) / range) * maxLevel + 0.5);
+		}
+	}
+
+	/**
+	* @brief Normalize all elements of T* src from 0 to 255.
+	*/
+	template<typename T>
+	inline void normalize(T* src, oph::uchar* dst, const oph::uint nx, const oph::uint ny) {
+		T minVal, maxVal;
+		minMaxOfArr<T>(src, (int)(nx * ny), minVal, maxVal);
+		quantize<T, oph::uchar>(src, dst, nx, ny, minVal, maxVal, T(255));
+	}
+
 	/**
 	* @brief Normalize all elements from 0 to 255. 
 	*/
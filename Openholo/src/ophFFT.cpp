@@ -0,0 +1,195 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+
+#include "ophFFT.h"
+#include "define.h"
+#include "sys.h"
+#include "Profiler.h"
+
+using namespace oph;
+
+ophFFT::ophFFT()
+{
+	fftw_init_threads();
+}
+
+ophFFT::~ophFFT()
+{
+	clear();
+}
+
+ophFFT* ophFFT::getInstance()
+{
+	static ophFFT instance;
+	return &instance;
+}
+
+std::mutex& ophFFT::plannerLock()
+{
+	static std::mutex lock;
+	return lock;
+}
+
+fftw_plan ophFFT::getPlan2D(int nx, int ny, fftw_complex* in, fftw_complex* out, int sign)
+{
+	PlanKey key;
+	key.nx = nx;
+	key.ny = ny;
+	key.sign = sign;
+	key.bInPlace = (in == out);
+	key.bAligned = (fftw_alignment_of((double*)in) == 0) && (fftw_alignment_of((double*)out) == 0);
+
+	std::lock_guard<std::mutex> lock(plannerLock());
+	auto iter = plans.find(key);
+	if (iter != plans.end())
+		return iter->second;
+
+	// FFTW_ESTIMATE does not touch the buffers, so planning on the caller's data is safe.
+	uint flag = FFTW_ESTIMATE;
+	if (!key.bAligned) flag |= FFTW_UNALIGNED;
+	fftw_plan plan = fftw_plan_dft_2d(ny, nx, in, out, sign, flag);
+	if (!plan) {
+		LOG("<FAILED> fftw_plan_dft_2d (%d x %d).\n", nx, ny);
+		return nullptr;
+	}
+	plans[key] = plan;
+	return plan;
+}
+
+bool ophFFT::fft2(int nx, int ny, Complex<Real>* in, Complex<Real>* out, int sign, bool bNormalized)
+{
+	if (!in || !out || nx <= 0 || ny <= 0) return false;
+	OPH_PROFILE("fft");
+
+	fftw_plan plan = getPlan2D(nx, ny, (fftw_complex*)in, (fftw_complex*)out, sign);
+	if (!plan) return false;
+	fftw_execute_dft(plan, (fftw_complex*)in, (fftw_complex*)out);
+	OPH_PROFILE_COUNT(PROF_FFT, 1);
+
+	if (bNormalized) {
+		const int N = nx * ny;
+		const Real scale = 1.0 / N;
+		int i;
+#pragma omp parallel for private(i)
+		for (i = 0; i < N; i++) {
+			out[i][_RE] *= scale;
+			out[i][_IM] *= scale;
+		}
+	}
+	return true;
+}
+
+bool ophFFT::fft2Shifted(int nx, int ny, Complex<Real>* data, int sign, bool bNormalized)
+{
+	if (!data || nx <= 0 || ny <= 0) return false;
+
+	const Real scale = bNormalized ? 1.0 / ((Real)nx * ny) : 1.0;
+
+	if ((nx & 1) || (ny & 1)) {
+		// odd size : explicit ifftshift -> fft -> fftshift through a scratch buffer.
+		const int N = nx * ny;
+		Complex<Real>* tmp = new Complex<Real>[N];
+		int hx = nx / 2, hy = ny / 2;
+		int y;
+#pragma omp parallel for private(y)
+		for (y = 0; y < ny; y++) {
+			int sy = (y + hy) % ny;
+			for (int x = 0; x < nx; x++)
+				tmp[y * nx + x] = data[sy * nx + (x + hx) % nx];
+		}
+		bool bOk = fft2(nx, ny, tmp, tmp, sign, false);
+		hx = nx - hx;
+		hy = ny - hy;
+#pragma omp parallel for private(y)
+		for (y = 0; y < ny; y++) {
+			int sy = (y + hy) % ny;
+			for (int x = 0; x < nx; x++) {
+				Complex<Real>& v = tmp[sy * nx + (x + hx) % nx];
+				data[y * nx + x][_RE] = v[_RE] * scale;
+				data[y * nx + x][_IM] = v[_IM] * scale;
+			}
+		}
+		delete[] tmp;
+		return bOk;
+	}
+
+	// even size : fftshift(F(ifftshift(u)))[k] = (-1)^(k + N/2) * F((-1)^n * u)[k] on each axis.
+	OPH_PROFILE("fft");
+	int y;
+#pragma omp parallel for private(y)
+	for (y = 0; y < ny; y++) {
+		Complex<Real>* row = data + y * nx;
+		for (int x = (y & 1) ^ 1; x < nx; x += 2) {
+			row[x][_RE] = -row[x][_RE];
+			row[x][_IM] = -row[x][_IM];
+		}
+	}
+
+	fftw_plan plan = getPlan2D(nx, ny, (fftw_complex*)data, (fftw_complex*)data, sign);
+	if (!plan) return false;
+	fftw_execute_dft(plan, (fftw_complex*)data, (fftw_complex*)data);
+	OPH_PROFILE_COUNT(PROF_FFT, 1);
+
+	const Real s = (((nx / 2) + (ny / 2)) & 1) ? -scale : scale;
+#pragma omp parallel for private(y)
+	for (y = 0; y < ny; y++) {
+		Complex<Real>* row = data + y * nx;
+		for (int x = 0; x < nx; x++) {
+			const Real f = ((x + y) & 1) ? -s : s;
+			row[x][_RE] *= f;
+			row[x][_IM] *= f;
+		}
+	}
+	return true;
+}
+
+void ophFFT::clear()
+{
+	std::lock_guard<std::mutex> lock(plannerLock());
+	for (auto& plan : plans)
+		fftw_destroy_plan(plan.second);
+	plans.clear();
+}
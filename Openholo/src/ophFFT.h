@@ -0,0 +1,148 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+
+#ifndef __ophFFT_h
+#define __ophFFT_h
+
+#include <map>
+#include <mutex>
+#include "typedef.h"
+#include "complex.h"
+#include "fftw3.h"
+
+#ifdef OPH_EXPORT
+#define OPH_DLL __declspec(dllexport)
+#else
+#define OPH_DLL __declspec(dllimport)
+#endif
+
+namespace oph
+{
+	/**
+	* @brief Shared FFT layer of the library.
+	* @details FFTW plans are created once per (size, direction, in-place, alignment) and reused by
+	* fftw_execute_dft on any buffer of the same shape, so repeated transforms skip the planner.
+	* Execution is thread-safe; planning is serialized by plannerLock().
+	* Plans use the FFTW thread count set by the caller (Openholo sets omp_get_max_threads()).
+	* Data is row-major : nx is the number of column(contiguous), ny is the number of row.
+	* The cached plans live until the process exits, so the library never calls fftw_cleanup*,
+	* which would free them under the cache.
+	*/
+	class OPH_DLL ophFFT
+	{
+	private:
+		ophFFT();
+		~ophFFT();
+	public:
+		/**
+		* @brief Get the shared instance, created once on first use by any thread.
+		*/
+		static ophFFT* getInstance();
+
+		/**
+		* @brief Lock of the FFTW planner, which is not thread-safe.
+		* @details Every fftw_plan_* and fftw_destroy_plan of the library is called under it,
+		* the cached plans of ophFFT included. fftw_execute needs no lock.
+		*/
+		static std::mutex& plannerLock();
+
+		/**
+		* @brief Get the cached 2D plan matching the shape and buffers, create it on first use.
+		* @param[in] nx the number of column of the data.
+		* @param[in] ny the number of row of the data.
+		* @param[in] in Source buffer used for planning.
+		* @param[in] out Dest buffer used for planning. (in == out: in-place plan)
+		* @param[in] sign Sign of FFTW(OPH_FORWARD or OPH_BACKWARD)
+		* @return Plan to be executed with fftw_execute_dft, nullptr on failure.
+		*/
+		fftw_plan getPlan2D(int nx, int ny, fftw_complex* in, fftw_complex* out, int sign);
+
+		/**
+		* @brief 2D FFT with a cached plan.
+		* @param[in] nx the number of column of the data.
+		* @param[in] ny the number of row of the data.
+		* @param[in] in Source of data.
+		* @param[out] out Dest of data. (in-place when in == out)
+		* @param[in] sign Sign of FFTW(OPH_FORWARD or OPH_BACKWARD)
+		* @param[in] bNormalized If bNormalized == true, the result is scaled by 1/(nx*ny).
+		*/
+		bool fft2(int nx, int ny, Complex<Real>* in, Complex<Real>* out, int sign, bool bNormalized = false);
+
+		/**
+		* @brief In-place centered 2D FFT, same result as fftshift(fft2(ifftshift(data))).
+		* @details For even sizes the shifts are folded into a (-1)^(x+y) modulation before and after
+		* the transform, so no extra buffer or copy pass is needed. Odd sizes fall back to explicit shifts.
+		* @param[in] nx the number of column of the data.
+		* @param[in] ny the number of row of the data.
+		* @param[in,out] data Data to be transformed.
+		* @param[in] sign Sign of FFTW(OPH_FORWARD or OPH_BACKWARD)
+		* @param[in] bNormalized If bNormalized == true, the result is scaled by 1/(nx*ny).
+		*/
+		bool fft2Shifted(int nx, int ny, Complex<Real>* data, int sign, bool bNormalized = false);
+
+		/**
+		* @brief Destroy every cached plan.
+		*/
+		void clear();
+
+	private:
+		struct PlanKey
+		{
+			int nx, ny, sign;
+			bool bInPlace, bAligned;
+			bool operator<(const PlanKey& k) const {
+				if (nx != k.nx) return nx < k.nx;
+				if (ny != k.ny) return ny < k.ny;
+				if (sign != k.sign) return sign < k.sign;
+				if (bInPlace != k.bInPlace) return bInPlace < k.bInPlace;
+				return bAligned < k.bAligned;
+			}
+		};
+		std::map<PlanKey, fftw_plan> plans;
+	};
+}
+
+#endif
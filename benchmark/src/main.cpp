@@ -0,0 +1,113 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophGenBenchmark.h"
+#include "ophSigBenchmark.h"
+#include "ophRecBenchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+* @brief Command line runner of the benchmark cases of ophgen, ophsig and ophrec.
+* @details openholo_benchmark [options]@n
+*			-points N, -resolution W H, -layers N, -channels 1|3, -threads N, -repeat N, -warmup N, -seed N,
+*			-workdir DIR, -filter TEXT : fields of BenchmarkConfig.@n
+*			-json FILE, -csv FILE : result files, benchmark.json by default.@n
+*			The exit code is 0 when every case succeeded.
+*/
+static void usage(const char* exe)
+{
+	printf("usage : %s [-points N] [-resolution W H] [-layers N] [-channels 1|3] [-threads N]\n"
+		"\t[-repeat N] [-warmup N] [-seed N] [-workdir DIR] [-filter TEXT] [-json FILE] [-csv FILE]\n", exe);
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkConfig config;
+	const char* json = "benchmark.json";
+	const char* csv = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const bool bValue = i + 1 < argc;
+		if (!strcmp(arg, "-points") && bValue) config.nPoints = strtoull(argv[++i], nullptr, 10);
+		else if (!strcmp(arg, "-resolution") && i + 2 < argc) {
+			config.resolution[_X] = atoi(argv[++i]);
+			config.resolution[_Y] = atoi(argv[++i]);
+		}
+		else if (!strcmp(arg, "-layers") && bValue) config.nLayers = atoi(argv[++i]);
+		else if (!strcmp(arg, "-channels") && bValue) config.nChannels = atoi(argv[++i]);
+		else if (!strcmp(arg, "-threads") && bValue) config.nThreads = atoi(argv[++i]);
+		else if (!strcmp(arg, "-repeat") && bValue) config.repeat = atoi(argv[++i]);
+		else if (!strcmp(arg, "-warmup") && bValue) config.warmup = atoi(argv[++i]);
+		else if (!strcmp(arg, "-seed") && bValue) config.seed = (uint)strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(arg, "-workdir") && bValue) config.workDir = argv[++i];
+		else if (!strcmp(arg, "-filter") && bValue) config.filter = argv[++i];
+		else if (!strcmp(arg, "-json") && bValue) json = argv[++i];
+		else if (!strcmp(arg, "-csv") && bValue) csv = argv[++i];
+		else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (config.nChannels != 1 && config.nChannels != 3) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	Benchmark bench(config);
+	if (!ophGenBenchmark::addCases(bench) ||
+		!ophSigBenchmark::addCases(bench) ||
+		!ophRecBenchmark::addCases(bench)) {
+		printf("<FAILED> Prepare benchmark inputs : %s\n", config.workDir.c_str());
+		return 1;
+	}
+
+	const bool bOK = bench.run();
+	if (json && !bench.exportJSON(json)) return 1;
+	if (csv && !bench.exportCSV(csv)) return 1;
+	return bOK ? 0 : 1;
+}
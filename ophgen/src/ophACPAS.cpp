@@ -8,6 +8,7 @@
 #include <windows.h>
 
 #include "sys.h"
+#include "ophFFT.h"
 
 #include "tinyxml2.h"
 #include "PLYparser.h"
@@ -637,7 +638,10 @@ void ophACPAS::ACPAS(long voxelnum, OphPointCloudData *data, OphPointCloudConfig
 		}
 	}
 
-	plan = fftw_plan_dft_2d(FFTsegSize, FFTsegSize, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		plan = fftw_plan_dft_2d(FFTsegSize, FFTsegSize, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	}
 
 	for (segy = 0; segy < segNumy; segy++) {
 		for (segx = 0; segx < segNumx; segx++) {
@@ -666,7 +670,10 @@ void ophACPAS::ACPAS(long voxelnum, OphPointCloudData *data, OphPointCloudConfig
 	//AfxMessageBox(mm);
 	cout << duration << endl;
 
-	fftw_destroy_plan(plan);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(plan);
+	}
 	fftw_free(in);
 	fftw_free(out);
 	delete[] dPhaseSFy;
@@ -823,7 +830,10 @@ void ophACPAS::ACPAS(long voxelnum, VoxelStruct * _h_vox, CGHEnvironmentData * _
 		}
 	}
 
-	plan = fftw_plan_dft_2d(FFTsegSize, FFTsegSize, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		plan = fftw_plan_dft_2d(FFTsegSize, FFTsegSize, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	}
 
 	for (segy = 0; segy<segNumy; segy++) {
 		for (segx = 0; segx<segNumx; segx++) {
@@ -852,7 +862,10 @@ void ophACPAS::ACPAS(long voxelnum, VoxelStruct * _h_vox, CGHEnvironmentData * _
 	//AfxMessageBox(mm);
 	cout << duration << endl;
 
-	fftw_destroy_plan(plan);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(plan);
+	}
 	fftw_free(in);
 	fftw_free(out);
 	delete[] dPhaseSFy;
@@ -1,7 +1,6 @@
 #define OPH_DM_EXPORT 
 
 #include "ophAS.h"
-#include <random>
 #include "sys.h"
 #include "tinyxml2.h"
 #include "PLYparser.h"
@@ -9,6 +8,7 @@
 #include <device_launch_parameters.h>
 #include "ophAS_GPU.h"
 #include "FFTImplementationCallback.h"
+#include "ophFFT.h"
 
 
 
@@ -18,6 +18,9 @@ ophAS::ophAS()
 	this->y = 0.0;
 	this->z = 0.0;
 	this->amplitude = 1.0;
+	this->res = nullptr;
+	this->n_points = 0;
+	this->is_CPU = true;
 }
 
 ophAS::~ophAS()
@@ -177,135 +180,143 @@ void ophAS::ASCalculation(double w, double h, double wavelength, double knumber,
 
 void ophAS::RayleighSommerfield(double w, double h, double wavelength, double knumber, double xi_interval, double eta_interval, double depth, coder::array<creal_T, 2U>& fringe)
 {
-	double pi = atan(1) * 4;
-	random_device rd;
-	mt19937 gen(rd());
-	uniform_real_distribution<double> dis(0, 1);
-	double init_phase = 1.0;
-	double eta_tilting = 0 * pi / 180;
-	double xi_tilting = 0 * pi / 180;
-	int n = log10(w) / log10(2);
-	for(int i=0;i<w; i++)
+	if (n_points > 0 && pc_data.vertex != nullptr)
 	{
-		double eta = (i - w / 2)*eta_interval;
-		for (int j = 0; j < h; j++)
-		{
-			double xi = (j - h / 2)*xi_interval;
-			double R = sqrt(pow(eta - this->y, 2) + pow(xi - this->x, 2) + pow(depth + this->z, 2));
-			double total_phase = knumber*R + knumber*xi*sin(xi_tilting) + knumber*eta*sin(eta_tilting) + init_phase * 2 * pi;
-			complex<double> tmp = (this->amplitude / R)*exp(total_phase*I);
-			fringe[i + (j<<n)].re = tmp.real();
-			fringe[i + (j <<n)].im = tmp.imag();
-		}
+		RayleighSommerfield(w, h, wavelength, knumber, xi_interval, eta_interval, depth, pc_data, fringe);
+		return;
 	}
+
+	// single object point (x, y, z, amplitude) as an one-point set.
+	Real vertex[3] = { this->x, this->y, this->z };
+	Real color[1] = { this->amplitude };
+	OphPointCloudData single;
+	single.n_points = 1;
+	single.n_colors = 1;
+	single.vertex = vertex;
+	single.color = color;
+	pointField(w, h, knumber, xi_interval, eta_interval, depth, single, vec3(1.0, 1.0, 1.0), fringe);
 }
 
-void ophAS::AngularSpectrum(double w, double h, double wavelength, double knumber, double xi_interval, double eta_interval, double depth, const coder::array<creal_T, 2U>& fringe, coder::array<creal_T, 2U>& b_AngularC)
+void ophAS::RayleighSommerfield(double w, double h, double wavelength, double knumber, double xi_interval, double eta_interval, double depth, const OphPointCloudData& pc, coder::array<creal_T, 2U>& fringe)
 {
-	auto start = CUR_TIME;
-	coder::array<creal_T, 2U> fringe_temp1;
-	int loop_ub;
-	int i;
-	coder::array<creal_T, 2U> fringe_temp3;
-	double eta;
-	int xi_id;
-	coder::array<creal_T, 2U> fringe_temp2;
-	double y_im;
-	double y_re;
-	double minfrequency_eta;
-	double minfrequency_xi;
-
-
-
-
+	pointField(w, h, knumber, xi_interval, eta_interval, depth, pc, pc_config.scale, fringe);
+}
 
-	fringe_temp1.set_size(fringe.size(0), fringe.size(1));
-	loop_ub = fringe.size(0) * fringe.size(1);
-	for (i = 0; i < loop_ub; i++) {
-		fringe_temp1[i] = fringe[i];
+void ophAS::pointField(double w, double h, double knumber, double xi_interval, double eta_interval, double depth, const OphPointCloudData& pc, const vec3& scale, coder::array<creal_T, 2U>& fringe)
+{
+	auto start = CUR_TIME;
+	const double init_phase = 1.0 * 2 * M_PI;
+	const int nx = static_cast<int>(w);
+	const int ny = static_cast<int>(h);
+	const int nPoints = static_cast<int>(pc.n_points);
+
+	// scaled points laid out as arrays for the inner loop.
+	vector<double> px(nPoints), py(nPoints), pz(nPoints), amp(nPoints), phase(nPoints);
+	for (int p = 0; p < nPoints; p++)
+	{
+		px[p] = pc.vertex[3 * p + _X] * scale[_X];
+		py[p] = pc.vertex[3 * p + _Y] * scale[_Y];
+		pz[p] = pc.vertex[3 * p + _Z] * scale[_Z];
+		amp[p] = pc.color ? pc.color[pc.n_colors * p] : this->amplitude;
+		phase[p] = (pc.isPhaseParse && pc.phase) ? pc.phase[p] : init_phase;
 	}
 
-	fringe_temp3.set_size(fringe.size(0), fringe.size(1));
-	loop_ub = fringe.size(0) * fringe.size(1);
-	for (i = 0; i < loop_ub; i++) {
-		fringe_temp3[i] = fringe[i];
+	int j;
+#pragma omp parallel for private(j)
+	for (j = 0; j < ny; j++)
+	{
+		vector<double> re(nx, 0.0), im(nx, 0.0);
+		double xi = (j - h / 2)*xi_interval;
+		for (int p = 0; p < nPoints; p++)
+		{
+			// as the baseline : eta(i, contiguous) runs along y, xi(j, row) along x.
+			double dz = depth + pz[p];
+			double c = (xi - px[p]) * (xi - px[p]) + dz * dz;
+			double x0 = w / 2 * eta_interval + py[p];
+			double a0 = amp[p];
+			double p0 = phase[p];
+			for (int i = 0; i < nx; i++)
+			{
+				double dx = i * eta_interval - x0;
+				double R = sqrt(dx * dx + c);
+				double total_phase = knumber * R + p0;
+				double a = a0 / R;
+				re[i] += a * cos(total_phase);
+				im[i] += a * sin(total_phase);
+			}
+		}
+		for (int i = 0; i < nx; i++)
+		{
+			fringe[i + j * nx].re = re[i];
+			fringe[i + j * nx].im = im[i];
+		}
 	}
 
+	auto end = CUR_TIME;
+	LOG("%d points : %.5lfsec\n", nPoints, ELAPSED_TIME(start, end));
+}
 
+void ophAS::AngularSpectrum(double w, double h, double wavelength, double knumber, double xi_interval, double eta_interval, double depth, const coder::array<creal_T, 2U>& fringe, coder::array<creal_T, 2U>& b_AngularC)
+{
+	auto start = CUR_TIME;
 
-	i = static_cast<int>(w);
-	for (loop_ub = 0; loop_ub < i; loop_ub++) {
-		eta = (((static_cast<double>(loop_ub) + 1.0) - 1.0) - w / 2.0) *
-			eta_interval;
-		for (xi_id = 0; xi_id < i; xi_id++) {
-			y_im = knumber * ((((static_cast<double>(xi_id) + 1.0) - 1.0) - w / 2.0) *
-				xi_interval * 0.0 + eta * 0.0);
-			if (-y_im == 0.0) {
-				y_re = std::exp(y_im * 0.0);
-				y_im = 0.0;
-			}
-			else {
-				y_re = std::numeric_limits<double>::quiet_NaN();
-				y_im = std::numeric_limits<double>::quiet_NaN();
-			}
+	// dim 0 (eta) is contiguous, dim 1 (xi) is the row.
+	const int nx = fringe.size(0);
+	const int ny = fringe.size(1);
+	const int N = nx * ny;
 
-			fringe_temp1[loop_ub + fringe_temp1.size(0) * xi_id].re = fringe[loop_ub +
-				fringe.size(0) * xi_id].re * y_re - fringe[loop_ub + fringe.size(0) *
-				xi_id].im * y_im;
-			fringe_temp1[loop_ub + fringe_temp1.size(0) * xi_id].im = fringe[loop_ub +
-				fringe.size(0) * xi_id].re * y_im + fringe[loop_ub + fringe.size(0) *
-				xi_id].im * y_re;
-		}
-	}
-	
-	eml_fftshift(fringe_temp1, 1);
-	eml_fftshift(fringe_temp1, 2);
-	fft2_matlab(fringe_temp1, fringe_temp2);
-	eml_fftshift(fringe_temp2, 1);
-	eml_fftshift(fringe_temp2, 2);
+	b_AngularC.set_size(nx, ny);
+	Complex<Real>* field = reinterpret_cast<Complex<Real>*>(&b_AngularC[0]);
+	memcpy(field, &fringe[0], sizeof(creal_T) * N);
 
-	
-	
-	minfrequency_eta = 1.0 / (w * eta_interval);
-	minfrequency_xi = 1.0 / (w * xi_interval);
-		
+	ophFFT* fft = ophFFT::getInstance();
+	fft->fft2Shifted(nx, ny, field, OPH_FORWARD);
 
-	for (loop_ub = 0; loop_ub < i; loop_ub++) {
-	double a;
-	a = wavelength * (((static_cast<double>(loop_ub) + 1.0) - (w/2.0+1.0)) *
-	minfrequency_eta);
-	for (xi_id = 0; xi_id < i; xi_id++) {
-	y_im = wavelength * (((static_cast<double>(xi_id) + 1.0) - (w / 2.0 + 1.0)) *
-	minfrequency_xi);
-	y_im = (knumber*depth) * std::sqrt((1.0 - a * a) - y_im * y_im);
-	y_re = std::cos(y_im);
-	y_im = std::sin(y_im);
-	fringe_temp3[loop_ub + fringe_temp3.size(0) * xi_id].re =
-	fringe_temp2[loop_ub + fringe_temp2.size(0) * xi_id].re * y_re -
-	fringe_temp2[loop_ub + fringe_temp2.size(0) * xi_id].im * y_im;
-	fringe_temp3[loop_ub + fringe_temp3.size(0) * xi_id].im =
-	fringe_temp2[loop_ub + fringe_temp2.size(0) * xi_id].re * y_im +
-	fringe_temp2[loop_ub + fringe_temp2.size(0) * xi_id].im * y_re;
-	}
+	// angular spectrum transfer function, evanescent components are dropped.
+	const double lambda_eta = wavelength / (nx * eta_interval);
+	const double lambda_xi = wavelength / (ny * xi_interval);
+	const double kd = knumber * depth;
+	const double hnx = nx / 2.0;
+	const double hny = ny / 2.0;
+	int j;
+#pragma omp parallel for private(j)
+	for (j = 0; j < ny; j++)
+	{
+		double b = lambda_xi * (j - hny);
+		double b2 = 1.0 - b * b;
+		Complex<Real>* row = field + j * nx;
+		for (int i = 0; i < nx; i++)
+		{
+			double a = lambda_eta * (i - hnx);
+			double r = b2 - a * a;
+			if (r < 0.0) {
+				row[i][_RE] = 0.0;
+				row[i][_IM] = 0.0;
+				continue;
+			}
+			double phase = kd * sqrt(r);
+			double c = cos(phase);
+			double s = sin(phase);
+			double re = row[i][_RE];
+			double im = row[i][_IM];
+			row[i][_RE] = re * c - im * s;
+			row[i][_IM] = re * s + im * c;
+		}
 	}
 
-	//  angular spectrum transfor function
-	
+	// ifft2 of this class applies ifftshift before and after its normalized inverse transform,
+	// which is fft2Shifted for the power-of-two sizes ophAS works with, so the shifted form is kept.
+	fft->fft2Shifted(nx, ny, field, OPH_BACKWARD, true);
 
-	
-	ifft2(fringe_temp3, b_AngularC);
-	
-	
 	auto end = CUR_TIME;
 
 	auto during = ((std::chrono::duration<Real>)(end - start)).count();
 	LOG("%.5lfsec...done\n", during);
-	
-	
 }
 
 void ophAS::generateHologram()
 {
+	OPH_PROFILE("generate");
 	coder::array<creal_T, 2U> temp;
 	res = new unsigned char[w*h]{ 0 };
 	ASCalculation(w, h, wavelength, knumber, xi_interval, eta_interval, depth, temp, im);
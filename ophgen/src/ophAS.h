@@ -36,6 +36,12 @@ private:
 	OphPointCloudData pc_data;
 	int n_points;
 	bool is_CPU;
+
+	/**
+	* @brief Point field shared by both RayleighSommerfield overloads.
+	*/
+	void pointField(double w, double h, double knumber, double xi_interval, double eta_interval,
+		double depth, const OphPointCloudData &pc, const vec3 &scale, coder::array<creal_T, 2U> &fringe);
 public:
 	ophAS();
 	virtual ~ophAS();
@@ -49,6 +55,17 @@ public:
 	void RayleighSommerfield(double w, double h, double wavelength, double knumber, double
 		xi_interval, double eta_interval, double depth, coder::
 		array<creal_T, 2U> &fringe);
+	/**
+	* @brief Field of a whole point set on the sensor plane, summed in one parallel pass.
+	* @details Direct sum of every point on every pixel, parallel over the sensor rows,
+	* the inner loop runs over a contiguous row.
+	* Geometry is scaled by pc_config.scale, amplitude is the first color channel.
+	* @param[in] pc Point cloud data. (vertex x, y, z interleaved)
+	* @param[out] fringe Complex field, eta(column) is contiguous.
+	*/
+	void RayleighSommerfield(double w, double h, double wavelength, double knumber, double
+		xi_interval, double eta_interval, double depth, const OphPointCloudData &pc, coder::
+		array<creal_T, 2U> &fringe);
 	void AngularSpectrum(double w, double h, double wavelength, double knumber, double
 		xi_interval, double eta_interval, double depth, const coder::
 		array<creal_T, 2U> &fringe, coder::array<creal_T, 2U>
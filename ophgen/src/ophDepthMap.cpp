@@ -62,6 +62,10 @@ ophDepthMap::ophDepthMap()
 	: ophGen()
 	, m_nProgress(0)
 	, bSinglePrecision(false)
+	, incReady(false)
+	, incUpdated(0)
+	, incCacheLimit(0)
+	, incCacheBytes(0)
 {
 	is_CPU = true;
 
@@ -79,6 +83,8 @@ ophDepthMap::ophDepthMap()
 	alpha_map = nullptr;
 	depth_index = nullptr;
 	dmap = 0;
+	layerBuf = nullptr;
+	layerBufSize = 0;
 	dstep = 0;
 	dlevel.clear();
 	setViewingWindow(FALSE);
@@ -216,68 +222,41 @@ bool ophDepthMap::readConfig(const char * fname)
 */
 bool ophDepthMap::readImageDepth(const char* source_folder, const char* img_prefix, const char* depth_img_prefix)
 {
-	std::string sdir = source_folder;
-	sdir = sdir.append("\\").append(img_prefix).append("*.bmp");
-
-	_finddatai64_t fd;
-	intptr_t handle;
-	handle = _findfirst64(sdir.c_str(), &fd);
-	if (handle == -1)
+	std::vector<std::string> imgs = ImgSequence::scan(source_folder, img_prefix, "bmp");
+	if (imgs.empty())
 	{
-		LOG("Error: Source image does not exist: %s.\n", sdir.c_str());
+		LOG("Error: Source image does not exist: %s\\%s*.bmp.\n", source_folder, img_prefix);
 		return false;
 	}
-
-	std::string imgfullname;
-	imgfullname = std::string(source_folder).append("\\").append(fd.name);
-
-	int w, h, bytesperpixel;
-	bool ret = getImgSize(w, h, bytesperpixel, imgfullname.c_str());
-
-	oph::uchar* imgload = new uchar[w*h*bytesperpixel];
-	ret = loadAsImgUpSideDown(imgfullname.c_str(), imgload);
-	if (!ret) {
-		LOG("Failed::Image Load: %s\n", imgfullname.c_str());
+	std::vector<std::string> dimgs = ImgSequence::scan(source_folder, depth_img_prefix, "bmp");
+	if (dimgs.empty())
+	{
+		LOG("Error: Source depthmap does not exist: %s\\%s*.bmp.\n", source_folder, depth_img_prefix);
 		return false;
 	}
-	LOG("Succeed::Image Load: %s\n", imgfullname.c_str());
-
-	oph::uchar* img = new uchar[w*h];
-	convertToFormatGray8(imgload, img, w, h, bytesperpixel);
-
-	delete[] imgload;
 
-
-	//=================================================================================
-	std::string sddir = std::string(source_folder).append("\\").append(depth_img_prefix).append("*.bmp");
-	handle = _findfirst64(sddir.c_str(), &fd);
-	if (handle == -1)
-	{
-		LOG("Error: Source depthmap does not exist: %s.\n", sddir);
+	// image and depth map are decoded concurrently.
+	std::vector<std::string> files = { imgs[0], dimgs[0] };
+	std::vector<ImgFrame> frames;
+	ImgSequence::loadAll(files, frames, true, true, 2);
+	if (frames[0].pixels.empty()) {
+		LOG("Failed::Image Load: %s\n", files[0].c_str());
 		return false;
 	}
-
-	std::string dimgfullname = std::string(source_folder).append("\\").append(fd.name);
-
-	int dw, dh, dbytesperpixel;
-	ret = getImgSize(dw, dh, dbytesperpixel, dimgfullname.c_str());
-	
-	uchar* dimgload = new uchar[dw*dh*dbytesperpixel];
-	ret = loadAsImgUpSideDown(dimgfullname.c_str(), dimgload);
-	if (!ret) {
-		LOG("Failed::Depth Image Load: %s\n", dimgfullname.c_str());
+	LOG("Succeed::Image Load: %s\n", files[0].c_str());
+	if (frames[1].pixels.empty()) {
+		LOG("Failed::Depth Image Load: %s\n", files[1].c_str());
 		return false;
 	}
-	LOG("Succeed::Depth Image Load: %s\n", dimgfullname.c_str());
-
-	// 2019-10-14 mwnam
-	m_vecDepthImg[_X] = dw;
-	m_vecDepthImg[_Y] = dh;
+	LOG("Succeed::Depth Image Load: %s\n", files[1].c_str());
 
-	uchar* dimg = new uchar[dw*dh];
-	convertToFormatGray8(dimgload, dimg, dw, dh, dbytesperpixel);
+	return setImageDepth(frames[0], frames[1]);
+}
 
-	delete[] dimgload;
+bool ophDepthMap::setImageDepth(const ImgFrame& img, const ImgFrame& depth)
+{
+	int w = img.width, h = img.height;
+	int dw = depth.width, dh = depth.height;
 
 	//resize image
 	int pnX = context_.pixel_number[_X];
@@ -289,36 +268,67 @@ bool ophDepthMap::readImageDepth(const char* source_folder, const char* img_pref
 	memset(rgb_img, 0, sizeof(char)*pnX*pnY);
 
 	if (w != pnX || h != pnY)
-		imgScaleBilinear(img, rgb_img, w, h, pnX, pnY);
+		imgScaleBilinear(img.pixels.data(), rgb_img, w, h, pnX, pnY);
 	else
-		memcpy(rgb_img, img, sizeof(char)*pnX*pnY);
+		memcpy(rgb_img, img.pixels.data(), sizeof(char)*pnX*pnY);
 
 	// 2019-10-14 mwnam
 	m_vecRGBImg[_X] = pnX;
 	m_vecRGBImg[_Y] = pnY;
 
-	//ret = creatBitmapFile(newimg, pnX, pnY, 8, "stest");
 	if (depth_img) delete[] depth_img;
 
 	depth_img = new uchar[pnX*pnY];
 	memset(depth_img, 0, sizeof(char)*pnX*pnY);
 
 	if (dw != pnX || dh != pnY)
-		imgScaleBilinear(dimg, depth_img, dw, dh, pnX, pnY);
+		imgScaleBilinear(depth.pixels.data(), depth_img, dw, dh, pnX, pnY);
 	else
-		memcpy(depth_img, dimg, sizeof(char)*pnX*pnY);
+		memcpy(depth_img, depth.pixels.data(), sizeof(char)*pnX*pnY);
 	// 2019-10-14 mwnam
 	m_vecDepthImg[_X] = pnX;
 	m_vecDepthImg[_Y] = pnY;
 
-	delete[] img;
-	delete[] dimg;
-
 	return true;
 }
 
+int ophDepthMap::openImageDepthSequence(const char* source_folder, const char* img_prefix, const char* depth_img_prefix, int nPrefetch)
+{
+	closeImageDepthSequence();
+	std::vector<std::string> imgs = ImgSequence::scan(source_folder, img_prefix, "bmp");
+	std::vector<std::string> dimgs = ImgSequence::scan(source_folder, depth_img_prefix, "bmp");
+	if (imgs.empty() || imgs.size() != dimgs.size())
+	{
+		LOG("Error: %zu source images and %zu depthmaps in %s.\n", imgs.size(), dimgs.size(), source_folder);
+		return 0;
+	}
+	seqImg.open(imgs, true, true, 1, nPrefetch);
+	seqDepth.open(dimgs, true, true, 1, nPrefetch);
+	return (int)imgs.size();
+}
+
+bool ophDepthMap::readNextImageDepth(void)
+{
+	ImgFrame img, depth;
+	bool bImg = seqImg.next(img);
+	bool bDepth = seqDepth.next(depth);
+	if (!bImg || !bDepth) {
+		if (!img.path.empty() || !depth.path.empty())
+			LOG("Failed::Image Load: %s, %s\n", img.path.c_str(), depth.path.c_str());
+		return false;
+	}
+	return setImageDepth(img, depth);
+}
+
+void ophDepthMap::closeImageDepthSequence(void)
+{
+	seqImg.close();
+	seqDepth.close();
+}
+
 Real ophDepthMap::generateHologram(void)
 {
+	OPH_PROFILE("generate");
 	resetBuffer();
 
 	m_vecEncodeSize = context_.pixel_number;
@@ -377,7 +387,7 @@ void ophDepthMap::encoding(unsigned int ENCODE_FLAG, unsigned int SSB_PASSBAND)
 	const uint pnX = context_.pixel_number[_X];
 	const uint pnY = context_.pixel_number[_Y];
 	const uint nChannel = context_.waveNum;
-	Complex<Real>* dst = new Complex<Real>[pnX * pnY];
+	Complex<Real>* dst = getLayerBuffer();
 
 	for (uint ch = 0; ch < nChannel; ch++) {
 		fft2(context_.pixel_number, complex_H[ch], OPH_BACKWARD);
@@ -404,7 +414,6 @@ void ophDepthMap::encoding(unsigned int ENCODE_FLAG, unsigned int SSB_PASSBAND)
 		}
 		else ophGen::encoding(ENCODE_FLAG, SSB_PASSBAND, dst);
 	}
-	delete[] dst;
 	auto end = CUR_TIME;
 	LOG("Elapsed Time: %lf(s)\n", ELAPSED_TIME(begin, end));
 }
@@ -433,6 +442,7 @@ void ophDepthMap::initialize()
 */
 void ophDepthMap::getDepthValues()
 {
+	dlevel.clear();
 	if (dm_config_.num_of_depth > 1)
 	{
 		dstep = (dm_config_.far_depthmap - dm_config_.near_depthmap) / (dm_config_.num_of_depth - 1);
@@ -500,8 +510,6 @@ void ophDepthMap::initCPU()
 
 	if (dmap) delete[] dmap;
 	dmap = new Real[pnXY];
-
-	fftw_cleanup();
 }
 
 /**
@@ -630,6 +638,7 @@ void ophDepthMap::calcHoloCPU()
 	fft2(ivec2(pnX, pnY), in, OPH_FORWARD, OPH_ESTIMATE);
 
 	int sum = 0;
+	Complex<Real> *input = getLayerBuffer();
 
 	for (int ch = 0; ch < nChannel; ch++) {
 		Real lambda = context_.wave_length[ch];
@@ -639,36 +648,19 @@ void ophDepthMap::calcHoloCPU()
 
 			Real temp_depth = (is_ViewingWindow) ? dlevel_transform[dtr - 1] : dlevel[dtr - 1];
 
-			Complex<Real> *input = new Complex<Real>[pnXY];
-			memset(input, 0.0, sizeof(Complex<Real>) * pnXY);
+			Complex<Real> rand_phase_val;
+			getRandPhaseValue(rand_phase_val, dm_config_.RANDOM_PHASE);
 
-			Real locsum = 0.0;
-			for (int i = 0; i < pnXY; i++)
-			{
-				if (depth_index[i] == dtr) {
-					input[i][_RE] = img_src[i] * alpha_map[i];
-					locsum += input[i][_RE];
-				}
-			}
+			Complex<Real> carrier_phase_delay(0, k * temp_depth);
+			carrier_phase_delay.exp();
 
-			if (locsum > 0.0)
+			if (prepareLayerCPU(dtr, img_src, alpha_map, depth_index, rand_phase_val, carrier_phase_delay, input))
 			{
-				Complex<Real> rand_phase_val;
-				getRandPhaseValue(rand_phase_val, dm_config_.RANDOM_PHASE);
-
-				Complex<Real> carrier_phase_delay(0, k * temp_depth);
-				carrier_phase_delay.exp();
-
-				for (int i = 0; i < pnXY; i++) {
-					input[i] = input[i] * rand_phase_val * carrier_phase_delay;
-				}
-				fftwShift(input, input, pnX, pnY, OPH_FORWARD, false);
 				propagationAngularSpectrum(ch, input, -temp_depth, k, lambda);
 			}
 			else {
 				//LOG("Depth: %d of %d : Nothing here\n", dtr, dm_config_.num_of_depth);
 			}
-			delete[] input;
 			m_nProgress = (int)((Real)(ch * depth_sz + p) * 100 / (depth_sz * nChannel));
 
 		}
@@ -680,9 +672,238 @@ void ophDepthMap::calcHoloCPU()
 
 }
 
+Complex<Real>* ophDepthMap::getLayerBuffer(void)
+{
+	const uint pnXY = context_.pixel_number[_X] * context_.pixel_number[_Y];
+	// reallocated only when the resolution changes.
+	if (layerBufSize != pnXY) {
+		if (layerBuf) delete[] layerBuf;
+		layerBuf = new Complex<Real>[pnXY];
+		layerBufSize = pnXY;
+	}
+	return layerBuf;
+}
+
+bool ophDepthMap::prepareLayerCPU(int dtr, const Real* img, const int* alpha, const Real* index,
+	const Complex<Real>& rand_phase_val, const Complex<Real>& carrier_phase_delay, Complex<Real>* input)
+{
+	const uint pnX = context_.pixel_number[_X];
+	const uint pnY = context_.pixel_number[_Y];
+	const uint pnXY = pnX * pnY;
+
+	memset(input, 0.0, sizeof(Complex<Real>) * pnXY);
+
+	Real locsum = 0.0;
+	for (int i = 0; i < pnXY; i++)
+	{
+		if (index[i] == dtr) {
+			input[i][_RE] = img[i] * alpha[i];
+			locsum += input[i][_RE];
+		}
+	}
+	if (locsum <= 0.0) return false;
+
+	Complex<Real> rand_phase = rand_phase_val;
+	Complex<Real> carrier = carrier_phase_delay;
+	for (int i = 0; i < pnXY; i++) {
+		input[i] = input[i] * rand_phase * carrier;
+	}
+	fftwShift(input, input, pnX, pnY, OPH_FORWARD, false);
+	return true;
+}
+
+void ophDepthMap::hashLayersCPU(std::vector<uint64_t>& hash)
+{
+	const uint pnXY = context_.pixel_number[_X] * context_.pixel_number[_Y];
+	const size_t depth_sz = dm_config_.render_depth.size();
+
+	// depth index -> rendered layer
+	int maxDepth = 0;
+	for (int dtr : dm_config_.render_depth)
+		if (dtr > maxDepth) maxDepth = dtr;
+	std::vector<int> layer(maxDepth + 1, -1);
+	for (size_t p = 0; p < depth_sz; p++)
+		if (dm_config_.render_depth[p] >= 0) layer[dm_config_.render_depth[p]] = (int)p;
+
+	// FNV-1a over (pixel, intensity) of the non-zero pixels of each layer.
+	const uint64_t prime = 0x100000001b3ULL;
+	hash.assign(depth_sz, 0xcbf29ce484222325ULL);
+	for (uint i = 0; i < pnXY; i++) {
+		const Real value = img_src[i] * alpha_map[i];
+		if (value == 0.0) continue;
+		const int dtr = (int)depth_index[i];
+		if (dtr != depth_index[i] || dtr < 0 || dtr > maxDepth || layer[dtr] < 0) continue;
+
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint64_t& h = hash[layer[dtr]];
+		h = (h ^ i) * prime;
+		h = (h ^ bits) * prime;
+	}
+}
+
+Real ophDepthMap::generateIncremental(void)
+{
+	OPH_PROFILE("generate");
+	if (!is_CPU) {
+		LOG("Incremental generation is supported on CPU only, generate all layers.\n");
+		return generateHologram();
+	}
+
+	auto begin = CUR_TIME;
+
+	const uint pnX = context_.pixel_number[_X];
+	const uint pnY = context_.pixel_number[_Y];
+	const uint pnXY = pnX * pnY;
+	const int nChannel = context_.waveNum;
+	const size_t depth_sz = dm_config_.render_depth.size();
+	const size_t nSlot = depth_sz * nChannel;
+
+	m_vecEncodeSize = context_.pixel_number;
+	prepareInputdataCPU(rgb_img, depth_img);
+	getDepthValues();
+	if (is_ViewingWindow)
+		transVW();
+
+	std::vector<uint64_t> hash;
+	hashLayersCPU(hash);
+
+	// the contributions of the previous frame are only valid for the same propagation.
+	std::vector<Real> depth(depth_sz);
+	for (size_t p = 0; p < depth_sz; ++p) {
+		const int dtr = dm_config_.render_depth[p];
+		depth[p] = (is_ViewingWindow) ? dlevel_transform[dtr - 1] : dlevel[dtr - 1];
+	}
+	std::vector<Real> wave(context_.wave_length, context_.wave_length + nChannel);
+	const vec2 pitch = context_.pixel_pitch;
+
+	// full generation when there is no valid previous frame.
+	const bool bFull = !incReady || incHash.size() != depth_sz || incCache.size() != nSlot || incImg.size() != pnXY ||
+		incDepth != depth || incWave != wave || incPitch[_X] != pitch[_X] || incPitch[_Y] != pitch[_Y];
+	if (bFull) {
+		resetIncremental();
+		resetBuffer();
+		incPhase.resize(nSlot);
+		incCache.assign(nSlot, nullptr);
+		for (size_t s = 0; s < nSlot; s++)
+			getRandPhaseValue(incPhase[s], dm_config_.RANDOM_PHASE);
+	}
+
+	Complex<Real> *in = nullptr;
+	fft2(ivec2(pnX, pnY), in, OPH_FORWARD, OPH_ESTIMATE);
+	Complex<Real> *input = getLayerBuffer();
+	const size_t layerBytes = sizeof(Complex<Real>) * pnXY;
+
+	incUpdated = 0;
+	for (size_t p = 0; p < depth_sz; ++p) {
+		if (!bFull && hash[p] == incHash[p]) continue;
+		int dtr = dm_config_.render_depth[p];
+		incUpdated++;
+
+		for (int ch = 0; ch < nChannel; ch++) {
+			Real lambda = context_.wave_length[ch];
+			Real k = context_.k = (2 * M_PI / lambda);
+			Real temp_depth = depth[p];
+			Complex<Real> carrier_phase_delay(0, k * temp_depth);
+			carrier_phase_delay.exp();
+
+			const size_t s = ch * depth_sz + p;
+			Complex<Real>* cache = incCache[s];
+			Complex<Real>* H = complex_H[ch];
+			int i;
+
+			// remove the contribution of the previous frame.
+			if (!bFull) {
+				if (cache) {
+#ifdef _OPENMP
+#pragma omp parallel for private(i)
+#endif
+					for (i = 0; i < pnXY; i++) {
+						H[i][_RE] -= cache[i][_RE];
+						H[i][_IM] -= cache[i][_IM];
+					}
+				}
+				else {
+					// a negated phase gives exactly the negated field.
+					Complex<Real> neg_phase(-incPhase[s][_RE], -incPhase[s][_IM]);
+					if (prepareLayerCPU(dtr, incImg.data(), incAlpha.data(), incIndex.data(), neg_phase, carrier_phase_delay, input))
+						propagationAngularSpectrum(ch, input, -temp_depth, k, lambda);
+				}
+			}
+
+			// add the contribution of the current frame.
+			if (prepareLayerCPU(dtr, img_src, alpha_map, depth_index, incPhase[s], carrier_phase_delay, input)) {
+				if (!cache && incCacheBytes + layerBytes <= incCacheLimit) {
+					cache = incCache[s] = new Complex<Real>[pnXY];
+					incCacheBytes += layerBytes;
+				}
+				if (cache) {
+					memset(cache, 0, layerBytes);
+					propagationAngularSpectrum(ch, input, -temp_depth, k, lambda, cache);
+#ifdef _OPENMP
+#pragma omp parallel for private(i)
+#endif
+					for (i = 0; i < pnXY; i++) {
+						H[i][_RE] += cache[i][_RE];
+						H[i][_IM] += cache[i][_IM];
+					}
+				}
+				else {
+					propagationAngularSpectrum(ch, input, -temp_depth, k, lambda);
+				}
+			}
+			else if (cache) {
+				// the layer became empty.
+				delete[] cache;
+				incCache[s] = nullptr;
+				incCacheBytes -= layerBytes;
+			}
+		}
+		m_nProgress = (int)((Real)(p + 1) * 100 / depth_sz);
+	}
+
+	incHash.swap(hash);
+	incImg.assign(img_src, img_src + pnXY);
+	incAlpha.assign(alpha_map, alpha_map + pnXY);
+	incIndex.assign(depth_index, depth_index + pnXY);
+	incDepth.swap(depth);
+	incWave.swap(wave);
+	incPitch = pitch;
+	incReady = true;
+
+	m_nProgress = 0;
+	m_elapsedTime = ELAPSED_TIME(begin, CUR_TIME);
+	LOG("%s : %d/%d layers updated, %lf(s)\n", __FUNCTION__, incUpdated, (int)depth_sz, m_elapsedTime);
+	return m_elapsedTime;
+}
+
+void ophDepthMap::resetIncremental(void)
+{
+	for (Complex<Real>* cache : incCache) {
+		if (cache) delete[] cache;
+	}
+	incCache.clear();
+	incCacheBytes = 0;
+	incHash.clear();
+	incPhase.clear();
+	incImg.clear();
+	incAlpha.clear();
+	incIndex.clear();
+	incDepth.clear();
+	incWave.clear();
+	incReady = false;
+}
+
 void ophDepthMap::ophFree(void)
 {
 	ophGen::ophFree();
+	resetIncremental();
+	if (layerBuf) {
+		delete[] layerBuf;
+		layerBuf = nullptr;
+		layerBufSize = 0;
+	}
+	closeImageDepthSequence();
 	if (depth_img) {
 		delete[] depth_img;
 		depth_img = nullptr;
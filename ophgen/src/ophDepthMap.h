@@ -49,6 +49,7 @@
 #include "ophGen.h"
 #include <cufft.h>
 #include "include.h"
+#include "ImgSequence.h"
 
 //Build Option : Multi Core Processing (OpenMP)
 #ifdef _OPENMP
@@ -137,6 +138,20 @@ public:
 	bool readConfig(const char* fname);
 	bool readImageDepth(const char* source_folder, const char* img_prefix, const char* depth_img_prefix);
 	//bool readImageDepth(const char* rgb, const char* depth);
+
+	/**
+	* @brief Open a sequence of image / depth map pairs (video input), the files are sorted by name.
+	* @details Frames are decoded by reader threads ahead of readNextImageDepth.
+	* @param[in] nPrefetch number of frames decoded ahead.
+	* @return number of frames, 0 if there is no image or the numbers of images and depth maps differ.
+	*/
+	int openImageDepthSequence(const char* source_folder, const char* img_prefix, const char* depth_img_prefix, int nPrefetch = 4);
+	/**
+	* @brief Load the next image / depth map pair of the sequence opened by openImageDepthSequence.
+	* @return false at the end of the sequence.
+	*/
+	bool readNextImageDepth(void);
+	void closeImageDepthSequence(void);
 	
 	/**
 	* @brief Generate a hologram, main funtion. When the calculation is finished, the angular spectrum is performed.
@@ -168,6 +183,31 @@ public:
 	void setResolution(ivec2 resolution);
 	uint* getProgress() { return &m_nProgress; }
 
+	/**
+	* @brief Generate the hologram of the current image / depth map incrementally from the previous frame.
+	* @details The masked intensity of each depth layer is hashed, and only the layers whose pixel set changed
+	*			are re-propagated : the old contribution is subtracted from complex_H and the new one is added.@n
+	*			Old contributions come from the layer cache, or are recomputed from the previous frame when
+	*			the layer is not cached. The first call, a call after resetIncremental, or a call after a change
+	*			of the resolution, the layer depths (near / far depth, field length, number of depth),
+	*			the wavelengths or the pixel pitch generates all layers. CPU only.
+	* @return implement time (sec)
+	*/
+	Real generateIncremental(void);
+	/**
+	* @brief Drop the state of the incremental mode, the next generateIncremental() generates all layers.
+	*/
+	void resetIncremental(void);
+	/**
+	* @brief Memory cap of the propagated layer cache of the incremental mode.
+	* @param bytes maximum size of the cached layers, 0 : layers are always recomputed.
+	*/
+	void setLayerCacheLimit(size_t bytes) { incCacheLimit = bytes; }
+	/**
+	* @brief Number of depth layers re-propagated by the last generateIncremental().
+	*/
+	int getUpdatedLayerCount() { return incUpdated; }
+
 public:
 	inline void setFieldLens(Real fieldlens) { dm_config_.fieldLength = fieldlens; }
 	inline void setNearDepth(Real neardepth) { dm_config_.near_depthmap = neardepth; }
@@ -198,6 +238,21 @@ private:
 	void transVW();
 
 	void calcHoloCPU(void);
+
+	/**
+	* @brief Fill the input field of one depth layer and transform it to the spectrum.
+	* @return false if the layer is empty.
+	*/
+	bool prepareLayerCPU(int dtr, const Real* img, const int* alpha, const Real* index,
+		const Complex<Real>& rand_phase_val, const Complex<Real>& carrier_phase_delay, Complex<Real>* input);
+	/**
+	* @brief Work buffer of pixel_number[_X] * pixel_number[_Y], kept across layers and frames.
+	*/
+	Complex<Real>* getLayerBuffer(void);
+	/**
+	* @brief Hash of the masked intensity of each rendered depth layer.
+	*/
+	void hashLayersCPU(std::vector<uint64_t>& hash);
 	void calcHoloGPU(void);
 	void propagationAngularSpectrumGPU(uint channel, cufftDoubleComplex* input_u, Real propagation_dist);
 
@@ -207,6 +262,11 @@ protected:
 	void ophFree(void);
 
 private:
+	/**
+	* @brief Resize decoded image & depth map to the hologram resolution.
+	*/
+	bool setImageDepth(const ImgFrame& img, const ImgFrame& depth);
+
 	bool					is_CPU;								///< if true, it is implemented on the CPU, otherwise on the GPU.
 	bool					is_ViewingWindow;
 	bool					bSinglePrecision;
@@ -224,6 +284,8 @@ private:
 	int*					alpha_map;							///< CPU variable - calculated alpha map data, values are 0 or 1.
 
 	Real*					dmap;								///< CPU variable - physical distances of depth map.
+	Complex<Real>*			layerBuf;							///< CPU variable - field of one layer, see getLayerBuffer().
+	uint					layerBufSize;
 
 	Real					dstep;								///< the physical increment of each depth map layer.
 	vector<Real>			dlevel;								///< the physical value of all depth map layer.
@@ -233,6 +295,25 @@ private:
 
 
 	uint m_nProgress;
+
+	ImgSequence				seqImg;								///< prefetched image sequence of the video input.
+	ImgSequence				seqDepth;							///< prefetched depth map sequence of the video input.
+
+	/// state of the incremental mode, layer slots are indexed by ch * render_depth.size() + p.
+	bool					incReady;
+	int						incUpdated;
+	size_t					incCacheLimit;
+	size_t					incCacheBytes;
+	std::vector<uint64_t>	incHash;
+	std::vector<Complex<Real>>	incPhase;
+	std::vector<Complex<Real>*>	incCache;
+	std::vector<Real>		incImg;
+	std::vector<int>		incAlpha;
+	std::vector<Real>		incIndex;
+	/// propagation distance of each layer, wavelengths and pixel pitch the incremental state was built with.
+	std::vector<Real>		incDepth;
+	std::vector<Real>		incWave;
+	vec2					incPitch;
 };
 
 #endif //>__ophDepthMap_h
\ No newline at end of file
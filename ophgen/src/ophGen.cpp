@@ -52,6 +52,11 @@
 #include <omp.h>
 #include "tinyxml2.h"
 #include "PLYparser.h"
+#include "ophFFT.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 //#include "OpenCL.h"
 //#include "CUDA.h"
 
@@ -113,6 +118,10 @@ ophGen::ophGen(void)
 	: Openholo()
 	, m_lpEncoded(nullptr)
 	, m_lpNormalized(nullptr)
+	, m_lpNormalized16(nullptr)
+	, m_pSequence(nullptr)
+	, m_bPointCache(false)
+	, m_ePointCacheSort(PointCloudCache::SORT_NONE)
 	, m_nOldChannel(0)
 	, m_elapsedTime(0.0)
 	, m_dFieldLength(0.0)
@@ -187,6 +196,16 @@ void ophGen::initialize(void)
 		memset(m_lpNormalized[i], 0, sizeof(uchar) * pnXY);
 	}
 
+	// 10/12-bit buffer is allocated on demand by encodeQuantized.
+	if (m_lpNormalized16 != nullptr) {
+		for (uint i = 0; i < m_nOldChannel; i++)
+			delete[] m_lpNormalized16[i];
+		delete[] m_lpNormalized16;
+		m_lpNormalized16 = nullptr;
+	}
+
+	OPH_PROFILE_COUNT(PROF_ALLOC_BYTES, (ulonglong)nChannel * pnXY * (sizeof(Complex<Real>) + sizeof(Real) + sizeof(uchar)));
+
 	m_nOldChannel = nChannel;
 	m_vecEncodeSize[_X] = pnX;
 	m_vecEncodeSize[_Y] = pnY;
@@ -194,13 +213,33 @@ void ophGen::initialize(void)
 
 int ophGen::loadPointCloud(const char* pc_file, OphPointCloudData *pc_data_)
 {
+	OPH_PROFILE("load");
 	LOG("[%s] %s\n", __FUNCTION__, pc_file);
 	auto begin = CUR_TIME;
 
+	std::string plyPath = pc_file;
+	if ((plyPath.find(".ply") == std::string::npos) && (plyPath.find(".PLY") == std::string::npos)) plyPath += ".ply";
+	const std::string cachePath = plyPath + ".ophpc";
+
+	if (m_bPointCache) {
+		PointCloudCache cache;
+		if (cache.open(cachePath.c_str(), plyPath.c_str()) && cache.getSort() == m_ePointCacheSort &&
+			cache.toArrays(pc_data_->n_points, pc_data_->n_colors, &pc_data_->vertex, &pc_data_->color, &pc_data_->phase)) {
+			pc_data_->isPhaseParse = pc_data_->phase != nullptr;
+			LOG("%.5lfsec...done (cache)\n", ELAPSED_TIME(begin, CUR_TIME));
+			return pc_data_->n_points;
+		}
+	}
+
 	PLYparser plyIO;
 	if (!plyIO.loadPLY(pc_file, pc_data_->n_points, pc_data_->n_colors, &pc_data_->vertex, &pc_data_->color, &pc_data_->phase, pc_data_->isPhaseParse))
 		return -1;
 
+	if (m_bPointCache) {
+		PointCloudCache::save(cachePath.c_str(), pc_data_->n_points, pc_data_->n_colors, pc_data_->vertex, pc_data_->color,
+			pc_data_->isPhaseParse ? pc_data_->phase : nullptr, m_ePointCacheSort, 256, 16, 16, plyPath.c_str());
+	}
+
 	auto end = CUR_TIME;
 	LOG("%.5lfsec...done\n", ELAPSED_TIME(begin, end));
 	return pc_data_->n_points;
@@ -299,6 +338,7 @@ bool ophGen::readConfig(const char* fname)
 
 void ophGen::RS_Propagation(uchar *src, Complex<Real> *dst, Real lambda, Real distance)
 {
+	OPH_PROFILE("propagate");
 	OphConfig *pConfig = &context_;
 	const int pnX = pConfig->pixel_number[_X];
 	const int pnY = pConfig->pixel_number[_Y];
@@ -621,6 +661,7 @@ void ophGen::Fresnel_Convolution(vec3 src, Complex<Real> *dst, Real lambda, Real
 
 void ophGen::Fresnel_FFT(Complex<Real> *src, Complex<Real> *dst, Real lambda, Real waveRatio, Real distance)
 {
+	OPH_PROFILE("propagate");
 	auto begin = CUR_TIME;
 
 	OphConfig *pConfig = &context_;
@@ -718,6 +759,7 @@ void ophGen::Fresnel_FFT(Complex<Real> *src, Complex<Real> *dst, Real lambda, Re
 
 void ophGen::AngularSpectrum(Complex<Real> *src, Complex<Real> *dst, Real lambda, Real distance)
 {
+	OPH_PROFILE("propagate");
 	OphConfig *pConfig = &context_;
 	const int pnX = pConfig->pixel_number[_X];
 	const int pnY = pConfig->pixel_number[_Y];
@@ -762,8 +804,9 @@ void ophGen::AngularSpectrum(Complex<Real> *src, Complex<Real> *dst, Real lambda
 }
 
 
-void ophGen::propagationAngularSpectrum(int ch, Complex<Real>* input_u, Real propagation_dist, Real k, Real lambda)
+void ophGen::propagationAngularSpectrum(int ch, Complex<Real>* input_u, Real propagation_dist, Real k, Real lambda, Complex<Real>* output)
 {
+	Complex<Real>* dst = output ? output : complex_H[ch];
 	const int pnX = context_.pixel_number[_X];
 	const int pnY = context_.pixel_number[_Y];
 	const Real ppX = context_.pixel_pitch[_X];
@@ -850,11 +893,11 @@ void ophGen::propagationAngularSpectrum(int ch, Complex<Real>* input_u, Real pro
 #ifdef _OPENMP
 #pragma omp atomic
 #endif
-				complex_H[ch][i][_RE] += u_frequency[_RE];
+				dst[i][_RE] += u_frequency[_RE];
 #ifdef _OPENMP
 #pragma omp atomic
 #endif
-				complex_H[ch][i][_IM] += u_frequency[_IM];
+				dst[i][_IM] += u_frequency[_IM];
 			}
 		}
 #ifdef _OPENMP
@@ -898,6 +941,7 @@ bool ophGen::separateColor(int idx, int width, int height, uchar *src, uchar *ds
 
 void ophGen::normalize(void)
 {
+	OPH_PROFILE("normalize");
 	const uint pnX = context_.pixel_number[_X];
 	const uint pnY = context_.pixel_number[_Y];
 	for (uint ch = 0; ch < context_.waveNum; ch++)
@@ -909,7 +953,6 @@ bool ophGen::save(const char * fname, uint8_t bitsperpixel, uchar* src, uint px,
 	if (fname == nullptr) return false;
 
 	uchar* source = src;
-	bool bAlloc = false;
 	const uint nChannel = context_.waveNum;
 
 	ivec2 p(px, py);
@@ -948,14 +991,7 @@ bool ophGen::save(const char * fname, uint8_t bitsperpixel, uchar* src, uint px,
 		}
 		else if (nChannel == 3) {
 			if (context_.bMergeImg) {
-				uint nSize = (((p[_X] * bitsperpixel / 8) + 3) & ~3) * p[_Y];
-				source = new uchar[nSize];
-				bAlloc = true;
-				for (int i = 0; i < nChannel; i++) {
-					mergeColor(i, p[_X], p[_Y], m_lpNormalized[i], source);
-				}
-				saveAsImg(path, bitsperpixel, source, p[_X], p[_Y]);
-				if (bAlloc) delete[] source;
+				saveAsImg(path, bitsperpixel, m_lpNormalized, nChannel, p[_X], p[_Y]);
 			}
 			else {
 				for (int i = 0; i < nChannel; i++) {
@@ -1052,13 +1088,298 @@ void ophGen::resetBuffer()
 
 void ophGen::encoding(unsigned int ENCODE_FLAG, Complex<Real>* holo)
 {
+	OPH_PROFILE("encode");
 	LOG("\n[Encoding] ");
 	auto begin = CUR_TIME;
+
+	if (!encodeChannels(ENCODE_FLAG, nullptr)) return;
+
+	//encodeSymmetrization((holo), m_lpEncoded[ch], ivec2(0, 1));
+	auto end = CUR_TIME;
+	LOG("[Done] %lf(s)\n", ELAPSED_TIME(begin, end));
+}
+
+bool ophGen::encodeQuantized(unsigned int ENCODE_FLAG, int bitDepth)
+{
+	if (bitDepth != 8 && bitDepth != 10 && bitDepth != 12) {
+		LOG("<FAILED> Wrong bit depth (%d).\n", bitDepth);
+		return false;
+	}
+	LOG("\n[Encoding %d-bit] ", bitDepth);
+	auto begin = CUR_TIME;
 	const uint pnX = context_.pixel_number[_X];
 	const uint pnY = context_.pixel_number[_Y];
 	const uint nChannel = context_.waveNum;
 	const uint pnXY = pnX * pnY;
-	void (ophGen::*encodeFunc) (Complex<Real>*, Real*, const int) = nullptr;
+
+	Real* range = new Real[nChannel * 2];
+	if (!encodeChannels(ENCODE_FLAG, range)) {
+		delete[] range;
+		return false;
+	}
+
+	if (bitDepth == 8) {
+		for (uint ch = 0; ch < nChannel; ch++)
+			quantize<Real, uchar>(m_lpEncoded[ch], m_lpNormalized[ch], pnX, pnY, range[ch * 2], range[ch * 2 + 1], 255.0);
+	}
+	else {
+		if (m_lpNormalized16 == nullptr) {
+			m_lpNormalized16 = new ushort*[nChannel];
+			for (uint ch = 0; ch < nChannel; ch++)
+				m_lpNormalized16[ch] = new ushort[pnXY];
+		}
+		const Real maxLevel = (Real)((1 << bitDepth) - 1);
+		for (uint ch = 0; ch < nChannel; ch++)
+			quantize<Real, ushort>(m_lpEncoded[ch], m_lpNormalized16[ch], pnX, pnY, range[ch * 2], range[ch * 2 + 1], maxLevel);
+	}
+	delete[] range;
+
+	auto end = CUR_TIME;
+	LOG("[Done] %lf(s)\n", ELAPSED_TIME(begin, end));
+	return true;
+}
+
+struct ophGen::SequenceContext {
+	struct Frame {
+		int index;
+		bool bSuccess;
+		SequenceFrame src;
+		uchar* image;
+	};
+
+	unsigned int encodeFlag;
+	int queueDepth;
+	std::thread loader, generator, saver;
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::deque<Frame> submitted, loaded, encoded, done;
+	std::vector<uchar*> pool;
+	bool bRunning;
+	bool bEnd;
+	bool bLoaderDone, bGeneratorDone;
+	int nInFlight;
+	int nSubmitted;
+	int nCollected;
+	std::chrono::system_clock::time_point begin;
+	Real elapsed;
+};
+
+bool ophGen::beginSequence(unsigned int ENCODE_FLAG, int queueDepth)
+{
+	if (m_pSequence && m_pSequence->bRunning) {
+		LOG("<FAILED> A sequence is already running.\n");
+		return false;
+	}
+	if (ENCODE_FLAG > ENCODE_TWOPHASE || complex_H == nullptr || m_lpEncoded == nullptr) {
+		LOG("<FAILED> beginSequence : wrong encode flag or buffers are not initialized.\n");
+		return false;
+	}
+
+	if (!m_pSequence) m_pSequence = new SequenceContext;
+	SequenceContext& seq = *m_pSequence;
+	seq.encodeFlag = ENCODE_FLAG;
+	seq.queueDepth = queueDepth < 1 ? 1 : queueDepth;
+	seq.submitted.clear();
+	seq.loaded.clear();
+	seq.encoded.clear();
+	seq.done.clear();
+	seq.bRunning = true;
+	seq.bEnd = false;
+	seq.bLoaderDone = false;
+	seq.bGeneratorDone = false;
+	seq.nInFlight = 0;
+	seq.nSubmitted = 0;
+	seq.nCollected = 0;
+	seq.elapsed = 0.0;
+	seq.begin = CUR_TIME;
+
+	seq.loader = std::thread(&ophGen::sequenceLoader, this);
+	seq.generator = std::thread(&ophGen::sequenceGenerator, this);
+	seq.saver = std::thread(&ophGen::sequenceSaver, this);
+	LOG("[Sequence] started (queue depth %d)\n", seq.queueDepth);
+	return true;
+}
+
+int ophGen::submitFrame(const SequenceFrame& frame)
+{
+	if (!m_pSequence || !m_pSequence->bRunning) return -1;
+	SequenceContext& seq = *m_pSequence;
+
+	std::unique_lock<std::mutex> lock(seq.mtx);
+	seq.cv.wait(lock, [&seq] { return seq.nInFlight < seq.queueDepth; });
+
+	SequenceContext::Frame f;
+	f.index = seq.nSubmitted++;
+	f.bSuccess = false;
+	f.src = frame;
+	f.image = nullptr;
+	if (!seq.pool.empty()) {
+		f.image = seq.pool.back();
+		seq.pool.pop_back();
+	}
+	seq.nInFlight++;
+	seq.submitted.push_back(std::move(f));
+	seq.cv.notify_all();
+	return seq.submitted.back().index;
+}
+
+bool ophGen::collectFrame(int& index, uchar* dst)
+{
+	index = -1;
+	if (!m_pSequence) return false;
+	SequenceContext& seq = *m_pSequence;
+
+	std::unique_lock<std::mutex> lock(seq.mtx);
+	seq.cv.wait(lock, [&seq] { return !seq.done.empty() || seq.nInFlight == 0; });
+	if (seq.done.empty()) return false;
+
+	SequenceContext::Frame f = std::move(seq.done.front());
+	seq.done.pop_front();
+	lock.unlock();
+
+	const uint frameSize = context_.waveNum * context_.pixel_number[_X] * context_.pixel_number[_Y];
+	if (dst && f.bSuccess) memcpy(dst, f.image, sizeof(uchar) * frameSize);
+
+	lock.lock();
+	if (f.image) seq.pool.push_back(f.image);
+	seq.nInFlight--;
+	seq.nCollected++;
+	seq.elapsed = ELAPSED_TIME(seq.begin, CUR_TIME);
+	seq.cv.notify_all();
+
+	index = f.index;
+	return f.bSuccess;
+}
+
+void ophGen::endSequence(void)
+{
+	if (!m_pSequence || !m_pSequence->bRunning) return;
+	SequenceContext& seq = *m_pSequence;
+	{
+		std::lock_guard<std::mutex> lock(seq.mtx);
+		seq.bEnd = true;
+		seq.cv.notify_all();
+	}
+	seq.loader.join();
+	seq.generator.join();
+	seq.saver.join();
+
+	for (auto& f : seq.done) {
+		if (f.image) seq.pool.push_back(f.image);
+	}
+	seq.done.clear();
+	for (uchar* image : seq.pool) delete[] image;
+	seq.pool.clear();
+	seq.bRunning = false;
+
+	LOG("[Sequence] %d frames collected, %lf(s), %.2lf fps\n", seq.nCollected, seq.elapsed, getSequenceFPS());
+}
+
+Real ophGen::getSequenceFPS(void)
+{
+	if (!m_pSequence || m_pSequence->elapsed <= 0.0) return 0.0;
+	return m_pSequence->nCollected / m_pSequence->elapsed;
+}
+
+void ophGen::sequenceLoader(void)
+{
+	SequenceContext& seq = *m_pSequence;
+	std::unique_lock<std::mutex> lock(seq.mtx);
+	while (true) {
+		seq.cv.wait(lock, [&seq] { return !seq.submitted.empty() || seq.bEnd; });
+		if (seq.submitted.empty()) break;
+
+		SequenceContext::Frame f = std::move(seq.submitted.front());
+		seq.submitted.pop_front();
+		lock.unlock();
+		f.bSuccess = f.src.load ? f.src.load() : true;
+		lock.lock();
+		seq.loaded.push_back(std::move(f));
+		seq.cv.notify_all();
+	}
+	seq.bLoaderDone = true;
+	seq.cv.notify_all();
+}
+
+void ophGen::sequenceGenerator(void)
+{
+	SequenceContext& seq = *m_pSequence;
+	const uint pnX = context_.pixel_number[_X];
+	const uint pnY = context_.pixel_number[_Y];
+	const uint pnXY = pnX * pnY;
+	const uint nChannel = context_.waveNum;
+	Real* range = new Real[nChannel * 2];
+
+	std::unique_lock<std::mutex> lock(seq.mtx);
+	while (true) {
+		seq.cv.wait(lock, [&seq] { return !seq.loaded.empty() || seq.bLoaderDone; });
+		if (seq.loaded.empty()) break;
+
+		SequenceContext::Frame f = std::move(seq.loaded.front());
+		seq.loaded.pop_front();
+		lock.unlock();
+
+		if (f.bSuccess) {
+			f.bSuccess = f.src.generate ? f.src.generate(this) : true;
+			if (f.bSuccess) f.bSuccess = encodeChannels(seq.encodeFlag, range);
+			if (f.bSuccess) {
+				if (!f.image) f.image = new uchar[nChannel * pnXY];
+				for (uint ch = 0; ch < nChannel; ch++)
+					quantize<Real, uchar>(m_lpEncoded[ch], f.image + ch * pnXY, pnX, pnY, range[ch * 2], range[ch * 2 + 1], 255.0);
+			}
+		}
+
+		lock.lock();
+		seq.encoded.push_back(std::move(f));
+		seq.cv.notify_all();
+	}
+	seq.bGeneratorDone = true;
+	seq.cv.notify_all();
+	lock.unlock();
+	delete[] range;
+}
+
+void ophGen::sequenceSaver(void)
+{
+	SequenceContext& seq = *m_pSequence;
+	const uint pnX = context_.pixel_number[_X];
+	const uint pnY = context_.pixel_number[_Y];
+	const uint pnXY = pnX * pnY;
+	const uint nChannel = context_.waveNum;
+
+	std::unique_lock<std::mutex> lock(seq.mtx);
+	while (true) {
+		seq.cv.wait(lock, [&seq] { return !seq.encoded.empty() || seq.bGeneratorDone; });
+		if (seq.encoded.empty()) break;
+
+		SequenceContext::Frame f = std::move(seq.encoded.front());
+		seq.encoded.pop_front();
+		lock.unlock();
+
+		if (f.bSuccess && !f.src.savePath.empty()) {
+			if (nChannel == 1) {
+				f.bSuccess = saveAsImg(f.src.savePath.c_str(), 8, f.image, pnX, pnY);
+			}
+			else {
+				uchar* planes[3] = { f.image, f.image + pnXY, f.image + 2 * pnXY };
+				f.bSuccess = saveAsImg(f.src.savePath.c_str(), 8 * nChannel, planes, nChannel, pnX, pnY);
+			}
+		}
+
+		lock.lock();
+		seq.done.push_back(std::move(f));
+		seq.cv.notify_all();
+	}
+	lock.unlock();
+}
+
+bool ophGen::encodeChannels(unsigned int ENCODE_FLAG, Real* range)
+{
+	const uint pnX = context_.pixel_number[_X];
+	const uint pnY = context_.pixel_number[_Y];
+	const uint nChannel = context_.waveNum;
+	const uint pnXY = pnX * pnY;
+	void (ophGen::*encodeFunc) (Complex<Real>*, Real*, const int, Real*) = nullptr;
 
 	switch (ENCODE_FLAG)
 	{
@@ -1071,24 +1392,21 @@ void ophGen::encoding(unsigned int ENCODE_FLAG, Complex<Real>* holo)
 		//		ENCODE_SSB,
 		//		ENCODE_OFFSSB,
 		//		ENCODE_SYMMETRIZATION
-	default: LOG("Wrong encode flag.\n");  return;
+	default: LOG("Wrong encode flag.\n");  return false;
 	}
 
 	// initialzed zero
-	for (int ch = 0; ch < nChannel; ch++) {
+	for (uint ch = 0; ch < nChannel; ch++) {
 		memset(m_lpEncoded[ch], 0, sizeof(Real) * pnXY);
 		memset(m_lpNormalized[ch], 0, sizeof(uchar) * pnXY);
-		holo = complex_H[ch];
-		(this->*encodeFunc)(holo, m_lpEncoded[ch], pnXY);
+		(this->*encodeFunc)(complex_H[ch], m_lpEncoded[ch], pnXY, range ? range + ch * 2 : nullptr);
 	}
-
-	//encodeSymmetrization((holo), m_lpEncoded[ch], ivec2(0, 1));
-	auto end = CUR_TIME;
-	LOG("[Done] %lf(s)\n", ELAPSED_TIME(begin, end));
+	return true;
 }
 
 void ophGen::encoding(unsigned int ENCODE_FLAG, unsigned int passband, Complex<Real>* holo)
 {
+	OPH_PROFILE("encode");
 	holo == nullptr ? holo = *complex_H : holo;
 
 	const uint pnX = m_vecEncodeSize[_X] = context_.pixel_number[_X];
@@ -1130,6 +1448,7 @@ void ophGen::encoding(unsigned int ENCODE_FLAG, unsigned int passband, Complex<R
 
 void ophGen::encoding()
 {
+	OPH_PROFILE("encode");
 	const uint pnX = m_vecEncodeSize[_X] = context_.pixel_number[_X];
 	const uint pnY = m_vecEncodeSize[_Y] = context_.pixel_number[_Y];
 	const uint pnXY = pnX * pnY;
@@ -1206,61 +1525,39 @@ void ophGen::encoding()
 
 void ophGen::singleSideBand(oph::Complex<Real>* holo, Real* encoded, const ivec2 holosize, int SSB_PASSBAND)
 {
-	int size = holosize[_X] * holosize[_Y];
+	const int pnX = holosize[_X];
+	const int pnY = holosize[_Y];
+	const int size = pnX * pnY;
 
 	oph::Complex<Real>* AS = new oph::Complex<Real>[size];
-	fft2(holosize, holo, OPH_FORWARD, OPH_ESTIMATE);
-	fftwShift(holo, AS, holosize[_X], holosize[_Y], OPH_FORWARD, false);
-	//fftExecute(temp);
+	memcpy(AS, holo, sizeof(Complex<Real>) * size);
+	ophFFT::getInstance()->fft2Shifted(pnX, pnY, AS, OPH_FORWARD, false);
 
+	// remove the stopped half of the spectrum
+	int x0 = 0, x1 = pnX, y0 = 0, y1 = pnY;
 	switch (SSB_PASSBAND)
 	{
-	case SSB_LEFT:
-		for (int i = 0; i < holosize[_Y]; i++)
-		{
-			for (int j = holosize[_X] / 2; j < holosize[_X]; j++)
-			{
-				AS[i*holosize[_X] + j] = 0;
-			}
-		}
-		break;
-	case SSB_RIGHT:
-		for (int i = 0; i < holosize[_Y]; i++)
-		{
-			for (int j = 0; j < holosize[_X] / 2; j++)
-			{
-				AS[i*holosize[_X] + j] = 0;
-			}
-		}
-		break;
-	case SSB_TOP:
-		for (int i = size / 2; i < size; i++)
-		{
-			AS[i] = 0;
-		}
-		break;
-
-	case SSB_BOTTOM:
-		for (int i = 0; i < size / 2; i++)
-		{
-			AS[i] = 0;
-		}
-		break;
+	case SSB_LEFT: x0 = pnX / 2; break;
+	case SSB_RIGHT: x1 = pnX / 2; break;
+	case SSB_TOP: y0 = pnY / 2; break;
+	case SSB_BOTTOM: y1 = pnY / 2; break;
+	default: x0 = x1; break;
+	}
+	int y;
+#pragma omp parallel for private(y)
+	for (y = y0; y < y1; y++) {
+		memset(AS + y * pnX + x0, 0, sizeof(Complex<Real>) * (x1 - x0));
 	}
 
-	oph::Complex<Real>* filtered = new oph::Complex<Real>[size];
-	fft2(holosize, AS, OPH_BACKWARD, OPH_ESTIMATE);
-	fftwShift(AS, filtered, holosize[_X], holosize[_Y], OPH_BACKWARD, false);
-
-	//fftExecute(filtered);
-
+	ophFFT::getInstance()->fft2Shifted(pnX, pnY, AS, OPH_BACKWARD, false);
 
 	Real* realFiltered = new Real[size];
-	oph::realPart<Real>(filtered, realFiltered, size);
+	oph::realPart<Real>(AS, realFiltered, size);
 
 	oph::normalize(realFiltered, encoded, size);
 
-	delete[] AS, filtered, realFiltered;
+	delete[] AS;
+	delete[] realFiltered;
 }
 
 void ophGen::freqShift(oph::Complex<Real>* src, Complex<Real>* dst, const ivec2 holosize, int shift_x, int shift_y)
@@ -1282,6 +1579,7 @@ void ophGen::freqShift(oph::Complex<Real>* src, Complex<Real>* dst, const ivec2
 
 void ophGen::fresnelPropagation(OphConfig context, Complex<Real>* in, Complex<Real>* out, Real distance)
 {
+	OPH_PROFILE("propagate");
 	const int pnX = context.pixel_number[_X];
 	const int pnY = context.pixel_number[_Y];
 	const uint pnXY = pnX * pnY;
@@ -1356,6 +1654,7 @@ void ophGen::fresnelPropagation(OphConfig context, Complex<Real>* in, Complex<Re
 
 void ophGen::fresnelPropagation(Complex<Real>* in, Complex<Real>* out, Real distance, uint channel)
 {
+	OPH_PROFILE("propagate");
 	auto begin = CUR_TIME;
 
 	const int pnX = context_.pixel_number[_X];
@@ -1459,101 +1758,103 @@ bool ophGen::Shift(Real x, Real y)
 	const uint pnY = context_.pixel_number[_Y];
 	const Real ppX = context_.pixel_pitch[_X];
 	const Real ppY = context_.pixel_pitch[_Y];
-	const uint pnXY = pnX * pnY;
 	const vec2 ss = context_.ss;
 	Real ppY2 = ppY * 2;
 	Real ppX2 = ppX * 2;
 	Real ssX = -ss[_X] / 2;
 	Real ssY = -ss[_Y] / 2;
 
-	Real *waveRatio = new Real[nChannel];
-
-	Complex<Real> pi2(0.0, -2 * M_PI);
-	int num_threads = 1;
+	Complex<Real>* carrierX = bAxisX ? new Complex<Real>[pnX] : nullptr;
+	Complex<Real>* carrierY = bAxisY ? new Complex<Real>[pnY] : nullptr;
 
 	for (int i = 0; i < nChannel; i++) {
-		waveRatio[i] = context_.wave_length[nChannel - 1] / context_.wave_length[i];
-
-		Real ratioX = x * waveRatio[i];
-		Real ratioY = y * waveRatio[i];
-		int y;
-
-#ifdef _OPENMP
-#pragma omp parallel
-		{
-			num_threads = omp_get_num_threads();
-#pragma omp for private(y)
-#endif
-			for (y = 0; y < pnY; y++) {
-				Complex<Real> yy(0, 0);
-				if (bAxisY) {
-					Real startY = ssY + (ppY * y);
-					Real shiftY = startY / ppY2 * ratioY;
-					yy = (pi2 * shiftY).exp();
-				}
-				int offset = y * pnX;
-
-				for (int x = 0; x < pnX; x++) {
-					if (bAxisY) {
-						complex_H[i][offset + x] = complex_H[i][offset + x] * yy;
-					}
-					if (bAxisX) {
-						Real startX = ssX + (ppX * x);
-						Real shiftX = startX / ppX2 * ratioX;
-						Complex<Real> xx = (pi2 * shiftX).exp();
-						complex_H[i][offset + x] = complex_H[i][offset + x] * xx;
-					}
-				}
+		Real waveRatio = context_.wave_length[nChannel - 1] / context_.wave_length[i];
+		Real ratioX = x * waveRatio;
+		Real ratioY = y * waveRatio;
+
+		// exp(-i * 2pi * shift) per column and per row
+		if (bAxisX) {
+			for (uint c = 0; c < pnX; c++) {
+				Real shiftX = (ssX + (ppX * c)) / ppX2 * ratioX;
+				carrierX[c] = Complex<Real>(cos(-2 * M_PI * shiftX), sin(-2 * M_PI * shiftX));
 			}
-#ifdef _OPENMP
+		}
+		if (bAxisY) {
+			for (uint r = 0; r < pnY; r++) {
+				Real shiftY = (ssY + (ppY * r)) / ppY2 * ratioY;
+				carrierY[r] = Complex<Real>(cos(-2 * M_PI * shiftY), sin(-2 * M_PI * shiftY));
 			}
-#endif
+		}
+		applyCarrier(complex_H[i], carrierX, carrierY);
 	}
+	if (carrierX) delete[] carrierX;
+	if (carrierY) delete[] carrierY;
 
 	auto end = CUR_TIME;
-	LOG("Complex Field Shift (%d threads): %lf(s)\n",
-		num_threads,
-		ELAPSED_TIME(begin, end));
+	LOG("Complex Field Shift : %lf(s)\n", ELAPSED_TIME(begin, end));
 	return true;
 }
 
+void ophGen::applyCarrier(Complex<Real>* field, const Complex<Real>* carrierX, const Complex<Real>* carrierY)
+{
+	if (!field || (!carrierX && !carrierY)) return;
+
+	const int pnX = context_.pixel_number[_X];
+	const int pnY = context_.pixel_number[_Y];
+	int y;
+#pragma omp parallel for private(y)
+	for (y = 0; y < pnY; y++) {
+		Real* row = reinterpret_cast<Real*>(field + y * pnX);
+		const Real cyRe = carrierY ? carrierY[y].real() : 1.0;
+		const Real cyIm = carrierY ? carrierY[y].imag() : 0.0;
+		if (!carrierX) {
+			for (int x = 0; x < pnX; x++) {
+				const Real re = row[2 * x], im = row[2 * x + 1];
+				row[2 * x] = re * cyRe - im * cyIm;
+				row[2 * x + 1] = re * cyIm + im * cyRe;
+			}
+			continue;
+		}
+		const Real* cx = reinterpret_cast<const Real*>(carrierX);
+		for (int x = 0; x < pnX; x++) {
+			const Real tRe = cyRe * cx[2 * x] - cyIm * cx[2 * x + 1];
+			const Real tIm = cyRe * cx[2 * x + 1] + cyIm * cx[2 * x];
+			const Real re = row[2 * x], im = row[2 * x + 1];
+			row[2 * x] = re * tRe - im * tIm;
+			row[2 * x + 1] = re * tIm + im * tRe;
+		}
+	}
+}
+
 void ophGen::waveCarry(Real carryingAngleX, Real carryingAngleY, Real distance)
 {
-	const uint pnX = context_.pixel_number[_X];
-	const uint pnY = context_.pixel_number[_Y];
+	const int pnX = context_.pixel_number[_X];
+	const int pnY = context_.pixel_number[_Y];
 	const Real ppX = context_.pixel_pitch[_X];
 	const Real ppY = context_.pixel_pitch[_Y];
-	const uint pnXY = pnX * pnY;
 	const uint nChannel = context_.waveNum;
 	Real dfx = 1 / ppX / pnX;
 	Real dfy = 1 / ppY / pnY;
-	Real* fx = new Real[pnXY];
-	Real* fy = new Real[pnXY];
-	Real* fz = new Real[pnXY];
-	uint i = 0;
-	for (uint ch = 0; ch < nChannel; ch++) {
-		Real lambda = context_.wave_length[ch];
+	Real kx = distance * tan(carryingAngleX);
+	Real ky = distance * tan(carryingAngleY);
 
-		for (int idxFy = pnY / 2; idxFy > -pnY / 2; idxFy--) {
-			for (int idxFx = -pnX / 2; idxFx < pnX / 2; idxFx++) {
-				fx[i] = idxFx * dfx;
-				fy[i] = idxFy * dfy;
-				fz[i] = sqrt((1 / lambda)*(1 / lambda) - fx[i] * fx[i] - fy[i] * fy[i]);
+	// exp(i * (kx * fx + ky * fy)) = exp(i * kx * fx) * exp(i * ky * fy), the same for every channel.
+	Complex<Real>* carrierX = new Complex<Real>[pnX];
+	Complex<Real>* carrierY = new Complex<Real>[pnY];
+	for (int c = 0; c < pnX; c++) {
+		Real fx = (c - pnX / 2) * dfx;
+		carrierX[c] = Complex<Real>(cos(kx * fx), sin(kx * fx));
+	}
+	for (int r = 0; r < pnY; r++) {
+		Real fy = (pnY / 2 - r) * dfy;
+		carrierY[r] = Complex<Real>(cos(ky * fy), sin(ky * fy));
+	}
 
-				i++;
-			}
-		}
+	for (uint ch = 0; ch < nChannel; ch++)
+		applyCarrier(complex_H[ch], carrierX, carrierY);
 
-		Complex<Real> carrier;
-		for (int i = 0; i < pnXY; i++) {
-			carrier[_RE] = 0;
-			carrier[_IM] = distance * tan(carryingAngleX)*fx[i] + distance * tan(carryingAngleY)*fy[i];
-			complex_H[ch][i] = complex_H[ch][i] * exp(carrier);
-		}
-	}
-	delete[] fx;
-	delete[] fy;
-	delete[] fz;
+	delete[] carrierX;
+	delete[] carrierY;
 }
 
 void ophGen::encodeSideBand(bool bCPU, ivec2 sig_location)
@@ -1603,40 +1904,65 @@ void ophGen::encodeSideBand_CPU(int cropx1, int cropx2, int cropy1, int cropy2,
 	const uint pnX = context_.pixel_number[_X];
 	const uint pnY = context_.pixel_number[_Y];
 	const uint pnXY = pnX * pnY;
-	const uint nChannel = context_.waveNum;
+	const int nChannel = context_.waveNum;
 
-	Complex<Real>* h_crop = new Complex<Real>[pnXY];
+	Complex<Real>* carrierX = new Complex<Real>[pnX];
+	Complex<Real>* carrierY = new Complex<Real>[pnY];
+	getShiftPhaseTable(sig_location, carrierX, carrierY);
 
-	for (uint ch = 0; ch < nChannel; ch++) {
+	// one work buffer per channel, so the channels are encoded concurrently on the plans of one FFT layer.
+	Complex<Real>* h_crop = new Complex<Real>[pnXY * nChannel];
+	ophFFT* fft = ophFFT::getInstance();
 
-		memset(h_crop, 0.0, sizeof(Complex<Real>) * pnXY);
-
-		int p = 0;
-#pragma omp parallel for private(p)
-		for (p = 0; p < pnXY; p++)
-		{
-			int x = p % pnX;
-			int y = p / pnX;
-			if (x >= cropx1 && x <= cropx2 && y >= cropy1 && y <= cropy2)
-				h_crop[p] = complex_H[ch][p];
+	if (nChannel == 1) {
+		encodeSideBandKernel(fft, complex_H[0], m_lpEncoded[0], h_crop, cropx1, cropx2, cropy1, cropy2, carrierX, carrierY);
+	}
+	else {
+		int ch;
+#pragma omp parallel for private(ch)
+		for (ch = 0; ch < nChannel; ch++) {
+			encodeSideBandKernel(fft, complex_H[ch], m_lpEncoded[ch], h_crop + ch * pnXY, cropx1, cropx2, cropy1, cropy2, carrierX, carrierY);
 		}
+	}
+	delete[] h_crop;
+	delete[] carrierX;
+	delete[] carrierY;
+}
 
-		Complex<Real> *in = nullptr;
-
-		fft2(ivec2(pnX, pnY), in, OPH_BACKWARD);
-		fftwShift(h_crop, h_crop, pnX, pnY, OPH_BACKWARD, true);
-
-		memset(m_lpEncoded[ch], 0.0, sizeof(Real) * pnXY);
-		int i = 0;
-#pragma omp parallel for private(i)	
-		for (i = 0; i < pnXY; i++) {
-			Complex<Real> shift_phase(1, 0);
-			getShiftPhaseValue(shift_phase, i, sig_location);
-
-			m_lpEncoded[ch][i] = (h_crop[i] * shift_phase).real();
+void ophGen::encodeSideBandKernel(ophFFT* fft, Complex<Real>* holo, Real* encoded, Complex<Real>* buf, int cropx1, int cropx2, int cropy1, int cropy2,
+	const Complex<Real>* carrierX, const Complex<Real>* carrierY)
+{
+	const int pnX = context_.pixel_number[_X];
+	const int pnY = context_.pixel_number[_Y];
+	const int x0 = max(cropx1, 0), x1 = min(cropx2, pnX - 1);
+	const int y0 = max(cropy1, 0), y1 = min(cropy2, pnY - 1);
+
+	int y;
+#pragma omp parallel for private(y)
+	for (y = 0; y < pnY; y++) {
+		Complex<Real>* dst = buf + y * pnX;
+		if (y < y0 || y > y1 || x0 > x1) {
+			memset(dst, 0, sizeof(Complex<Real>) * pnX);
+			continue;
+		}
+		if (x0 > 0) memset(dst, 0, sizeof(Complex<Real>) * x0);
+		memcpy(dst + x0, holo + y * pnX + x0, sizeof(Complex<Real>) * (x1 - x0 + 1));
+		if (x1 < pnX - 1) memset(dst + x1 + 1, 0, sizeof(Complex<Real>) * (pnX - 1 - x1));
+	}
+
+	fft->fft2Shifted(pnX, pnY, buf, OPH_BACKWARD, true);
+
+#pragma omp parallel for private(y)
+	for (y = 0; y < pnY; y++) {
+		const Complex<Real> cy = carrierY[y];
+		const Complex<Real>* src = buf + y * pnX;
+		Real* dst = encoded + y * pnX;
+		for (int x = 0; x < pnX; x++) {
+			const Real re = cy.real() * carrierX[x].real() - cy.imag() * carrierX[x].imag();
+			const Real im = cy.real() * carrierX[x].imag() + cy.imag() * carrierX[x].real();
+			dst[x] = src[x].real() * re - src[x].imag() * im;
 		}
 	}
-	delete[] h_crop;
 }
 
 void ophGen::encodeSymmetrization(Complex<Real>* holo, Real* encoded, const ivec2 sig_loc)
@@ -1677,34 +2003,16 @@ void ophGen::encodeSymmetrization(Complex<Real>* holo, Real* encoded, const ivec
 	cropy1 -= 1;
 	cropy2 -= 1;
 
-	Complex<Real>* h_crop = new Complex<Real >[pnXY];
-	memset(h_crop, 0.0, sizeof(Complex<Real>) * pnXY);
-	int i;
-#ifdef _OPENMP
-#pragma omp parallel for private(i)
-#endif
-	for (i = 0; i < pnXY; i++) {
-		int x = i % pnX;
-		int y = i / pnX;
-		if (x >= cropx1 && x <= cropx2 && y >= cropy1 && y <= cropy2)
-			h_crop[i] = holo[i];
-	}
-	fftw_complex *in = nullptr, *out = nullptr;
-	fftw_plan plan = fftw_plan_dft_2d(pnX, pnY, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
-	fftwShift(h_crop, h_crop, pnX, pnY, -1, true);
-	fftw_destroy_plan(plan);
-	fftw_cleanup();
+	Complex<Real>* carrierX = new Complex<Real>[pnX];
+	Complex<Real>* carrierY = new Complex<Real>[pnY];
+	getShiftPhaseTable(sig_loc, carrierX, carrierY);
 
-#ifdef _OPENMP
-#pragma omp parallel for private(i)
-#endif
-	for (i = 0; i < pnXY; i++) {
-		Complex<Real> shift_phase(1, 0);
-		getShiftPhaseValue(shift_phase, i, sig_loc);
-		encoded[i] = (h_crop[i] * shift_phase)._Val[_RE];
-	}
+	Complex<Real>* h_crop = new Complex<Real>[pnXY];
+	encodeSideBandKernel(ophFFT::getInstance(), holo, encoded, h_crop, cropx1, cropx2, cropy1, cropy2, carrierX, carrierY);
 
 	delete[] h_crop;
+	delete[] carrierX;
+	delete[] carrierY;
 }
 
 void ophGen::encodeSideBand_GPU(int cropx1, int cropx2, int cropy1, int cropy2, oph::ivec2 sig_location)
@@ -1793,6 +2101,36 @@ void ophGen::getShiftPhaseValue(oph::Complex<Real>& shift_phase_val, int idx, op
 	}
 }
 
+void ophGen::getShiftPhaseTable(oph::ivec2 sig_location, Complex<Real>* carrierX, Complex<Real>* carrierY)
+{
+	const int pnX = context_.pixel_number[_X];
+	const int pnY = context_.pixel_number[_Y];
+	const Real ppX = context_.pixel_pitch[_X];
+	const Real ppY = context_.pixel_pitch[_Y];
+	const Real ssX = context_.ss[_X] = pnX * ppX;
+	const Real ssY = context_.ss[_Y] = pnY * ppY;
+
+	for (int r = 0; r < pnY; r++) {
+		if (sig_location[1] != 0) {
+			Real yy = (ssY / 2.0) - (ppY)*r - ppY;
+			Real phase = (sig_location[1] == 1) ? 2 * M_PI * (yy / (4 * ppY)) : 2 * M_PI * (-yy / (4 * ppY));
+			carrierY[r] = Complex<Real>(cos(phase), sin(phase));
+		}
+		else
+			carrierY[r] = Complex<Real>(1, 0);
+	}
+
+	for (int c = 0; c < pnX; c++) {
+		if (sig_location[0] != 0) {
+			Real xx = (-ssX / 2.0) - (ppX)*c - ppX;
+			Real phase = (sig_location[0] == -1) ? 2 * M_PI * (-xx / (4 * ppX)) : 2 * M_PI * (xx / (4 * ppX));
+			carrierX[c] = Complex<Real>(cos(phase), sin(phase));
+		}
+		else
+			carrierX[c] = Complex<Real>(1, 0);
+	}
+}
+
 void ophGen::getRandPhaseValue(Complex<Real>& rand_phase_val, bool rand_phase)
 {
 	if (rand_phase)
@@ -1826,61 +2164,60 @@ void ophGen::setResolution(ivec2 resolution)
 	}
 }
 
-void ophGen::RealPart(Complex<Real> *holo, Real *encoded, const int size)
+/**
+* Encodes every element with op and, if range is given, reduces the min/max of the result in the same pass.
+*/
+template<typename Op>
+static void encodeWithRange(Complex<Real>* holo, Real* encoded, const int size, Real* range, Op op)
 {
-	int num_threads = 1;
 	int i;
-#ifdef _OPENMP
-#pragma omp parallel
-	{
-		num_threads = omp_get_num_threads();
-#pragma omp for private(i)
-#endif
+	if (range == nullptr) {
+#pragma omp parallel for private(i)
 		for (i = 0; i < size; i++) {
-			encoded[i] = real(holo[i]);
-		}
-#ifdef _OPENMP
+			encoded[i] = op(holo[i]);
 		}
-#endif
-}
+		return;
+	}
 
-void ophGen::Phase(Complex<Real> *holo, Real *encoded, const int size)
-{
-	int num_threads = 1;
-	int i;
-#ifdef _OPENMP
+	Real minVal = MAX_DOUBLE;
+	Real maxVal = -MAX_DOUBLE;
 #pragma omp parallel
 	{
-		num_threads = omp_get_num_threads();
+		Real localMin = MAX_DOUBLE;
+		Real localMax = -MAX_DOUBLE;
 #pragma omp for private(i)
-#endif
 		for (i = 0; i < size; i++) {
-			encoded[i] = holo[i].angle() + M_PI;
+			Real val = op(holo[i]);
+			encoded[i] = val;
+			if (val < localMin) localMin = val;
+			if (val > localMax) localMax = val;
 		}
-#ifdef _OPENMP
+#pragma omp critical
+		{
+			if (localMin < minVal) minVal = localMin;
+			if (localMax > maxVal) maxVal = localMax;
 		}
-#endif
+	}
+	range[0] = minVal;
+	range[1] = maxVal;
 }
 
-void ophGen::Amplitude(Complex<Real> *holo, Real *encoded, const int size)
+void ophGen::RealPart(Complex<Real> *holo, Real *encoded, const int size, Real* range)
 {
-	int num_threads = 1;
-	int i;
-#ifdef _OPENMP
-#pragma omp parallel
-	{
-		num_threads = omp_get_num_threads();
-#pragma omp for private(i)
-#endif
-		for (i = 0; i < size; i++) {
-			encoded[i] = holo[i].mag();
-		}
-#ifdef _OPENMP
-		}
-#endif
+	encodeWithRange(holo, encoded, size, range, [](Complex<Real>& c) { return c.real(); });
+}
+
+void ophGen::Phase(Complex<Real> *holo, Real *encoded, const int size, Real* range)
+{
+	encodeWithRange(holo, encoded, size, range, [](Complex<Real>& c) { return c.angle() + M_PI; });
+}
+
+void ophGen::Amplitude(Complex<Real> *holo, Real *encoded, const int size, Real* range)
+{
+	encodeWithRange(holo, encoded, size, range, [](Complex<Real>& c) { return c.mag(); });
 }
 
-void ophGen::TwoPhase(Complex<Real>* holo, Real* encoded, const int size)
+void ophGen::TwoPhase(Complex<Real>* holo, Real* encoded, const int size, Real* range)
 {
 	int resize = size / 2;
 	int num_threads = 1;
@@ -1925,9 +2262,11 @@ void ophGen::TwoPhase(Complex<Real>* holo, Real* encoded, const int size)
 	delete[] normCplx;
 	delete[] ampl;
 	delete[] phase;
+
+	if (range) minMaxOfArr<Real>(encoded, size, range[0], range[1]);
 }
 
-void ophGen::Burckhardt(Complex<Real>* holo, Real* encoded, const int size)
+void ophGen::Burckhardt(Complex<Real>* holo, Real* encoded, const int size, Real* range)
 {
 	int resize = size / 3;
 	int num_threads = 1;
@@ -1988,42 +2327,32 @@ void ophGen::Burckhardt(Complex<Real>* holo, Real* encoded, const int size)
 	delete[] ampl;
 	delete[] phase;
 	delete[] norm;
+
+	if (range) minMaxOfArr<Real>(encoded, size, range[0], range[1]);
 }
 
-void ophGen::SimpleNI(Complex<Real>* holo, Real* encoded, const int size)
+void ophGen::SimpleNI(Complex<Real>* holo, Real* encoded, const int size, Real* range)
 {
-	int num_threads = 1;
-	Real* tmp1 = new Real[size];
+	Real max = MIN_DOUBLE;
 	int i;
-#ifdef _OPENMP
 #pragma omp parallel
 	{
-		num_threads = omp_get_num_threads();
+		Real localMax = MIN_DOUBLE;
 #pragma omp for private(i)
-#endif
 		for (i = 0; i < size; i++) {
-			tmp1[i] = holo[i].mag();
+			Real mag = holo[i].mag();
+			if (mag > localMax) localMax = mag;
 		}
-#ifdef _OPENMP
+#pragma omp critical
+		{
+			if (localMax > max) max = localMax;
 		}
-#endif
-
-	Real max = maxOfArr(tmp1, size);
-	delete[] tmp1;
+	}
 
-#ifdef _OPENMP
-#pragma omp parallel
-	{
-		num_threads = omp_get_num_threads();
-#pragma omp for private(i)
-#endif
-		for (i = 0; i < size; i++) {
-			Real tmp = (holo[i] + max).mag();
-			encoded[i] = tmp * tmp;
-		}
-#ifdef _OPENMP
-		}
-#endif
+	encodeWithRange(holo, encoded, size, range, [max](Complex<Real>& c) {
+		Real tmp = (c + max).mag();
+		return tmp * tmp;
+	});
 }
 
 void ophGen::transVW(int nSize, Real *dst, Real *src)
@@ -2093,6 +2422,12 @@ bool ophGen::readImage(const char* fname, bool bRGB)
 
 void ophGen::ophFree(void)
 {
+	if (m_pSequence) {
+		endSequence();
+		delete m_pSequence;
+		m_pSequence = nullptr;
+	}
+	waitImgSaving();
 	Openholo::ophFree();
 	if (m_lpEncoded) {
 		delete[] m_lpEncoded;
@@ -2102,4 +2437,10 @@ void ophGen::ophFree(void)
 		delete[] m_lpNormalized;
 		m_lpNormalized = nullptr;
 	}
+	if (m_lpNormalized16) {
+		for (uint i = 0; i < m_nOldChannel; i++)
+			delete[] m_lpNormalized16[i];
+		delete[] m_lpNormalized16;
+		m_lpNormalized16 = nullptr;
+	}
 }
@@ -47,6 +47,9 @@
 #define __ophGen_h
 
 #include "Openholo.h"
+#include "PointCloudCache.h"
+#include <functional>
+#include <string>
 
 #ifdef GEN_EXPORT
 #define GEN_DLL __declspec(dllexport)
@@ -59,6 +62,7 @@ struct OphPointCloudData;
 struct OphDepthMapConfig;
 struct OphMeshData;
 struct OphWRPConfig;
+namespace oph { class ophFFT; }
 
 /**
 * @ingroup gen
@@ -108,6 +112,13 @@ public:
 	*				If the function fails, the return value is <B>nullptr</B>.
 	*/
 	inline uchar** getNormalizedBuffer(void) { return m_lpNormalized; }
+	/**
+	* @brief Function for getting the 10/12-bit normalized complex field buffer filled by encodeQuantized
+	* @return Type: <B>ushort**</B>\n
+	*				If the function succeeds, the return value is <B>normalized complex field data's pointer</B>.\n
+	*				If the function fails, the return value is <B>nullptr</B>.
+	*/
+	inline ushort** getNormalizedBuffer16(void) { return m_lpNormalized16; }
 
 	/**
 	* @brief Initialize variables for Hologram complex field, encoded data, normalized data
@@ -124,6 +135,19 @@ public:
 	*/
 	int loadPointCloud(const char* pc_file, OphPointCloudData *pc_data_);
 
+	/**
+	* @brief Use the binary point cloud cache (<PLY file>.ophpc) in loadPointCloud.
+	* @details A valid cache is memory-mapped instead of parsing the PLY file, and the cache is
+	*			written next to the PLY file after parsing when it is missing or older than the PLY file.
+	*			A cache is used only when its point order is the requested one. Disabled by default.
+	* @param[in] bEnable use the cache.
+	* @param[in] sort point order of the cache : PointCloudCache::SORT_NONE keeps the PLY order,
+	*			SORT_DEPTH or SORT_TILE reorder the loaded points.
+	*/
+	void setPointCloudCache(bool bEnable, PointCloudCache::SORT sort = PointCloudCache::SORT_NONE) { m_bPointCache = bEnable; m_ePointCacheSort = sort; }
+	bool getPointCloudCache(void) { return m_bPointCache; }
+	PointCloudCache::SORT getPointCloudCacheSort(void) { return m_ePointCacheSort; }
+
 	/**
 	* @brief load to configuration file.
 	* @param[in] fname config file name
@@ -140,9 +164,10 @@ public:
 	* @param[in] propagation_dist the distance from the object to the hologram plane.
 	* @param[in] k const value.
 	* @param[in] lambda wave length.
+	* @param[out] output accumulation target, complex_H[ch] if nullptr.
 	* @see calcHoloCPU, fftwShift
 	*/
-	void propagationAngularSpectrum(int ch, Complex<Real>* input_u, Real propagation_dist, Real k, Real lambda);
+	void propagationAngularSpectrum(int ch, Complex<Real>* input_u, Real propagation_dist, Real k, Real lambda, Complex<Real>* output = nullptr);
 
 	/**
 	* @brief Normalization function to save as image file after hologram creation
@@ -217,6 +242,19 @@ public:
 	void encoding(unsigned int ENCODE_FLAG, Complex<Real>* holo = nullptr);
 
 	void encoding();
+
+	/**
+	* @brief	Encoding and normalization in one pipeline stage
+	* @details	Each encoder reduces the min/max of its output while encoding, so the encoded buffer
+	*			is read once more only by the quantization (the vertical flip is part of its addressing).@n
+	*			8-bit results are stored in getNormalizedBuffer(), 10/12-bit results in getNormalizedBuffer16().
+	* @param[in] ENCODE_FLAG ENCODE_PHASE, ENCODE_AMPLITUDE, ENCODE_REAL, ENCODE_SIMPLENI, ENCODE_BURCKHARDT or ENCODE_TWOPHASE.
+	* @param[in] bitDepth 8, 10 or 12.
+	* @return Type: <B>bool</B>\n
+	*				If the function succeeds, the return value is <B>true</B>.\n
+	*				If the function fails, the return value is <B>false</B>.
+	*/
+	bool encodeQuantized(unsigned int ENCODE_FLAG, int bitDepth = 8);
 	/*
 	* @brief	Encoding Functions
 	* @details
@@ -230,6 +268,67 @@ public:
 	virtual void encoding(unsigned int ENCODE_FLAG, unsigned int SSB_PASSBAND, Complex<Real>* holo = nullptr);
 	enum SSB_PASSBAND { SSB_LEFT, SSB_RIGHT, SSB_TOP, SSB_BOTTOM };
 
+public:
+	/**
+	* @brief One frame of a hologram sequence.
+	* @details load runs on the loader thread and must only touch data owned by the frame
+	*			(e.g. a point cloud file parsed into a buffer captured by the lambda).@n
+	*			generate runs on the generator thread with exclusive use of this object and fills complex_H,
+	*			typically by handing the loaded data to the object and calling generateHologram().
+	*/
+	struct SequenceFrame {
+		std::function<bool(void)> load;
+		std::function<bool(ophGen*)> generate;
+		/// image file of the frame, not saved if empty.
+		std::string savePath;
+	};
+
+	/**
+	* @brief Start a frame-sequence pipeline (load -> generate and encode -> save), each stage on its own thread.
+	* @details Buffers of this object, the cached FFT plans and the frame image pool are kept for the whole sequence.@n
+	*			The object must not be used directly until endSequence().
+	* @param[in] ENCODE_FLAG ENCODE_PHASE, ENCODE_AMPLITUDE, ENCODE_REAL, ENCODE_SIMPLENI, ENCODE_BURCKHARDT or ENCODE_TWOPHASE.
+	* @param[in] queueDepth maximum number of frames submitted but not yet collected.
+	* @return Type: <B>bool</B>\n
+	*				If the function succeeds, the return value is <B>true</B>.\n
+	*				If the function fails, the return value is <B>false</B>.
+	*/
+	bool beginSequence(unsigned int ENCODE_FLAG, int queueDepth = 3);
+	/**
+	* @brief Queue a frame, blocks while queueDepth frames are in flight.
+	* @return Type: <B>int</B>\n
+	*				If the function succeeds, the return value is <B>index of the frame</B>.\n
+	*				If the function fails, the return value is <B>-1</B>.
+	*/
+	int submitFrame(const SequenceFrame& frame);
+	/**
+	* @brief Wait for the oldest frame in flight.
+	* @param[out] index index of the frame returned by submitFrame.
+	* @param[out] dst if not nullptr, receives the 8-bit normalized frame (waveNum * pixel_number[_X] * pixel_number[_Y]).
+	* @return Type: <B>bool</B>\n
+	*				If the frame succeeded, the return value is <B>true</B>.\n
+	*				If the frame failed or no frame is in flight, the return value is <B>false</B> (index is -1 for the latter).
+	*/
+	bool collectFrame(int& index, uchar* dst = nullptr);
+	/**
+	* @brief Finish the frames in flight, stop the pipeline threads and log the sustained frame rate.
+	*/
+	void endSequence(void);
+	/**
+	* @brief Sustained frame rate of the current (or last) sequence : collected frames / elapsed time.
+	*/
+	Real getSequenceFPS(void);
+
+private:
+	struct SequenceContext;
+	SequenceContext*		m_pSequence;
+	bool					m_bPointCache;
+	PointCloudCache::SORT	m_ePointCacheSort;
+	/// thread bodies of the sequence pipeline.
+	void sequenceLoader(void);
+	void sequenceGenerator(void);
+	void sequenceSaver(void);
+
 public:
 
 	bool Shift(Real x, Real y);
@@ -254,6 +353,8 @@ protected:
 	Real**					m_lpEncoded;
 	/// buffer to normalized.
 	uchar**					m_lpNormalized;
+	/// buffer to normalized with 10/12-bit depth.
+	ushort**				m_lpNormalized16;
 
 private:
 	/// previous number of channel.
@@ -294,14 +395,22 @@ protected:
 	* @param[in] holo Source data.
 	* @param[out] encoded Destination data.
 	* @param[in] size size of encode.
+	* @param[out] range if not nullptr, [0] : minimum and [1] : maximum of the encoded data.
 	*/
-	void RealPart(Complex<Real>* holo, Real* encoded, const int size);
+	void RealPart(Complex<Real>* holo, Real* encoded, const int size, Real* range = nullptr);
 
-	void Phase(Complex<Real>* holo, Real* encoded, const int size);
-	void Amplitude(Complex<Real>* holo, Real* encoded, const int size);
-	void TwoPhase(Complex<Real>* holo, Real* encoded, const int size);
-	void Burckhardt(Complex<Real>* holo, Real* encoded, const int size);
-	void SimpleNI(Complex<Real>* holo, Real* encoded, const int size);
+	void Phase(Complex<Real>* holo, Real* encoded, const int size, Real* range = nullptr);
+	void Amplitude(Complex<Real>* holo, Real* encoded, const int size, Real* range = nullptr);
+	void TwoPhase(Complex<Real>* holo, Real* encoded, const int size, Real* range = nullptr);
+	void Burckhardt(Complex<Real>* holo, Real* encoded, const int size, Real* range = nullptr);
+	void SimpleNI(Complex<Real>* holo, Real* encoded, const int size, Real* range = nullptr);
+
+	/**
+	* @brief	Runs the encoder selected by ENCODE_FLAG on every channel of complex_H.
+	* @param[in] ENCODE_FLAG encoding method.
+	* @param[out] range if not nullptr, min/max pair of each channel (2 * waveNum).
+	*/
+	bool encodeChannels(unsigned int ENCODE_FLAG, Real* range);
 
 	/**
 	* @brief	Encoding method.
@@ -390,6 +499,34 @@ protected:
 	*/
 	void getShiftPhaseValue(Complex<Real>& shift_phase_val, int idx, ivec2 sig_location);
 
+	/**
+	* @brief Separable form of getShiftPhaseValue : shift phase of (r, c) = carrierY[r] * carrierX[c].
+	* @param[in] sig_location signal location.
+	* @param[out] carrierX shift phase of each column (pixel_number[_X]).
+	* @param[out] carrierY shift phase of each row (pixel_number[_Y]).
+	*/
+	void getShiftPhaseTable(ivec2 sig_location, Complex<Real>* carrierX, Complex<Real>* carrierY);
+
+	/**
+	* @brief Crop the spectrum, propagate it back and take the real part of the carrier modulated field.
+	* @param[in] fft FFT layer, fetched once by the caller outside its parallel region.
+	* @param[in] holo Source spectrum.
+	* @param[out] encoded Destination data.
+	* @param[in] buf Work buffer of pixel_number[_X] * pixel_number[_Y].
+	* @param[in] cropx1, cropx2, cropy1, cropy2 the crop window (inclusive).
+	* @param[in] carrierX, carrierY separable shift phase from getShiftPhaseTable.
+	*/
+	void encodeSideBandKernel(ophFFT* fft, Complex<Real>* holo, Real* encoded, Complex<Real>* buf, int cropx1, int cropx2, int cropy1, int cropy2,
+		const Complex<Real>* carrierX, const Complex<Real>* carrierY);
+
+	/**
+	* @brief Multiply the field by a separable carrier : field(r, c) *= carrierY[r] * carrierX[c].
+	* @param[in,out] field complex field of pixel_number[_X] * pixel_number[_Y].
+	* @param[in] carrierX carrier of each column, nullptr if the carrier does not vary along x.
+	* @param[in] carrierY carrier of each row, nullptr if the carrier does not vary along y.
+	*/
+	void applyCarrier(Complex<Real>* field, const Complex<Real>* carrierX, const Complex<Real>* carrierY);
+
 	/**
 	* @brief Assign random phase value if RANDOM_PHASE == 1
 	* @details If RANDOM_PHASE == 1, calculate a random phase value using random generator@n
@@ -0,0 +1,392 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophGenBenchmark.h"
+#include "ophPointCloud.h"
+#include "ophDepthMap.h"
+#include "ophWRP.h"
+#include "ophTriMesh.h"
+#include "ophLightField.h"
+#include "ophIFTA.h"
+#include "ophPAS.h"
+#include "sys.h"
+#include <memory>
+#include <random>
+
+namespace {
+	const int LF_VIEWS = 8;
+
+	/// generators have protected destructors and are freed by release().
+	template<typename T>
+	std::shared_ptr<T> createGenerator(void)
+	{
+		return std::shared_ptr<T>(new T(), [](T* gen) { gen->release(); });
+	}
+
+	std::string path(const BenchmarkConfig& config, const char* name)
+	{
+		return config.workDir + "/" + name;
+	}
+}
+
+bool ophGenBenchmark::writeConfig(const char* fname, const BenchmarkConfig& config)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) return false;
+
+	const Real wavelength[3] = { 638e-9, 532e-9, 473e-9 };
+	const int nChannels = config.nChannels == 3 ? 3 : 1;
+	const int pnX = config.resolution[_X];
+	const int pnY = config.resolution[_Y];
+
+	// one root holding the elements of every generator, each readConfig picks its own.
+	fprintf(fp, "<BenchmarkConfig>\n");
+	fprintf(fp, "\t<SLM_WaveNum>%d</SLM_WaveNum>\n", nChannels);
+	for (int i = 0; i < nChannels; i++)
+		fprintf(fp, "\t<SLM_WaveLength_%d>%.9e</SLM_WaveLength_%d>\n", i + 1, nChannels == 3 ? wavelength[i] : wavelength[1], i + 1);
+	fprintf(fp, "\t<SLM_PixelNumX>%d</SLM_PixelNumX>\n\t<SLM_PixelNumY>%d</SLM_PixelNumY>\n", pnX, pnY);
+	fprintf(fp, "\t<SLM_PixelPitchX>8e-6</SLM_PixelPitchX>\n\t<SLM_PixelPitchY>8e-6</SLM_PixelPitchY>\n");
+	fprintf(fp, "\t<IMG_Rotation>false</IMG_Rotation>\n\t<IMG_Merge>false</IMG_Merge>\n\t<DoublePrecision>true</DoublePrecision>\n");
+	fprintf(fp, "\t<ShiftX>0</ShiftX>\n\t<ShiftY>0</ShiftY>\n\t<ShiftZ>0</ShiftZ>\n\t<FieldLength>0.1</FieldLength>\n\t<NumOfStream>1</NumOfStream>\n");
+	// point cloud, WRP, PAS, triangle mesh
+	fprintf(fp, "\t<ScaleX>0.002</ScaleX>\n\t<ScaleY>0.002</ScaleY>\n\t<ScaleZ>0.002</ScaleZ>\n\t<Distance>0.1</Distance>\n");
+	fprintf(fp, "\t<LocationOfWRP>0.003</LocationOfWRP>\n\t<NumOfWRP>1</NumOfWRP>\n");
+	fprintf(fp, "\t<ObjectShiftX>0</ObjectShiftX>\n\t<ObjectShiftY>0</ObjectShiftY>\n\t<ObjectShiftZ>0.1</ObjectShiftZ>\n");
+	fprintf(fp, "\t<LampDirectionX>0</LampDirectionX>\n\t<LampDirectionY>0.2</LampDirectionY>\n\t<LampDirectionZ>1</LampDirectionZ>\n");
+	// depth map, IFTA
+	fprintf(fp, "\t<FlagChangeDepthQuantization>1</FlagChangeDepthQuantization>\n");
+	fprintf(fp, "\t<DefaultDepthQuantization>%d</DefaultDepthQuantization>\n\t<NumberOfDepthQuantization>%d</NumberOfDepthQuantization>\n", config.nLayers, config.nLayers);
+	fprintf(fp, "\t<RenderDepth>1:%d</RenderDepth>\n\t<RandomPhase>0</RandomPhase>\n", config.nLayers);
+	fprintf(fp, "\t<NearOfDepth>0.1</NearOfDepth>\n\t<FarOfDepth>0.12</FarOfDepth>\n");
+	fprintf(fp, "\t<DepthLevel>%d</DepthLevel>\n\t<NumOfIteration>5</NumOfIteration>\n", config.nLayers);
+	// light field
+	fprintf(fp, "\t<Image_NumOfX>%d</Image_NumOfX>\n\t<Image_NumOfY>%d</Image_NumOfY>\n", LF_VIEWS, LF_VIEWS);
+	fprintf(fp, "\t<Image_Width>%d</Image_Width>\n\t<Image_Height>%d</Image_Height>\n", pnX / LF_VIEWS, pnY / LF_VIEWS);
+	// ACPAS
+	fprintf(fp, "\t<ScalingXofPointCloud>0.002</ScalingXofPointCloud>\n\t<ScalingYofPointCloud>0.002</ScalingYofPointCloud>\n");
+	fprintf(fp, "\t<ScalingZofPointCloud>0.002</ScalingZofPointCloud>\n\t<OffsetInDepth>0.1</OffsetInDepth>\n");
+	fprintf(fp, "\t<SLMpixelPitchX>8e-6</SLMpixelPitchX>\n\t<SLMpixelPitchY>8e-6</SLMpixelPitchY>\n");
+	fprintf(fp, "\t<SLMpixelNumX>%d</SLMpixelNumX>\n\t<SLMpixelNumY>%d</SLMpixelNumY>\n", pnX, pnY);
+	fprintf(fp, "\t<WavelengthofLaser>%.9e</WavelengthofLaser>\n", wavelength[1]);
+	fprintf(fp, "</BenchmarkConfig>\n");
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool ophGenBenchmark::writePointCloud(const char* fname, const BenchmarkConfig& config)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) return false;
+
+	std::vector<Real> vertex, color;
+	const int nChannels = config.nChannels == 3 ? 3 : 1;
+	Benchmark::randomPoints(config.seed, config.nPoints, nChannels, vertex, color);
+
+	fprintf(fp, "ply\nformat ascii 1.0\nelement vertex %llu\n", config.nPoints);
+	fprintf(fp, "property float x\nproperty float y\nproperty float z\n");
+	fprintf(fp, "property uchar red\nproperty uchar green\nproperty uchar blue\nend_header\n");
+	for (ulonglong i = 0; i < config.nPoints; i++) {
+		int c[3];
+		for (int ch = 0; ch < 3; ch++)
+			c[ch] = (int)(color[i * nChannels + (nChannels == 3 ? ch : 0)] * 255.0);
+		fprintf(fp, "%f %f %f %d %d %d\n", vertex[i * 3 + 0], vertex[i * 3 + 1], vertex[i * 3 + 2], c[0], c[1], c[2]);
+	}
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool ophGenBenchmark::writeMesh(const char* fname, const BenchmarkConfig& config, int nFaces)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) return false;
+
+	// small triangles scattered in the object volume.
+	std::vector<Real> center, color, offset, unused;
+	Benchmark::randomPoints(config.seed, nFaces, 1, center, color);
+	Benchmark::randomPoints(config.seed + 1, (ulonglong)nFaces * 3, 1, offset, unused);
+
+	fprintf(fp, "ply\nformat ascii 1.0\nelement vertex %d\n", nFaces * 3);
+	fprintf(fp, "property uint face_idx\nproperty float x\nproperty float y\nproperty float z\n");
+	fprintf(fp, "property uchar red\nproperty uchar green\nproperty uchar blue\nend_header\n");
+	for (int f = 0; f < nFaces; f++) {
+		int c = (int)(color[f] * 255.0);
+		for (int v = 0; v < 3; v++) {
+			const Real* o = &offset[((size_t)f * 3 + v) * 3];
+			fprintf(fp, "%d %f %f %f %d %d %d\n", f,
+				center[f * 3 + 0] + 0.1 * o[0], center[f * 3 + 1] + 0.1 * o[1], center[f * 3 + 2] + 0.1 * o[2], c, c, c);
+		}
+	}
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool ophGenBenchmark::writeImage(const char* fname, int width, int height, const uchar* image)
+{
+	FILE* fp = fopen(fname, "wb");
+	if (fp == nullptr) return false;
+
+	const int nLine = (width + 3) & ~3;
+	bitmap8bit header;
+	memset(&header, 0, sizeof(header));
+	header.fileheader.signature[0] = 'B';
+	header.fileheader.signature[1] = 'M';
+	header.fileheader.filesize = sizeof(bitmap8bit) + nLine * height;
+	header.fileheader.fileoffset_to_pixelarray = sizeof(bitmap8bit);
+	header.bitmapinfoheader.dibheadersize = sizeof(bitmapinfoheader);
+	header.bitmapinfoheader.width = width;
+	header.bitmapinfoheader.height = height;
+	header.bitmapinfoheader.planes = OPH_PLANES;
+	header.bitmapinfoheader.bitsperpixel = 8;
+	header.bitmapinfoheader.compression = OPH_COMPRESSION;
+	header.bitmapinfoheader.imagesize = nLine * height;
+	header.bitmapinfoheader.numcolorspallette = 256;
+	for (int i = 0; i < 256; i++)
+		header.rgbquad[i].rgbBlue = header.rgbquad[i].rgbGreen = header.rgbquad[i].rgbRed = i;
+	fwrite(&header, sizeof(header), 1, fp);
+
+	std::vector<uchar> line(nLine, 0);
+	for (int y = 0; y < height; y++) {
+		memcpy(line.data(), image + (size_t)y * width, width);
+		fwrite(line.data(), 1, nLine, fp);
+	}
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool ophGenBenchmark::addCases(Benchmark& bench)
+{
+	const BenchmarkConfig& config = bench.getConfig();
+	if (!Benchmark::makeDirectory(config.workDir.c_str()) || !Benchmark::makeDirectory(path(config, "lf").c_str())) {
+		LOG("<FAILED> Benchmark directory : %s\n", config.workDir.c_str());
+		return false;
+	}
+
+	const int pnX = config.resolution[_X];
+	const int pnY = config.resolution[_Y];
+	const ulonglong pnXY = (ulonglong)pnX * pnY;
+	const int nFaces = config.nPoints / 100 < 16 ? 16 : (int)(config.nPoints / 100);
+
+	const std::string xml = path(config, "config.xml");
+	const std::string ply = path(config, "pointcloud.ply");
+	const std::string mesh = path(config, "mesh.ply");
+	const std::string img = path(config, "img.bmp");
+	const std::string depth = path(config, "depth.bmp");
+
+	std::vector<uchar> image;
+	bool bOK = writeConfig(xml.c_str(), config) && writePointCloud(ply.c_str(), config) && writeMesh(mesh.c_str(), config, nFaces);
+	Benchmark::syntheticImage(config.seed, pnX, pnY, 32, image);
+	bOK = bOK && writeImage(img.c_str(), pnX, pnY, image.data());
+	Benchmark::syntheticImage(config.seed + 1, pnX, pnY, 0, image);
+	bOK = bOK && writeImage(depth.c_str(), pnX, pnY, image.data());
+	for (int i = 0; i < LF_VIEWS * LF_VIEWS && bOK; i++) {
+		char name[32];
+		sprintf(name, "lf/lf_%03d.bmp", i);
+		Benchmark::syntheticImage(config.seed + 2 + i, pnX / LF_VIEWS, pnY / LF_VIEWS, 32, image);
+		bOK = writeImage(path(config, name).c_str(), pnX / LF_VIEWS, pnY / LF_VIEWS, image.data());
+	}
+	if (!bOK) {
+		LOG("<FAILED> Benchmark inputs : %s\n", config.workDir.c_str());
+		return false;
+	}
+
+	// generators are created and loaded by the first prepare, the timed runs only generate.
+	auto pc = std::make_shared<std::shared_ptr<ophPointCloud>>();
+	auto loadPC = [pc, xml, ply]() {
+		if (*pc) return true;
+		*pc = createGenerator<ophPointCloud>();
+		return (*pc)->readConfig(xml.c_str()) && (*pc)->loadPointCloud(ply.c_str()) > 0;
+	};
+	bench.add("pointcloud_rs", "points", loadPC, [pc]() {
+		(*pc)->generateHologram(ophPointCloud::PC_DIFF_RS);
+		return (ulonglong)(*pc)->getNumberOfPoints();
+	});
+	bench.add("pointcloud_fresnel", "points", loadPC, [pc]() {
+		(*pc)->generateHologram(ophPointCloud::PC_DIFF_FRESNEL);
+		return (ulonglong)(*pc)->getNumberOfPoints();
+	});
+
+	auto dm = std::make_shared<std::shared_ptr<ophDepthMap>>();
+	const std::string dir = config.workDir;
+	bench.add("depthmap", "pixels", [dm, xml, dir]() {
+		if (*dm) return true;
+		*dm = createGenerator<ophDepthMap>();
+		return (*dm)->readConfig(xml.c_str()) && (*dm)->readImageDepth(dir.c_str(), "img", "depth");
+	}, [dm, pnXY]() {
+		(*dm)->generateHologram();
+		return pnXY;
+	});
+
+	auto wrp = std::make_shared<std::shared_ptr<ophWRP>>();
+	bench.add("wrp", "points", [wrp, xml, ply]() {
+		if (*wrp) return true;
+		*wrp = createGenerator<ophWRP>();
+		return (*wrp)->readConfig(xml.c_str()) && (*wrp)->loadPointCloud(ply.c_str()) > 0;
+	}, [wrp]() {
+		(*wrp)->generateHologram();
+		return (ulonglong)(*wrp)->getNumOfPoints();
+	});
+
+	auto tri = std::make_shared<std::shared_ptr<ophTri>>();
+	auto loadTri = [tri, xml, mesh]() {
+		if (*tri) return true;
+		*tri = createGenerator<ophTri>();
+		return (*tri)->readConfig(xml.c_str()) && (*tri)->loadMeshData(mesh.c_str(), "ply");
+	};
+	bench.add("tri_flat", "faces", loadTri, [tri, nFaces]() {
+		(*tri)->generateHologram(ophTri::SHADING_FLAT);
+		return (ulonglong)nFaces;
+	});
+	bench.add("tri_continuous", "faces", loadTri, [tri, nFaces]() {
+		(*tri)->generateHologram(ophTri::SHADING_CONTINUOUS);
+		return (ulonglong)nFaces;
+	});
+
+	auto lf = std::make_shared<std::shared_ptr<ophLF>>();
+	const std::string lfDir = path(config, "lf");
+	bench.add("lightfield", "pixels", [lf, xml, lfDir]() {
+		if (*lf) return true;
+		*lf = createGenerator<ophLF>();
+		return (*lf)->readConfig(xml.c_str()) && (*lf)->loadLF(lfDir.c_str(), "bmp") > 0;
+	}, [lf, pnXY]() {
+		(*lf)->generateHologram();
+		return pnXY;
+	});
+
+	auto ifta = std::make_shared<std::shared_ptr<ophIFTA>>();
+	bench.add("ifta", "pixels", [ifta, xml, img, depth]() {
+		if (*ifta) return true;
+		*ifta = createGenerator<ophIFTA>();
+		return (*ifta)->readConfig(xml.c_str()) && (*ifta)->readImage(img.c_str(), true) && (*ifta)->readImage(depth.c_str(), false);
+	}, [ifta, pnXY]() {
+		(*ifta)->generateHologram();
+		return pnXY;
+	});
+
+	auto pas = std::make_shared<std::shared_ptr<ophPAS>>();
+	bench.add("pas", "points", [pas, xml, ply]() {
+		if (*pas) return true;
+		*pas = createGenerator<ophPAS>();
+		(*pas)->cgh_fringe = nullptr;
+		return (*pas)->readConfig(xml.c_str()) && (*pas)->loadPoint(ply.c_str()) > 0;
+	}, [pas, config]() {
+		(*pas)->generateHologram();
+		return config.nPoints;
+	}, [pas]() {
+		delete[] (*pas)->cgh_fringe;
+		(*pas)->cgh_fringe = nullptr;
+	});
+
+	addACPASCases(bench, xml, ply);
+	addLUTCases(bench);
+	addASCases(bench);
+
+	// encoders and normalization of the point-cloud hologram.
+	const ulonglong nEncode = pnXY * (config.nChannels == 3 ? 3 : 1);
+	auto bGenerated = std::make_shared<bool>(false);
+	auto loadHolo = [pc, loadPC, bGenerated]() {
+		if (*bGenerated) return true;
+		if (!loadPC()) return false;
+		(*pc)->generateHologram(ophPointCloud::PC_DIFF_RS);
+		*bGenerated = true;
+		return true;
+	};
+	const struct { const char* name; uint flag; } encoders[] = {
+		{ "encode_phase", ophGen::ENCODE_PHASE },
+		{ "encode_amplitude", ophGen::ENCODE_AMPLITUDE },
+		{ "encode_real", ophGen::ENCODE_REAL },
+		{ "encode_simpleni", ophGen::ENCODE_SIMPLENI },
+		{ "encode_burckhardt", ophGen::ENCODE_BURCKHARDT },
+		{ "encode_twophase", ophGen::ENCODE_TWOPHASE },
+		{ "encode_symmetrization", ophGen::ENCODE_SYMMETRIZATION },
+	};
+	for (auto& encoder : encoders) {
+		const uint flag = encoder.flag;
+		bench.add(encoder.name, "pixels", loadHolo, [pc, flag, nEncode]() {
+			(*pc)->encoding(flag);
+			return nEncode;
+		});
+	}
+	bench.add("encode_ssb", "pixels", loadHolo, [pc, nEncode]() {
+		(*pc)->encoding(ophGen::ENCODE_SSB, ophGen::SSB_TOP);
+		return nEncode;
+	});
+
+	// SSB again after a depth map is configured and released : the cached FFT plans must survive both,
+	// and the encoded field must match the one encoded before.
+	const int nChannel = config.nChannels == 3 ? 3 : 1;
+	auto ssbRef = std::make_shared<std::vector<Real>>();
+	auto copySSB = [pc, nChannel](std::vector<Real>& dst) {
+		const ivec2& size = (*pc)->getEncodeSize();
+		const ulonglong nXY = (ulonglong)size[_X] * size[_Y];
+		dst.resize(nXY * nChannel);
+		for (int ch = 0; ch < nChannel; ch++)
+			memcpy(dst.data() + nXY * ch, (*pc)->getEncodedBuffer()[ch], sizeof(Real) * nXY);
+	};
+	bench.add("encode_ssb_reuse", "pixels", [loadHolo, pc, ssbRef, copySSB, xml]() {
+		if (!loadHolo()) return false;
+		(*pc)->encoding(ophGen::ENCODE_SSB, ophGen::SSB_TOP);
+		copySSB(*ssbRef);
+		auto other = createGenerator<ophDepthMap>();
+		return other->readConfig(xml.c_str());
+	}, [pc, ssbRef, copySSB, nEncode]() {
+		(*pc)->encoding(ophGen::ENCODE_SSB, ophGen::SSB_TOP);
+		std::vector<Real> encoded;
+		copySSB(encoded);
+		return encoded == *ssbRef ? nEncode : 0;
+	});
+	bench.add("normalize", "pixels", loadHolo, [pc, nEncode]() {
+		(*pc)->normalize();
+		return nEncode;
+	});
+	return true;
+}
@@ -0,0 +1,103 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __ophGenBenchmark_h
+#define __ophGenBenchmark_h
+
+#include "ophGen.h"
+#include "Benchmark.h"
+
+/**
+* @ingroup gen
+* @brief Benchmark cases of the hologram generators and the encoders on the CPU.
+* @details Inputs are synthetic and seeded by the BenchmarkConfig : a point cloud of nPoints, a triangle mesh of
+*			nPoints / 100 faces, image & depth map, light field of 8 x 8 views and an XML configuration holding the
+*			parameters of every generator. They are written to the workDir of the config and loaded before the
+*			timed runs.@n
+*			Cases : pointcloud_rs, pointcloud_fresnel, depthmap, wrp, tri_flat, tri_continuous, lightfield, ifta,
+*			pas, acpas, lut, encode_* and normalize. as_1k, as_2k and as_4k time the angular spectrum propagation of
+*			ophAS at 1024, 2048 and 4096 pixels square, whatever the resolution of the config. encode_ssb_reuse
+*			encodes SSB after a depth map was configured and released, and fails when the result differs.
+*
+* @code
+*	BenchmarkConfig config;
+*	config.nPoints = 50000;
+*	Benchmark bench(config);
+*	ophGenBenchmark::addCases(bench);
+*	bench.run();
+*	bench.exportJSON("benchmark.json");
+* @endcode
+*/
+class GEN_DLL ophGenBenchmark
+{
+public:
+	/**
+	* @brief Write the synthetic inputs and add the cases to bench.
+	*/
+	static bool addCases(Benchmark& bench);
+
+	static bool writeConfig(const char* fname, const BenchmarkConfig& config);
+	/**
+	* @brief ASCII PLY point cloud, gray colors when config.nChannels is 1.
+	*/
+	static bool writePointCloud(const char* fname, const BenchmarkConfig& config);
+	/**
+	* @brief ASCII PLY triangle mesh in the layout of PLYparser : three vertices per face.
+	*/
+	static bool writeMesh(const char* fname, const BenchmarkConfig& config, int nFaces);
+	/**
+	* @brief 8-bit gray BMP.
+	*/
+	static bool writeImage(const char* fname, int width, int height, const uchar* image);
+
+private:
+	/// ophACPAS and ophLUT declare their own VoxelStruct, so their cases are built in separate files.
+	static void addACPASCases(Benchmark& bench, const std::string& xml, const std::string& ply);
+	static void addLUTCases(Benchmark& bench);
+	/// ophAS brings the coder arrays of the angular spectrum code.
+	static void addASCases(Benchmark& bench);
+};
+
+#endif // !__ophGenBenchmark_h
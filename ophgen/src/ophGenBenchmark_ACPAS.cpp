@@ -0,0 +1,87 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophGenBenchmark.h"
+#include "ophACPAS.h"
+
+void ophGenBenchmark::addACPASCases(Benchmark& bench, const std::string& xml, const std::string& ply)
+{
+	struct State {
+		ophACPAS* gen;
+		OphPointCloudConfig conf;
+		OphPointCloudData data;
+		int n_points;
+		std::vector<uchar> fringe;
+
+		State() : gen(nullptr), n_points(0) {}
+		~State() {
+			delete[] data.vertex;
+			delete[] data.color;
+			delete[] data.phase;
+			if (gen) gen->release();
+		}
+	};
+	auto state = std::make_shared<State>();
+
+	bench.add("acpas", "points", [state, xml, ply]() {
+		if (state->gen) return true;
+		state->gen = new ophACPAS();
+		state->gen->m_pHologram = nullptr;
+		// ophACPAS::readConfig sets the first wavelength only, ophGen::readConfig allocates them.
+		if (!static_cast<ophGen*>(state->gen)->readConfig(xml.c_str()) || !state->gen->readConfig(xml.c_str(), state->conf))
+			return false;
+		state->n_points = state->gen->loadPointCloud(ply.c_str(), &state->data);
+		const ivec2 pn = state->gen->getContext().pixel_number;
+		state->fringe.resize((size_t)pn[_X] * pn[_Y]);
+		return state->n_points > 0;
+	}, [state]() {
+		state->gen->ACPASCalcuation(state->n_points, state->fringe.data(), &state->data, state->conf);
+		return (ulonglong)state->n_points;
+	}, [state]() {
+		// DataInit allocates the hologram on every calculation.
+		delete[] state->gen->m_pHologram;
+		state->gen->m_pHologram = nullptr;
+	});
+}
@@ -0,0 +1,80 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophGenBenchmark.h"
+#include "ophAS.h"
+
+void ophGenBenchmark::addASCases(Benchmark& bench)
+{
+	struct State {
+		ophAS* gen;
+		coder::array<creal_T, 2U> fringe;
+		coder::array<creal_T, 2U> field;
+
+		State() : gen(nullptr) {}
+		~State() { if (gen) gen->release(); }
+	};
+	const Real wavelength = 532e-9;
+	const Real pitch = 8e-6;
+	const Real depth = -500e-3;
+
+	// the angular spectrum propagation of ophAS at fixed sizes, its field is the fringe of one point.
+	const int sizes[] = { 1024, 2048, 4096 };
+	for (int n : sizes) {
+		auto state = std::make_shared<State>();
+		char name[16];
+		sprintf(name, "as_%dk", n / 1024);
+		bench.add(name, "pixels", [state, n, wavelength, pitch]() {
+			if (state->gen) return true;
+			state->gen = new ophAS();
+			state->fringe.set_size(n, n);
+			state->gen->RayleighSommerfield(n, n, wavelength, 2 * M_PI / wavelength, pitch, pitch, 0.1, state->fringe);
+			return true;
+		}, [state, n, wavelength, pitch, depth]() {
+			state->gen->AngularSpectrum(n, n, wavelength, 2 * M_PI / wavelength, pitch, pitch, depth, state->fringe, state->field);
+			return (ulonglong)n * n;
+		});
+	}
+}
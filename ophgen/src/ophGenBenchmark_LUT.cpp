@@ -0,0 +1,104 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophGenBenchmark.h"
+#include "ophLUT.h"
+
+void ophGenBenchmark::addLUTCases(Benchmark& bench)
+{
+	struct State {
+		ophLUT* gen;
+		CGHEnvironmentData env;
+		std::vector<VoxelStruct> voxels;
+		std::vector<uchar> fringe;
+
+		State() : gen(nullptr) {}
+		~State() { if (gen) gen->release(); }
+	};
+	auto state = std::make_shared<State>();
+	const BenchmarkConfig config = bench.getConfig();
+
+	// the LUT generator takes its environment and voxels in memory, with the segment sizes of ophACPAS.
+	bench.add("lut", "points", [state, config]() {
+		if (state->gen) return true;
+		state->gen = new ophLUT();
+		state->gen->m_pHologram = nullptr;
+
+		CGHEnvironmentData& env = state->env;
+		env.CghWidth = config.resolution[_X];
+		env.CghHeight = config.resolution[_Y];
+		env.SegmentationSize = 8;
+		env.fftSegmentationSize = 64;
+		env.rWaveLength = 532e-9f;
+		env.rWaveNumber = (float)(M2_PI / env.rWaveLength);
+		env.ThetaX = env.ThetaY = 0.0f;
+		env.DefaultDepth = 0.1f;
+		env.xInterval = env.yInterval = 8e-6f;
+		env.xiInterval = env.etaInterval = 8e-6f;
+		env.CGHScale = 0.002f;
+
+		std::vector<Real> vertex, color;
+		Benchmark::randomPoints(config.seed, config.nPoints, 1, vertex, color);
+		state->voxels.resize(config.nPoints);
+		for (ulonglong i = 0; i < config.nPoints; i++) {
+			VoxelStruct& voxel = state->voxels[i];
+			voxel.num = (int)i;
+			voxel.x = (float)vertex[i * 3 + 0];
+			voxel.y = (float)vertex[i * 3 + 1];
+			voxel.z = (float)vertex[i * 3 + 2];
+			voxel.ph = 0.0f;
+			voxel.r = (float)color[i];
+		}
+		state->fringe.resize((size_t)env.CghWidth * env.CghHeight);
+		return true;
+	}, [state]() {
+		state->gen->LUTCalcuation((long)state->voxels.size(), state->fringe.data(), state->voxels.data(), &state->env);
+		return (ulonglong)state->voxels.size();
+	}, [state]() {
+		// DataInit allocates the hologram on every calculation.
+		delete[] state->gen->m_pHologram;
+		state->gen->m_pHologram = nullptr;
+	});
+}
@@ -0,0 +1,323 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophGenGolden.h"
+#include "ophGenBenchmark.h"
+#include "ophPointCloud.h"
+#include "ophDepthMap.h"
+#include "ophWRP.h"
+#include "ophTriMesh.h"
+#include "sys.h"
+
+namespace {
+	const struct { const char* name; GoldenTolerance tolerance; } tolerances[] = {
+		// the phase k * r of a point is ~1e6 rad, single precision keeps it to a few 1e-2 rad.
+		{ "pointcloud", GoldenTolerance(1e-2, 40.0, 5e-2) },
+		{ "wrp", GoldenTolerance(1e-2, 40.0, 5e-2) },
+		{ "depthmap", GoldenTolerance(1e-3, 50.0, 1e-2) },
+		{ "tri", GoldenTolerance(1e-3, 50.0, 1e-2) },
+		// wrapped phases may jump by 2 pi on a few samples.
+		{ "encode_phase", GoldenTolerance(1e-2, 30.0, -1) },
+		{ "encode", GoldenTolerance(1e-3, 50.0, -1) },
+	};
+
+	const struct { const char* name; uint flag; } encoders[] = {
+		{ "encode_phase", ophGen::ENCODE_PHASE },
+		{ "encode_amplitude", ophGen::ENCODE_AMPLITUDE },
+		{ "encode_real", ophGen::ENCODE_REAL },
+		{ "encode_simpleni", ophGen::ENCODE_SIMPLENI },
+		{ "encode_burckhardt", ophGen::ENCODE_BURCKHARDT },
+		{ "encode_twophase", ophGen::ENCODE_TWOPHASE },
+		{ "encode_symmetrization", ophGen::ENCODE_SYMMETRIZATION },
+	};
+
+	/**
+	* @brief Stores the buffers of a capture, or compares them with the stored ones.
+	*/
+	class Session
+	{
+	public:
+		Session(const std::string& dir, std::vector<GoldenError>* errors) : dir(dir), errors(errors), bOK(true) {}
+
+		void field(const char* name, ophGen* gen);
+		void encoded(const char* name, ophGen* gen);
+		/// the scene could not be generated.
+		void fail(const char* name);
+		bool isOK(void) const { return bOK; }
+
+	private:
+		std::string path(const char* name) const { return dir + "/" + name + ".golden"; }
+		GoldenError create(const char* name) const;
+		void add(GoldenError& error);
+
+		std::string dir;
+		std::vector<GoldenError>* errors;	///< nullptr : capture
+		bool bOK;
+	};
+
+	GoldenError Session::create(const char* name) const
+	{
+		GoldenError error;
+		error.name = name;
+		error.bPass = false;
+		error.relL2 = 0;
+		error.psnr = GoldenReference::PSNR_MAX;
+		error.phase = 0;
+		error.tolerance = ophGenGolden::getTolerance(name);
+		return error;
+	}
+
+	void Session::add(GoldenError& error)
+	{
+		GoldenReference::check(error);
+		LOG("[Golden] %s : relL2 %e, PSNR %.2f dB, phase %e : %s\n", error.name.c_str(),
+			error.relL2, error.psnr, error.phase, error.bPass ? "pass" : "FAIL");
+		bOK = bOK && error.bPass;
+		errors->push_back(error);
+	}
+
+	void Session::fail(const char* name)
+	{
+		LOG("<FAILED> Golden scene : %s\n", name);
+		bOK = false;
+		if (!errors) return;
+
+		GoldenError error = create(name);
+		error.relL2 = 1;
+		error.psnr = 0;
+		error.phase = M_PI;
+		add(error);
+	}
+
+	void Session::field(const char* name, ophGen* gen)
+	{
+		const int nChannels = (int)gen->getContext().waveNum;
+		const ivec2 size = gen->getContext().pixel_number;
+		Complex<Real>** field = gen->getComplexField();
+		if (!errors) {
+			bOK = GoldenReference::save(path(name).c_str(), field, nChannels, size) && bOK;
+			return;
+		}
+
+		std::vector<Complex<Real>> ref;
+		int nRef;
+		ivec2 sizeRef;
+		if (!GoldenReference::load(path(name).c_str(), ref, nRef, sizeRef) || nRef != nChannels || sizeRef != size) {
+			fail(name);
+			return;
+		}
+
+		GoldenError error = create(name);
+		const ulonglong n = (ulonglong)size[_X] * size[_Y];
+		std::vector<Real> intensityRef, intensityTest;
+		for (int ch = 0; ch < nChannels; ch++) {
+			Complex<Real>* channel = ref.data() + n * ch;
+			error.relL2 = max(error.relL2, GoldenReference::relativeL2(channel, field[ch], n));
+			error.phase = max(error.phase, GoldenReference::maxPhaseError(channel, field[ch], n));
+
+			GoldenReference::reconstruct(channel, size, intensityRef);
+			GoldenReference::reconstruct(field[ch], size, intensityTest);
+			error.psnr = min(error.psnr, GoldenReference::psnr(intensityRef.data(), intensityTest.data(), n));
+		}
+		add(error);
+	}
+
+	void Session::encoded(const char* name, ophGen* gen)
+	{
+		const int nChannels = (int)gen->getContext().waveNum;
+		const ivec2 size = gen->getEncodeSize();
+		Real** data = gen->getEncodedBuffer();
+		if (!errors) {
+			bOK = GoldenReference::save(path(name).c_str(), data, nChannels, size) && bOK;
+			return;
+		}
+
+		std::vector<Real> ref;
+		int nRef;
+		ivec2 sizeRef;
+		if (!GoldenReference::load(path(name).c_str(), ref, nRef, sizeRef) || nRef != nChannels || sizeRef != size) {
+			fail(name);
+			return;
+		}
+
+		GoldenError error = create(name);
+		const ulonglong n = (ulonglong)size[_X] * size[_Y];
+		for (int ch = 0; ch < nChannels; ch++) {
+			error.relL2 = max(error.relL2, GoldenReference::relativeL2(ref.data() + n * ch, data[ch], n));
+			error.psnr = min(error.psnr, GoldenReference::psnr(ref.data() + n * ch, data[ch], n));
+		}
+		add(error);
+	}
+}
+
+BenchmarkConfig ophGenGolden::getSceneConfig(const char* dir)
+{
+	BenchmarkConfig config;
+	config.seed = 1234;
+	config.nPoints = 2000;
+	config.resolution = ivec2(256, 256);
+	config.nLayers = 16;
+	config.nChannels = 1;
+	config.workDir = std::string(dir) + "/input";
+	return config;
+}
+
+GoldenTolerance ophGenGolden::getTolerance(const char* name)
+{
+	const std::string str(name);
+	for (auto& t : tolerances) {
+		if (str.compare(0, strlen(t.name), t.name) == 0)
+			return t.tolerance;
+	}
+	return GoldenTolerance();
+}
+
+bool ophGenGolden::capture(const char* dir)
+{
+	return process(dir, nullptr);
+}
+
+bool ophGenGolden::verify(const char* dir, std::vector<GoldenError>& errors)
+{
+	errors.clear();
+	return process(dir, &errors);
+}
+
+bool ophGenGolden::process(const char* dir, std::vector<GoldenError>* errors)
+{
+	const BenchmarkConfig config = getSceneConfig(dir);
+	const std::string input = config.workDir;
+	if (!Benchmark::makeDirectory(dir) || !Benchmark::makeDirectory(input.c_str())) {
+		LOG("<FAILED> Golden directory : %s\n", dir);
+		return false;
+	}
+
+	// the inputs are written again on every call, they only depend on the seed.
+	const int pnX = config.resolution[_X];
+	const int pnY = config.resolution[_Y];
+	const int nFaces = config.nPoints / 100 < 16 ? 16 : (int)(config.nPoints / 100);
+	const std::string xml = input + "/config.xml";
+	const std::string ply = input + "/pointcloud.ply";
+	const std::string mesh = input + "/mesh.ply";
+
+	std::vector<uchar> image;
+	bool bOK = ophGenBenchmark::writeConfig(xml.c_str(), config) && ophGenBenchmark::writePointCloud(ply.c_str(), config) &&
+		ophGenBenchmark::writeMesh(mesh.c_str(), config, nFaces);
+	Benchmark::syntheticImage(config.seed, pnX, pnY, 32, image);
+	bOK = bOK && ophGenBenchmark::writeImage((input + "/img.bmp").c_str(), pnX, pnY, image.data());
+	Benchmark::syntheticImage(config.seed + 1, pnX, pnY, 0, image);
+	bOK = bOK && ophGenBenchmark::writeImage((input + "/depth.bmp").c_str(), pnX, pnY, image.data());
+	if (!bOK) {
+		LOG("<FAILED> Golden inputs : %s\n", input.c_str());
+		return false;
+	}
+
+	Session session(dir, errors);
+
+	// the encoders run on the Rayleigh-Sommerfeld field, generated last.
+	// the references are made from the PLY parser, never from a cache left in the input directory.
+	ophPointCloud* pc = new ophPointCloud();
+	pc->setPointCloudCache(false);
+	if (pc->readConfig(xml.c_str()) && pc->loadPointCloud(ply.c_str()) > 0) {
+		pc->generateHologram(ophPointCloud::PC_DIFF_FRESNEL);
+		session.field("pointcloud_fresnel", pc);
+		pc->generateHologram(ophPointCloud::PC_DIFF_RS);
+		session.field("pointcloud_rs", pc);
+		for (auto& encoder : encoders) {
+			pc->encoding(encoder.flag);
+			session.encoded(encoder.name, pc);
+		}
+		pc->encoding(ophGen::ENCODE_SSB, ophGen::SSB_TOP);
+		session.encoded("encode_ssb", pc);
+	}
+	else
+		session.fail("pointcloud");
+	pc->release();
+
+	ophDepthMap* dm = new ophDepthMap();
+	if (dm->readConfig(xml.c_str()) && dm->readImageDepth(input.c_str(), "img", "depth")) {
+		dm->generateHologram();
+		session.field("depthmap", dm);
+	}
+	else
+		session.fail("depthmap");
+	dm->release();
+
+	ophWRP* wrp = new ophWRP();
+	wrp->setPointCloudCache(false);
+	if (wrp->readConfig(xml.c_str()) && wrp->loadPointCloud(ply.c_str()) > 0) {
+		wrp->generateHologram();
+		session.field("wrp", wrp);
+	}
+	else
+		session.fail("wrp");
+	wrp->release();
+
+	ophTri* tri = new ophTri();
+	if (tri->readConfig(xml.c_str()) && tri->loadMeshData(mesh.c_str(), "ply")) {
+		tri->generateHologram(ophTri::SHADING_FLAT);
+		session.field("tri_flat", tri);
+		tri->generateHologram(ophTri::SHADING_CONTINUOUS);
+		session.field("tri_continuous", tri);
+	}
+	else
+		session.fail("tri");
+	tri->release();
+
+	// SSB once more, after a depth map was configured and the other generators released,
+	// on the FFT plans cached by the first encode.
+	pc = new ophPointCloud();
+	pc->setPointCloudCache(false);
+	if (pc->readConfig(xml.c_str()) && pc->loadPointCloud(ply.c_str()) > 0) {
+		pc->generateHologram(ophPointCloud::PC_DIFF_RS);
+		pc->encoding(ophGen::ENCODE_SSB, ophGen::SSB_TOP);
+		session.encoded("encode_ssb_reuse", pc);
+	}
+	else
+		session.fail("encode_ssb_reuse");
+	pc->release();
+
+	return session.isOK();
+}
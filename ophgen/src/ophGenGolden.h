@@ -0,0 +1,95 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#ifndef __ophGenGolden_h
+#define __ophGenGolden_h
+
+#include "ophGen.h"
+#include "Benchmark.h"
+#include "GoldenReference.h"
+
+/**
+* @ingroup gen
+* @brief Golden-reference check of the generators and the encoders.
+* @details capture() generates a fixed set of seeded scenes with the current CPU implementation and stores
+*			complex_H of each one and m_lpEncoded of every encoder in a directory. After a kernel is optimized,
+*			verify() generates the same scenes again and compares each buffer with its reference within the
+*			tolerance of its algorithm.@n
+*			Scenes : pointcloud_rs, pointcloud_fresnel, depthmap, wrp, tri_flat, tri_continuous, and the
+*			encoders on pointcloud_rs. encode_ssb_reuse encodes SSB again after the other generators were released.
+*			ophLF and ophIFTA are left out, their random phase is seeded by the time.
+*
+* @code
+*	ophGenGolden::capture("golden");			// once, on the reference build
+*	std::vector<GoldenError> errors;
+*	bool bPass = ophGenGolden::verify("golden", errors);
+*	GoldenReference::exportJSON("golden.json", errors);
+* @endcode
+*/
+class GEN_DLL ophGenGolden
+{
+public:
+	/**
+	* @brief Inputs of the scenes : 256 x 256, 2000 points, 16 depth layers, one channel, seed 1234.
+	*/
+	static BenchmarkConfig getSceneConfig(const char* dir);
+	/**
+	* @brief Tolerance of an algorithm, wide enough for single precision and reordered sums.
+	*/
+	static GoldenTolerance getTolerance(const char* name);
+
+	static bool capture(const char* dir);
+	/**
+	* @param[out] errors one entry per buffer : the scene name, or encode_* for the encoded buffers
+	* @return Type: <B>bool</B>\n
+	*				If every buffer is within its tolerance, the return value is <B>true</B>.
+	*/
+	static bool verify(const char* dir, std::vector<GoldenError>& errors);
+
+private:
+	static bool process(const char* dir, std::vector<GoldenError>* errors);
+};
+
+#endif // !__ophGenGolden_h
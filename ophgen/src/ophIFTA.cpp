@@ -30,6 +30,7 @@ ophIFTA::~ophIFTA()
 using namespace oph;
 Real ophIFTA::generateHologram()
 {
+	OPH_PROFILE("generate");
 	if ((!imgRGB && m_config.num_of_depth == 1) || (!imgRGB && !imgDepth))
 		return 0.0;
 
@@ -8,6 +8,7 @@
 #include <windows.h>
 
 #include "sys.h"
+#include "ophFFT.h"
 
 //CGHEnvironmentData CONF;	// config
 
@@ -361,7 +362,10 @@ void ophLUT::APAS(long voxelnum, VoxelStruct * _h_vox, CGHEnvironmentData * _CGH
 		}
 	}
 
-	plan = fftw_plan_dft_2d(FFTsegSize, FFTsegSize, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		plan = fftw_plan_dft_2d(FFTsegSize, FFTsegSize, in, out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	}
 
 	for (segy = 0; segy<segNumy; segy++) {
 		for (segx = 0; segx<segNumx; segx++) {
@@ -391,7 +395,10 @@ void ophLUT::APAS(long voxelnum, VoxelStruct * _h_vox, CGHEnvironmentData * _CGH
 	//mm.Format("%f", duration);
 	//AfxMessageBox(mm);
 
-	fftw_destroy_plan(plan);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(plan);
+	}
 	fftw_free(in);
 	fftw_free(out);
 	delete[] SFrequency_cx;
@@ -47,6 +47,8 @@
 #include "include.h"
 #include "sys.h"
 #include "tinyxml2.h"
+#include "ImgSequence.h"
+#include "ophFFT.h"
 
 #define for_i(itr, oper) for(int i=0; i<itr; i++){ oper }
 
@@ -58,6 +60,9 @@ ophLF::ophLF(void)
 	, is_ViewingWindow(false)
 	, LF(nullptr)
 	, RSplane_complex_field(nullptr)
+	, RSplaneSize(0)
+	, viewBuf(nullptr)
+	, viewBufSize(0)
 	, bSinglePrecision(false)
 {
 	LOG("*** LIGHT FIELD : BUILD DATE: %s %s ***\n\n", __DATE__, __TIME__);
@@ -137,108 +142,63 @@ int ophLF::loadLF(const char* directory, const char* exten)
 
 	initializeLF();
 
-	_finddata_t data;
-
-	string sdir = std::string(LF_directory).append("\\").append("*.").append(ext);
-	intptr_t ff = _findfirst(sdir.c_str(), &data);
-	if (ff != -1)
-	{
-		int num = 0;
-		uchar* rgbOut;
-		ivec2 sizeOut;
-		int bytesperpixel;
-
-		while (1)
-		{
-			string imgfullname = std::string(LF_directory).append("\\").append(data.name);
-
-			getImgSize(sizeOut[_X], sizeOut[_Y], bytesperpixel, imgfullname.c_str());
-
-			rgbOut = loadAsImg(imgfullname.c_str());
-
-			if (rgbOut == 0) {
-				cout << "LF load was failed." << endl;
-				return -1;
-			}
-
-			convertToFormatGray8(rgbOut, *(LF + num), sizeOut[_X], sizeOut[_Y], bytesperpixel);
-			delete[] rgbOut; // solved memory leak.
-			num++;
-
-			int out = _findnext(ff, &data);
-			if (out == -1)
-				break;
-		}
-		_findclose(ff);
-		cout << "LF load was successed." << endl;
-
-		if (num_image[_X] * num_image[_Y] != num) {
-			cout << "num_image is not matched." << endl;
-		}
-		return 1;
-	}
-	else
+	int num = loadLFImages();
+	if (num <= 0)
 	{
 		cout << "LF load was failed." << endl;
 		return -1;
 	}
+	cout << "LF load was successed." << endl;
+
+	if (num_image[_X] * num_image[_Y] != num) {
+		cout << "num_image is not matched." << endl;
+	}
+	return 1;
 }
 
 int ophLF::loadLF()
 {
 	initializeLF();
 
-	_finddata_t data;
-
-	string sdir = std::string("./").append(LF_directory).append("/").append("*.").append(ext);
-	intptr_t ff = _findfirst(sdir.c_str(), &data);
-	if (ff != -1)
-	{
-		int num = 0;
-		uchar* rgbOut;
-		ivec2 sizeOut;
-		int bytesperpixel;
-
-		while (1)
-		{
-			string imgfullname = std::string(LF_directory).append("/").append(data.name);
-
-			getImgSize(sizeOut[_X], sizeOut[_Y], bytesperpixel, imgfullname.c_str());
-			rgbOut = loadAsImg(imgfullname.c_str());
-
-			if (rgbOut == 0) {
-				cout << "LF load was failed." << endl;
-				cin.get();
-				return -1;
-			}
-
-			convertToFormatGray8(rgbOut, *(LF + num), sizeOut[_X], sizeOut[_Y], bytesperpixel);
-
-			num++;
-
-			int out = _findnext(ff, &data);
-			if (out == -1)
-				break;
-		}
-		_findclose(ff);
-		cout << "LF load was successed." << endl;
-
-		if (num_image[_X] * num_image[_Y] != num) {
-			cout << "num_image is not matched." << endl;
-			cin.get();
-		}
-		return 1;
-	}
-	else
+	int num = loadLFImages();
+	if (num <= 0)
 	{
 		cout << "LF load was failed." << endl;
 		cin.get();
 		return -1;
 	}
+	cout << "LF load was successed." << endl;
+
+	if (num_image[_X] * num_image[_Y] != num) {
+		cout << "num_image is not matched." << endl;
+		cin.get();
+	}
+	return 1;
+}
+
+int ophLF::loadLFImages()
+{
+	std::vector<std::string> files = ImgSequence::scan(LF_directory, "", ext);
+	if (files.empty()) return 0;
+	// images beyond num_image have no buffer.
+	if ((int)files.size() > nImages) files.resize(nImages);
+
+	std::vector<ImgFrame> frames;
+	ImgSequence::loadAll(files, frames, true, false);
+
+	const size_t nSize = (size_t)resolution_image[_X] * resolution_image[_Y];
+	for (size_t i = 0; i < frames.size(); i++) {
+		if (frames[i].pixels.empty()) return -1;
+		if (frames[i].pixels.size() != nSize)
+			LOG("Warning: %s is not %dx%d.\n", files[i].c_str(), resolution_image[_X], resolution_image[_Y]);
+		memcpy(LF[i], frames[i].pixels.data(), frames[i].pixels.size() < nSize ? frames[i].pixels.size() : nSize);
+	}
+	return (int)files.size();
 }
 
 void ophLF::generateHologram() 
 {
+	OPH_PROFILE("generate");
 	resetBuffer();
 
 	LOG("1) Algorithm Method : Light Field\n");
@@ -303,6 +263,21 @@ void ophLF::initializeLF()
 }
 
 
+void ophLF::ophFree(void)
+{
+	ophGen::ophFree();
+	if (RSplane_complex_field) {
+		delete[] RSplane_complex_field;
+		RSplane_complex_field = nullptr;
+		RSplaneSize = 0;
+	}
+	if (viewBuf) {
+		delete[] viewBuf;
+		viewBuf = nullptr;
+		viewBufSize = 0;
+	}
+}
+
 void ophLF::convertLF2ComplexField()
 {
 	auto begin = CUR_TIME;
@@ -314,17 +289,23 @@ void ophLF::convertLF2ComplexField()
 	const uint rY = resolution_image[_Y];
 	const uint rXY = rX * rY;
 
-	if (RSplane_complex_field) {
-		delete[] RSplane_complex_field;
-		RSplane_complex_field = nullptr;
+	// reused across frames, reallocated only when the light field size changes.
+	if (RSplaneSize != nXY * rXY) {
+		if (RSplane_complex_field) delete[] RSplane_complex_field;
+		RSplane_complex_field = new Complex<Real>[nXY * rXY];
+		RSplaneSize = nXY * rXY;
 	}
-	RSplane_complex_field = new Complex<Real>[nXY * rXY];
 	memset(RSplane_complex_field, 0.0, sizeof(Complex<Real>) * nXY * rXY);
 
-	//Complex<Real>* complexLF = new Complex<Real>[rXY];
-	Complex<Real>* complexLF = new Complex<Real>[nXY];
-
-	Complex<Real>* FFTLF = new Complex<Real>[nXY];
+	if (viewBufSize != nXY) {
+		if (viewBuf) delete[] viewBuf;
+		viewBuf = new Complex<Real>[nXY * 2];
+		viewBufSize = nXY;
+	}
+	Complex<Real>* complexLF = viewBuf;
+	Complex<Real>* FFTLF = viewBuf + nXY;
+	// one cached plan for every ray sampling point.
+	ophFFT* fft = ophFFT::getInstance();
 
 	Real randVal;
 	Complex<Real> phase(0.0, 0.0);
@@ -344,8 +325,10 @@ void ophLF::convertLF2ComplexField()
 				}
 			}
 
-			fft2(num_image, complexLF, OPH_FORWARD, OPH_ESTIMATE);
-			fftwShift(complexLF, FFTLF, nX, nY, OPH_FORWARD);
+			// same as fftwShift(complexLF, FFTLF, nX, nY, OPH_FORWARD).
+			fftShift(nX, nY, complexLF, FFTLF);
+			fft->fft2(nX, nY, FFTLF, complexLF, OPH_FORWARD);
+			fftShift(nX, nY, complexLF, FFTLF);
 			//fftExecute(FFTLF);
 
 			for (int idxnX = 0; idxnX < nX; idxnX++) { // 10
@@ -364,8 +347,6 @@ void ophLF::convertLF2ComplexField()
 			idxImg++;
 		}
 	}
-	delete[] complexLF, FFTLF;
-	fftFree();
 	auto end = CUR_TIME;
 	LOG("\n%s : %lf(s)\n\n", __FUNCTION__, ((std::chrono::duration<Real>)(end - begin)).count());
 }
@@ -108,10 +108,15 @@ protected:
 	*/
 	virtual ~ophLF(void) {}
 
+	virtual void ophFree(void);
+
 private:
 
 	uchar** LF;										/// Light Field array / 4-D array
 	Complex<Real>* RSplane_complex_field;			/// Complex field in Ray Sampling plane
+	uint RSplaneSize;								/// allocated size of RSplane_complex_field, kept across frames
+	Complex<Real>* viewBuf;							/// two view-domain work buffers of num_image, kept across frames
+	uint viewBufSize;
 
 	// ==== GPU Variables ===============================================
 	bool		is_CPU;
@@ -204,6 +209,11 @@ protected:
 	// Inner functions
 
 	void initializeLF();
+	/**
+	* @brief Decode the LF source images of LF_directory concurrently into LF.
+	* @return number of loaded images, -1 if an image can not be loaded.
+	*/
+	int loadLFImages();
 	void convertLF2ComplexField();
 
 	// ==== GPU Methods ===============================================
@@ -8,6 +8,7 @@
 #include <windows.h>
 
 #include "sys.h"
+#include "ophFFT.h"
 
 #include "tinyxml2.h"
 #include "PLYparser.h"
@@ -637,14 +638,20 @@ void ophPAS::DataInit(int segsize, int cghwidth, int cghheight, float xiinter, f
 	for (i = 0; i<m_segNumx; i++)
 		m_xc[i] = ((i - m_hsegNumx) * m_segSize + m_hsegSize) * xiinter;
 
-	m_plan = fftw_plan_dft_2d(m_segSize, m_segSize, m_in, m_out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		m_plan = fftw_plan_dft_2d(m_segSize, m_segSize, m_in, m_out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	}
 }
 
 void ophPAS::MemoryRelease(void)
 {
 	int i, j;
 
-	fftw_destroy_plan(m_plan);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(m_plan);
+	}
 	fftw_free(m_in);
 	fftw_free(m_out);
 
@@ -670,6 +677,7 @@ void ophPAS::MemoryRelease(void)
 
 void ophPAS::generateHologram()
 {
+	OPH_PROFILE("generate");
 	
 	auto begin = CUR_TIME;
 	cgh_fringe = new unsigned char[context_.pixel_number[_X] * context_.pixel_number[_Y]];
@@ -8,6 +8,7 @@
 #include <windows.h>
 #include <cooperative_groups.h>
 #include "sys.h"
+#include "ophFFT.h"
 #include <cuda.h>
 
 #include <cuda_device_runtime_api.h>
@@ -740,7 +741,10 @@ void ophPAS_GPU::DataInit(int segsize, int cghwidth, int cghheight, float xiinte
 	for (i = 0; i<m_segNumx; i++)
 		m_xc[i] = ((i - m_hsegNumx) * m_segSize + m_hsegSize) * xiinter;
 
-	m_plan = fftw_plan_dft_2d(m_segSize, m_segSize, m_in, m_out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		m_plan = fftw_plan_dft_2d(m_segSize, m_segSize, m_in, m_out, FFTW_BACKWARD, FFTW_ESTIMATE);
+	}
 
 	sex = m_segNumx;
 	sey = m_segNumy;
@@ -752,7 +756,10 @@ void ophPAS_GPU::MemoryRelease(void)
 {
 	int i, j;
 
-	fftw_destroy_plan(m_plan);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(m_plan);
+	}
 	fftw_free(m_in);
 	fftw_free(m_out);
 
@@ -793,6 +800,7 @@ void ophPAS_GPU::MemoryRelease(void)
 
 void ophPAS_GPU::generateHologram()
 {
+	OPH_PROFILE("generate");
 
 	auto begin = CUR_TIME;
 	cgh_fringe = new unsigned char[context_.pixel_number[_X] * context_.pixel_number[_Y]];
@@ -48,6 +48,9 @@
 #include "tinyxml2.h"
 #include <sys.h>
 #include <cufft.h>
+#include <future>
+#include "PLYparser.h"
+#include "PointCloudCache.h"
 
 ophPointCloud::ophPointCloud(void)
 	: ophGen()
@@ -56,6 +59,12 @@ ophPointCloud::ophPointCloud(void)
 	, m_nProgress(0)
 	, n_points(-1)
 	, bSinglePrecision(false)
+	, bIncremental(false)
+	, incDiffFlag(PC_DIFF_RS)
+	, incRefreshInterval(0)
+	, incFrameCount(0)
+	, encodeBuf(nullptr)
+	, encodeBufSize(0)
 {
 	LOG("*** POINT CLOUD : BUILD DATE: %s %s ***\n\n", __DATE__, __TIME__);
 }
@@ -65,6 +74,12 @@ ophPointCloud::ophPointCloud(const char* pc_file, const char* cfg_file)
 	, is_CPU(true)
 	, is_ViewingWindow(false)
 	, m_nProgress(0)
+	, bIncremental(false)
+	, incDiffFlag(PC_DIFF_RS)
+	, incRefreshInterval(0)
+	, incFrameCount(0)
+	, encodeBuf(nullptr)
+	, encodeBufSize(0)
 {
 	n_points = loadPointCloud(pc_file);
 	if (n_points == -1) std::cerr << "OpenHolo Error : Failed to load Point Cloud Data File(*.dat)" << std::endl;
@@ -144,6 +159,7 @@ bool ophPointCloud::readConfig(const char* fname)
 
 Real ophPointCloud::generateHologram(uint diff_flag)
 {
+	OPH_PROFILE("generate");
 	if (diff_flag < PC_DIFF_RS || diff_flag > PC_DIFF_FRESNEL) {
 		LOG("Wrong Diffraction Method.\n");
 		return 0.0;
@@ -179,6 +195,100 @@ Real ophPointCloud::generateHologram(uint diff_flag)
 	return m_elapsedTime;
 }
 
+Real ophPointCloud::generateHologramStream(const char* pc_file, uint diff_flag, ulonglong batchSize)
+{
+	OPH_PROFILE("generate");
+	if (!is_CPU) {
+		LOG("<FAILED> Streaming generation is supported on CPU only.\n");
+		return 0.0;
+	}
+	if (diff_flag < PC_DIFF_RS || diff_flag > PC_DIFF_FRESNEL) {
+		LOG("Wrong Diffraction Method.\n");
+		return 0.0;
+	}
+	if (batchSize == 0 || batchSize > INT_MAX) batchSize = 1 << 20;
+
+	auto begin = CUR_TIME;
+
+	// source : a cache given directly, a valid cache of the PLY file, or the PLY file.
+	PointCloudCache cache;
+	PLYparser plyIO;
+	PLYparser::PlyStream* stream = nullptr;
+	ulonglong nTotal = 0;
+	int nColors = 0;
+	if (checkExtension(pc_file, ".ophpc")) {
+		if (!cache.open(pc_file)) {
+			LOG("<FAILED> Load point cloud cache : %s\n", pc_file);
+			return 0.0;
+		}
+	}
+	else {
+		std::string plyPath = pc_file;
+		if ((plyPath.find(".ply") == std::string::npos) && (plyPath.find(".PLY") == std::string::npos)) plyPath += ".ply";
+		const std::string cachePath = plyPath + ".ophpc";
+		if (getPointCloudCache() && cache.open(cachePath.c_str(), plyPath.c_str()) && cache.getSort() != getPointCloudCacheSort())
+			cache.close();
+		if (!cache.isOpen()) {
+			bool bPhase;
+			stream = plyIO.openStream(plyPath, nTotal, nColors, bPhase);
+			if (!stream) {
+				LOG("<FAILED> Load point cloud : %s\n", pc_file);
+				return 0.0;
+			}
+		}
+	}
+	if (cache.isOpen()) {
+		nTotal = cache.getNumberOfPoints();
+		nColors = cache.getNumberOfColors();
+	}
+
+	LOG("1) Algorithm Method : Point Cloud (stream)\n");
+	LOG("2) Source : %s\n", stream ? "PLY" : "Cache");
+	LOG("3) Transform Viewing Window : %s\n", is_ViewingWindow ? "ON" : "OFF");
+	LOG("4) Diffraction Method : %s\n", diff_flag == PC_DIFF_RS ? "R-S" : "Fresnel");
+	LOG("5) Number of Point Cloud : %llu (batch : %llu)\n", nTotal, batchSize);
+
+	resetBuffer();
+
+	// two batch buffers : one is diffracted while the other is read.
+	std::vector<Real> vertex[2], color[2];
+	for (int b = 0; b < 2; b++) {
+		vertex[b].resize(batchSize * 3);
+		color[b].resize(batchSize * nColors);
+	}
+	ulonglong nRead = 0;
+	// batches are read serially, as readStream, beside the OpenMP team of the diffraction.
+	auto readBatch = [&](int b) -> ulonglong {
+		ulonglong n = stream ?
+			plyIO.readStream(stream, batchSize, vertex[b].data(), color[b].data(), nullptr) :
+			cache.read(nRead, batchSize, vertex[b].data(), color[b].data(), nullptr, false);
+		nRead += n;
+		return n;
+	};
+
+	int cur = 0;
+	ulonglong nDone = 0;
+	ulonglong nBatch = readBatch(cur);
+	while (nBatch > 0) {
+		std::future<ulonglong> next = std::async(std::launch::async, readBatch, cur ^ 1);
+		diffractPoints(diff_flag, (int)nBatch, vertex[cur].data(), color[cur].data(), nColors, 1.0);
+		nDone += nBatch;
+		m_nProgress = (uint)(nDone * 100 / nTotal);
+		nBatch = next.get();
+		cur ^= 1;
+	}
+	if (stream) plyIO.closeStream(stream);
+
+	m_nProgress = 0;
+	m_elapsedTime = ELAPSED_TIME(begin, CUR_TIME);
+	if (nDone != nTotal) {
+		LOG("<FAILED> Read %llu / %llu points.\n", nDone, nTotal);
+		return 0.0;
+	}
+	LOG("Total Elapsed Time: %lf (s)\n", m_elapsedTime);
+	return m_elapsedTime;
+}
+
 void ophPointCloud::encodeHologram(const vec2 band_limit, const vec2 spectrum_shift)
 {
 	if (complex_H == nullptr) {
@@ -216,18 +326,13 @@ void ophPointCloud::encodeHologram(const vec2 band_limit, const vec2 spectrum_sh
 	for (int i = 0; i < pnY; i++)
 		y_o[i] = (ss[_Y] - ppY) - (ppY * i);
 
-	Real* xx_o = new Real[pnXY];
-	Real* yy_o = new Real[pnXY];
-
-	for (int i = 0; i < pnXY; i++)
-		xx_o[i] = x_o[i % pnX];
-
-
-	for (int i = 0; i < pnX; i++)
-		for (int j = 0; j < pnY; j++)
-			yy_o[i + j * pnX] = y_o[j];
-
-	Complex<Real>* h = new Complex<Real>[pnXY];
+	// reused across frames, reallocated only when the resolution changes.
+	if (encodeBufSize != pnXY) {
+		if (encodeBuf) delete[] encodeBuf;
+		encodeBuf = new Complex<Real>[pnXY];
+		encodeBufSize = pnXY;
+	}
+	Complex<Real>* h = encodeBuf;
 
 	for (uint ch = 0; ch < nChannel; ch++) {
 		fftwShift(complex_H[ch], h, pnX, pnY, OPH_FORWARD);
@@ -245,19 +350,16 @@ void ophPointCloud::encodeHologram(const vec2 band_limit, const vec2 spectrum_sh
 			int r = i / pnX;
 			int c = i % pnX;
 
-			Real X = (M_PI * xx_o[i] * spectrum_shift[_X]) / ppX;
-			Real Y = (M_PI * yy_o[i] * spectrum_shift[_Y]) / ppY;
+			Real X = (M_PI * x_o[c] * spectrum_shift[_X]) / ppX;
+			Real Y = (M_PI * y_o[r] * spectrum_shift[_Y]) / ppY;
 
 			shift_phase[_RE] = shift_phase[_RE] * (cos(X) * cos(Y) - sin(X) * sin(Y));
 
 			m_lpEncoded[ch][i] = (h[i] * shift_phase).real();
 		}
 	}
-	delete[] h;
 	delete[] x_o;
-	delete[] xx_o;
 	delete[] y_o;
-	delete[] yy_o;
 
 	LOG("Done.\n");
 }
@@ -278,15 +380,27 @@ Real ophPointCloud::genCghPointCloudCPU(uint diff_flag)
 {
 	auto begin = CUR_TIME;
 
+	m_nProgress = 0;
+	int num_threads = diffractPoints(diff_flag, n_points, pc_data_.vertex, pc_data_.color, pc_data_.n_colors, 1.0);
+
+	auto end = CUR_TIME;
+	Real elapsed_time = ((chrono::duration<Real>)(end - begin)).count();
+	LOG("\n%s : %lf(s) <%d threads>\n\n",
+		__FUNCTION__,
+		elapsed_time,
+		num_threads);
+
+	return elapsed_time;
+}
+
+int ophPointCloud::diffractPoints(uint diff_flag, int nPoints, const Real* vertex, const Real* color, int nColors, Real sign)
+{
+	OPH_PROFILE_COUNT(PROF_POINTS, nPoints);
 	// Output Image Size
 	ivec2 pn;
 	pn[_X] = context_.pixel_number[_X];
 	pn[_Y] = context_.pixel_number[_Y];
 
-	// Tilt Angle
-	Real thetaX = RADIAN(pc_config_.tilt_angle[_X]);
-	Real thetaY = RADIAN(pc_config_.tilt_angle[_Y]);
-
 	// Pixel pitch at eyepiece lens plane (by simple magnification) ==> SLM pitch
 	vec2 pp;
 	pp[_X] = context_.pixel_pitch[_X];
@@ -299,22 +413,12 @@ Real ophPointCloud::genCghPointCloudCPU(uint diff_flag)
 
 	uint nChannel = context_.waveNum;
 
-	bool bIsGrayScale = pc_data_.n_colors == 1 ? true : false;
+	bool bIsGrayScale = nColors == 1 ? true : false;
 
 	int i; // private variable for Multi Threading
 	int num_threads = 1;
 	int sum = 0;
-	m_nProgress = 0;
 
-	Real *pVertex = nullptr;
-	if (is_ViewingWindow) {
-		pVertex = new Real[n_points * 3];
-		transVW(n_points * 3, pVertex, pc_data_.vertex);
-	}
-	else {
-		pVertex = pc_data_.vertex;
-	}
-	
 	for (uint ch = 0; ch < nChannel; ++ch) {
 		// Wave Number (2 * PI / lambda(wavelength))
 		Real lambda = context_.wave_length[ch];
@@ -327,40 +431,29 @@ Real ophPointCloud::genCghPointCloudCPU(uint diff_flag)
 #pragma omp parallel
 		{
 			num_threads = omp_get_num_threads(); // get number of Multi Threading
-			int tid = omp_get_thread_num();
 
 #pragma omp for private(i)
 #endif
-			for (i = 0; i < n_points; ++i) { //Create Fringe Pattern
+			for (i = 0; i < nPoints; ++i) { //Create Fringe Pattern
 				uint iVertex = 3 * i; // x, y, z
-				uint iColor = pc_data_.n_colors * i + nAdd; // rgb or gray-scale
-				Real pcx, pcy, pcz;
-
-				pcx = pVertex[iVertex + _X];
-				pcy = pVertex[iVertex + _Y];
-				pcz = pVertex[iVertex + _Z];
-				pcx *= pc_config_.scale[_X];
-				pcy *= pc_config_.scale[_Y];
-				pcz *= pc_config_.scale[_Z];
-				pcx *= ratio;
-				pcy *= ratio;
-#if 1
-				pcz += pc_config_.distance;
-				
-				Real amplitude = pc_data_.color[iColor];
+				uint iColor = nColors * i + nAdd; // rgb or gray-scale
+				Real pc[3];
+
+				if (is_ViewingWindow)
+					transVW(3, pc, const_cast<Real*>(vertex + iVertex));
+				else
+					memcpy(pc, vertex + iVertex, sizeof(Real) * 3);
+
+				Real pcx = pc[_X] * pc_config_.scale[_X] * ratio;
+				Real pcy = pc[_Y] * pc_config_.scale[_Y] * ratio;
+				Real pcz = pc[_Z] * pc_config_.scale[_Z] + pc_config_.distance;
+
+				Real amplitude = sign * color[iColor];
 
 				switch (diff_flag)
 				{
 				case PC_DIFF_RS:
 					diffractNotEncodedRS(ch, pn, pp, ss, vec3(pcx, pcy, pcz), k, amplitude, lambda);
-#else
-				Real amplitude = pc_data_.color[iColor];
-				switch (diff_flag)
-				{
-				case PC_DIFF_RS:
-					RS_Propagation(vec3(pcx, pcy, pcz), complex_H[ch], lambda, pc_config_.distance, amplitude);
-
-#endif
 					break;
 				case PC_DIFF_FRESNEL:
 					diffractNotEncodedFrsn(ch, pn, pp, ss, vec3(pcx, pcy, pcz), k, amplitude, lambda);
@@ -369,23 +462,159 @@ Real ophPointCloud::genCghPointCloudCPU(uint diff_flag)
 #pragma omp atomic
 				sum++;
 
-				m_nProgress = (int)((Real)sum * 100 / ((Real)n_points * nChannel));
+				m_nProgress = (int)((Real)sum * 100 / ((Real)nPoints * nChannel));
 			}
 #ifdef _OPENMP
 		}
 #endif
 	}
-	if (is_ViewingWindow) {
-		delete[] pVertex;
+	return num_threads;
+}
+
+Real ophPointCloud::beginIncremental(uint diff_flag, int refreshInterval)
+{
+	if (!is_CPU) {
+		LOG("<FAILED> Incremental generation is supported on CPU only.\n");
+		return 0.0;
+	}
+	if (diff_flag < PC_DIFF_RS || diff_flag > PC_DIFF_FRESNEL) {
+		LOG("Wrong Diffraction Method.\n");
+		return 0.0;
+	}
+	if (n_points <= 0 || pc_data_.vertex == nullptr || pc_data_.color == nullptr) {
+		LOG("<FAILED> Point cloud is not loaded.\n");
+		return 0.0;
 	}
-	auto end = CUR_TIME;
-	Real elapsed_time = ((chrono::duration<Real>)(end - begin)).count();
-	LOG("\n%s : %lf(s) <%d threads>\n\n",
-		__FUNCTION__,
-		elapsed_time,
-		num_threads);
 
-	return elapsed_time;
+	const int nColors = pc_data_.n_colors;
+	incIds.resize(n_points);
+	incVertex.assign(pc_data_.vertex, pc_data_.vertex + n_points * 3);
+	incColor.assign(pc_data_.color, pc_data_.color + n_points * nColors);
+	incSlot.clear();
+	incSlot.reserve(n_points);
+	for (int i = 0; i < n_points; i++) {
+		incIds[i] = i;
+		incSlot[i] = i;
+	}
+
+	incDiffFlag = diff_flag;
+	incRefreshInterval = refreshInterval < 0 ? 0 : refreshInterval;
+	incFrameCount = 0;
+	bIncremental = true;
+
+	return generateHologram(diff_flag);
+}
+
+Real ophPointCloud::generateIncremental(const FrameDelta& delta)
+{
+	OPH_PROFILE("generate");
+	if (!bIncremental) {
+		LOG("<FAILED> Incremental mode is not started.\n");
+		return -1.0;
+	}
+	const int nColors = pc_data_.n_colors;
+	const int nChanged = static_cast<int>(delta.ids.size());
+	if (delta.vertex.size() != (size_t)nChanged * 3 || delta.color.size() != (size_t)nChanged * nColors) {
+		LOG("<FAILED> Wrong size of the frame delta.\n");
+		return -1.0;
+	}
+
+	auto begin = CUR_TIME;
+
+	// old contributions to subtract, new contributions to add.
+	std::vector<Real>& subVertex = incSubVertex;
+	std::vector<Real>& subColor = incSubColor;
+	subVertex.clear();
+	subColor.clear();
+	subVertex.reserve((delta.removed.size() + nChanged) * 3);
+	subColor.reserve((delta.removed.size() + nChanged) * nColors);
+
+	for (int id : delta.removed) {
+		auto iter = incSlot.find(id);
+		if (iter == incSlot.end()) continue;
+		const int slot = iter->second;
+		const int last = static_cast<int>(incIds.size()) - 1;
+		subVertex.insert(subVertex.end(), incVertex.begin() + slot * 3, incVertex.begin() + slot * 3 + 3);
+		subColor.insert(subColor.end(), incColor.begin() + slot * nColors, incColor.begin() + (slot + 1) * nColors);
+
+		// move the last point into the hole.
+		if (slot != last) {
+			std::copy(incVertex.begin() + last * 3, incVertex.begin() + last * 3 + 3, incVertex.begin() + slot * 3);
+			std::copy(incColor.begin() + last * nColors, incColor.begin() + (last + 1) * nColors, incColor.begin() + slot * nColors);
+			incIds[slot] = incIds[last];
+			incSlot[incIds[slot]] = slot;
+		}
+		incIds.pop_back();
+		incVertex.resize(last * 3);
+		incColor.resize(last * nColors);
+		incSlot.erase(iter);
+	}
+
+	for (int i = 0; i < nChanged; i++) {
+		const int id = delta.ids[i];
+		auto iter = incSlot.find(id);
+		int slot;
+		if (iter != incSlot.end()) {
+			slot = iter->second;
+			subVertex.insert(subVertex.end(), incVertex.begin() + slot * 3, incVertex.begin() + slot * 3 + 3);
+			subColor.insert(subColor.end(), incColor.begin() + slot * nColors, incColor.begin() + (slot + 1) * nColors);
+		}
+		else {
+			slot = static_cast<int>(incIds.size());
+			incSlot[id] = slot;
+			incIds.push_back(id);
+			incVertex.resize((slot + 1) * 3);
+			incColor.resize((slot + 1) * nColors);
+		}
+		std::copy(delta.vertex.begin() + i * 3, delta.vertex.begin() + i * 3 + 3, incVertex.begin() + slot * 3);
+		std::copy(delta.color.begin() + i * nColors, delta.color.begin() + (i + 1) * nColors, incColor.begin() + slot * nColors);
+	}
+
+	incFrameCount++;
+	m_nProgress = 0;
+	if (incRefreshInterval > 0 && incFrameCount % incRefreshInterval == 0) {
+		resetBuffer();
+		diffractPoints(incDiffFlag, static_cast<int>(incIds.size()), incVertex.data(), incColor.data(), nColors, 1.0);
+		LOG("Incremental frame %d : full recompute of %d points\n", incFrameCount, (int)incIds.size());
+	}
+	else {
+		const int nSub = static_cast<int>(subVertex.size() / 3);
+		if (nSub > 0)
+			diffractPoints(incDiffFlag, nSub, subVertex.data(), subColor.data(), nColors, -1.0);
+		if (nChanged > 0)
+			diffractPoints(incDiffFlag, nChanged, delta.vertex.data(), delta.color.data(), nColors, 1.0);
+		LOG("Incremental frame %d : -%d / +%d points\n", incFrameCount, nSub, nChanged);
+	}
+	m_nProgress = 0;
+
+	m_elapsedTime = ELAPSED_TIME(begin, CUR_TIME);
+	LOG("Total Elapsed Time: %lf (s)\n", m_elapsedTime);
+	return m_elapsedTime;
+}
+
+void ophPointCloud::endIncremental(void)
+{
+	if (!bIncremental) return;
+
+	const int nPoints = static_cast<int>(incIds.size());
+	if (pc_data_.vertex) delete[] pc_data_.vertex;
+	if (pc_data_.color) delete[] pc_data_.color;
+	if (pc_data_.phase) {
+		delete[] pc_data_.phase;
+		pc_data_.phase = nullptr;
+	}
+	pc_data_.vertex = new Real[nPoints * 3];
+	pc_data_.color = new Real[nPoints * pc_data_.n_colors];
+	std::copy(incVertex.begin(), incVertex.end(), pc_data_.vertex);
+	std::copy(incColor.begin(), incColor.end(), pc_data_.color);
+	pc_data_.n_points = nPoints;
+	n_points = nPoints;
+
+	incSlot.clear();
+	incIds.clear();
+	incVertex.clear();
+	incColor.clear();
+	bIncremental = false;
 }
 
 void ophPointCloud::diffractEncodedRS(uint channel, ivec2 pn, vec2 pp, vec2 ss, vec3 pc, Real k, Real amplitude, vec2 theta)
@@ -547,6 +776,11 @@ void ophPointCloud::diffractNotEncodedFrsn(uint channel, ivec2 pn, vec2 pp, vec2
 
 void ophPointCloud::ophFree(void)
 {
+	if (encodeBuf) {
+		delete[] encodeBuf;
+		encodeBuf = nullptr;
+		encodeBufSize = 0;
+	}
 	if (pc_data_.vertex) {
 		delete[] pc_data_.vertex;
 		pc_data_.vertex = nullptr;
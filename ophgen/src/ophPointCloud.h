@@ -49,6 +49,7 @@
 #define _USE_MATH_DEFINES
 
 #include "ophGen.h"
+#include <unordered_map>
 
 //Build Option : Multi Core Processing (OpenMP)
 #ifdef _OPENMP
@@ -552,6 +553,20 @@ public:
 		PC_DIFF_RS,
 		PC_DIFF_FRESNEL,
 	};
+	/**
+	* @brief Change of an animated point cloud since the previous frame, points are keyed by a stable ID.
+	*/
+	struct FrameDelta {
+		/// IDs of the removed points
+		std::vector<int> removed;
+		/// IDs of the added or moved points
+		std::vector<int> ids;
+		/// x, y, z of each entry of ids
+		std::vector<Real> vertex;
+		/// n_colors values of each entry of ids
+		std::vector<Real> color;
+	};
+
 	/**
 	* @brief Constructor
 	* @details Initialize variables.
@@ -688,6 +703,19 @@ public:
 	*/
 	Real generateHologram(uint diff_flag = PC_DIFF_RS);
 	/**
+	* @brief Generate a hologram from a point cloud file larger than memory.
+	* @details The points are read in batches from a PLY file or a point cloud cache (*.ophpc) and
+	*			accumulated into complex_H, the next batch is read on another thread while the current one
+	*			is diffracted. Memory holds the hologram and two batches, the loaded point cloud is not used.
+	*			A valid <PLY file>.ophpc of the requested point order is read instead of the PLY file
+	*			when the cache is enabled (see setPointCloudCache). CPU only.
+	* @param pc_file PLY or *.ophpc file path
+	* @param diff_flag PC_DIFF_RS or PC_DIFF_FRESNEL
+	* @param batchSize number of points per batch
+	* @return implement time (sec), 0 if it fails
+	*/
+	Real generateHologramStream(const char* pc_file, uint diff_flag = PC_DIFF_RS, ulonglong batchSize = 1 << 20);
+	/**
 	* @brief encode Single-side band
 	* @param Vector band limit
 	* @param Vector specturm shift
@@ -715,6 +743,28 @@ public:
 	*/
 	uint* getProgress() { return &m_nProgress; }
 
+	/**
+	* @brief Start the incremental mode for an animated point cloud, and generate the first frame.
+	* @details The loaded points get the IDs 0 ~ n_points - 1. complex_H is kept between frames and
+	*			generateIncremental() only diffracts the points of the delta. CPU only.
+	* @param diff_flag PC_DIFF_RS or PC_DIFF_FRESNEL
+	* @param refreshInterval every refreshInterval frames the field is recomputed from all points to bound the drift of the accumulation, 0 : never
+	* @return implement time (sec), 0 if it fails
+	*/
+	Real beginIncremental(uint diff_flag = PC_DIFF_RS, int refreshInterval = 60);
+	/**
+	* @brief Update complex_H by a frame delta : the old contributions of the removed and moved points are
+	*		 subtracted and the new ones are added, the cost is proportional to the changed points.
+	* @param delta changed points of this frame
+	* @return implement time (sec), -1 if it fails
+	*/
+	Real generateIncremental(const FrameDelta& delta);
+	/**
+	* @brief Stop the incremental mode, the current points are written back to the point cloud model.
+	*/
+	void endIncremental(void);
+	inline bool isIncremental(void) { return bIncremental; }
+
 	//int AddPoint(vec3 vertex) { points.push_back(vertex); }
 	
 private:
@@ -733,6 +783,16 @@ private:
 	void diffractEncodedFrsn(void);
 	void diffractNotEncodedFrsn(uint channel, ivec2 pn, vec2 pp, vec2 ss, vec3 pc, Real k, Real amplitude, Real lambda);
 
+	/**
+	* @brief Accumulate the fringe patterns of the points into complex_H on CPU.
+	* @param nPoints number of points
+	* @param vertex x, y, z per point
+	* @param color nColors values per point
+	* @param sign 1.0 to add the points, -1.0 to remove them
+	* @return number of threads
+	*/
+	int diffractPoints(uint diff_flag, int nPoints, const Real* vertex, const Real* color, int nColors, Real sign);
+
 
 	/**
 	* @brief GPGPU Accelation of genCghPointCloud() using NVIDIA CUDA
@@ -751,6 +811,21 @@ private:
 	uint m_nProgress;
 	OphPointCloudConfig pc_config_;
 	OphPointCloudData	pc_data_;
+
+	/// state of the incremental mode, points are stored compactly and incSlot maps ID -> index.
+	bool bIncremental;
+	uint incDiffFlag;
+	int incRefreshInterval;
+	int incFrameCount;
+	std::unordered_map<int, int> incSlot;
+	std::vector<int> incIds;
+	std::vector<Real> incVertex;
+	std::vector<Real> incColor;
+	std::vector<Real> incSubVertex;	///< contributions to subtract, kept across frames
+	std::vector<Real> incSubColor;
+
+	Complex<Real>* encodeBuf;	///< spectrum of encodeHologram, kept across frames
+	uint encodeBufSize;
 };
 
 #endif // !__ophPointCloud_h
\ No newline at end of file
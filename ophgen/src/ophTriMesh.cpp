@@ -455,6 +455,7 @@ vec3 vecCross(const vec3& a, const vec3& b)
 
 void ophTri::generateHologram(uint SHADING_FLAG) 
 {
+	OPH_PROFILE("generate");
 	resetBuffer();
 
 	auto start_time = CUR_TIME;
@@ -506,25 +507,12 @@ void ophTri::generateMeshHologram() {
 
 void ophTri::generateAS(uint SHADING_FLAG)
 {
-	calGlobalFrequency();
-
 	const uint pnX = context_.pixel_number[_X];
 	const uint pnY = context_.pixel_number[_Y];
 	const uint pnXY = pnX * pnY;
 
-	flx = new Real[pnXY];
-	fly = new Real[pnXY];
-	flz = new Real[pnXY];
-
-	freqTermX = new Real[pnXY];
-	freqTermY = new Real[pnXY];
-
-	refAS = new Complex<Real>[pnXY];
-
-	ASTerm = new Complex<Real>[pnXY];
-	randTerm = new Complex<Real>[pnXY];
-	phaseTerm = new Complex<Real>[pnXY];
-	convol = new Complex<Real>[pnXY];
+	allocFrequencyBuffer(pnXY);
+	calGlobalFrequency();
 
 	findNormals(SHADING_FLAG);
 	
@@ -562,8 +550,55 @@ void ophTri::generateAS(uint SHADING_FLAG)
 		LOG(szLog);
 	}
 	LOG("Angular Spectrum Generated...\n");
+}
 
-	delete[]/* mesh, mesh_local,*/scaledMeshData, fx, fy, fz, flx, fly, flz, freqTermX, freqTermY, refAS, ASTerm, randTerm, phaseTerm, convol;
+void ophTri::allocFrequencyBuffer(uint pnXY)
+{
+	if (scratchSize == pnXY) return;
+	releaseFrequencyBuffer();
+
+	fx = new Real[pnXY];
+	fy = new Real[pnXY];
+	fz = new Real[pnXY];
+	flx = new Real[pnXY];
+	fly = new Real[pnXY];
+	flz = new Real[pnXY];
+	flxShifted = new Real[pnXY];
+	flyShifted = new Real[pnXY];
+	freqTermX = new Real[pnXY];
+	freqTermY = new Real[pnXY];
+
+	refAS = new Complex<Real>[pnXY];
+	ASTerm = new Complex<Real>[pnXY];
+	randTerm = new Complex<Real>[pnXY];
+	phaseTerm = new Complex<Real>[pnXY];
+	convol = new Complex<Real>[pnXY];
+	scratchSize = pnXY;
+}
+
+void ophTri::releaseFrequencyBuffer()
+{
+	Real** reals[] = { &fx, &fy, &fz, &flx, &fly, &flz, &flxShifted, &flyShifted, &freqTermX, &freqTermY };
+	for (Real** p : reals) {
+		if (*p) delete[] *p;
+		*p = nullptr;
+	}
+	Complex<Real>** cplxs[] = { &refAS, &ASTerm, &randTerm, &phaseTerm, &convol };
+	for (Complex<Real>** p : cplxs) {
+		if (*p) delete[] *p;
+		*p = nullptr;
+	}
+	scratchSize = 0;
+}
+
+void ophTri::ophFree(void)
+{
+	ophGen::ophFree();
+	releaseFrequencyBuffer();
+	if (scaledMeshData) {
+		delete[] scaledMeshData;
+		scaledMeshData = nullptr;
+	}
 }
 
 
@@ -714,16 +749,14 @@ void ophTri::calGlobalFrequency()
 
 	Real dfx = 1 / ssX;
 	Real dfy = 1 / ssY;
-	fx = new Real[pnXY];
-	fy = new Real[pnXY];
-	fz = new Real[pnXY];
 	uint i = 0;
-	
-	for (uint ch = 0; ch < nChannel; ch++) {
-		Real lambda = context_.wave_length[ch];
+
+	// one frequency grid of pnXY (the mesh terms use wave_length[0]).
+	{
+		Real lambda = context_.wave_length[0];
 		Real dfl = 1 / lambda;
-		for (uint idxFy = pnY / 2; idxFy > -pnY / 2; idxFy--) {
-			for (uint idxFx = -pnX / 2; idxFx < pnX / 2; idxFx++) {
+		for (int idxFy = pnY / 2; idxFy > pnY / 2 - pnY; idxFy--) {
+			for (int idxFx = -pnX / 2; idxFx < pnX - pnX / 2; idxFx++) {
 
 				Real x;
 				fx[i] = x = idxFx * dfx;
@@ -743,8 +776,6 @@ uint ophTri::calFrequencyTerm()
 	const uint pnY = context_.pixel_number[_Y];
 	const uint pnXY = pnX * pnY;
 
-	Real* flxShifted = new Real[pnXY];
-	Real* flyShifted = new Real[pnXY];
 	Real waveLength = context_.wave_length[0];
 	Real w = 1 / waveLength;
 	Real ww = w * w;
@@ -788,8 +819,6 @@ uint ophTri::calFrequencyTerm()
 		freqTermY[i] = invLoRot[2] * flxShifted[i] + invLoRot[3] * flyShifted[i];
 	}
 	
-	delete[] flxShifted;
-	delete[] flyShifted;
 	delete[] invLoRot;
 	return 1;
 }
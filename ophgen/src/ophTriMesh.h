@@ -111,6 +111,12 @@ public:
 		normalizedMeshData = nullptr;
 		angularSpectrum = nullptr;
 		bSinglePrecision = false;
+		fx = fy = fz = nullptr;
+		flx = fly = flz = nullptr;
+		flxShifted = flyShifted = nullptr;
+		freqTermX = freqTermY = nullptr;
+		refAS = ASTerm = randTerm = phaseTerm = convol = nullptr;
+		scratchSize = 0;
 
 		LOG("*** MESH : BUILD DATE: %s %s ***\n\n", __DATE__, __TIME__);
 	}
@@ -228,6 +234,9 @@ public:
 	*/
 	void setViewingWindow(bool is_ViewingWindow);
 
+protected:
+	virtual void ophFree(void);
+
 private:
 	
 	// Inner functions
@@ -239,6 +248,11 @@ private:
 	uint findGeometricalRelations(Real* mesh, vec3 no);
 	void calGlobalFrequency();
 	uint calFrequencyTerm();
+	/**
+	* @brief Allocate the per-pixel frequency buffers once per resolution, they are reused by every frame.
+	*/
+	void allocFrequencyBuffer(uint pnXY);
+	void releaseFrequencyBuffer();
 	uint refAS_Flat(vec3 na);
 	uint refAS_Continuous(uint n);
 	void randPhaseDist(Complex<Real>* AS);
@@ -297,6 +311,9 @@ private:
 	Complex<Real>* randTerm;
 	Complex<Real>* phaseTerm;
 	Complex<Real>* convol;
+	Real* flxShifted;
+	Real* flyShifted;
+	uint scratchSize;					/// number of pixels of the frequency buffers
 	bool is_ViewingWindow;
 	bool bSinglePrecision;
 
@@ -50,10 +50,12 @@
 ophWRP::ophWRP(void)
 	: ophGen()
 	, scaledVertex(nullptr)
+	, scaledVertexSize(0)
 	, bSinglePrecision(false)
 {
 	n_points = -1;
 	p_wrp_ = nullptr;
+	wrpBufSize = 0;
 	is_CPU = true;
 	is_ViewingWindow = false;
 	LOG("*** WRP : BUILD DATE: %s %s ***\n\n", __DATE__, __TIME__);
@@ -80,11 +82,12 @@ void ophWRP::autoScaling()
 	Real size = pnY * ppY * 0.8 / 2.0;
 
 	OphPointCloudData pc = obj_;
-	if (scaledVertex) {
-		delete[] scaledVertex;
-		scaledVertex = nullptr;
+	// reused across frames, reallocated only when the point set grows.
+	if (scaledVertexSize < n_points * 3) {
+		if (scaledVertex) delete[] scaledVertex;
+		scaledVertex = new Real[n_points * 3];
+		scaledVertexSize = n_points * 3;
 	}
-	scaledVertex = new Real[n_points * 3];
 	memset(scaledVertex, 0.0, sizeof(Real) * n_points * 3);
 
 	if (is_ViewingWindow) {
@@ -343,11 +346,11 @@ double ophWRP::calculateWRPCPU(void)
 
 	// Memory Location for Result Image
 
-	if (p_wrp_) {
-		delete[] p_wrp_;
-		p_wrp_ = nullptr;
+	if (wrpBufSize != pnXY) {
+		if (p_wrp_) delete[] p_wrp_;
+		p_wrp_ = new Complex<Real>[pnXY];
+		wrpBufSize = pnXY;
 	}
-	p_wrp_ = new Complex<Real>[pnXY];
 	memset(p_wrp_, 0.0, sizeof(Complex<Real>) * pnXY);
 
 	int num_threads = 1;
@@ -430,10 +433,6 @@ double ophWRP::calculateWRPCPU(void)
 		fresnelPropagation(p_wrp_, complex_H[ch], distance, ch);
 		memset(p_wrp_, 0.0, sizeof(Complex<Real>) * pnXY);
 	}
-	delete[] p_wrp_;
-	delete[] scaledVertex;
-	p_wrp_ = nullptr;
-	scaledVertex = nullptr;
 
 	auto end = CUR_TIME;
 	LOG("\n%s : %lf(s) <%d threads>\n\n",
@@ -446,6 +445,7 @@ double ophWRP::calculateWRPCPU(void)
 
 void ophWRP::generateHologram(void)
 {
+	OPH_PROFILE("generate");
 	resetBuffer();
 
 	auto start_time = CUR_TIME;
@@ -503,6 +503,16 @@ Complex<Real>** ophWRP::calculateMWRP(void)
 
 void ophWRP::ophFree(void)
 {
+	if (p_wrp_) {
+		delete[] p_wrp_;
+		p_wrp_ = nullptr;
+		wrpBufSize = 0;
+	}
+	if (scaledVertex) {
+		delete[] scaledVertex;
+		scaledVertex = nullptr;
+		scaledVertexSize = 0;
+	}
 	if (obj_.vertex) {
 		delete[] obj_.vertex;
 		obj_.vertex = nullptr;
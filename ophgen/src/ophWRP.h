@@ -237,9 +237,11 @@ protected:
 	int n_points;                 ///< numbers of points
 
 	Complex<Real>* p_wrp_;   ///< wrp buffer - complex type
+	uint wrpBufSize;         ///< allocated size of p_wrp_, kept across frames
 
 	OphPointCloudData obj_;       ///< Input Pointcloud Data
 	Real *scaledVertex;
+	int scaledVertexSize;         ///< allocated size of scaledVertex, kept across frames
 	OphWRPConfig wrp_config_;      ///< structure variable for WRP hologram configuration
 
 private:
@@ -48,8 +48,11 @@ double ophWRP::calculateWRPGPU(void)
 {
 	auto begin = CUR_TIME;
 
-	if (p_wrp_) delete[] p_wrp_;
-	p_wrp_ = new oph::Complex<Real>[context_.pixel_number[_X] * context_.pixel_number[_Y]];
+	if (wrpBufSize != context_.pixel_number[_X] * context_.pixel_number[_Y]) {
+		if (p_wrp_) delete[] p_wrp_;
+		p_wrp_ = new oph::Complex<Real>[context_.pixel_number[_X] * context_.pixel_number[_Y]];
+		wrpBufSize = context_.pixel_number[_X] * context_.pixel_number[_Y];
+	}
 	memset(p_wrp_, 0.0, sizeof(oph::Complex<Real>) * context_.pixel_number[_X] * context_.pixel_number[_Y]);
 
 	prepareInputdataGPU();
@@ -130,16 +130,40 @@ bool ophCascadedPropagation::saveAsOhc(const char * fname)
 
 bool ophCascadedPropagation::loadAsOhc(const char * fname)
 {
-	if (!Openholo::loadAsOhc(fname))
-		return -1;
+	return loadAsOhcRegion(fname, 0, 0);
+}
+
+bool ophCascadedPropagation::loadAsOhcRegion(const char * fname, oph::uint offset_x, oph::uint offset_y)
+{
+	std::string fullname = fname;
+	if (!checkExtension(fname, ".ohc")) fullname.append(".ohc");
+	OHC_decoder->setFileName(fullname.c_str());
+	if (!OHC_decoder->open())
+		return false;
 
 	oph::uint nx = getResX();
 	oph::uint ny = getResY();
+	ivec2 pxNum = OHC_decoder->getNumOfPixel();
+	if (offset_x + nx > (oph::uint)pxNum[_X] || offset_y + ny > (oph::uint)pxNum[_Y] || OHC_decoder->getNumOfWavlen() > wavefield_SLM.size())
+	{
+		PRINT_ERROR("sub-aperture is out of the field of ohc file");
+		OHC_decoder->close();
+		return false;
+	}
+
+	// decode straight into the SLM wavefields, tiled files read only the overlapping tiles
 	config_.num_colors = OHC_decoder->getNumOfWavlen();
 	for (oph::uint i = 0; i < getNumColors(); i++)
-		memcpy(wavefield_SLM[i], complex_H[i], nx * ny * sizeof(Complex<Real>));
+	{
+		if (!OHC_decoder->decodeRegion(wavefield_SLM[i], i, offset_x, offset_y, nx, ny))
+		{
+			OHC_decoder->close();
+			return false;
+		}
+	}
+	OHC_decoder->close();
 
-	return 1;
+	return true;
 }
 
 bool ophCascadedPropagation::allocateMem()
@@ -201,6 +201,16 @@ class RECON_DLL ophCascadedPropagation : public ophRec {
 		*/
 		virtual bool loadAsOhc(const char *fname);
 
+		/**
+		* @brief Function to read a sub-aperture of OHC file
+		* @details Reads nx * ny pixels from (offset_x, offset_y) of the field into the SLM wavefields.
+		*		   Tiled OHC files much larger than the SLM are read tile by tile.
+		* @param fname: file name
+		* @param offset_x: first column of the sub-aperture
+		* @param offset_y: first row of the sub-aperture
+		*/
+		bool loadAsOhcRegion(const char *fname, oph::uint offset_x, oph::uint offset_y);
+
 
 	private:
 		/**
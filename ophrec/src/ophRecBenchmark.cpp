@@ -0,0 +1,125 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophRecBenchmark.h"
+#include "ophWaveAberration.h"
+#include "sys.h"
+#include <memory>
+#include <random>
+
+namespace {
+	const int ZERNIKE_TERMS = 45;
+
+	/**
+	* @brief ophWaveAberration keeps the wave aberration of the last run, it is freed before the next one.
+	*/
+	class AberrationTarget : public ophWaveAberration
+	{
+	public:
+		AberrationTarget(void) { complex_W = nullptr; }
+
+		void run(void)
+		{
+			if (complex_W) Free2D(complex_W);
+			accumulateZernikePolynomial();
+		}
+
+	protected:
+		virtual void ophFree(void)
+		{
+			if (complex_W) ophWaveAberration::ophFree();
+			complex_W = nullptr;
+		}
+	};
+}
+
+bool ophRecBenchmark::writeAberrationConfig(const char* fname, const BenchmarkConfig& config)
+{
+	FILE* fp = fopen(fname, "w");
+	if (fp == nullptr) return false;
+
+	// coefficients in waves, the low orders dominate as in a real eye or lens.
+	std::mt19937_64 engine(config.seed);
+	std::uniform_real_distribution<Real> coeff(-0.5, 0.5);
+
+	// readConfig takes the first node as the root, so no XML declaration.
+	fprintf(fp, "<WaveAberration>\n");
+	fprintf(fp, "\t<Wavelength>532e-9</Wavelength>\n");
+	fprintf(fp, "\t<PixelPitchHor>8e-6</PixelPitchHor>\n\t<PixelPitchVer>8e-6</PixelPitchVer>\n");
+	fprintf(fp, "\t<ResolutionHor>%d</ResolutionHor>\n\t<ResolutionVer>%d</ResolutionVer>\n", config.resolution[_X], config.resolution[_Y]);
+	fprintf(fp, "\t<ZernikeCoeff");
+	for (int i = 0; i < ZERNIKE_TERMS; i++)
+		fprintf(fp, " z%d=\"%f\"", i, coeff(engine) / (1 + i / 5));
+	fprintf(fp, "/>\n");
+	fprintf(fp, "</WaveAberration>\n");
+
+	bool bOK = ferror(fp) == 0;
+	fclose(fp);
+	return bOK;
+}
+
+bool ophRecBenchmark::addCases(Benchmark& bench)
+{
+	const BenchmarkConfig& config = bench.getConfig();
+	const std::string xml = config.workDir + "/aberration.xml";
+	if (!Benchmark::makeDirectory(config.workDir.c_str()) || !writeAberrationConfig(xml.c_str(), config)) {
+		LOG("<FAILED> Benchmark inputs : %s\n", config.workDir.c_str());
+		return false;
+	}
+
+	const ulonglong pnXY = (ulonglong)config.resolution[_X] * config.resolution[_Y];
+
+	auto wa = std::make_shared<std::shared_ptr<AberrationTarget>>();
+	bench.add("rec_aberration", "pixels", [wa, xml]() {
+		if (*wa) return true;
+		*wa = std::shared_ptr<AberrationTarget>(new AberrationTarget(), [](AberrationTarget* target) { target->release(); });
+		return (*wa)->readConfig(xml.c_str());
+	}, [wa, pnXY]() {
+		(*wa)->run();
+		return pnXY;
+	});
+
+	return true;
+}
@@ -45,6 +45,7 @@
 
 #include "ophSig.h"
 #include "include.h"
+#include "ophFFT.h"
 
 
 ophSig::ophSig(void)
@@ -125,7 +126,11 @@ void ophSig::fft1(matrix<Complex<T>> &src, matrix<Complex<T>> &dst, int sign, ui
 		fft_in[i][_IM] = src(0, i).imag();
 	}
 
-	fftw_plan plan = fftw_plan_dft_1d(src.size[_Y], fft_in, fft_out, sign, flag);
+	fftw_plan plan;
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		plan = fftw_plan_dft_1d(src.size[_Y], fft_in, fft_out, sign, flag);
+	}
 
 	fftw_execute(plan);
 	if (sign == OPH_FORWARD)
@@ -143,7 +148,10 @@ void ophSig::fft1(matrix<Complex<T>> &src, matrix<Complex<T>> &dst, int sign, ui
 		}
 	}
 
-	fftw_destroy_plan(plan);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(plan);
+	}
 	fftw_free(fft_in);
 	fftw_free(fft_out);
 }
@@ -164,7 +172,11 @@ void ophSig::fft2(matrix<Complex<T>> &src, matrix<Complex<T>> &dst, int sign, ui
 		}
 	}
 
-	fftw_plan plan = fftw_plan_dft_2d(src.size[_X], src.size[_Y], fft_in, fft_out, sign, flag);
+	fftw_plan plan;
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		plan = fftw_plan_dft_2d(src.size[_X], src.size[_Y], fft_in, fft_out, sign, flag);
+	}
 
 	fftw_execute(plan);
 	if (sign == OPH_FORWARD)
@@ -187,7 +199,10 @@ void ophSig::fft2(matrix<Complex<T>> &src, matrix<Complex<T>> &dst, int sign, ui
 		}
 	}
 
-	fftw_destroy_plan(plan);
+	{
+		std::lock_guard<std::mutex> lock(ophFFT::plannerLock());
+		fftw_destroy_plan(plan);
+	}
 	fftw_free(fft_in);
 	fftw_free(fft_out);
 }
@@ -226,6 +241,62 @@ bool ophSig::loadAsOhc(const char *fname)
 	return true;
 }
 */
+bool ophSig::loadAsOhcRegion(const char *fname, int x0, int y0, int width, int height)
+{
+	std::string fullname = fname;
+	if (!checkExtension(fname, ".ohc")) fullname.append(".ohc");
+	OHC_decoder->setFileName(fullname.c_str());
+
+	if (!OHC_decoder->open()) return false;
+
+	ivec2 pxNum = OHC_decoder->getNumOfPixel();
+	if (x0 < 0 || y0 < 0 || width <= 0 || height <= 0 || x0 + width > pxNum[_X] || y0 + height > pxNum[_Y]) {
+		LOG("failed : The region is out of the field of ohc file.\n");
+		OHC_decoder->close();
+		return false;
+	}
+
+	vector<Real> wavelengthArray;
+	OHC_decoder->getWavelength(wavelengthArray);
+	_wavelength_num = OHC_decoder->getNumOfWavlen();
+
+	context_.pixel_number[_X] = width;
+	context_.pixel_number[_Y] = height;
+
+	context_.wave_length = new Real[_wavelength_num];
+
+	ComplexH = new OphComplexField[_wavelength_num];
+
+	// ComplexH(x, y) is stored at x * pxNumY + y like loadAsOhc / saveAsOhc, so the region covers the file rows
+	// holding x0 ... x0 + width - 1. Only these rows are decoded, tiled files read the overlapping tiles only.
+	const ulonglong first = (ulonglong)x0 * pxNum[_Y] + y0;
+	const ulonglong last = (ulonglong)(x0 + width - 1) * pxNum[_Y] + (y0 + height - 1);
+	const int row0 = (int)(first / pxNum[_X]);
+	const int nRows = (int)(last / pxNum[_X]) - row0 + 1;
+	const ulonglong base = (ulonglong)row0 * pxNum[_X];
+
+	Complex<Real>* band = new Complex<Real>[(ulonglong)nRows * pxNum[_X]];
+	for (int i = 0; i < _wavelength_num; i++)
+	{
+		context_.wave_length[i] = wavelengthArray[(_wavelength_num - 1) - i];
+
+		if (!OHC_decoder->decodeRegion(band, (_wavelength_num - 1) - i, 0, row0, pxNum[_X], nRows)) {
+			delete[] band;
+			OHC_decoder->close();
+			return false;
+		}
+
+		ComplexH[i].resize(width, height);
+		for (int x = 0; x < width; x++)
+			for (int y = 0; y < height; y++)
+				ComplexH[i](x, y) = band[(ulonglong)(x0 + x) * pxNum[_Y] + (y0 + y) - base];
+	}
+	delete[] band;
+	OHC_decoder->close();
+
+	return true;
+}
+
 bool ophSig::saveAsOhc(const char *fname)
 {
 	std::string fullname = fname;
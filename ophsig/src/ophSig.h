@@ -604,6 +604,18 @@ public:
 	*/
 	//bool loadAsOhc(const char *fname);
 	/**
+	* @brief          Load a sub-aperture of ohc file
+	* @details        ComplexH(x, y) is the same pixel as after loadAsOhc, and only the part of the file holding x0 ... x0 + width - 1
+	*                 is decoded, so tiled ohc files larger than memory can be processed by parts.
+	* @param fname    File name
+	* @param x0       First x index of the sub-aperture
+	* @param y0       First y index of the sub-aperture
+	* @param width    Number of x indices of the sub-aperture
+	* @param height   Number of y indices of the sub-aperture
+	* @return         If works well return true or error occurs return false
+	*/
+	bool loadAsOhcRegion(const char *fname, int x0, int y0, int width, int height);
+	/**
 	* @brief          Save data as ohc file
 	* @param fname    File name
 	* @return         If works well return 0  or error occurs return -1
@@ -0,0 +1,344 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install, copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Digital Holographic Library
+//
+// Openholo library is free software;
+// you can redistribute it and/or modify it under the terms of the BSD 2-Clause license.
+//
+// Copyright (C) 2017-2024, Korea Electronics Technology Institute. All rights reserved.
+// E-mail : contact.openholo@gmail.com
+// Web : http://www.openholo.org
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  1. Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the copyright holder or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+// This software contains opensource software released under GNU Generic Public License,
+// NVDIA Software License Agreement, or CUDA supplement to Software License Agreement.
+// Check whether software you use contains licensed software.
+//
+//M*/
+
+#include "ophSigBenchmark.h"
+#include "ophSigPU.h"
+#include "ophSigCH.h"
+#include "sys.h"
+#include <memory>
+#include <random>
+
+namespace {
+	const int OBJECT_POINTS = 16;
+	const int AUTOFOCUS_PLANES = 8;
+	const int TV_ITERATIONS = 20;
+	const Real PIXEL_PITCH = 8e-6;
+	const Real DISTANCE = 0.1;
+
+	/**
+	* @brief Signal processing target holding a synthetic field, restore() puts it back before every run
+	*		since the transforms work in place.
+	*/
+	class SigTarget : public ophSigPU
+	{
+	public:
+		SigTarget(const BenchmarkConfig& config, int nChannels);
+
+		/// wrapped phase of a smooth surface with seeded noise, input of the phase unwrapping.
+		void initPhase(uint seed);
+		void restore(void);
+
+		/// replaces the field by a sub-aperture of an ohc file, like an out-of-core reader.
+		bool loadRegion(const char* fname, int x0, int y0, int width, int height);
+		/// true if the field is the sub-aperture of ref from (x0, y0).
+		bool matchRegion(SigTarget& ref, int x0, int y0);
+
+	protected:
+		virtual ~SigTarget(void) = default;
+		virtual void ophFree(void);
+
+	private:
+		std::vector<Real> wavelength;
+		OphComplexField* source;
+	};
+
+	SigTarget::SigTarget(const BenchmarkConfig& config, int nChannels)
+	{
+		const int nx = config.resolution[_X];
+		const int ny = config.resolution[_Y];
+
+		setMode(true);
+		context_.pixel_number[_X] = nx;
+		context_.pixel_number[_Y] = ny;
+		context_.pixel_pitch[_X] = context_.pixel_pitch[_Y] = PIXEL_PITCH;
+		_cfgSig.rows = nx;
+		_cfgSig.cols = ny;
+		_cfgSig.width = (Real_t)(nx * PIXEL_PITCH);
+		_cfgSig.height = (Real_t)(ny * PIXEL_PITCH);
+		_cfgSig.NA = (Real_t)(_cfgSig.width / (2 * DISTANCE));
+		_cfgSig.z = (Real_t)DISTANCE;
+		_radius = _cfgSig.width;
+		// blue, green, red : the order of sigConvertCAC.
+		_foc[0] = (Real_t)0.0198;
+		_foc[1] = (Real_t)0.0199;
+		_foc[2] = (Real_t)0.02;
+
+		if (nChannels == 3)
+			wavelength = { 473e-9, 532e-9, 638e-9 };
+		else
+			wavelength = { 532e-9 };
+		_wavelength_num = (int)wavelength.size();
+		context_.wave_length = new Real[_wavelength_num];
+
+		// Fresnel hologram of a few seeded object points around DISTANCE.
+		std::vector<Real> vertex, color;
+		Benchmark::randomPoints(config.seed, OBJECT_POINTS, 1, vertex, color);
+
+		source = new OphComplexField[_wavelength_num];
+		ComplexH = new OphComplexField[_wavelength_num];
+		for (int c = 0; c < _wavelength_num; c++) {
+			source[c].resize(nx, ny);
+			ComplexH[c].resize(nx, ny);
+			Real k = M_PI / wavelength[c];
+
+			for (int i = 0; i < nx; i++) {
+				Real x = (i - nx / 2) * PIXEL_PITCH;
+				for (int j = 0; j < ny; j++) {
+					Real y = (j - ny / 2) * PIXEL_PITCH;
+					Complex<Real> sum(0, 0);
+					for (int p = 0; p < OBJECT_POINTS; p++) {
+						Real px = vertex[p * 3 + 0] * _cfgSig.width / 4;
+						Real py = vertex[p * 3 + 1] * _cfgSig.height / 4;
+						Real pz = DISTANCE + vertex[p * 3 + 2] * 0.01;
+						Real phase = k / pz * ((x - px) * (x - px) + (y - py) * (y - py));
+						sum._Val[_RE] += color[p] * cos(phase);
+						sum._Val[_IM] += color[p] * sin(phase);
+					}
+					source[c](i, j) = sum;
+				}
+			}
+		}
+		restore();
+	}
+
+	void SigTarget::initPhase(uint seed)
+	{
+		Nr = context_.pixel_number[_X];
+		Nc = context_.pixel_number[_Y];
+		PhaseOriginal.resize(Nr, Nc);
+
+		std::mt19937_64 engine(seed);
+		std::normal_distribution<Real> noise(0.0, 0.3);
+		for (int i = 0; i < Nr; i++) {
+			Real u = (Real)i / Nr - 0.5;
+			for (int j = 0; j < Nc; j++) {
+				Real v = (Real)j / Nc - 0.5;
+				Real phase = 40 * M_PI * (u * u + v * v) + noise(engine);
+				PhaseOriginal(i, j) = atan2(sin(phase), cos(phase));
+			}
+		}
+		setPUparam(4);
+	}
+
+	void SigTarget::restore(void)
+	{
+		for (int c = 0; c < _wavelength_num; c++) {
+			context_.wave_length[c] = wavelength[c];
+			ComplexH[c] = source[c];
+		}
+		if (Nr > 0) {
+			PhaseUnwrapped.resize(Nr, Nc);
+			PhaseUnwrapped.zeros();
+		}
+	}
+
+	bool SigTarget::loadRegion(const char* fname, int x0, int y0, int width, int height)
+	{
+		delete[] ComplexH;
+		delete[] context_.wave_length;
+		ComplexH = nullptr;
+		context_.wave_length = nullptr;
+		return loadAsOhcRegion(fname, x0, y0, width, height);
+	}
+
+	bool SigTarget::matchRegion(SigTarget& ref, int x0, int y0)
+	{
+		if (ComplexH == nullptr || _wavelength_num != ref._wavelength_num) return false;
+
+		for (int c = 0; c < _wavelength_num; c++) {
+			if (context_.wave_length[c] != ref.context_.wave_length[c]) return false;
+			for (int x = 0; x < context_.pixel_number[_X]; x++) {
+				for (int y = 0; y < context_.pixel_number[_Y]; y++) {
+					const Complex<Real>& a = ComplexH[c](x, y);
+					const Complex<Real>& b = ref.ComplexH[c](x0 + x, y0 + y);
+					// the field may be stored as float.
+					const Real tol = 1e-4 * (1 + fabs(b._Val[_RE]) + fabs(b._Val[_IM]));
+					if (fabs(a._Val[_RE] - b._Val[_RE]) > tol || fabs(a._Val[_IM] - b._Val[_IM]) > tol)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void SigTarget::ophFree(void)
+	{
+		delete[] source;
+		delete[] ComplexH;
+		delete[] context_.wave_length;
+		source = nullptr;
+		ComplexH = nullptr;
+		context_.wave_length = nullptr;
+		ophSigPU::ophFree();
+	}
+
+	/**
+	* @brief Compressive holography target, the TV denoising step of TwIST on a noisy smooth image.
+	*/
+	class TVTarget : public ophSigCH
+	{
+	public:
+		TVTarget(const BenchmarkConfig& config);
+
+		void denoise(void) { tvdenoise(input, 0.5, TV_ITERATIONS, output); }
+
+	protected:
+		virtual ~TVTarget(void) = default;
+
+	private:
+		matrix<Real> input;
+		matrix<Real> output;
+	};
+
+	TVTarget::TVTarget(const BenchmarkConfig& config)
+	{
+		const int nr = config.resolution[_X];
+		const int nc = config.resolution[_Y];
+		input.resize(nr, nc);
+		output.resize(nr, nc);
+
+		std::mt19937_64 engine(config.seed);
+		std::normal_distribution<Real> noise(0.0, 0.1);
+		for (int i = 0; i < nr; i++) {
+			Real u = (Real)i / nr;
+			for (int j = 0; j < nc; j++) {
+				Real v = (Real)j / nc;
+				input(i, j) = (u < 0.5 ? 1.0 : 0.0) + 0.5 * sin(4 * M_PI * v) + noise(engine);
+			}
+		}
+	}
+
+	std::shared_ptr<SigTarget> createTarget(const BenchmarkConfig& config, int nChannels)
+	{
+		return std::shared_ptr<SigTarget>(new SigTarget(config, nChannels), [](SigTarget* sig) { sig->release(); });
+	}
+}
+
+bool ophSigBenchmark::addCases(Benchmark& bench)
+{
+	const BenchmarkConfig& config = bench.getConfig();
+	const int nChannels = config.nChannels == 3 ? 3 : 1;
+	const ulonglong pnXY = (ulonglong)config.resolution[_X] * config.resolution[_Y];
+
+	// the field is built once, at the first prepare of a matching case.
+	auto sig = std::make_shared<std::shared_ptr<SigTarget>>();
+	auto restore = [sig, config, nChannels]() {
+		if (!*sig) *sig = createTarget(config, nChannels);
+		(*sig)->restore();
+		return true;
+	};
+
+	bench.add("sig_offaxis", "pixels", restore, [sig, pnXY]() {
+		(*sig)->sigConvertOffaxis(M_PI / 180, 0);
+		return pnXY;
+	});
+	bench.add("sig_hpo", "pixels", restore, [sig, pnXY]() {
+		(*sig)->sigConvertHPO(DISTANCE, (Real_t)0.5);
+		return pnXY;
+	});
+	bench.add("sig_propagate", "pixels", restore, [sig, pnXY, nChannels]() {
+		(*sig)->propagationHolo((float)-DISTANCE);
+		return pnXY * nChannels;
+	});
+	bench.add("sig_autofocus", "pixels", restore, [sig, pnXY]() {
+		(*sig)->sigGetParamSF((float)(DISTANCE + 0.01), (float)(DISTANCE - 0.01), AUTOFOCUS_PLANES, 0.3f);
+		return pnXY * (AUTOFOCUS_PLANES + 1);
+	});
+
+	// chromatic aberration compensation always works on three wavelengths.
+	auto cac = std::make_shared<std::shared_ptr<SigTarget>>();
+	bench.add("sig_cac", "pixels", [cac, config]() {
+		if (!*cac) *cac = createTarget(config, 3);
+		(*cac)->restore();
+		return true;
+	}, [cac, pnXY]() {
+		(*cac)->sigConvertCAC(638e-9, 532e-9, 473e-9);
+		return pnXY * 3;
+	});
+
+	// round trip of saveAsOhc and loadAsOhcRegion, the run fails if the region is not the same pixels.
+	if (!Benchmark::makeDirectory(config.workDir.c_str())) {
+		LOG("<FAILED> Benchmark directory : %s\n", config.workDir.c_str());
+		return false;
+	}
+	const std::string ohc = config.workDir + "/sig_field.ohc";
+	const int rx0 = config.resolution[_X] / 4, ry0 = config.resolution[_Y] / 8;
+	const int rw = config.resolution[_X] / 2, rh = config.resolution[_Y] / 3;
+	auto region = std::make_shared<std::shared_ptr<SigTarget>>();
+	bench.add("sig_ohc_region", "pixels", [sig, region, restore, config, nChannels, ohc]() {
+		if (!restore() || !(*sig)->saveAsOhc(ohc.c_str())) return false;
+		if (!*region) *region = createTarget(config, nChannels);
+		return true;
+	}, [sig, region, ohc, rx0, ry0, rw, rh]() {
+		if (!(*region)->loadRegion(ohc.c_str(), rx0, ry0, rw, rh) || !(*region)->matchRegion(**sig, rx0, ry0))
+			return (ulonglong)0;
+		return (ulonglong)rw * rh;
+	});
+
+	// the denoiser reads its input and writes a separate output, so the input is built once.
+	auto tv = std::make_shared<std::shared_ptr<TVTarget>>();
+	bench.add("sig_tvdenoise", "pixels", [tv, config]() {
+		if (!*tv) *tv = std::shared_ptr<TVTarget>(new TVTarget(config), [](TVTarget* sig) { sig->release(); });
+		return true;
+	}, [tv, pnXY]() {
+		(*tv)->denoise();
+		return pnXY * TV_ITERATIONS;
+	});
+
+	auto pu = std::make_shared<std::shared_ptr<SigTarget>>();
+	bench.add("sig_unwrap", "pixels", [pu, config]() {
+		if (!*pu) {
+			*pu = createTarget(config, 1);
+			(*pu)->initPhase(config.seed);
+		}
+		(*pu)->restore();
+		return true;
+	}, [pu, pnXY]() {
+		(*pu)->runPU();
+		return pnXY;
+	});
+
+	return true;
+}
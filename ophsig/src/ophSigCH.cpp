@@ -1,4 +1,7 @@
 #include "ophSigCH.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 ophSigCH::ophSigCH(void) 
 	: Nz(0)
@@ -92,99 +95,95 @@ bool ophSigCH::runCH(int complexHidx)
 
 void ophSigCH::tvdenoise(matrix<Real>& input, double lam, int iters, matrix<Real>& output)
 {
-	double dt = 0.25;
-	int nr = input.size(_X);
-	int nc = input.size(_Y);
-	matrix<Real> divp(nr, nc);
-	divp.zeros();
-		
-	matrix<Real> z(nr, nc);
-	matrix<Real> z1, z2;
-	z1.resize(nr, nc);
-	z2.resize(nr, nc);
-
-	matrix<Real> p1, p2;
-	p1.resize(nr, nc);
-	p2.resize(nr, nc);
+	const double dt = 0.25;
+	const int nr = input.size(_X);
+	const int nc = input.size(_Y);
 
-	matrix<Real> denom(nr, nc);
+	// dual variables and divergence, row-major and contiguous.
+	vector<Real> divp(nr * nc, 0.0);
+	vector<Real> p1(nr * nc, 0.0);
+	vector<Real> p2(nr * nc, 0.0);
 
-	for (int iter = 0; iter < iters; iter++)
+#pragma omp parallel
 	{
-		for (int i = 0; i < nr; i++)
+#ifdef _OPENMP
+		const int nth = omp_get_num_threads();
+		const int tid = omp_get_thread_num();
+#else
+		const int nth = 1;
+		const int tid = 0;
+#endif
+		// each thread owns a band of rows; the row below the band is the halo of z.
+		const int r0 = (int)((long long)nr * tid / nth);
+		const int r1 = (int)((long long)nr * (tid + 1) / nth);
+		vector<Real> zc(nc), zn(nc);
+
+		for (int iter = 0; iter < iters; iter++)
 		{
-			for (int j = 0; j < nc; j++)
+			// z = divp - lam * input, gradient, denominator and dual update in one sweep.
+			if (r0 < r1)
 			{
-				z(i,j) = divp(i, j) - input(i, j)*lam;
+				const Real* d = &divp[r0 * nc];
+				const Real* in = &input.mat[r0][0];
+				for (int j = 0; j < nc; j++)
+					zc[j] = d[j] - in[j] * lam;
 			}
-		}
-
-		/////////////////////////
-		for (int i = 0; i < nr - 1; i++)
-		{
-			for (int j = 0; j < nc - 1; j++)
+			for (int i = r0; i < r1; i++)
 			{
-				z1(i, j) = z(i, j + 1) - z(i, j);
-				z2(i, j) = z(i + 1, j) - z(i, j);
-				denom(i, j) = 1 + dt*sqrt(z1(i, j)*z1(i, j) + z2(i, j)*z2(i, j));
+				const bool bLastRow = (i == nr - 1);
+				if (!bLastRow)
+				{
+					const Real* d = &divp[(i + 1) * nc];
+					const Real* in = &input.mat[i + 1][0];
+					for (int j = 0; j < nc; j++)
+						zn[j] = d[j] - in[j] * lam;
+				}
+				Real* q1 = &p1[i * nc];
+				Real* q2 = &p2[i * nc];
+				for (int j = 0; j < nc; j++)
+				{
+					Real z1 = (j < nc - 1) ? zc[j + 1] - zc[j] : 0.0;
+					Real z2 = bLastRow ? 0.0 : zn[j] - zc[j];
+					Real denom = 1.0 + dt * sqrt(z1 * z1 + z2 * z2);
+					q1[j] = (q1[j] + dt * z1) / denom;
+					q2[j] = (q2[j] + dt * z2) / denom;
+				}
+				zc.swap(zn);
 			}
-		}
-		for (int i = 0; i < nr-1; i++)
-		{
-			z1(i, nc-1) = 0.0;
-			z2(i, nc-1) = z(i + 1, nc-1) - z(i, nc-1);
-			denom(i, nc-1) = 1 + dt*sqrt(z1(i, nc-1)*z1(i, nc-1) + z2(i, nc-1)*z2(i, nc-1));
-		}
-		for (int j = 0; j < nc - 1; j++)
-		{
-			z1(nr-1, j) = z(nr-1, j+1) - z(nr-1, j);
-			z2(nr-1, j) = 0.0;
-			denom(nr-1, j) = 1 + dt*sqrt(z1(nr-1, j)*z1(nr-1, j) + z2(nr-1, j)*z2(nr-1, j));
-		}
-		denom(nr-1, nc-1) = 1.0;
-		z1(nr - 1, nc - 1) = 0.0;
-		z2(nr - 1, nc - 1) = 0.0;
-		//////////////////////////
-
+#pragma omp barrier
 
-		for (int i = 0; i < nr ; i++)
-		{
-			for (int j = 0; j < nc; j++)
+			// divergence of the updated dual field.
+			for (int i = r0; i < r1; i++)
 			{
-				p1(i, j) = (p1(i, j) + dt*z1(i, j)) / denom(i, j);
-				p2(i, j) = (p2(i, j) + dt*z2(i, j)) / denom(i, j);
+				Real* d = &divp[i * nc];
+				const Real* q1 = &p1[i * nc];
+				const Real* q2 = &p2[i * nc];
+				if (i == 0)
+				{
+					d[0] = 0.0;
+					for (int j = 1; j < nc; j++)
+						d[j] = q1[j] - q1[j - 1];
+				}
+				else
+				{
+					const Real* q2u = &p2[(i - 1) * nc];
+					d[0] = q2[0] - q2u[0];
+					for (int j = 1; j < nc; j++)
+						d[j] = q1[j] - q1[j - 1] + q2[j] - q2u[j];
+				}
 			}
+#pragma omp barrier
 		}
 
-		////////////////////////////////
-		for (int i = 1; i < nr; i++)
+		for (int i = r0; i < r1; i++)
 		{
-			for (int j = 1; j < nc; j++)
-			{
-				divp(i, j) = p1(i, j) - p1(i, j - 1) + p2(i, j) - p2(i - 1, j);
-			}
-		}
-		for (int i = 1; i < nr; i++)
-		{
-			divp(i, 0) = p2(i, 0) - p2(i-1, 0);
-		}
-		for (int j = 1; j < nc; j++)
-		{
-			divp(0, j) = p1(0, j) - p1(0, j - 1);
-		}
-		divp(0, 0) = 0.0;
-		//////////////////////////////
-
-	}
-
-	for (int i = 0; i < input.size[_X]; i++)
-	{
-		for (int j = 0; j < input.size[_Y]; j++)
-		{
-			output(i, j) = input(i,j) - divp(i, j)/lam;
+			const Real* d = &divp[i * nc];
+			const Real* in = &input.mat[i][0];
+			Real* out = &output.mat[i][0];
+			for (int j = 0; j < nc; j++)
+				out[j] = in[j] - d[j] / lam;
 		}
 	}
-
 }
 
 double ophSigCH::tvnorm(matrix<Real>& input)
@@ -193,22 +192,25 @@ double ophSigCH::tvnorm(matrix<Real>& input)
 	int nr = input.size[_X];
 	int nc = input.size[_Y];
 
-	for (int i = 0; i < nr-1; i++)
+	// rows wrap to the first row/column at the boundary.
+	int i;
+#pragma omp parallel for private(i) reduction(+:sqrtsum)
+	for (i = 0; i < nr; i++)
 	{
-		for (int j = 0; j < nc-1; j++)
+		const Real* row = &input.mat[i][0];
+		const Real* next = &input.mat[(i + 1 < nr) ? i + 1 : 0][0];
+		double sum = 0.0;
+		for (int j = 0; j < nc - 1; j++)
 		{
-			sqrtsum += sqrt((input(i,j)-input(i+1,j))*(input(i,j)-input(i+1,j)) + (input(i,j)-input(i,j+1))*(input(i,j)-input(i,j+1)));
+			Real dv = row[j] - next[j];
+			Real dh = row[j] - row[j + 1];
+			sum += sqrt(dv * dv + dh * dh);
 		}
+		Real dv = row[nc - 1] - next[nc - 1];
+		Real dh = row[nc - 1] - row[0];
+		sum += sqrt(dv * dv + dh * dh);
+		sqrtsum += sum;
 	}
-	for (int i = 0; i < nr-1; i++)
-	{
-		sqrtsum += sqrt(pow(input(i, nc-1) - input(i + 1, nc-1), 2) + pow(input(i, nc-1) - input(i, 0), 2));
-	}
-	for (int j = 0; j < nc - 1; j++)
-	{
-		sqrtsum += sqrt(pow(input(nr-1, j) - input(0, j), 2) + pow(input(nr-1, j) - input(nr-1, j+1), 2));
-	}
-	sqrtsum += sqrt(pow(input(nr-1, nc-1) - input(0, nc-1), 2) + pow(input(nr-1, nc-1) - input(nr-1, 0), 2));
 
 	return sqrtsum;
 }
@@ -244,23 +246,37 @@ void ophSigCH::volume2plane(matrix<Real>& realimagvolumeinput, vector<Real> z, m
 	int nr = realimagvolumeinput.size(_X) / 2;	// real imag
 	int nc = realimagvolumeinput.size(_Y) / nz;
 
-	matrix<Complex<Real>> complexTemp(nr,nc);
-	matrix<Complex<Real>> complexAccum(nr, nc);
-	complexAccum.zeros();
+	if (!preparePropagator(nr, nc, z)) return;
 
-	for (int k = 0; k < nz; k++)
+	planeBuf.resize(nr * nc);
+	volumeBuf.resize(nz * nr * nc);
+
+	int i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < nr; i++)
 	{
-		for (int i = 0; i < nr; i++)
+		for (int k = 0; k < nz; k++)
 		{
+			Complex<Real>* dst = &volumeBuf[(k * nr + i) * nc];
 			for (int j = 0; j < nc; j++)
 			{
-				complexTemp(i, j)._Val[_RE] = realimagvolumeinput(i, j + k*nc);
-				complexTemp(i, j)._Val[_IM] = realimagvolumeinput(i + nr, j + k*nc);
+				dst[j][_RE] = realimagvolumeinput(i, j + k*nc);
+				dst[j][_IM] = realimagvolumeinput(i + nr, j + k*nc);
 			}
 		}
-		complexAccum = complexAccum + propagationHoloAS(complexTemp, static_cast<float>(z.at(k)));
 	}
-	c2ri(complexAccum, realimagplaneoutput);
+
+	propOp.volume2plane(volumeBuf.data(), planeBuf.data());
+
+#pragma omp parallel for private(i)
+	for (i = 0; i < nr; i++)
+	{
+		for (int j = 0; j < nc; j++)
+		{
+			realimagplaneoutput(i, j) = planeBuf[i * nc + j].real();
+			realimagplaneoutput(i + nr, j) = planeBuf[i * nc + j].imag();
+		}
+	}
 }
 
 
@@ -270,31 +286,55 @@ void ophSigCH::plane2volume(matrix<Real>& realimagplaneinput, vector<Real> z, ma
 	int nc = realimagplaneinput.size(_Y);
 	int nz = z.size();
 
-	matrix<Complex<Real>> complexplaneinput(nr, nc);
-	for (int i = 0; i < nr; i++)
+	if (!preparePropagator(nr, nc, z)) return;
+
+	planeBuf.resize(nr * nc);
+	volumeBuf.resize(nz * nr * nc);
+
+	int i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < nr; i++)
 	{
 		for (int j = 0; j < nc; j++)
 		{
-			complexplaneinput(i, j)._Val[_RE] = realimagplaneinput(i, j);
-			complexplaneinput(i, j)._Val[_IM] = realimagplaneinput(i + nr, j);
+			planeBuf[i * nc + j][_RE] = realimagplaneinput(i, j);
+			planeBuf[i * nc + j][_IM] = realimagplaneinput(i + nr, j);
 		}
 	}
 
+	propOp.plane2volume(planeBuf.data(), volumeBuf.data());
 
-	matrix<Complex<Real>> temp(nr, nc);
-	for (int k = 0; k < nz; k++)
+#pragma omp parallel for private(i)
+	for (i = 0; i < nr; i++)
 	{
-		temp = propagationHoloAS(complexplaneinput, static_cast<float>(-z.at(k)));
-		for (int i = 0; i < nr; i++)
+		for (int k = 0; k < nz; k++)
 		{
+			const Complex<Real>* src = &volumeBuf[(k * nr + i) * nc];
 			for (int j = 0; j < nc; j++)
 			{
-				realimagplaneoutput(i, j + k*nc) = temp(i, j)._Val[_RE];
-				realimagplaneoutput(i + nr, j + k*nc) = temp(i, j)._Val[_IM];
+				realimagplaneoutput(i, j + k*nc) = src[j].real();
+				realimagplaneoutput(i + nr, j + k*nc) = src[j].imag();
 			}
 		}
 	}
+}
+
+bool ophSigCH::preparePropagator(int nr, int nc, vector<Real>& z)
+{
+	Real dr = _cfgSig.height / _cfgSig.rows;
+	Real dc = _cfgSig.width / _cfgSig.cols;
+	if (propOp.isReady(nr, nc, dr, dc, _cfgSig.wavelength[0], z))
+		return true;
 
+	auto start = CUR_TIME;
+	if (!propOp.init(nr, nc, dr, dc, _cfgSig.wavelength[0], z))
+	{
+		LOG("<FAILED> Build propagation operator.\n");
+		return false;
+	}
+	auto end = CUR_TIME;
+	LOG("Propagation operator (%d depths) : %.5lf sec\n", (int)z.size(), ELAPSED_TIME(start, end));
+	return true;
 }
 
 void ophSigCH::convert3Dto2D(matrix<Complex<Real>>* complex3Dinput, int nz, matrix<Complex<Real>>& complex2Doutput)
@@ -384,6 +424,7 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 	// compute and sotre initial value of the objective function
 	matrix<Real> resid(nrp, ncp);
 	volume2plane(realimagvolumeoutput, Z, resid);
+#pragma omp parallel for
 	for (int i = 0; i < nrp; i++)
 	{
 		for (int j = 0; j < ncp; j++)
@@ -421,6 +462,7 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 		plane2volume(resid, Z, grad);
 		while (for_ever)
 		{
+#pragma omp parallel for
 			for (int i = 0; i < nrv; i++)
 			{
 				for (int j = 0; j < ncv; j++)
@@ -434,6 +476,7 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 			{
 				if (sparse)
 				{
+#pragma omp parallel for
 					for (int i = 0; i < nrv; i++)
 					{
 						for (int j = 0; j < ncv; j++)
@@ -448,6 +491,7 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 						
 				}
 				// two step iteration
+#pragma omp parallel for
 				for (int i = 0; i < nrv; i++)
 				{
 					for (int j = 0; j < ncv; j++)
@@ -458,6 +502,7 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 				// compute residual
 				volume2plane(xm2, Z, resid);
 				
+#pragma omp parallel for
 				for (int i = 0; i < nrp; i++)
 				{
 					for (int j = 0; j < ncp; j++)
@@ -485,6 +530,7 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 			else
 			{
 				volume2plane(realimagvolumeoutput, Z, resid);
+#pragma omp parallel for
 				for (int i = 0; i < nrp; i++)
 				{
 					for (int j = 0; j < ncp; j++)
@@ -534,6 +580,7 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 	if (verbose)
 	{
 		double sum_abs_x=0.0;
+#pragma omp parallel for reduction(+:sum_abs_x)
 		for (int i = 0; i < nrv; i++)
 		{
 			for (int j = 0; j < ncv; j++)
@@ -551,12 +598,17 @@ void ophSigCH::twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvol
 double ophSigCH::matrixEleSquareSum(matrix<Real>& input)
 {
 	double output = 0.0;
-	for (int i = 0; i < input.size(_X); i++)
+	int nr = input.size(_X);
+	int nc = input.size(_Y);
+	int i;
+#pragma omp parallel for private(i) reduction(+:output)
+	for (i = 0; i < nr; i++)
 	{
-		for (int j = 0; j < input.size(_Y); j++)
-		{
-			output += input(i, j)*input(i, j);
-		}
+		const Real* row = &input.mat[i][0];
+		double sum = 0.0;
+		for (int j = 0; j < nc; j++)
+			sum += row[j] * row[j];
+		output += sum;
 	}
 	return output;
 }
@@ -876,4 +928,188 @@ matrix<Complex<Real>> ophSigCH::propagationHoloAS(matrix<Complex<Real>> complexH
 		}
 	}
 	return dst;
-}
\ No newline at end of file
+}
+
+
+ophCHPropagator::ophCHPropagator(void)
+	: nr(0)
+	, nc(0)
+	, nr2(0)
+	, nc2(0)
+	, iStart(0)
+	, jStart(0)
+	, dr(0)
+	, dc(0)
+	, wavelength(0)
+	, kernel(nullptr)
+	, spec(nullptr)
+	, accum(nullptr)
+{
+}
+
+ophCHPropagator::~ophCHPropagator(void)
+{
+	release();
+}
+
+void ophCHPropagator::release(void)
+{
+	if (kernel) { delete[] kernel; kernel = nullptr; }
+	if (spec) { delete[] spec; spec = nullptr; }
+	if (accum) { delete[] accum; accum = nullptr; }
+	z.clear();
+	nr = nc = nr2 = nc2 = 0;
+}
+
+bool ophCHPropagator::isReady(int nr, int nc, Real dr, Real dc, Real wavelength, const vector<Real>& z) const
+{
+	return kernel != nullptr && this->nr == nr && this->nc == nc &&
+		this->dr == dr && this->dc == dc && this->wavelength == wavelength && this->z == z;
+}
+
+bool ophCHPropagator::init(int nr, int nc, Real dr, Real dc, Real wavelength, const vector<Real>& z)
+{
+	release();
+	if (nr <= 0 || nc <= 0 || z.empty() || wavelength <= 0) return false;
+
+	this->nr = nr;
+	this->nc = nc;
+	this->nr2 = 2 * nr;
+	this->nc2 = 2 * nc;
+	this->iStart = nr / 2 - 1;
+	this->jStart = nc / 2 - 1;
+	this->dr = dr;
+	this->dc = dc;
+	this->wavelength = wavelength;
+	this->z = z;
+
+	const int nz = (int)z.size();
+	const int N2 = nr2 * nc2;
+	kernel = new Complex<Real>[nz * N2];
+	spec = new Complex<Real>[N2];
+	accum = new Complex<Real>[N2];
+
+	// axial frequency of the centered spectrum, stored at the unshifted (FFT order) position.
+	// negative values mark evanescent components.
+	vector<Real> fz(N2);
+	const Real dfr = 1.0 / (((Real)nr2)*dr);
+	const Real dfc = 1.0 / (((Real)nc2)*dc);
+	const Real invL2 = 1.0 / (wavelength * wavelength);
+	int a;
+#pragma omp parallel for private(a)
+	for (a = 0; a < nr2; a++)
+	{
+		Real fr = (((a + nr) % nr2) - nr2 / 2.0 + 1.0)*dfr;
+		for (int b = 0; b < nc2; b++)
+		{
+			Real fc = (((b + nc) % nc2) - nc2 / 2.0 + 1.0)*dfc;
+			Real f2 = invL2 - fr * fr - fc * fc;
+			fz[a * nc2 + b] = f2 < 0 ? -1.0 : sqrt(f2);
+		}
+	}
+
+	for (int k = 0; k < nz; k++)
+	{
+		Complex<Real>* K = kernel + k * N2;
+		const Real w = 2 * M_PI * z[k];
+		int n;
+#pragma omp parallel for private(n)
+		for (n = 0; n < N2; n++)
+		{
+			if (fz[n] < 0) {
+				K[n][_RE] = 0.0;
+				K[n][_IM] = 0.0;
+			}
+			else {
+				K[n][_RE] = cos(w * fz[n]);
+				K[n][_IM] = sin(w * fz[n]);
+			}
+		}
+	}
+	return true;
+}
+
+void ophCHPropagator::pad(const Complex<Real>* src, Complex<Real>* dst)
+{
+	memset(dst, 0, sizeof(Complex<Real>) * nr2 * nc2);
+	int i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < nr; i++)
+	{
+		Complex<Real>* row = dst + ((i + iStart + nr) % nr2) * nc2;
+		const Complex<Real>* s = src + i * nc;
+		for (int j = 0; j < nc; j++)
+			row[(j + jStart + nc) % nc2] = s[j];
+	}
+}
+
+void ophCHPropagator::crop(const Complex<Real>* src, Complex<Real>* dst)
+{
+	int i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < nr; i++)
+	{
+		const Complex<Real>* row = src + ((i + iStart + nr) % nr2) * nc2;
+		Complex<Real>* d = dst + i * nc;
+		for (int j = 0; j < nc; j++)
+			d[j] = row[(j + jStart + nc) % nc2];
+	}
+}
+
+void ophCHPropagator::plane2volume(const Complex<Real>* plane, Complex<Real>* volume)
+{
+	if (!kernel) return;
+	const int nz = (int)z.size();
+	const int N2 = nr2 * nc2;
+	ophFFT* fft = ophFFT::getInstance();
+
+	// spectrum of the plane is shared by every depth.
+	pad(plane, accum);
+	fft->fft2(nc2, nr2, accum, accum, OPH_FORWARD);
+
+	for (int k = 0; k < nz; k++)
+	{
+		const Complex<Real>* K = kernel + k * N2;
+		int n;
+#pragma omp parallel for private(n)
+		for (n = 0; n < N2; n++)
+		{
+			// -z : conjugate of the +z kernel
+			Real re = accum[n].real(), im = accum[n].imag();
+			Real kr = K[n].real(), ki = -K[n].imag();
+			spec[n][_RE] = re * kr - im * ki;
+			spec[n][_IM] = re * ki + im * kr;
+		}
+		fft->fft2(nc2, nr2, spec, spec, OPH_BACKWARD, true);
+		crop(spec, volume + k * nr * nc);
+	}
+}
+
+void ophCHPropagator::volume2plane(const Complex<Real>* volume, Complex<Real>* plane)
+{
+	if (!kernel) return;
+	const int nz = (int)z.size();
+	const int N2 = nr2 * nc2;
+	ophFFT* fft = ophFFT::getInstance();
+
+	memset(accum, 0, sizeof(Complex<Real>) * N2);
+	for (int k = 0; k < nz; k++)
+	{
+		pad(volume + k * nr * nc, spec);
+		fft->fft2(nc2, nr2, spec, spec, OPH_FORWARD);
+
+		const Complex<Real>* K = kernel + k * N2;
+		int n;
+#pragma omp parallel for private(n)
+		for (n = 0; n < N2; n++)
+		{
+			Real re = spec[n].real(), im = spec[n].imag();
+			Real kr = K[n].real(), ki = K[n].imag();
+			accum[n][_RE] += re * kr - im * ki;
+			accum[n][_IM] += re * ki + im * kr;
+		}
+	}
+	// propagation is linear, so the depths are summed before a single inverse transform.
+	fft->fft2(nc2, nr2, accum, accum, OPH_BACKWARD, true);
+	crop(accum, plane);
+}
@@ -5,6 +5,65 @@
 #define __ophSigCH_h
 
 #include "ophSig.h"
+#include "ophFFT.h"
+
+/**
+* @ingroup CH
+* @brief Precomputed multi-depth angular spectrum operator used by the TwIST iterations.
+* @details The 2x padded transfer functions of every depth are built once, in FFT order, so the
+* shifts of propagationHoloAS are folded into the pad/crop addressing.
+* plane2volume is one forward FFT plus Nz kernel multiplies and inverse FFTs,
+* volume2plane is Nz forward FFTs accumulated in the frequency domain and one inverse FFT.
+* Plane data is row-major (nr x nc), volume data is Nz planes stored one after another.
+*/
+class SIG_DLL ophCHPropagator
+{
+public:
+	ophCHPropagator(void);
+	~ophCHPropagator(void);
+
+	/**
+	* @brief Build the transfer functions of every depth.
+	* @param[in] nr the number of row of the plane.
+	* @param[in] nc the number of column of the plane.
+	* @param[in] dr pixel pitch along the row direction.
+	* @param[in] dc pixel pitch along the column direction.
+	* @param[in] wavelength wavelength of the hologram.
+	* @param[in] z depth of each reconstruction plane.
+	* @return true when the operator is ready.
+	*/
+	bool init(int nr, int nc, Real dr, Real dc, Real wavelength, const vector<Real> &z);
+	/**
+	* @brief Whether the operator was built for these parameters.
+	*/
+	bool isReady(int nr, int nc, Real dr, Real dc, Real wavelength, const vector<Real> &z) const;
+	void release(void);
+
+	/**
+	* @brief Propagate a plane to every depth(-z).
+	* @param[in] plane nr x nc complex field.
+	* @param[out] volume Nz x nr x nc complex field.
+	*/
+	void plane2volume(const Complex<Real> *plane, Complex<Real> *volume);
+	/**
+	* @brief Propagate every depth plane(+z) to the hologram plane and sum them.
+	* @param[in] volume Nz x nr x nc complex field.
+	* @param[out] plane nr x nc complex field.
+	*/
+	void volume2plane(const Complex<Real> *volume, Complex<Real> *plane);
+
+private:
+	void pad(const Complex<Real> *src, Complex<Real> *dst);
+	void crop(const Complex<Real> *src, Complex<Real> *dst);
+
+	int nr, nc, nr2, nc2;
+	int iStart, jStart;
+	Real dr, dc, wavelength;
+	vector<Real> z;
+	Complex<Real> *kernel;	// Nz x nr2 x nc2, exp(i*2pi*z*fz) in FFT order
+	Complex<Real> *spec;	// nr2 x nc2 work buffer
+	Complex<Real> *accum;	// nr2 x nc2 frequency-domain accumulator
+};
 
 /**
 * @addtogroup CH
@@ -65,6 +124,10 @@ protected:
 	void convert2Dto3D(matrix<Complex<Real>> &complex2Dinput, int nz, matrix<Complex<Real>> *complex3Doutput);
 	void twist(matrix<Real>& realimagplaneinput, matrix<Real>& realimagvolumeoutput);
 	double matrixEleSquareSum(matrix<Real> &input);
+	/**
+	* @brief Build the propagation operator for the current config and depth list, if not built yet.
+	*/
+	bool preparePropagator(int nr, int nc, vector<Real> &z);
 
 
 	
@@ -80,6 +143,9 @@ protected:
 	int TvIter;
 	matrix<Real> NumRecRealImag;
 	vector<Real> Z;
+	ophCHPropagator propOp;
+	vector<Complex<Real>> planeBuf;
+	vector<Complex<Real>> volumeBuf;
 
 };
 
@@ -1,12 +1,19 @@
 #include "ophSigPU.h"
+#include <queue>
+#include <functional>
 
 ophSigPU::ophSigPU(void)
+	: MaxBoxRadius(0)
+	, QualityGuided(false)
+	, Nr(0)
+	, Nc(0)
 {
 }
 
-bool ophSigPU::setPUparam(int maxBoxRadius)
+bool ophSigPU::setPUparam(int maxBoxRadius, bool qualityGuided)
 {
 	MaxBoxRadius = maxBoxRadius;
+	QualityGuided = qualityGuided;
 	return false;
 }
 
@@ -241,68 +248,30 @@ void ophSigPU::phaseResidues(matrix<Real>& outputResidue)
 	/*
 	This code was written with slight modification based on
 	https://kr.mathworks.com/matlabcentral/fileexchange/22504-2d-phase-unwrapping-algorithms
+	The 2x2 loop of each pixel is read straight from the neighbouring rows, border residues are zero.
 	*/
 
-	matrix<Real> below(Nr, Nc);
-	matrix<Real> right(Nr, Nc);
-	matrix<Real> belowright(Nr, Nc);
-	below.zeros(); right.zeros(); belowright.zeros();
-
-	for (int i = 0; i < Nr-1; i++)
+	int i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < Nr; i++)
 	{
-		for (int j = 0; j < Nc-1; j++)
+		Real* res = &outputResidue.mat[i][0];
+		if (i == 0 || i == Nr - 1)
 		{
-			below(i, j) = PhaseOriginal(i + 1, j);
-			right(i, j) = PhaseOriginal(i, j + 1);
-			belowright(i, j) = PhaseOriginal(i + 1, j + 1);
+			for (int j = 0; j < Nc; j++) res[j] = 0;
+			continue;
 		}
-	}
-	for (int i = 0; i < Nr-1; i++)
-	{
-		below(i, Nc-1) = PhaseOriginal(i + 1, Nc-1);
-	}
-	for (int j = 0; j < Nc - 1; j++)
-	{
-		right(Nr-1, j) = PhaseOriginal(Nr-1, j+1);
-	}
-
-	double res1, res2, res3, res4;
-	double temp_residue;
-	for (int i = 0; i < Nr; i++)
-	{
-		for (int j = 0; j < Nc; j++)
+		const Real* cur = &PhaseOriginal.mat[i][0];
+		const Real* next = &PhaseOriginal.mat[i + 1][0];
+		res[0] = 0;
+		res[Nc - 1] = 0;
+		for (int j = 1; j < Nc - 1; j++)
 		{
-			res1 = mod2pi(PhaseOriginal(i, j) - below(i, j));
-			res2 = mod2pi(below(i, j) - belowright(i,j));
-			res3 = mod2pi(belowright(i, j) - right(i, j));
-			res4 = mod2pi(right(i, j) - PhaseOriginal(i, j));
-
-			temp_residue = res1 + res2 + res3 + res4;
-			if (temp_residue >= 6.)
-			{
-				outputResidue(i, j) = 1;
-			}
-			else if (temp_residue <= -6.)
-			{
-				outputResidue(i, j) = -1;
-			}
-			else
-			{
-				outputResidue(i, j) = 0;
-			}
+			double sum = mod2pi(cur[j] - next[j]) + mod2pi(next[j] - next[j + 1])
+				+ mod2pi(next[j + 1] - cur[j + 1]) + mod2pi(cur[j + 1] - cur[j]);
+			res[j] = (sum >= 6.) ? 1 : ((sum <= -6.) ? -1 : 0);
 		}
 	}
-
-	for (int i = 0; i < Nr; i++)
-	{
-		outputResidue(i, 0) = 0;
-		outputResidue(i, Nc - 1) = 0;
-	}
-	for (int j = 0; j < Nc; j++)
-	{
-		outputResidue(0, j) = 0;
-		outputResidue(Nr - 1, j) = 0;
-	}
 }
 
 void ophSigPU::branchCuts(matrix<Real>& inputResidue, matrix<Real>& outputBranchCuts)
@@ -310,183 +279,121 @@ void ophSigPU::branchCuts(matrix<Real>& inputResidue, matrix<Real>& outputBranch
 	/*
 	This code was written with slight modification based on
 	https://kr.mathworks.com/matlabcentral/fileexchange/22504-2d-phase-unwrapping-algorithms
+	Residues are bucketed in a grid of MaxBoxRadius sized cells, so a box search around a residue
+	only visits the 3x3 cells it overlaps instead of scanning the box pixel by pixel.
 	*/
 
-	int clusterCounter = 1;
-	int satelliteResidue = 0;
-	matrix<int> residueBinary(Nr, Nc);
-	for (int i = 0; i < Nr; i++)
+	if (Nr < 3 || Nc < 3) return;
+	const int cellSize = MaxBoxRadius > 0 ? MaxBoxRadius : 1;
+	const int gr = (Nr + cellSize - 1) / cellSize;
+	const int gc = (Nc + cellSize - 1) / cellSize;
+
+	// residues in raster order
+	vector<int> resRow, resCol, charge;
+	for (int i = 1; i < Nr - 1; i++)
 	{
-		for (int j = 0; j < Nc; j++)
+		const Real* res = &inputResidue.mat[i][0];
+		for (int j = 1; j < Nc - 1; j++)
 		{
-			if (inputResidue(i, j) != 0)
+			if (res[j] != 0)
 			{
-				residueBinary(i, j) = 1;
+				resRow.push_back(i);
+				resCol.push_back(j);
+				charge.push_back(res[j] > 0 ? 1 : -1);
 			}
-			else
-			{
-				residueBinary(i, j) = 0;
-			}	
 		}
 	}
-	matrix<Real> residueBalanced(Nr, Nc);
-	residueBalanced.zeros();
-	matrix<int> adjacentResidue(Nr, Nc);
-	adjacentResidue.zeros();
-	int missedResidue = 0;
+	const int nRes = (int)resRow.size();
+
+	// grid index : residues of cell k are cellRes[cellStart[k] .. cellStart[k + 1])
+	vector<int> cellStart(gr * gc + 1, 0), cellRes(nRes);
+	for (int k = 0; k < nRes; k++)
+		cellStart[(resRow[k] / cellSize) * gc + resCol[k] / cellSize + 1]++;
+	for (int k = 0; k < gr * gc; k++)
+		cellStart[k + 1] += cellStart[k];
+	{
+		vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+		for (int k = 0; k < nRes; k++)
+			cellRes[fill[(resRow[k] / cellSize) * gc + resCol[k] / cellSize]++] = k;
+	}
 
-	int adjacentResidueCount = 0;
+	vector<uchar> balanced(nRes, 0);
+	vector<int> stamp(nRes, -1);
+	vector<int> cluster;
 
-	for (int i = 0; i < Nr; i++)
+	// cut from (r, c) to the nearest image border
+	auto cutToBorder = [&](int r, int c) {
+		int dTop = r, dBottom = Nr - 1 - r, dLeft = c, dRight = Nc - 1 - c;
+		int d = min(min(dTop, dBottom), min(dLeft, dRight));
+		if (d == dTop) placeBranchCutsInternal(outputBranchCuts, r, c, 0, c);
+		else if (d == dBottom) placeBranchCutsInternal(outputBranchCuts, r, c, Nr - 1, c);
+		else if (d == dLeft) placeBranchCutsInternal(outputBranchCuts, r, c, r, 0);
+		else placeBranchCutsInternal(outputBranchCuts, r, c, r, Nc - 1);
+	};
+
+	int satelliteResidue = 0;
+	int missedResidue = 0;
+	for (int s = 0; s < nRes; s++)
 	{
-		for (int j = 0; j < Nc; j++)
+		if (balanced[s]) continue;
+
+		balanced[s] = 1;
+		stamp[s] = s;
+		cluster.clear();
+		cluster.push_back(s);
+		int chargeCounter = charge[s];
+
+		for (int radius = 1; (radius <= MaxBoxRadius) && (chargeCounter != 0); radius++)
 		{
-			if (residueBinary(i, j) == 1)
+			for (size_t k = 0; (k < cluster.size()) && (chargeCounter != 0); k++)
 			{
-				int rActive = i;
-				int cActive = j;
-
-				int radius = 1;
-				int countNearbyResidueFlag = 1;
-				clusterCounter = 1;
-				adjacentResidue.zeros();
-				int chargeCounter = inputResidue(rActive, cActive);
-				if (residueBalanced(rActive, cActive) != 1)
+				const int a = cluster[k];
+				const int ra = resRow[a], ca = resCol[a];
+				const int gr0 = max(ra - radius, 0) / cellSize, gr1 = min(ra + radius, Nr - 1) / cellSize;
+				const int gc0 = max(ca - radius, 0) / cellSize, gc1 = min(ca + radius, Nc - 1) / cellSize;
+
+				for (int y = gr0; (y <= gr1) && (chargeCounter != 0); y++)
 				{
-					while (chargeCounter != 0)
+					for (int x = gc0; (x <= gc1) && (chargeCounter != 0); x++)
 					{
-						for (int m = rActive - radius; m < rActive + radius + 1; m++)
+						for (int e = cellStart[y * gc + x]; (e < cellStart[y * gc + x + 1]) && (chargeCounter != 0); e++)
 						{
-							for (int n = cActive - radius; n < cActive + radius + 1; n++)
+							const int t = cellRes[e];
+							if (stamp[t] == s) continue;
+							if (abs(resRow[t] - ra) > radius || abs(resCol[t] - ca) > radius) continue;
+
+							placeBranchCutsInternal(outputBranchCuts, ra, ca, resRow[t], resCol[t]);
+							stamp[t] = s;
+							cluster.push_back(t);
+							if (!balanced[t])
 							{
-								if (((abs(m - rActive) == radius) | (abs(n - cActive) == radius)) & (chargeCounter != 0))
-								{
-									if ((m < 1) | (m >= Nr - 1) | (n < 1) | (m >= Nc - 1))
-									{
-										if (m >= Nr - 1) { m = Nr - 1; }
-										if (n >= Nc - 1) { n = Nc - 1; }
-										if (n < 1) { n = 0; }
-										if (m < 1) { m = 0; }
-										placeBranchCutsInternal(outputBranchCuts, rActive, cActive, m, n);
-										clusterCounter += 1;
-										chargeCounter = 0;
-										residueBalanced(rActive, cActive) = 1;
-									}
-									if (residueBinary(m, n))
-									{
-										if (countNearbyResidueFlag == 1) { adjacentResidue(m, n) = 1; }
-										placeBranchCutsInternal(outputBranchCuts, rActive, cActive, m, n);
-										clusterCounter += 1;
-										if (residueBalanced(m, n) == 0)
-										{
-											residueBalanced(m, n) = 1;
-											chargeCounter += inputResidue(m, n);
-										}
-										if (chargeCounter == 0) { residueBalanced(rActive, cActive) = 1; }
-									}
-	 
-								}
-							}
-						}
-
-						double sumAdjacentResidue = 0;
-						int adjacentSize = 0;
-						for (int ii = 0; ii < Nr; ii++)
-						{
-							for (int jj = 0; jj < Nc; jj++)
-							{
-								sumAdjacentResidue += adjacentResidue(ii, jj);
-							}
-						}
-						if (sumAdjacentResidue == 0)
-						{
-							radius += 1;
-							rActive = i;
-							cActive = j;
-						}
-						else
-						{
-							vector<int> rAdjacent, cAdjacent;
-							if (countNearbyResidueFlag == 1)
-							{
-								findNZ(adjacentResidue, rAdjacent, cAdjacent);
-								adjacentSize = rAdjacent.size();
-								rActive = rAdjacent[0];
-								cActive = cAdjacent[0];
-								adjacentResidueCount = 1;
-								residueBalanced(rActive, cActive) = 1;
-								countNearbyResidueFlag = 0;
-							}
-							else
-							{
-								adjacentResidueCount += 1;
-								if (adjacentResidueCount <= adjacentSize)
-								{
-									rActive = rAdjacent[adjacentResidueCount-1];
-									cActive = cAdjacent[adjacentResidueCount-1];
-								}
-								else
-								{
-									radius += 1;
-									rActive = i;
-									cActive = j;
-									adjacentResidue.zeros();
-									countNearbyResidueFlag = 1;
-								}
-							}
-						}
-						if (radius > MaxBoxRadius)
-						{
-							if (clusterCounter != 1)
-							{
-								missedResidue += 1;
-							}
-							else
-							{
-								satelliteResidue += 1;
-							}
-							chargeCounter = 0;
-							while (clusterCounter == 1)
-							{
-								rActive = i;
-								cActive = j;
-								for (int m = rActive - radius; m < rActive + radius + 1; m++)
-								{
-									for (int n = cActive - radius; n < cActive + radius + 1; n++)
-									{
-										if (((abs(m - rActive) == radius) | (abs(n - cActive) == radius) ))
-										{
-											if ((m < 1) | (m >= Nr - 1) | (n < 1) | (m >= Nc - 1))
-											{
-												if (m >= Nr - 1) { m = Nr - 1; }
-												if (n >= Nc - 1) { n = Nc - 1; }
-												if (n < 1) { n = 0; }
-												if (m < 1) { m = 0; }
-												placeBranchCutsInternal(outputBranchCuts, rActive, cActive, m, n);
-												clusterCounter += 1;
-												residueBalanced(rActive, cActive) = 1;
-											}
-											if (residueBinary(m, n))
-											{
-												placeBranchCutsInternal(outputBranchCuts, rActive, cActive, m, n);
-												clusterCounter += 1;
-												residueBalanced(rActive, cActive) = 1;
-											}
-
-										}
-									}
-								}
-								radius += 1;
+								balanced[t] = 1;
+								chargeCounter += charge[t];
 							}
 						}
 					}
 				}
+
+				// the box reached the border : the border absorbs the remaining charge
+				if ((chargeCounter != 0) && ((ra - radius <= 0) || (ra + radius >= Nr - 1) || (ca - radius <= 0) || (ca + radius >= Nc - 1)))
+				{
+					cutToBorder(ra, ca);
+					chargeCounter = 0;
+				}
 			}
 		}
+
+		if (chargeCounter != 0)
+		{
+			if (cluster.size() == 1) satelliteResidue += 1;
+			else missedResidue += 1;
+			cutToBorder(resRow[s], resCol[s]);
+		}
 	}
 
-	LOG("Branch cut operation completed. \n");
+	LOG("Branch cut operation completed. (%d residues)\n", nRes);
 	LOG("Satellite residues accounted for = %d\n", satelliteResidue);
+	LOG("Unbalanced clusters cut to the border = %d\n", missedResidue);
 }
 
 void ophSigPU::placeBranchCutsInternal(matrix<Real>& branchCuts, int r1, int c1, int r2, int c2)
@@ -524,197 +431,206 @@ void ophSigPU::floodFill(matrix<Real>& inputBranchCuts)
 	/*
 	This code was written with slight modification based on
 	https://kr.mathworks.com/matlabcentral/fileexchange/22504-2d-phase-unwrapping-algorithms
+	Every pixel is reached once and unwrapped, when reached, against the neighbor that reached it.
 	*/
 
-	matrix<int> adjoin(Nr, Nc);
-	adjoin.zeros();
+	const int N = Nr * Nc;
+	vector<Real> phase(N), unwrapped(N);
+	vector<uchar> cut(N);
+	vector<uchar> state(N, 0);	// 0 : not reached, 1 : unwrapped
+
+	int i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < Nr; i++)
+	{
+		for (int j = 0; j < Nc; j++)
+		{
+			phase[i * Nc + j] = PhaseOriginal(i, j);
+			unwrapped[i * Nc + j] = PhaseUnwrapped(i, j);
+			cut[i * Nc + j] = (inputBranchCuts(i, j) != 0) ? 1 : 0;
+		}
+	}
 
-	matrix<int> unwrappedBinary(Nr, Nc);
-	unwrappedBinary.zeros();
-	
 	// set ref phase
-	bool refPhaseFound = false;
-	for (int i = 1; (i < Nr - 1) & !refPhaseFound; i++)
+	int seed = -1;
+	for (int r = 1; (r < Nr - 1) && (seed < 0); r++)
 	{
-		for (int j = 1; (j < Nc - 1) & !refPhaseFound; j++)
+		for (int c = 1; (c < Nc - 1) && (seed < 0); c++)
 		{
-			if (inputBranchCuts(i, j) == 0)
+			if (!cut[r * Nc + c]) seed = r * Nc + c;
+		}
+	}
+	if (seed < 0)
+	{
+		LOG("Floodfill failed : no pixel outside the branch cuts\n");
+		return;
+	}
+	unwrapped[seed] = phase[seed];
+	state[seed] = 1;
+
+	// only interior pixels off the branch cuts are flood filled, p itself is always interior.
+	auto expand = [&](int p, auto&& push) {
+		int r = p / Nc, c = p - r * Nc;
+		int q[4] = { -1, -1, -1, -1 };
+		if (r < Nr - 2) q[0] = p + Nc;
+		if (r > 1) q[1] = p - Nc;
+		if (c < Nc - 2) q[2] = p + 1;
+		if (c > 1) q[3] = p - 1;
+		for (int k = 0; k < 4; k++)
+		{
+			if (q[k] >= 0 && !cut[q[k]] && state[q[k]] == 0)
 			{
-				adjoin(i - 1, j) = 1;
-				adjoin(i + 1, j) = 1;
-				adjoin(i, j - 1) = 1;
-				adjoin(i, j + 1) = 1;
-				unwrappedBinary(i, j) = 1;
-				PhaseUnwrapped(i, j) = PhaseOriginal(i, j);
-				refPhaseFound = true;
+				unwrapped[q[k]] = unwrap(unwrapped[p], phase[q[k]]);
+				state[q[k]] = 1;
+				push(q[k]);
 			}
 		}
-	}
+	};
 
-	// floodfill
-	int countLimit = 0;
-	int adjoinStuck = 0;
-	vector<int> rAdjoin;
-	vector<int> cAdjoin;
-	int rActive = 0;
-	int cActive = 0;
-	double phaseRef = 0;
-	while ((matrixPartialSum(adjoin, 1, 1, Nr - 2, Nc - 2) > 0) & (countLimit < 100))
+	int nUnwrapped = 0;
+	if (!QualityGuided)
 	{
-		//while (countLimit < 100)
-		//{
-		LOG("%d\n", matrixPartialSum(adjoin, 1, 1, Nr - 2, Nc - 2));
-			findNZ(adjoin, rAdjoin, cAdjoin);
-			if (adjoinStuck == rAdjoin.size())
+		// scanline fill : a seed is extended along its row, then one seed is queued per
+		// unvisited run in the rows above and below, so the memory is walked row by row.
+		vector<int> stack;
+		stack.push_back(seed);
+		nUnwrapped = 1;
+		while (!stack.empty())
+		{
+			int p = stack.back();
+			stack.pop_back();
+			int r = p / Nc, c = p - r * Nc;
+			Real* row = &unwrapped[r * Nc];
+			const uchar* rowCut = &cut[r * Nc];
+			uchar* rowState = &state[r * Nc];
+
+			int cl = c, cr = c;
+			while (cl > 1 && !rowCut[cl - 1] && !rowState[cl - 1])
 			{
-				countLimit += 1;
-				LOG("countLimit %d\n", countLimit);
+				cl--;
+				row[cl] = unwrap(row[cl + 1], phase[r * Nc + cl]);
+				rowState[cl] = 1;
+				nUnwrapped++;
 			}
-			else
+			while (cr < Nc - 2 && !rowCut[cr + 1] && !rowState[cr + 1])
 			{
-				countLimit = 0;
+				cr++;
+				row[cr] = unwrap(row[cr - 1], phase[r * Nc + cr]);
+				rowState[cr] = 1;
+				nUnwrapped++;
 			}
-			adjoinStuck = rAdjoin.size();
-			for (int i = 0; i < rAdjoin.size(); i++)
+
+			for (int rr = r - 1; rr <= r + 1; rr += 2)
 			{
-				rActive = rAdjoin[i];
-				cActive = cAdjoin[i];
-				if ((rActive <= Nr - 2) & (rActive >= 1) & (cActive <= Nc - 2) & (cActive >= 1))
+				if (rr < 1 || rr > Nr - 2) continue;
+				bool bInRun = false;
+				for (int cc = cl; cc <= cr; cc++)
 				{
-					if ((inputBranchCuts(rActive + 1, cActive) == 0) & (unwrappedBinary(rActive + 1, cActive) == 1))
-					{
-						phaseRef = PhaseUnwrapped(rActive + 1, cActive);
-						PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-						unwrappedBinary(rActive, cActive) = 1;
-						adjoin(rActive, cActive) = 0;
-						if ((unwrappedBinary(rActive - 1, cActive) == 0) & (inputBranchCuts(rActive - 1, cActive) == 0))
-						{
-							adjoin(rActive - 1, cActive) = 1;
-						}
-						if ((unwrappedBinary(rActive, cActive-1) == 0) & (inputBranchCuts(rActive, cActive-1) == 0))
-						{
-							adjoin(rActive, cActive-1) = 1;
-						}
-						if ((unwrappedBinary(rActive, cActive+1) == 0) & (inputBranchCuts(rActive, cActive+1) == 0))
-						{
-							adjoin(rActive, cActive+1) = 1;
-						}
-					}
-					if ((inputBranchCuts(rActive - 1, cActive) == 0) & (unwrappedBinary(rActive - 1, cActive) == 1))
-					{
-						phaseRef = PhaseUnwrapped(rActive - 1, cActive);
-						PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-						unwrappedBinary(rActive, cActive) = 1;
-						adjoin(rActive, cActive) = 0;
-						if ((unwrappedBinary(rActive + 1, cActive) == 0) & (inputBranchCuts(rActive + 1, cActive) == 0))
-						{
-							adjoin(rActive + 1, cActive) = 1;
-						}
-						if ((unwrappedBinary(rActive, cActive - 1) == 0) & (inputBranchCuts(rActive, cActive - 1) == 0))
-						{
-							adjoin(rActive, cActive - 1) = 1;
-						}
-						if ((unwrappedBinary(rActive, cActive + 1) == 0) & (inputBranchCuts(rActive, cActive + 1) == 0))
-						{
-							adjoin(rActive, cActive + 1) = 1;
-						}
-					}
-					if ((inputBranchCuts(rActive, cActive +1) == 0) & (unwrappedBinary(rActive, cActive+1) == 1))
-					{
-						phaseRef = PhaseUnwrapped(rActive, cActive+1);
-						PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-						unwrappedBinary(rActive, cActive) = 1;
-						adjoin(rActive, cActive) = 0;
-						if ((unwrappedBinary(rActive + 1, cActive) == 0) & (inputBranchCuts(rActive + 1, cActive) == 0))
-						{
-							adjoin(rActive + 1, cActive) = 1;
-						}
-						if ((unwrappedBinary(rActive, cActive - 1) == 0) & (inputBranchCuts(rActive, cActive - 1) == 0))
-						{
-							adjoin(rActive, cActive - 1) = 1;
-						}
-						if ((unwrappedBinary(rActive -1 , cActive) == 0) & (inputBranchCuts(rActive-1, cActive) == 0))
-						{
-							adjoin(rActive-1, cActive) = 1;
-						}
-					}
-					if ((inputBranchCuts(rActive, cActive-1) == 0) & (unwrappedBinary(rActive, cActive-1) == 1))
-					{
-						phaseRef = PhaseUnwrapped(rActive, cActive-1);
-						PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-						unwrappedBinary(rActive, cActive) = 1;
-						adjoin(rActive, cActive) = 0;
-						if ((unwrappedBinary(rActive + 1, cActive) == 0) & (inputBranchCuts(rActive + 1, cActive) == 0))
-						{
-							adjoin(rActive + 1, cActive) = 1;
-						}
-						if ((unwrappedBinary(rActive -1, cActive) == 0) & (inputBranchCuts(rActive-1, cActive) == 0))
-						{
-							adjoin(rActive-1, cActive) = 1;
-						}
-						if ((unwrappedBinary(rActive, cActive + 1) == 0) & (inputBranchCuts(rActive, cActive + 1) == 0))
-						{
-							adjoin(rActive, cActive + 1) = 1;
-						}
-					}
-
+					int q = rr * Nc + cc;
+					if (cut[q] || state[q]) { bInRun = false; continue; }
+					if (bInRun) continue;
+					unwrapped[q] = unwrap(row[cc], phase[q]);
+					state[q] = 1;
+					nUnwrapped++;
+					stack.push_back(q);
+					bInRun = true;
 				}
-
 			}
-		//}
+		}
+	}
+	else
+	{
+		vector<Real> quality;
+		phaseDerivativeVariance(phase, quality);
+
+		typedef std::pair<Real, int> Entry;
+		std::priority_queue<Entry, vector<Entry>, std::greater<Entry>> heap;
+		heap.push(Entry(quality[seed], seed));
+		while (!heap.empty())
+		{
+			int p = heap.top().second;
+			heap.pop();
+			nUnwrapped++;
+			expand(p, [&heap, &quality](int q) { heap.push(Entry(quality[q], q)); });
+		}
 	}
 
-	adjoin.zeros();
-	for (int i = 1; i <= Nr - 2; i++)
+	// pixels on the branch cuts take the phase of an unwrapped neighbor.
+	for (int r = 1; r <= Nr - 2; r++)
 	{
-		for (int j = 1; j < Nc - 2; j++)
+		for (int c = 1; c <= Nc - 2; c++)
 		{
-			if ((inputBranchCuts(i, j) == 1) & 
-				((inputBranchCuts(i + 1, j) == 0) | 
-				(inputBranchCuts(i - 1, j) == 0) | 
-					(inputBranchCuts(i, j - 1) == 0) | 
-					(inputBranchCuts(i, j + 1) == 0)))
+			int p = r * Nc + c;
+			if (!cut[p]) continue;
+			if (cut[p + Nc] && cut[p - Nc] && cut[p + 1] && cut[p - 1]) continue;
+			const int offset[4] = { Nc, -Nc, 1, -1 };
+			for (int k = 0; k < 4; k++)
 			{
-				adjoin(i, j) = 1;
+				int q = p + offset[k];
+				if (state[q] == 1)
+				{
+					unwrapped[p] = unwrap(unwrapped[q], phase[p]);
+					state[p] = 1;
+				}
 			}
 		}
 	}
-	findNZ(adjoin, rAdjoin, cAdjoin);
-	for (int i = 0; i < rAdjoin.size(); i++)
-	{
-		rActive = rAdjoin[i];
-		cActive = cAdjoin[i];
 
-		if (unwrappedBinary(rActive + 1, cActive) == 1)
-		{
-			phaseRef = PhaseUnwrapped(rActive + 1, cActive);
-			PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-			unwrappedBinary(rActive, cActive) = 1;
-			adjoin(rActive, cActive) = 0;
-		}
-		if (unwrappedBinary(rActive - 1, cActive) == 1)
+#pragma omp parallel for private(i)
+	for (i = 0; i < Nr; i++)
+	{
+		for (int j = 0; j < Nc; j++)
 		{
-			phaseRef = PhaseUnwrapped(rActive - 1, cActive);
-			PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-			unwrappedBinary(rActive, cActive) = 1;
-			adjoin(rActive, cActive) = 0;
+			PhaseUnwrapped(i, j) = unwrapped[i * Nc + j];
 		}
-		if (unwrappedBinary(rActive, cActive+1) == 1)
+	}
+	LOG("Floodfill completed (%d pixels)\n", nUnwrapped);
+}
+
+void ophSigPU::phaseDerivativeVariance(const vector<Real>& phase, vector<Real>& quality)
+{
+	const int N = Nr * Nc;
+	vector<Real> dx(N, 0.0), dy(N, 0.0);
+	quality.assign(N, 0.0);
+
+	int i;
+#pragma omp parallel for private(i)
+	for (i = 0; i < Nr - 1; i++)
+	{
+		for (int j = 0; j < Nc - 1; j++)
 		{
-			phaseRef = PhaseUnwrapped(rActive, cActive+1);
-			PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-			unwrappedBinary(rActive, cActive) = 1;
-			adjoin(rActive, cActive) = 0;
+			int p = i * Nc + j;
+			dx[p] = mod2pi(phase[p + 1] - phase[p]);
+			dy[p] = mod2pi(phase[p + Nc] - phase[p]);
 		}
-		if (unwrappedBinary(rActive, cActive-1) == 1)
+	}
+
+#pragma omp parallel for private(i)
+	for (i = 1; i < Nr - 1; i++)
+	{
+		for (int j = 1; j < Nc - 1; j++)
 		{
-			phaseRef = PhaseUnwrapped(rActive, cActive-1);
-			PhaseUnwrapped(rActive, cActive) = unwrap(phaseRef, PhaseOriginal(rActive, cActive));
-			unwrappedBinary(rActive, cActive) = 1;
-			adjoin(rActive, cActive) = 0;
+			Real mx = 0, my = 0;
+			for (int m = -1; m <= 1; m++)
+				for (int n = -1; n <= 1; n++)
+				{
+					mx += dx[(i + m) * Nc + j + n];
+					my += dy[(i + m) * Nc + j + n];
+				}
+			mx /= 9.0;
+			my /= 9.0;
+			Real vx = 0, vy = 0;
+			for (int m = -1; m <= 1; m++)
+				for (int n = -1; n <= 1; n++)
+				{
+					Real ex = dx[(i + m) * Nc + j + n] - mx;
+					Real ey = dy[(i + m) * Nc + j + n] - my;
+					vx += ex * ex;
+					vy += ey * ey;
+				}
+			quality[i * Nc + j] = (sqrt(vx) + sqrt(vy)) / 9.0;
 		}
 	}
-	LOG("Floodfill completed\n");
 }
 
 double ophSigPU::unwrap(double phaseRef, double phaseInput)
@@ -726,6 +642,7 @@ double ophSigPU::unwrap(double phaseRef, double phaseInput)
 
 double ophSigPU::mod2pi(double phase)
 {
+	if (phase >= -M_PI && phase <= M_PI) return phase;
 	double temp;
 	temp = fmod(phase, 2 * M_PI);
 	if (temp > M_PI)
@@ -738,33 +655,3 @@ double ophSigPU::mod2pi(double phase)
 	}
 	return temp;
 }
-
-void ophSigPU::findNZ(matrix<int>& inputMatrix, vector<int>& row, vector<int>& col)
-{
-	row.clear();
-	col.clear();
-	for (int i = 0; i < inputMatrix.size(_X); i++)
-	{
-		for (int j = 0; j < inputMatrix.size(_Y); j++)
-		{
-			if (inputMatrix(i,j) != 0)
-			{
-				row.push_back(i);
-				col.push_back(j);
-			}
-		}
-	}
-}
-
-int ophSigPU::matrixPartialSum(matrix<int>& inputMatrix, int r1, int c1, int r2, int c2)
-{
-	int outputsum = 0;
-	for (int i = r1; i <= r2; i++)
-	{
-		for (int j = c1; j <= c2; j++)
-		{
-			outputsum += inputMatrix(i, j);
-		}
-	}
-	return outputsum;
-}
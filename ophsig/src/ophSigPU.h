@@ -31,8 +31,9 @@ public:
 	/**
 	* @brief Set parameters for Goldstein branchcut algorithm 
 	* @param maxBoxRadius : maximum box radius for neighboring residue search
+	* @param qualityGuided : if true, flood fill follows the phase-derivative variance (lowest first) instead of breadth-first order
 	*/
-	bool setPUparam(int maxBoxRadius);
+	bool setPUparam(int maxBoxRadius, bool qualityGuided = false);
 
 	/**
 	* @brief Load original wrapped phase data
@@ -66,16 +67,21 @@ protected:
 	void branchCuts(matrix<Real> &inputResidue, matrix<Real> &outputBranchCuts);
 	void placeBranchCutsInternal(matrix<Real> &branchCuts, int r1, int c1, int r2, int c2);
 	void floodFill(matrix<Real> &inputBranchCuts);
+	/**
+	* @brief Phase-derivative variance in a 3x3 window, used as the (inverse) quality map of the flood fill
+	* @param phase : wrapped phase, row-major Nr x Nc
+	* @param quality : output variance, row-major Nr x Nc (valid for interior pixels)
+	*/
+	void phaseDerivativeVariance(const vector<Real> &phase, vector<Real> &quality);
 	double unwrap(double phaseRef, double phaseInput);
 	double mod2pi(double phase);
-	void findNZ(matrix<int> &inputMatrix, vector<int> &row, vector<int> &col);
-	int matrixPartialSum(matrix<int> &inputMatrix, int r1, int c1, int r2, int c2);
 public:
 
 
 
 protected:
 	int MaxBoxRadius;
+	bool QualityGuided;
 	int Nr;
 	int Nc;
 	matrix<Real> PhaseOriginal;